@@ -50,6 +50,13 @@ async function buildRelease() {
       console.log('  ✓ hide-windows-preload.js');
     }
 
+    // 复制可选的原生加速模块（npm run build:native 生成）
+    const addonSource = join(__dirname, 'native', 'build', 'Release', 'codeagenthub_native.node');
+    if (existsSync(addonSource)) {
+      copyFileSync(addonSource, join(releaseDir, 'codeagenthub_native.node'));
+      console.log('  ✓ codeagenthub_native.node');
+    }
+
     // 复制 better-sqlite3 及其依赖，以及 SDK 包
     console.log('📦 Copying native modules and SDK packages...');
     const modules = [
@@ -0,0 +1,24 @@
+{
+  "targets": [
+    {
+      "target_name": "codeagenthub_native",
+      "sources": [
+        "src/addon.cc",
+        "src/jsonl_scanner.cc",
+        "src/mapped_file.cc",
+        "src/message_counter.cc"
+      ],
+      "defines": ["NAPI_VERSION=8"],
+      "cflags_cc": ["-std=c++17", "-O3"],
+      "xcode_settings": {
+        "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
+        "MACOSX_DEPLOYMENT_TARGET": "10.15"
+      },
+      "msvs_settings": {
+        "VCCLCompilerTool": {
+          "AdditionalOptions": ["/std:c++17"]
+        }
+      }
+    }
+  ]
+}
@@ -0,0 +1,110 @@
+#include "addon.h"
+
+#include <string>
+
+namespace {
+
+bool CheckType(napi_env env, napi_value value, napi_valuetype expected,
+               const char* what) {
+  napi_valuetype type = napi_undefined;
+  if (!NapiOk(env, napi_typeof(env, value, &type))) {
+    return false;
+  }
+  if (type != expected) {
+    const std::string message =
+        std::string(what) + " must be a " +
+        (expected == napi_string ? "string" : "number");
+    napi_throw_type_error(env, nullptr, message.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool NapiOk(napi_env env, napi_status status) {
+  if (status == napi_ok) {
+    return true;
+  }
+  if (status == napi_pending_exception) {
+    return false;
+  }
+  const napi_extended_error_info* info = nullptr;
+  napi_get_last_error_info(env, &info);
+  const std::string message = info != nullptr && info->error_message != nullptr
+                                  ? info->error_message
+                                  : "N-API call failed";
+  bool pending = false;
+  napi_is_exception_pending(env, &pending);
+  if (!pending) {
+    napi_throw_error(env, nullptr, message.c_str());
+  }
+  return false;
+}
+
+bool ExportFunction(napi_env env, napi_value exports, const char* name,
+                    napi_callback callback) {
+  napi_value function;
+  return NapiOk(env, napi_create_function(env, name, NAPI_AUTO_LENGTH,
+                                          callback, nullptr, &function)) &&
+         NapiOk(env, napi_set_named_property(env, exports, name, function));
+}
+
+bool GetString(napi_env env, napi_value value, const char* what,
+               std::string* out) {
+  size_t length = 0;
+  if (!CheckType(env, value, napi_string, what) ||
+      !NapiOk(env, napi_get_value_string_utf8(env, value, nullptr, 0,
+                                              &length))) {
+    return false;
+  }
+  out->resize(length + 1);
+  if (!NapiOk(env, napi_get_value_string_utf8(env, value, &(*out)[0],
+                                              length + 1, &length))) {
+    return false;
+  }
+  out->resize(length);
+  return true;
+}
+
+bool GetInt64(napi_env env, napi_value value, const char* what,
+              int64_t* out) {
+  return CheckType(env, value, napi_number, what) &&
+         NapiOk(env, napi_get_value_int64(env, value, out));
+}
+
+napi_value QueueWork(napi_env env, const char* name,
+                     napi_async_execute_callback execute,
+                     napi_async_complete_callback complete, void* data,
+                     napi_async_work* work, napi_deferred* deferred) {
+  napi_value promise;
+  napi_value resource_name;
+  if (!NapiOk(env, napi_create_promise(env, deferred, &promise)) ||
+      !NapiOk(env, napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH,
+                                           &resource_name)) ||
+      !NapiOk(env, napi_create_async_work(env, nullptr, resource_name,
+                                          execute, complete, data, work))) {
+    return nullptr;
+  }
+  if (!NapiOk(env, napi_queue_async_work(env, *work))) {
+    napi_delete_async_work(env, *work);
+    return nullptr;
+  }
+  return promise;
+}
+
+void RejectWithMessage(napi_env env, napi_deferred deferred,
+                       const std::string& message) {
+  napi_value text = nullptr;
+  napi_value error = nullptr;
+  napi_create_string_utf8(env, message.c_str(), message.size(), &text);
+  napi_create_error(env, nullptr, text, &error);
+  napi_reject_deferred(env, deferred, error);
+}
+
+NAPI_MODULE_INIT() {
+  if (!InitJsonlScanner(env, exports) || !InitMessageCounter(env, exports)) {
+    return nullptr;
+  }
+  return exports;
+}
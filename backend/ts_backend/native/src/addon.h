@@ -0,0 +1,49 @@
+#ifndef CODEAGENTHUB_NATIVE_ADDON_H_
+#define CODEAGENTHUB_NATIVE_ADDON_H_
+
+#include <node_api.h>
+
+#include <cstdint>
+#include <string>
+
+// Optional native helpers for the backend. src/native.ts loads the addon
+// when it has been built (npm run build:native) and the callers fall back to
+// their TypeScript implementations otherwise, so every export must give the
+// same results as its fallback.
+
+// Returns true if |status| is napi_ok. Otherwise makes sure a JavaScript
+// exception is pending, so the caller only has to return.
+bool NapiOk(napi_env env, napi_status status);
+
+// Adds |callback| to |exports| as |name|.
+bool ExportFunction(napi_env env, napi_value exports, const char* name,
+                    napi_callback callback);
+
+// Reads the JavaScript string |value| as UTF-8. Throws a TypeError naming
+// |what| if it is not a string.
+bool GetString(napi_env env, napi_value value, const char* what,
+               std::string* out);
+
+// Reads the JavaScript number |value| as an integer. Throws a TypeError
+// naming |what| if it is not a number.
+bool GetInt64(napi_env env, napi_value value, const char* what,
+              int64_t* out);
+
+// Creates a promise and queues |execute| on the libuv thread pool, followed
+// by |complete| on the main thread, which settles |*deferred| and deletes
+// |*work|. Returns nullptr with an exception pending if that fails, in which
+// case the caller still owns |data|.
+napi_value QueueWork(napi_env env, const char* name,
+                     napi_async_execute_callback execute,
+                     napi_async_complete_callback complete, void* data,
+                     napi_async_work* work, napi_deferred* deferred);
+
+// Rejects |deferred| with an Error carrying |message|.
+void RejectWithMessage(napi_env env, napi_deferred deferred,
+                       const std::string& message);
+
+// Per-module initializers, called from addon.cc.
+bool InitJsonlScanner(napi_env env, napi_value exports);
+bool InitMessageCounter(napi_env env, napi_value exports);
+
+#endif  // CODEAGENTHUB_NATIVE_ADDON_H_
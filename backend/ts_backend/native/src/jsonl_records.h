@@ -0,0 +1,104 @@
+#ifndef CODEAGENTHUB_NATIVE_JSONL_RECORDS_H_
+#define CODEAGENTHUB_NATIVE_JSONL_RECORDS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// How the backend splits JSONL transcripts: a record is a line that is not
+// blank once trimmed. Line breaks are found with memchr, which the C library
+// vectorizes.
+
+struct Range {
+  const char* begin;
+  const char* end;
+};
+
+// Returns the length of the whitespace character at |p| that
+// String.prototype.trim() removes, or 0.
+inline size_t SpaceAt(const char* p, const char* end) {
+  const auto* u = reinterpret_cast<const unsigned char*>(p);
+  const size_t left = end - p;
+  switch (u[0]) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\v':
+    case '\f':
+    case '\r':
+      return 1;
+    case 0xC2:  // U+00A0
+      return left >= 2 && u[1] == 0xA0 ? 2 : 0;
+    case 0xE1:  // U+1680
+      return left >= 3 && u[1] == 0x9A && u[2] == 0x80 ? 3 : 0;
+    case 0xE2:
+      if (left < 3) {
+        return 0;
+      }
+      if (u[1] == 0x80) {
+        // U+2000..U+200A, U+2028, U+2029, U+202F
+        return u[2] <= 0x8A || u[2] == 0xA8 || u[2] == 0xA9 || u[2] == 0xAF
+                   ? 3
+                   : 0;
+      }
+      return u[1] == 0x81 && u[2] == 0x9F ? 3 : 0;  // U+205F
+    case 0xE3:  // U+3000
+      return left >= 3 && u[1] == 0x80 && u[2] == 0x80 ? 3 : 0;
+    case 0xEF:  // U+FEFF, which also covers a byte order mark
+      return left >= 3 && u[1] == 0xBB && u[2] == 0xBF ? 3 : 0;
+    default:
+      return 0;
+  }
+}
+
+// Trims |line| in place; false if nothing is left.
+inline bool Trim(Range* line) {
+  while (line->begin < line->end) {
+    const size_t space = SpaceAt(line->begin, line->end);
+    if (space == 0) {
+      break;
+    }
+    line->begin += space;
+  }
+  while (line->begin < line->end) {
+    size_t space = 0;
+    for (size_t width = 1; width <= 3 && space == 0; ++width) {
+      if (static_cast<size_t>(line->end - line->begin) >= width &&
+          SpaceAt(line->end - width, line->end) == width) {
+        space = width;
+      }
+    }
+    if (space == 0) {
+      break;
+    }
+    line->end -= space;
+  }
+  return line->begin < line->end;
+}
+
+// Calls |visit| with every record of |data|, trimmed.
+template <typename Visit>
+void ForEachRecord(const char* data, size_t size, Visit visit) {
+  const char* position = data;
+  const char* const end = data + size;
+  while (position < end) {
+    const char* newline = static_cast<const char*>(
+        memchr(position, '\n', static_cast<size_t>(end - position)));
+    Range line = {position, newline != nullptr ? newline : end};
+    if (Trim(&line)) {
+      visit(line);
+    }
+    if (newline == nullptr) {
+      break;
+    }
+    position = newline + 1;
+  }
+}
+
+inline int64_t CountRecords(const char* data, size_t size) {
+  int64_t count = 0;
+  ForEachRecord(data, size, [&count](const Range&) { ++count; });
+  return count;
+}
+
+#endif  // CODEAGENTHUB_NATIVE_JSONL_RECORDS_H_
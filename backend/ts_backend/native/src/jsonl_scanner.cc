@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "addon.h"
+#include "jsonl_records.h"
+#include "mapped_file.h"
+
+// Record-level access to JSONL transcripts without reading them into a
+// JavaScript string. A record is a line that is not blank after trimming;
+// records come back trimmed, the way sessionStore.ts and
+// codexSessionStore.ts split files:
+//
+//   countJsonlRecords(path) -> Promise<number>
+//   readJsonlRecords(path, offset, limit)
+//       -> Promise<{ total: number, records: string[] }>
+//
+// A negative offset counts from the end and a negative limit means no limit.
+// The file is mapped and scanned on the libuv thread pool.
+
+namespace {
+
+struct ScanJob {
+  napi_async_work work = nullptr;
+  napi_deferred deferred = nullptr;
+  std::string path;
+  bool read_records = false;
+  int64_t offset = 0;
+  int64_t limit = -1;
+
+  // Filled in on the thread pool. The ranges point into |file|, which stays
+  // mapped until the strings have been created.
+  MappedFile file;
+  std::string error;
+  int64_t total = 0;
+  std::vector<Range> records;
+};
+
+void ExecuteScan(napi_env /*env*/, void* data) {
+  auto* job = static_cast<ScanJob*>(data);
+  if (!job->file.Open(job->path, &job->error)) {
+    return;
+  }
+  const char* bytes = job->file.data();
+  const size_t size = job->file.size();
+  if (!job->read_records) {
+    job->total = CountRecords(bytes, size);
+    return;
+  }
+
+  int64_t first = job->offset;
+  if (first < 0) {
+    first = std::max<int64_t>(CountRecords(bytes, size) + first, 0);
+  }
+  const int64_t last = job->limit < 0 ? std::numeric_limits<int64_t>::max()
+                                      : first + job->limit;
+  int64_t index = 0;
+  ForEachRecord(bytes, size, [&](const Range& line) {
+    if (index >= first && index < last) {
+      job->records.push_back(line);
+    }
+    ++index;
+  });
+  job->total = index;
+}
+
+napi_value MakeResult(napi_env env, ScanJob* job) {
+  napi_value total;
+  if (!NapiOk(env, napi_create_int64(env, job->total, &total))) {
+    return nullptr;
+  }
+  if (!job->read_records) {
+    return total;
+  }
+  napi_value records;
+  if (!NapiOk(env, napi_create_array_with_length(env, job->records.size(),
+                                                 &records))) {
+    return nullptr;
+  }
+  for (size_t i = 0; i < job->records.size(); ++i) {
+    const Range& line = job->records[i];
+    napi_value record;
+    if (!NapiOk(env, napi_create_string_utf8(
+                         env, line.begin,
+                         static_cast<size_t>(line.end - line.begin),
+                         &record)) ||
+        !NapiOk(env, napi_set_element(env, records,
+                                      static_cast<uint32_t>(i), record))) {
+      return nullptr;
+    }
+  }
+  napi_value result;
+  if (!NapiOk(env, napi_create_object(env, &result)) ||
+      !NapiOk(env, napi_set_named_property(env, result, "total", total)) ||
+      !NapiOk(env, napi_set_named_property(env, result, "records", records))) {
+    return nullptr;
+  }
+  return result;
+}
+
+void CompleteScan(napi_env env, napi_status status, void* data) {
+  std::unique_ptr<ScanJob> job(static_cast<ScanJob*>(data));
+  napi_delete_async_work(env, job->work);
+  if (status == napi_ok && job->error.empty()) {
+    napi_value result = MakeResult(env, job.get());
+    if (result != nullptr) {
+      napi_resolve_deferred(env, job->deferred, result);
+      return;
+    }
+    // Building the result threw; the promise rejects with that instead.
+    napi_value exception = nullptr;
+    napi_get_and_clear_last_exception(env, &exception);
+    napi_reject_deferred(env, job->deferred, exception);
+    return;
+  }
+  RejectWithMessage(env, job->deferred,
+                    job->error.empty() ? "scan cancelled" : job->error);
+}
+
+napi_value StartScan(napi_env env, ScanJob* job) {
+  napi_value promise = QueueWork(env, "codeagenthub:jsonl", ExecuteScan,
+                                 CompleteScan, job, &job->work,
+                                 &job->deferred);
+  if (promise == nullptr) {
+    delete job;
+  }
+  return promise;
+}
+
+napi_value CountJsonlRecords(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  if (!NapiOk(env, napi_get_cb_info(env, info, &argc, argv, nullptr,
+                                    nullptr))) {
+    return nullptr;
+  }
+  auto* job = new ScanJob();
+  if (!GetString(env, argv[0], "path", &job->path)) {
+    delete job;
+    return nullptr;
+  }
+  return StartScan(env, job);
+}
+
+napi_value ReadJsonlRecords(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  if (!NapiOk(env, napi_get_cb_info(env, info, &argc, argv, nullptr,
+                                    nullptr))) {
+    return nullptr;
+  }
+  auto* job = new ScanJob();
+  job->read_records = true;
+  if (!GetString(env, argv[0], "path", &job->path) ||
+      !GetInt64(env, argv[1], "offset", &job->offset) ||
+      !GetInt64(env, argv[2], "limit", &job->limit)) {
+    delete job;
+    return nullptr;
+  }
+  return StartScan(env, job);
+}
+
+}  // namespace
+
+bool InitJsonlScanner(napi_env env, napi_value exports) {
+  return ExportFunction(env, exports, "countJsonlRecords", CountJsonlRecords) &&
+         ExportFunction(env, exports, "readJsonlRecords", ReadJsonlRecords);
+}
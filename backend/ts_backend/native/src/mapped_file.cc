@@ -0,0 +1,115 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef _WIN32
+
+namespace {
+
+std::string LastErrorMessage() {
+  return "error " + std::to_string(GetLastError());
+}
+
+}  // namespace
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+}
+
+bool MappedFile::Open(const std::string& path, std::string* error) {
+  const int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1,
+                                         nullptr, 0);
+  std::wstring wide_path(length > 0 ? length : 1, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide_path[0], length);
+  HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE |
+                                FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    *error = path + ": " + LastErrorMessage();
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    *error = path + ": " + LastErrorMessage();
+    CloseHandle(file);
+    return false;
+  }
+  size_ = static_cast<size_t>(size.QuadPart);
+  if (size_ == 0) {
+    // Empty files cannot be mapped; there is nothing to read anyway.
+    CloseHandle(file);
+    return true;
+  }
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    *error = path + ": " + LastErrorMessage();
+    size_ = 0;
+    return false;
+  }
+  data_ = static_cast<const char*>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size_));
+  CloseHandle(mapping);
+  if (data_ == nullptr) {
+    *error = path + ": " + LastErrorMessage();
+    size_ = 0;
+    return false;
+  }
+  return true;
+}
+
+#else
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+bool MappedFile::Open(const std::string& path, std::string* error) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    *error = path + ": " + strerror(errno);
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    *error = path + ": " + strerror(errno);
+    close(fd);
+    return false;
+  }
+  size_ = static_cast<size_t>(info.st_size);
+  if (size_ == 0) {
+    // Empty files cannot be mapped; there is nothing to read anyway.
+    close(fd);
+    return true;
+  }
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    *error = path + ": " + strerror(errno);
+    size_ = 0;
+    return false;
+  }
+  // One front-to-back pass.
+  madvise(data, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(data);
+  return true;
+}
+
+#endif
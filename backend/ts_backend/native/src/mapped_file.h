@@ -0,0 +1,28 @@
+#ifndef CODEAGENTHUB_NATIVE_MAPPED_FILE_H_
+#define CODEAGENTHUB_NATIVE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+// A read-only memory mapping of a whole file. Transcripts are append-only,
+// so the mapped prefix stays valid while the CLI keeps writing.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps the file at the UTF-8 |path|. Returns false with |error| set.
+  bool Open(const std::string& path, std::string* error);
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+#endif  // CODEAGENTHUB_NATIVE_MAPPED_FILE_H_
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "addon.h"
+#include "jsonl_records.h"
+#include "mapped_file.h"
+
+// Record counts for the session listings that survive between requests:
+//
+//   countJsonlRecordsCached(paths) -> Promise<number[]>
+//
+// Each file's size and modification time are remembered with its count, so
+// an unchanged transcript costs one stat. When a transcript grows, only the
+// bytes after its last complete line are scanned. Files that cannot be read
+// count as 0, as they do in jsonl.ts.
+
+namespace {
+
+// Bytes before the resume point that must still match for a grown file to be
+// treated as the same file with more appended.
+const size_t kGuardBytes = 64;
+
+struct CountState {
+  int64_t size = 0;
+  int64_t mtime = 0;
+  // Just past the last line break scanned, and the records before it.
+  size_t complete_offset = 0;
+  int64_t complete_count = 0;
+  // Whether the unterminated last line, which the CLI may still be writing,
+  // is a record.
+  bool tail_is_record = false;
+  std::string guard;
+
+  int64_t count() const { return complete_count + (tail_is_record ? 1 : 0); }
+};
+
+std::mutex g_states_mutex;
+std::unordered_map<std::string, CountState>& States() {
+  static auto* states = new std::unordered_map<std::string, CountState>();
+  return *states;
+}
+
+void Forget(const std::string& path) {
+  std::lock_guard<std::mutex> lock(g_states_mutex);
+  States().erase(path);
+}
+
+// Scans |file| from where |state| stopped, or from the start if the file no
+// longer begins with what was scanned before.
+void Advance(const MappedFile& file, CountState* state) {
+  const char* data = file.data();
+  const size_t size = file.size();
+  const size_t resume = state->complete_offset;
+  const bool appended =
+      resume > 0 && resume <= size &&
+      memcmp(data + resume - state->guard.size(), state->guard.data(),
+             state->guard.size()) == 0;
+  const char* position = data;
+  int64_t count = 0;
+  if (appended) {
+    position += resume;
+    count = state->complete_count;
+  }
+
+  const char* const end = data + size;
+  while (position < end) {
+    const char* newline = static_cast<const char*>(
+        memchr(position, '\n', static_cast<size_t>(end - position)));
+    if (newline == nullptr) {
+      break;
+    }
+    Range line = {position, newline};
+    if (Trim(&line)) {
+      ++count;
+    }
+    position = newline + 1;
+  }
+  Range tail = {position, end};
+  state->tail_is_record = Trim(&tail);
+  state->complete_offset = static_cast<size_t>(position - data);
+  state->complete_count = count;
+  const size_t guard = std::min(state->complete_offset, kGuardBytes);
+  state->guard.assign(position - guard, guard);
+  state->size = static_cast<int64_t>(size);
+}
+
+int64_t CountFile(const std::string& path) {
+  std::error_code error;
+  const std::filesystem::path file_path = std::filesystem::u8path(path);
+  const auto size = std::filesystem::file_size(file_path, error);
+  if (error) {
+    Forget(path);
+    return 0;
+  }
+  const int64_t mtime = std::filesystem::last_write_time(file_path, error)
+                            .time_since_epoch()
+                            .count();
+  if (error) {
+    Forget(path);
+    return 0;
+  }
+
+  CountState state;
+  bool cached = false;
+  {
+    std::lock_guard<std::mutex> lock(g_states_mutex);
+    auto found = States().find(path);
+    if (found != States().end()) {
+      state = found->second;
+      cached = true;
+    }
+  }
+  if (cached && state.size == static_cast<int64_t>(size) &&
+      state.mtime == mtime) {
+    return state.count();
+  }
+
+  MappedFile file;
+  std::string open_error;
+  if (!file.Open(path, &open_error)) {
+    Forget(path);
+    return 0;
+  }
+  // A write between the stat and the mapping leaves an older mtime with the
+  // newer size; the next call then rescans from the resume point.
+  Advance(file, &state);
+  state.mtime = mtime;
+  {
+    std::lock_guard<std::mutex> lock(g_states_mutex);
+    States()[path] = state;
+  }
+  return state.count();
+}
+
+struct CountJob {
+  napi_async_work work = nullptr;
+  napi_deferred deferred = nullptr;
+  std::vector<std::string> paths;
+  std::vector<int64_t> counts;
+};
+
+void ExecuteCount(napi_env /*env*/, void* data) {
+  auto* job = static_cast<CountJob*>(data);
+  job->counts.reserve(job->paths.size());
+  for (const std::string& path : job->paths) {
+    job->counts.push_back(CountFile(path));
+  }
+}
+
+void CompleteCount(napi_env env, napi_status status, void* data) {
+  std::unique_ptr<CountJob> job(static_cast<CountJob*>(data));
+  napi_delete_async_work(env, job->work);
+  if (status != napi_ok) {
+    RejectWithMessage(env, job->deferred, "count cancelled");
+    return;
+  }
+  napi_value counts;
+  bool ok = NapiOk(env, napi_create_array_with_length(
+                            env, job->counts.size(), &counts));
+  for (size_t i = 0; ok && i < job->counts.size(); ++i) {
+    napi_value count;
+    ok = NapiOk(env, napi_create_int64(env, job->counts[i], &count)) &&
+         NapiOk(env, napi_set_element(env, counts, static_cast<uint32_t>(i),
+                                      count));
+  }
+  if (ok) {
+    napi_resolve_deferred(env, job->deferred, counts);
+    return;
+  }
+  napi_value exception = nullptr;
+  napi_get_and_clear_last_exception(env, &exception);
+  napi_reject_deferred(env, job->deferred, exception);
+}
+
+napi_value CountJsonlRecordsCached(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  if (!NapiOk(env, napi_get_cb_info(env, info, &argc, argv, nullptr,
+                                    nullptr))) {
+    return nullptr;
+  }
+  bool is_array = false;
+  uint32_t length = 0;
+  if (!NapiOk(env, napi_is_array(env, argv[0], &is_array))) {
+    return nullptr;
+  }
+  if (!is_array) {
+    napi_throw_type_error(env, nullptr, "paths must be an array");
+    return nullptr;
+  }
+  if (!NapiOk(env, napi_get_array_length(env, argv[0], &length))) {
+    return nullptr;
+  }
+
+  auto job = std::make_unique<CountJob>();
+  job->paths.resize(length);
+  for (uint32_t i = 0; i < length; ++i) {
+    napi_value path;
+    if (!NapiOk(env, napi_get_element(env, argv[0], i, &path)) ||
+        !GetString(env, path, "paths[i]", &job->paths[i])) {
+      return nullptr;
+    }
+  }
+  napi_value promise =
+      QueueWork(env, "codeagenthub:count", ExecuteCount, CompleteCount,
+                job.get(), &job->work, &job->deferred);
+  if (promise != nullptr) {
+    job.release();
+  }
+  return promise;
+}
+
+}  // namespace
+
+bool InitMessageCounter(napi_env env, napi_value exports) {
+  return ExportFunction(env, exports, "countJsonlRecordsCached",
+                        CountJsonlRecordsCached);
+}
@@ -23,6 +23,7 @@ import { initDb } from "./database";
 import {
   bootstrapSessionsFromFiles,
   fetchSession,
+  fetchSessionAsync,
   listSessionSummaries,
   listSessionSummariesAsync,
   persistSessionMetadata,
@@ -30,10 +31,13 @@ import {
 import {
   bootstrapCodexSessionsFromFiles,
   fetchCodexSession,
-  listCodexSessionSummaries,
+  fetchCodexSessionAsync,
+  listCodexSessionSummariesAsync,
   persistCodexSessionMetadata,
 } from "./codexSessionStore";
-import { AnyRecord, formatSse, logSdkMessage, serializeSdkMessage } from "./streaming";
+import { JsonlPage } from "./jsonl";
+import { AnyRecord, formatSdkMessageSse, formatSse, logSdkMessage } from "./streaming";
+import { TurnTrace, monotonicUs } from "./tracing";
 import {
   ChangePasswordRequest,
   ChangeUsernameRequest,
@@ -172,6 +176,24 @@ function ensureSameUser(req: Request, res: Response, userId: string): boolean {
   return true;
 }
 
+// Reads the optional `offset` (negative counts from the end) and `limit` query
+// parameters of the session detail routes; null if either is malformed.
+function parseMessagePage(query: Request["query"]): JsonlPage | null {
+  const page: JsonlPage = {};
+  for (const key of ["offset", "limit"] as const) {
+    const raw = query[key];
+    if (raw === undefined) {
+      continue;
+    }
+    const value = typeof raw === "string" && /^-?\d+$/.test(raw) ? Number(raw) : NaN;
+    if (!Number.isSafeInteger(value) || (key === "limit" && value < 0)) {
+      return null;
+    }
+    page[key] = value;
+  }
+  return page;
+}
+
 function normalizePermissionMode(value?: string): PermissionMode {
   if (!value) {
     return "default";
@@ -436,13 +458,22 @@ export function createApp(): express.Express {
     }
   });
 
-  app.get("/sessions/:sessionId", (req, res) => {
-    const session = fetchSession(req.params.sessionId, true);
-    if (!session) {
-      res.status(404).json({ detail: "Session not found" });
+  app.get("/sessions/:sessionId", async (req, res) => {
+    const page = parseMessagePage(req.query);
+    if (!page) {
+      res.status(400).json({ detail: "offset and limit must be integers, limit non-negative" });
       return;
     }
-    res.json(session);
+    try {
+      const session = await fetchSessionAsync(req.params.sessionId, page);
+      if (!session) {
+        res.status(404).json({ detail: "Session not found" });
+        return;
+      }
+      res.json(session);
+    } catch (error) {
+      res.status(500).json({ detail: error instanceof Error ? error.message : String(error) });
+    }
   });
 
   app.post("/sessions/load", (req, res) => {
@@ -582,17 +613,30 @@ export function createApp(): express.Express {
     }
   });
 
-  app.get("/codex/sessions", (_req, res) => {
-    res.json(listCodexSessionSummaries());
+  app.get("/codex/sessions", async (_req, res) => {
+    try {
+      res.json(await listCodexSessionSummariesAsync());
+    } catch (error) {
+      res.status(500).json({ detail: error instanceof Error ? error.message : String(error) });
+    }
   });
 
-  app.get("/codex/sessions/:sessionId", (req, res) => {
-    const session = fetchCodexSession(req.params.sessionId, true);
-    if (!session) {
-      res.status(404).json({ detail: "Session not found" });
+  app.get("/codex/sessions/:sessionId", async (req, res) => {
+    const page = parseMessagePage(req.query);
+    if (!page) {
+      res.status(400).json({ detail: "offset and limit must be integers, limit non-negative" });
       return;
     }
-    res.json(session);
+    try {
+      const session = await fetchCodexSessionAsync(req.params.sessionId, page);
+      if (!session) {
+        res.status(404).json({ detail: "Session not found" });
+        return;
+      }
+      res.json(session);
+    } catch (error) {
+      res.status(500).json({ detail: error instanceof Error ? error.message : String(error) });
+    }
   });
 
   app.post("/codex/sessions/load", (req, res) => {
@@ -647,6 +691,7 @@ export function createApp(): express.Express {
   });
 
   app.post("/chat", (req, res) => {
+    const receivedUs = monotonicUs();
     const body = req.body as ChatRequest | undefined;
     if (!body || !body.message) {
       res.status(400).json({ detail: "message is required" });
@@ -777,6 +822,7 @@ export function createApp(): express.Express {
 
     // Set up SSE response
     const runId = generateRunId();
+    const trace = TurnTrace.fromHeader(req.header("X-Turn-Trace"), receivedUs);
     res.setHeader("Content-Type", "text/event-stream");
     res.setHeader("Cache-Control", "no-cache");
     res.setHeader("Connection", "keep-alive");
@@ -784,6 +830,9 @@ export function createApp(): express.Express {
     if (typeof res.flushHeaders === "function") {
       res.flushHeaders();
     }
+    if (trace) {
+      trace.headersUs = monotonicUs();
+    }
 
     // Create message stream controller
     const streamController = new MessageStreamController();
@@ -816,9 +865,11 @@ export function createApp(): express.Express {
     req.on("aborted", cleanup);
     res.on("close", cleanup);
 
-    // Broadcast event to all connections
-    const broadcastEvent = (event: string, payload: AnyRecord) => {
-      const data = formatSse(event, payload);
+    // Broadcast a frame to all connections; it is formatted once for all of them
+    const writeFrame = (event: string, format: () => string) => {
+      const formatStart = trace ? monotonicUs() : 0;
+      const data = format();
+      const writeStart = trace ? monotonicUs() : 0;
       for (const connection of newActiveSession.connections) {
         if (!connection.writableEnded) {
           try {
@@ -829,6 +880,25 @@ export function createApp(): express.Express {
           }
         }
       }
+      if (trace) {
+        trace.span("sse.format", formatStart, writeStart, { event });
+        trace.span("sse.write", writeStart, monotonicUs(), {
+          event,
+          bytes: data.length,
+          connections: newActiveSession.connections.size,
+        });
+      }
+    };
+    const broadcastEvent = (event: string, payload: AnyRecord) => {
+      writeFrame(event, () => formatSse(event, payload));
+    };
+
+    // Sends the backend spans to the client; must precede the terminal event,
+    // after which the client stops reading.
+    const emitTrace = () => {
+      if (trace) {
+        broadcastEvent("trace", trace.toPayload());
+      }
     };
 
     const options = buildClaudeOptionsFromRequest({
@@ -875,16 +945,25 @@ export function createApp(): express.Express {
     (async () => {
       const assistantChunks: string[] = [];
       try {
+        trace?.span("backend.setup", receivedUs);
         const stream = query({
           prompt: streamController.stream(),
           options,
         });
 
+        let waitStart = trace ? monotonicUs() : 0;
         // eslint-disable-next-line no-restricted-syntax
         for await (const message of stream) {
-          const rawPayload = serializeSdkMessage(message);
-          if (rawPayload) {
-            logSdkMessage(message.type, rawPayload, "ClaudeSDK");
+          const handleStart = trace ? monotonicUs() : 0;
+          trace?.span("sdk.receive", waitStart, handleStart, { type: message.type });
+          logSdkMessage(message.type, message, "ClaudeSDK", { runId, sessionId });
+
+          // Everything sent for this message (session, token and message
+          // events) leaves in one write per connection. Connections that end
+          // before the uncork below flush on end().
+          const corked = [...newActiveSession.connections];
+          for (const connection of corked) {
+            connection.cork();
           }
 
           if (isSystemInitMessage(message)) {
@@ -994,21 +1073,25 @@ export function createApp(): express.Express {
             }
           }
 
-          if (rawPayload) {
-            const payloadSessionId = extractSessionIdFromPayload(rawPayload) ?? sessionId;
-            if (!sessionId && payloadSessionId) {
-              sessionId = payloadSessionId;
-              newActiveSession.sessionId = sessionId;
-              // Update session registration if needed
-              if (sessionKey !== sessionId) {
-                activeSessions.delete(sessionKey);
-                activeSessions.set(sessionId, newActiveSession);
-              }
+          const payloadSessionId = extractSessionIdFromPayload(message) ?? sessionId;
+          if (!sessionId && payloadSessionId) {
+            sessionId = payloadSessionId;
+            newActiveSession.sessionId = sessionId;
+            // Update session registration if needed
+            if (sessionKey !== sessionId) {
+              activeSessions.delete(sessionKey);
+              activeSessions.set(sessionId, newActiveSession);
             }
-            broadcastEvent("message", {
-              session_id: payloadSessionId,
-              payload: rawPayload,
-            });
+          }
+          writeFrame("message", () => formatSdkMessageSse(payloadSessionId, message));
+
+          for (const connection of corked) {
+            connection.uncork();
+          }
+
+          if (trace) {
+            waitStart = monotonicUs();
+            trace.span("sdk.handle", handleStart, waitStart, { type: message.type });
           }
         }
 
@@ -1025,6 +1108,7 @@ export function createApp(): express.Express {
           updated_at: now,
         });
 
+        emitTrace();
         broadcastEvent("done", {
           run_id: runId,
           session_id: sessionId,
@@ -1035,6 +1119,7 @@ export function createApp(): express.Express {
         const isAborted =
           (error instanceof Error && error.name === "AbortError") ||
           (error instanceof Error && error.message.toLowerCase().includes("abort"));
+        emitTrace();
         if (isAborted) {
           broadcastEvent("stopped", {
             run_id: runId,
@@ -1194,7 +1279,10 @@ export function createApp(): express.Express {
             break;
           }
 
-          logSdkMessage(event.type, event as AnyRecord, "CodexSDK");
+          logSdkMessage(event.type, event, "CodexSDK", { sessionId });
+          // The session, token and message events for one Codex event leave
+          // in one write; res.end() in the finally block flushes on errors.
+          res.cork();
 
           if (event.type === "thread.started") {
             if (!sessionId) {
@@ -1243,10 +1331,8 @@ export function createApp(): express.Express {
             }
           }
 
-          writeEvent("message", {
-            session_id: sessionId,
-            payload: event,
-          });
+          res.write(formatSdkMessageSse(sessionId, event));
+          res.uncork();
         }
 
         if (!sessionId) {
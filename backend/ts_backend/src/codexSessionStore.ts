@@ -3,6 +3,7 @@ import path from "path";
 
 import { CODEX_SESSIONS_DIR } from "./config";
 import { getDb } from "./database";
+import { JsonlPage, countJsonlRecordsCached, readJsonlRecords } from "./jsonl";
 import { Session, SessionSummary } from "./models";
 
 type AnyRecord = Record<string, any>;
@@ -301,6 +302,45 @@ export function fetchCodexSession(sessionId: string, includeMessages = true): Se
   };
 }
 
+/** Loads a session with one page of its messages and the total count. */
+export async function fetchCodexSessionAsync(
+  sessionId: string,
+  page: JsonlPage = {},
+): Promise<Session | null> {
+  const row = getDb()
+    .prepare(
+      "SELECT session_id, title, cwd, created_at, updated_at FROM codex_sessions WHERE session_id = ?",
+    )
+    .get(sessionId) as
+    | {
+        session_id: string;
+        title: string;
+        cwd: string;
+        created_at: string;
+        updated_at: string;
+      }
+    | undefined;
+
+  if (!row) {
+    return null;
+  }
+
+  const filePath = findSessionFile(row.session_id);
+  const { total, records } = filePath
+    ? await readJsonlRecords(filePath, page)
+    : { total: 0, records: [] };
+
+  return {
+    session_id: row.session_id,
+    title: row.title,
+    cwd: row.cwd,
+    created_at: new Date(row.created_at),
+    updated_at: new Date(row.updated_at),
+    messages: records,
+    message_count: total,
+  };
+}
+
 export function listCodexSessionSummaries(): SessionSummary[] {
   const rows = getDb()
     .prepare("SELECT session_id, title, cwd, created_at, updated_at FROM codex_sessions ORDER BY updated_at DESC")
@@ -322,6 +362,30 @@ export function listCodexSessionSummaries(): SessionSummary[] {
   }));
 }
 
+export async function listCodexSessionSummariesAsync(): Promise<SessionSummary[]> {
+  const rows = getDb()
+    .prepare("SELECT session_id, title, cwd, created_at, updated_at FROM codex_sessions ORDER BY updated_at DESC")
+    .all() as {
+    session_id: string;
+    title: string;
+    cwd: string;
+    created_at: string;
+    updated_at: string;
+  }[];
+
+  const filePaths = rows.map((row) => findSessionFile(row.session_id));
+  const counts = await countJsonlRecordsCached(filePaths.filter((filePath): filePath is string => !!filePath));
+  let next = 0;
+  return rows.map((row, index) => ({
+    session_id: row.session_id,
+    title: row.title,
+    cwd: row.cwd,
+    created_at: new Date(row.created_at),
+    updated_at: new Date(row.updated_at),
+    message_count: filePaths[index] ? counts[next++] : 0,
+  }));
+}
+
 export function bootstrapCodexSessionsFromFiles(dir?: string): { sessions: number } {
   const root = dir ? path.resolve(dir) : CODEX_SESSIONS_DIR;
   if (!fs.existsSync(root)) {
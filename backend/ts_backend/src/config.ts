@@ -63,7 +63,7 @@ function getBackendDir(): string {
   return __dirname;
 }
 
-const APP_ROOT = getBackendDir();
+export const APP_ROOT = getBackendDir();
 const PROJECT_ROOT = APP_ROOT;
 const CONFIG_PATH = path.join(APP_ROOT, "config.yaml");
 const DEFAULT_USER_CREDENTIALS: UserCredentials = { admin: "642531" };
@@ -0,0 +1,113 @@
+import { promises as fsPromises } from "fs";
+
+import { nativeAddon } from "./native";
+
+/**
+ * A window of records; a negative offset counts from the end and an omitted
+ * limit reads to the end.
+ */
+export interface JsonlPage {
+  offset?: number;
+  limit?: number;
+}
+
+export interface JsonlRecords {
+  /** Number of records in the whole file. */
+  total: number;
+  records: Record<string, unknown>[];
+}
+
+// A record is a line that is not blank once trimmed.
+function splitRecords(content: string): string[] {
+  const records: string[] = [];
+  for (const rawLine of content.split(/\r?\n/)) {
+    const line = rawLine.trim();
+    if (line) {
+      records.push(line);
+    }
+  }
+  return records;
+}
+
+/** Counts the records of a JSONL file; 0 if it cannot be read. */
+export async function countJsonlRecords(filePath: string): Promise<number> {
+  try {
+    if (nativeAddon) {
+      return await nativeAddon.countJsonlRecords(filePath);
+    }
+    return splitRecords(await fsPromises.readFile(filePath, "utf-8")).length;
+  } catch {
+    return 0;
+  }
+}
+
+// Counts from the last listing, keyed by path, for when the addon is missing.
+const cachedCounts = new Map<string, { size: number; mtimeMs: number; count: number }>();
+
+async function countRecordsCached(filePath: string): Promise<number> {
+  try {
+    const stat = await fsPromises.stat(filePath);
+    const cached = cachedCounts.get(filePath);
+    if (cached && cached.size === stat.size && cached.mtimeMs === stat.mtimeMs) {
+      return cached.count;
+    }
+    const count = splitRecords(await fsPromises.readFile(filePath, "utf-8")).length;
+    cachedCounts.set(filePath, { size: stat.size, mtimeMs: stat.mtimeMs, count });
+    return count;
+  } catch {
+    cachedCounts.delete(filePath);
+    return 0;
+  }
+}
+
+/**
+ * Counts the records of several JSONL files, remembering each file's size and
+ * modification time so unchanged files are not read again. The native
+ * counter also scans only what was appended to a file since the last call.
+ * Files that cannot be read count as 0.
+ */
+export async function countJsonlRecordsCached(filePaths: string[]): Promise<number[]> {
+  if (nativeAddon) {
+    try {
+      return await nativeAddon.countJsonlRecordsCached(filePaths);
+    } catch {
+      // Fall back to the TypeScript counter below
+    }
+  }
+  return Promise.all(filePaths.map(countRecordsCached));
+}
+
+/**
+ * Parses one page of records from a JSONL file, skipping malformed ones. The
+ * native scanner only turns the requested records into strings, so a page
+ * costs little more than counting the file. An unreadable file has no
+ * records.
+ */
+export async function readJsonlRecords(filePath: string, page: JsonlPage = {}): Promise<JsonlRecords> {
+  const offset = page.offset ?? 0;
+  const limit = page.limit ?? -1;
+  let total = 0;
+  let lines: string[] = [];
+  try {
+    if (nativeAddon) {
+      ({ total, records: lines } = await nativeAddon.readJsonlRecords(filePath, offset, limit));
+    } else {
+      const all = splitRecords(await fsPromises.readFile(filePath, "utf-8"));
+      const start = offset < 0 ? Math.max(all.length + offset, 0) : offset;
+      total = all.length;
+      lines = all.slice(start, limit < 0 ? undefined : start + limit);
+    }
+  } catch {
+    return { total: 0, records: [] };
+  }
+
+  const records: Record<string, unknown>[] = [];
+  for (const line of lines) {
+    try {
+      records.push(JSON.parse(line));
+    } catch {
+      // Skip malformed lines
+    }
+  }
+  return { total, records };
+}
@@ -43,6 +43,8 @@ export interface Session {
   created_at: Date;
   updated_at: Date;
   messages: Record<string, unknown>[];
+  /** Records in the whole transcript, when messages holds only a page of them. */
+  message_count?: number;
 }
 
 export interface SessionSummary {
@@ -0,0 +1,48 @@
+import fs from "fs";
+import path from "path";
+
+import { APP_ROOT } from "./config";
+
+/** Exports of native/ (codeagenthub_native.node); see native/src/addon.h. */
+export interface NativeAddon {
+  countJsonlRecords(filePath: string): Promise<number>;
+  countJsonlRecordsCached(filePaths: string[]): Promise<number[]>;
+  readJsonlRecords(
+    filePath: string,
+    offset: number,
+    limit: number,
+  ): Promise<{ total: number; records: string[] }>;
+}
+
+const ADDON_FILE = "codeagenthub_native.node";
+
+// The addon is optional: `npm run build:native` builds it next to the sources
+// and the release build copies it next to backend.js. Without it (or with
+// CODEAGENTHUB_DISABLE_NATIVE set) callers use their TypeScript paths.
+function loadNativeAddon(): NativeAddon | null {
+  if (process.env.CODEAGENTHUB_DISABLE_NATIVE) {
+    return null;
+  }
+  const candidates = [
+    path.join(APP_ROOT, ADDON_FILE),
+    path.join(APP_ROOT, "..", "native", "build", "Release", ADDON_FILE),
+  ];
+  for (const candidate of candidates) {
+    if (!fs.existsSync(candidate)) {
+      continue;
+    }
+    try {
+      // eslint-disable-next-line global-require, import/no-dynamic-require
+      const addon = require(candidate) as NativeAddon;
+      // eslint-disable-next-line no-console
+      console.log(`[Native] loaded ${candidate}`);
+      return addon;
+    } catch (error) {
+      // eslint-disable-next-line no-console
+      console.warn(`[Native] failed to load ${candidate}:`, error);
+    }
+  }
+  return null;
+}
+
+export const nativeAddon = loadNativeAddon();
@@ -1,9 +1,9 @@
 import fs from "fs";
-import { promises as fsPromises } from "fs";
 import path from "path";
 
 import { CLAUDE_PROJECTS_DIR, CLAUDE_ROOT } from "./config";
 import { getDb } from "./database";
+import { JsonlPage, countJsonlRecords, countJsonlRecordsCached, readJsonlRecords } from "./jsonl";
 import { Session, SessionFileMetadata, SessionSummary } from "./models";
 
 type AnyRecord = Record<string, unknown>;
@@ -177,17 +177,7 @@ export function countSessionMessages(cwd: string, sessionId: string): number {
 }
 
 export async function countSessionMessagesAsync(cwd: string, sessionId: string): Promise<number> {
-  const filePath = sessionFilePath(cwd, sessionId);
-
-  try {
-    await fsPromises.access(filePath);
-    const content = await fsPromises.readFile(filePath, "utf-8");
-    return content
-      .split(/\r?\n/)
-      .filter((line) => line.trim().length > 0).length;
-  } catch {
-    return 0;
-  }
+  return countJsonlRecords(sessionFilePath(cwd, sessionId));
 }
 
 function isAgentSessionFile(filePath: string): boolean {
@@ -377,6 +367,30 @@ export function fetchSession(sessionId: string, includeMessages = true): Session
   };
 }
 
+/** Loads a session with one page of its messages and the total count. */
+export async function fetchSessionAsync(sessionId: string, page: JsonlPage = {}): Promise<Session | null> {
+  const row = getDb()
+    .prepare(
+      "SELECT session_id, title, cwd, created_at, updated_at FROM sessions WHERE session_id = ?",
+    )
+    .get(sessionId) as Record<string, string> | undefined;
+
+  if (!row) {
+    return null;
+  }
+
+  const { total, records } = await readJsonlRecords(sessionFilePath(row.cwd, row.session_id), page);
+  return {
+    session_id: row.session_id,
+    title: row.title,
+    cwd: row.cwd,
+    created_at: strToDate(row.created_at),
+    updated_at: strToDate(row.updated_at),
+    messages: records,
+    message_count: total,
+  };
+}
+
 export function listSessionSummaries(): SessionSummary[] {
   const rows = getDb()
     .prepare(
@@ -401,16 +415,15 @@ export async function listSessionSummariesAsync(): Promise<SessionSummary[]> {
     )
     .all() as Record<string, string>[];
 
-  const summariesPromises = rows.map(async (row) => ({
+  const counts = await countJsonlRecordsCached(rows.map((row) => sessionFilePath(row.cwd, row.session_id)));
+  return rows.map((row, index) => ({
     session_id: row.session_id,
     title: row.title,
     cwd: row.cwd,
     created_at: strToDate(row.created_at),
     updated_at: strToDate(row.updated_at),
-    message_count: await countSessionMessagesAsync(row.cwd, row.session_id),
+    message_count: counts[index],
   }));
-
-  return Promise.all(summariesPromises);
 }
 
 export function persistSessionMetadata(params: {
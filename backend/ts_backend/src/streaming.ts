@@ -1,5 +1,3 @@
-import type { SDKMessage } from "@anthropic-ai/claude-agent-sdk";
-
 import { ENABLE_VERBOSE_LOGS } from "./config";
 
 export type AnyRecord = Record<string, unknown>;
@@ -37,31 +35,102 @@ function jsonify(value: unknown): unknown {
   return String(value);
 }
 
-export function serializeSdkMessage(message: SDKMessage): AnyRecord | null {
-  const payload = jsonify(message);
-  if (isPlainObject(payload)) {
-    return payload;
+// True if JSON.stringify(value) already gives what JSON.stringify(jsonify(value))
+// would: only plain objects and arrays, no toJSON, and nothing that jsonify
+// turns into null or a string.
+function isJsonValue(value: unknown): boolean {
+  switch (typeof value) {
+    case "string":
+    case "number":
+    case "boolean":
+      return true;
+    case "object": {
+      if (value === null) {
+        return true;
+      }
+      if (Array.isArray(value)) {
+        if (Object.getPrototypeOf(value) !== Array.prototype) {
+          return false;
+        }
+        // undefined elements and holes come out as null either way.
+        for (let i = 0; i < value.length; i += 1) {
+          const item: unknown = value[i];
+          if (item !== undefined && !isJsonValue(item)) {
+            return false;
+          }
+        }
+        return true;
+      }
+      const prototype = Object.getPrototypeOf(value);
+      if (prototype !== Object.prototype && prototype !== null) {
+        return false;
+      }
+      const record = value as AnyRecord;
+      // eslint-disable-next-line no-restricted-syntax
+      for (const key in record) {
+        const item = record[key];
+        if (item === undefined || !isJsonValue(item)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+/**
+ * Formats the `message` event for an SDK message. SDK messages are nearly
+ * always plain JSON already, so they are stringified as they are and the
+ * jsonify copy is only made for the rest; the output is the same either way.
+ */
+export function formatSdkMessageSse(sessionId: string | null, message: unknown): string {
+  if (isPlainObject(message) && isJsonValue(message)) {
+    return formatSse("message", { session_id: sessionId, payload: message });
   }
-  return null;
+  const payload = jsonify(message);
+  return formatSse("message", {
+    session_id: sessionId,
+    payload: isPlainObject(payload) ? payload : null,
+  });
+}
+
+/**
+ * Run and session a logged SDK message belongs to. They are written into the
+ * record header (`[ClaudeSDK:assistant run=... session=...]`) so that the
+ * desktop runner's log ingestion can index records without reading payloads.
+ */
+export interface SdkLogContext {
+  runId?: string | null;
+  sessionId?: string | null;
 }
 
 export function logSdkMessage(
   label: string,
-  payload: AnyRecord | null,
+  message: unknown,
   source = "ClaudeSDK",
+  context: SdkLogContext = {},
 ): void {
   if (!ENABLE_VERBOSE_LOGS) {
     return;
   }
+  let header = `[${source}:${label}`;
+  if (context.runId) {
+    header += ` run=${context.runId}`;
+  }
+  if (context.sessionId) {
+    header += ` session=${context.sessionId}`;
+  }
+  header += "]";
+  const payload = jsonify(message);
   try {
     // eslint-disable-next-line no-console
     console.log(
-      `[${source}:${label}]\n${
-        payload ? JSON.stringify(payload, null, 2) : "<empty>"
-      }\n`,
+      `${header}\n${payload ? JSON.stringify(payload, null, 2) : "<empty>"}\n`,
     );
   } catch {
     // eslint-disable-next-line no-console
-    console.log(`[${source}:${label}]\n${String(payload)}\n`);
+    console.log(`${header}\n${String(payload)}\n`);
   }
 }
@@ -0,0 +1,69 @@
+import type { AnyRecord } from "./streaming";
+
+// Spans beyond this are counted but not kept, so a very long turn cannot grow
+// the trace without bound.
+const MAX_TRACE_SPANS = 20000;
+
+export interface TraceSpan {
+  name: string;
+  ts: number;
+  dur: number;
+  args?: AnyRecord;
+}
+
+/** Monotonic clock in microseconds (CLOCK_MONOTONIC on Linux). */
+export function monotonicUs(): number {
+  return Number(process.hrtime.bigint() / 1000n);
+}
+
+/**
+ * Backend half of a turn trace. The client sends `X-Turn-Trace: <id> <sent_us>`
+ * with the chat request, `sent_us` being its own monotonic clock; the backend
+ * records its spans on its clock and sends them back as a `trace` SSE event
+ * before the turn ends. The request receipt and header flush times let the
+ * client estimate the offset between the two clocks the way NTP does.
+ */
+export class TurnTrace {
+  readonly id: string;
+  readonly clientSentUs: number;
+  readonly receivedUs: number;
+  headersUs = 0;
+  private readonly spans: TraceSpan[] = [];
+  private dropped = 0;
+
+  private constructor(id: string, clientSentUs: number, receivedUs: number) {
+    this.id = id;
+    this.clientSentUs = clientSentUs;
+    this.receivedUs = receivedUs;
+  }
+
+  /** Returns null unless the request carries a trace context header. */
+  static fromHeader(header: string | undefined, receivedUs: number): TurnTrace | null {
+    const [id, sent] = (header ?? "").trim().split(/\s+/);
+    if (!id) {
+      return null;
+    }
+    const clientSentUs = Number(sent);
+    return new TurnTrace(id, Number.isFinite(clientSentUs) ? clientSentUs : 0, receivedUs);
+  }
+
+  span(name: string, startUs: number, endUs = monotonicUs(), args?: AnyRecord): void {
+    if (this.spans.length >= MAX_TRACE_SPANS) {
+      this.dropped += 1;
+      return;
+    }
+    this.spans.push({ name, ts: startUs, dur: Math.max(endUs - startUs, 0), args });
+  }
+
+  toPayload(): AnyRecord {
+    this.span("backend.turn", this.receivedUs);
+    return {
+      trace_id: this.id,
+      client_sent_us: this.clientSentUs,
+      received_us: this.receivedUs,
+      headers_us: this.headersUs,
+      spans: this.spans,
+      dropped: this.dropped,
+    };
+  }
+}
@@ -0,0 +1,78 @@
+import 'dart:math' as math;
+
+import 'package:flutter/scheduler.dart';
+import 'package:flutter/widgets.dart';
+
+/// 流式输出时让列表贴住底部
+///
+/// 内容变化时调用 [contentChanged]；之后每帧（由 Flutter 帧时钟驱动）按
+/// 当前与底部的距离算出一个平滑的目标位置，只做一次 jumpTo。相比每次
+/// 部分消息都延迟启动一段 animateTo，快速流式时不会有互相打断的动画和
+/// 多余的布局。用户拖动或 [shouldFollow] 返回 false 时不滚动。
+class FollowTailController {
+  final ScrollController scrollController;
+  final bool Function() shouldFollow;
+
+  /// 平滑时间常数：约 3 倍时间内追上 95% 的距离
+  static const Duration _timeConstant = Duration(milliseconds: 60);
+
+  /// 贴底后继续等待内容增长的时间（覆盖节流的界面更新）
+  static const Duration _settleTime = Duration(milliseconds: 250);
+
+  late final Ticker _ticker;
+  Duration _lastTick = Duration.zero;
+  Duration _settledSince = Duration.zero;
+  bool _settled = false;
+
+  FollowTailController({
+    required this.scrollController,
+    required TickerProvider vsync,
+    required this.shouldFollow,
+  }) {
+    _ticker = vsync.createTicker(_onTick);
+  }
+
+  /// 内容有变化（新消息、部分消息更新），开始跟随到底部
+  void contentChanged() {
+    if (!shouldFollow()) return;
+    _settled = false;
+    if (!_ticker.isActive) {
+      _lastTick = Duration.zero;
+      _ticker.start();
+    }
+  }
+
+  void _onTick(Duration elapsed) {
+    final dt = elapsed - _lastTick;
+    _lastTick = elapsed;
+    if (!scrollController.hasClients || !shouldFollow()) {
+      _ticker.stop();
+      return;
+    }
+
+    final position = scrollController.position;
+    // 用户正在拖动或惯性滚动
+    if (position.isScrollingNotifier.value) return;
+
+    final gap = position.maxScrollExtent - position.pixels;
+    if (gap <= 0.5) {
+      if (!_settled) {
+        _settled = true;
+        _settledSince = elapsed;
+      } else if (elapsed - _settledSince >= _settleTime) {
+        _ticker.stop();
+      }
+      return;
+    }
+    _settled = false;
+
+    // 与帧率无关的指数逼近；最后一两个像素直接到位
+    final fraction = 1 - math.exp(-dt.inMicroseconds / _timeConstant.inMicroseconds);
+    final step = gap <= 2 ? gap : math.max(gap * fraction, 1.0);
+    position.jumpTo(position.pixels + step);
+  }
+
+  void dispose() {
+    _ticker.dispose();
+  }
+}
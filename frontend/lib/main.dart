@@ -7,15 +7,19 @@ import 'core/theme/app_theme.dart';
 import 'config/app_config.dart';
 import 'screens/tab_manager_screen.dart';
 import 'screens/auth/login_screen.dart';
+import 'widgets/frame_pacing_overlay.dart';
 import 'services/api_service.dart';
 import 'services/codex_api_service.dart';
 import 'services/auth_service.dart';
 import 'services/config_service.dart';
 import 'services/app_settings_service.dart';
+import 'services/settings_snapshot.dart';
 import 'services/single_instance_service.dart';
 import 'services/windows_registry_service.dart';
 import 'services/backend_process_service.dart';
 import 'services/shared_project_data_service.dart';
+import 'services/soak_runner.dart';
+import 'services/soak_service.dart';
 import 'repositories/api_project_repository.dart';
 import 'repositories/api_codex_repository.dart';
 import 'core/constants/colors.dart';
@@ -28,6 +32,12 @@ BackendProcessService? _backendProcessService;
 void main(List<String> args) async {
   WidgetsFlutterBinding.ensureInitialized();
 
+  // Linux 浸泡测试模式：回放录制的对话并采样内存，生成报告后退出
+  final soakConfig = await SoakService.getInstance().getConfig();
+  if (soakConfig != null) {
+    exit(await runSoak(soakConfig));
+  }
+
   // 只在桌面平台初始化 window_manager
   if (!kIsWeb && (Platform.isWindows || Platform.isLinux || Platform.isMacOS)) {
     await windowManager.ensureInitialized();
@@ -315,6 +325,9 @@ class _MyAppState extends State<MyApp> with WindowListener {
     // 移除设置服务监听器
     _settingsService.removeListener(_onSettingsChanged);
 
+    // 设置快照在后台写盘，exit(0) 前立即写入
+    SettingsSnapshot.getInstance().flush();
+
     // 移除窗口关闭监听器
     if (!kIsWeb && (Platform.isWindows || Platform.isLinux || Platform.isMacOS)) {
       windowManager.removeListener(this);
@@ -698,12 +711,20 @@ class _MyAppState extends State<MyApp> with WindowListener {
       navigatorKey: _navigatorKey, // 添加导航键以便在 MaterialApp 上下文中显示对话框
       builder: (context, child) {
         // 应用全局字号缩放
-        return MediaQuery(
+        final scaled = MediaQuery(
           data: MediaQuery.of(context).copyWith(
             textScaleFactor: _settingsService.fontSize.scale,
           ),
           child: child!,
         );
+        if (!_settingsService.showFramePacing) return scaled;
+        return Stack(
+          fit: StackFit.expand,
+          children: [
+            scaled,
+            const FramePacingOverlay(),
+          ],
+        );
       },
       home: _isInitializing
           ? _buildLoadingScreen()
@@ -6,6 +6,10 @@ import '../models/message.dart';
 import '../models/session_settings.dart';
 import '../models/codex_user_settings.dart';
 import '../services/codex_api_service.dart';
+import '../services/project_index_service.dart';
+import '../services/stream_normalizer_service.dart';
+import '../services/timestamp_kernel.dart';
+import 'normalized_message_stream.dart';
 import 'codex_repository.dart';
 
 // Helper class to track message building state
@@ -19,6 +23,10 @@ class _CodexMessageBuildState {
 
 class ApiCodexRepository implements CodexRepository {
   final CodexApiService _apiService;
+  final ProjectIndexService _projectIndex = ProjectIndexService.getInstance();
+
+  // 逐个项目加载会话等连续查询在这段时间内复用同一份索引
+  static const Duration _projectIndexMaxAge = Duration(seconds: 5);
 
   ApiCodexRepository(this._apiService);
 
@@ -46,7 +54,13 @@ class ApiCodexRepository implements CodexRepository {
 
     final result = <Message>[];
 
-    for (var m in messages) {
+    // 整列时间戳一次解析（Linux 上由 runner 原生解析）
+    final timestamps = TimestampKernel.getInstance().parseColumn([
+      for (final m in messages) m['timestamp'] is String ? m['timestamp'] as String : null,
+    ]);
+
+    for (var i = 0; i < messages.length; i++) {
+      final m = messages[i];
       // Codex format: {type: "response_item", payload: {type: "message", role: "user", content: [...]}}
       final messageType = m['type'];
 
@@ -67,15 +81,8 @@ class ApiCodexRepository implements CodexRepository {
       if (roleStr != 'user' && roleStr != 'assistant') continue;
 
       // Get timestamp from top level
-      final timestampStr = m['timestamp'];
-      if (timestampStr == null) continue;
-
-      DateTime timestamp;
-      try {
-        timestamp = DateTime.parse(timestampStr);
-      } catch (e) {
-        continue; // Skip invalid timestamps
-      }
+      final timestamp = timestamps[i];
+      if (timestamp == null) continue; // Skip missing or invalid timestamps
 
       // Parse content blocks from payload
       final contentBlocks = _parseContentBlocks(payload['content']);
@@ -243,6 +250,41 @@ class ApiCodexRepository implements CodexRepository {
     const tokenEmitInterval = Duration(milliseconds: 100); // 节流间隔：100ms
     bool finalMessageEmitted = false; // 标记是否已发送最终消息，避免重复发送
 
+    // Linux：原生规范化器直接消费原始响应体；其他平台使用下面的 Dart 状态机
+    if (StreamNormalizerService.getInstance().isPlatformSupported) {
+      final events = normalizeMessageStream(
+        _apiService.chatBytes(
+          sessionId: sessionId,
+          message: content,
+          cwd: cwd,
+          settings: settings,
+          approvalPolicy: codexSettings?.approvalPolicy,
+          sandboxMode: codexSettings?.sandboxMode,
+          model: codexSettings?.model,
+          modelReasoningEffort: codexSettings?.modelReasoningEffort,
+          networkAccessEnabled: codexSettings?.networkAccessEnabled,
+          webSearchEnabled: codexSettings?.webSearchEnabled,
+          skipGitRepoCheck: codexSettings?.skipGitRepoCheck,
+        ),
+        schema: 'codex',
+        messageId: fixedMessageId,
+        sessionId: sessionId,
+        prompt: [{'type': 'text', 'text': content}],
+      );
+      await for (final event in events) {
+        if (event.runId != null) continue;
+        yield CodexMessageStreamEvent(
+          partialMessage: event.partialMessage,
+          finalMessage: event.finalMessage,
+          stats: event.stats,
+          error: event.error,
+          isDone: event.isDone,
+          sessionId: event.sessionId,
+        );
+      }
+      return;
+    }
+
     try {
       await for (var event in _apiService.chat(
         sessionId: sessionId,
@@ -644,6 +686,11 @@ class ApiCodexRepository implements CodexRepository {
   // 项目管理：从 sessions 按 cwd 分组创建虚拟项目
   @override
   Future<List<Project>> getProjects() async {
+    if (await _projectIndex.refresh('codex', _apiService.getSessionsJson)) {
+      final projects = await _projectIndex.projects('codex');
+      if (projects != null) return projects;
+    }
+
     final sessions = await _apiService.getSessions();
 
     // Group sessions by cwd to create projects
@@ -698,6 +745,11 @@ class ApiCodexRepository implements CodexRepository {
 
   @override
   Future<Project> getProject(String id) async {
+    if (await _projectIndex.refresh('codex', _apiService.getSessionsJson, maxAge: _projectIndexMaxAge)) {
+      final project = await _projectIndex.project('codex', id);
+      if (project != null) return project;
+    }
+
     final projects = await getProjects();
     return projects.firstWhere(
       (p) => p.id == id,
@@ -707,6 +759,11 @@ class ApiCodexRepository implements CodexRepository {
 
   @override
   Future<List<Session>> getProjectSessions(String projectId) async {
+    if (await _projectIndex.refresh('codex', _apiService.getSessionsJson, maxAge: _projectIndexMaxAge)) {
+      final sessions = await _projectIndex.projectSessions('codex', projectId);
+      if (sessions != null) return sessions;
+    }
+
     final allSessions = await _apiService.getSessions();
 
     // Filter sessions by cwd (projectId is the cwd)
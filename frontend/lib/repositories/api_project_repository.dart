@@ -2,10 +2,15 @@ import '../models/project.dart';
 import '../models/session.dart';
 import '../models/user_settings.dart';
 import '../services/api_service.dart';
+import '../services/project_index_service.dart';
 import 'project_repository.dart';
 
 class ApiProjectRepository implements ProjectRepository {
   final ApiService _apiService;
+  final ProjectIndexService _projectIndex = ProjectIndexService.getInstance();
+
+  // 逐个项目加载会话等连续查询在这段时间内复用同一份索引
+  static const Duration _projectIndexMaxAge = Duration(seconds: 5);
 
   ApiProjectRepository(this._apiService);
 
@@ -14,6 +19,11 @@ class ApiProjectRepository implements ProjectRepository {
 
   @override
   Future<List<Project>> getProjects() async {
+    if (await _projectIndex.refresh('claude', _apiService.getSessionsJson)) {
+      final projects = await _projectIndex.projects('claude');
+      if (projects != null) return projects;
+    }
+
     final sessions = await _apiService.getSessions();
 
     // Group sessions by cwd to create projects
@@ -70,6 +80,11 @@ class ApiProjectRepository implements ProjectRepository {
 
   @override
   Future<Project> getProject(String id) async {
+    if (await _projectIndex.refresh('claude', _apiService.getSessionsJson, maxAge: _projectIndexMaxAge)) {
+      final project = await _projectIndex.project('claude', id);
+      if (project != null) return project;
+    }
+
     final projects = await getProjects();
     return projects.firstWhere(
       (p) => p.id == id,
@@ -79,6 +94,11 @@ class ApiProjectRepository implements ProjectRepository {
 
   @override
   Future<List<Session>> getProjectSessions(String projectId) async {
+    if (await _projectIndex.refresh('claude', _apiService.getSessionsJson, maxAge: _projectIndexMaxAge)) {
+      final sessions = await _projectIndex.projectSessions('claude', projectId);
+      if (sessions != null) return sessions;
+    }
+
     final allSessions = await _apiService.getSessions();
 
     // Filter sessions by cwd (projectId is the cwd)
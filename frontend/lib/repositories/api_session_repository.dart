@@ -5,6 +5,11 @@ import '../models/message.dart';
 import '../models/session_settings.dart';
 import '../models/user_settings.dart';
 import '../services/api_service.dart';
+import '../services/stream_normalizer_service.dart';
+import '../services/timestamp_kernel.dart';
+import '../services/transcript_cache_service.dart';
+import '../services/turn_trace_service.dart';
+import 'normalized_message_stream.dart';
 import 'session_repository.dart';
 
 // Message streaming state machine
@@ -21,6 +26,7 @@ class _MessageBuildState {
   final contentBlockTypes = <int, String>{};
   final textBlocksBuilder = <int, StringBuffer>{};
   final toolUseBlocks = <int, Map<String, dynamic>>{};
+  final toolInputJson = <int, StringBuffer>{}; // 累积的 input_json_delta（结束时整体解析）
   final finalizedBlocks = <int>{}; // Track which blocks are finalized
   bool finalized = false;
 }
@@ -47,12 +53,35 @@ class ApiSessionRepository implements SessionRepository {
 
   @override
   Future<List<Message>> getSessionMessages(String sessionId) async {
-    final data = await _apiService.getSession(sessionId);
-    final messages = data['messages'] as List;
+    final cache = TranscriptCacheService.getInstance();
+    final List messages;
+    try {
+      final data = await _apiService.getSession(sessionId);
+      messages = data['messages'] as List;
+    } catch (e) {
+      // 后端不可用时回退到缓存（离线查看）；解码和消息构建在后台 isolate 完成
+      final cached = await cache.readRecordsInBackground(sessionId, messagesFromRecords);
+      if (cached == null) rethrow;
+      print('DEBUG: Backend unavailable, showing cached transcript for $sessionId');
+      return cached;
+    }
+    cache.syncRecords(sessionId, messages.cast<Map<String, dynamic>>());
+    return messagesFromRecords(sessionId, messages);
+  }
 
+  /// 将会话原始记录转换为消息列表
+  ///
+  /// 静态且不依赖仓库状态，可以在后台 isolate 中运行
+  static List<Message> messagesFromRecords(String sessionId, List messages) {
     final result = <Message>[];
 
-    for (var m in messages) {
+    // 整列时间戳一次解析（Linux 上由 runner 原生解析）
+    final timestamps = TimestampKernel.getInstance().parseColumn([
+      for (final m in messages) m['timestamp'] is String ? m['timestamp'] as String : null,
+    ]);
+
+    for (var i = 0; i < messages.length; i++) {
+      final m = messages[i];
       // Skip queue-operation and other non-message types
       final messageType = m['type'];
       if (messageType == null || messageType == 'queue-operation') continue;
@@ -69,15 +98,8 @@ class ApiSessionRepository implements SessionRepository {
       if (roleStr == null || roleStr != messageType) continue;
 
       // Get timestamp from top level
-      final timestampStr = m['timestamp'];
-      if (timestampStr == null) continue;
-
-      DateTime timestamp;
-      try {
-        timestamp = DateTime.parse(timestampStr);
-      } catch (e) {
-        continue; // Skip invalid timestamps
-      }
+      final timestamp = timestamps[i];
+      if (timestamp == null) continue; // Skip missing or invalid timestamps
 
       // Parse content blocks
       final contentBlocks = _parseContentBlocks(message['content']);
@@ -107,7 +129,7 @@ class ApiSessionRepository implements SessionRepository {
     return result;
   }
 
-  List<ContentBlock> _parseContentBlocks(dynamic content) {
+  static List<ContentBlock> _parseContentBlocks(dynamic content) {
     final blocks = <ContentBlock>[];
 
     if (content == null) {
@@ -294,6 +316,32 @@ class ApiSessionRepository implements SessionRepository {
       throw ArgumentError('Either content or contentBlocks must be provided');
     }
 
+    // Linux：原生规范化器直接消费原始响应体；其他平台使用下面的 Dart 状态机
+    if (StreamNormalizerService.getInstance().isPlatformSupported) {
+      final tracing = TurnTraceService.getInstance();
+      final trace = await tracing.begin('claude');
+      try {
+        yield* normalizeMessageStream(
+          _apiService.chatBytes(
+            sessionId: sessionId,
+            message: messageContent,
+            cwd: cwd,
+            settings: settings,
+            trace: trace,
+          ),
+          schema: 'claude',
+          sessionId: sessionId,
+          prompt: messageContent is String ? [{'type': 'text', 'text': messageContent}] : messageContent as List,
+          trace: trace,
+        );
+      } finally {
+        if (trace != null) {
+          tracing.finish(trace);
+        }
+      }
+      return;
+    }
+
     // Track multiple messages by their message IDs (for multi-turn)
     final messageStates = <String, _MessageBuildState>{}; // message.id -> build state
     String? currentMessageId;
@@ -486,6 +534,7 @@ class ApiSessionRepository implements SessionRepository {
                   'name': contentBlock['name'],
                   'input': {},
                 };
+                state.toolInputJson[index] = StringBuffer();
               } else if (blockType == 'tool_result') {
                 // 处理工具结果块 - tool_result 通常不会出现在 stream_event 中
                 // 它们通常通过 message 事件（type='user'）发送
@@ -533,8 +582,7 @@ class ApiSessionRepository implements SessionRepository {
                 final jsonDelta = delta['partial_json'] as String?;
                 if (jsonDelta != null && state.toolUseBlocks.containsKey(index)) {
                   // Accumulate JSON for tool input
-                  state.toolUseBlocks[index]!['input_json'] =
-                      (state.toolUseBlocks[index]!['input_json'] ?? '') + jsonDelta;
+                  state.toolInputJson.putIfAbsent(index, () => StringBuffer()).write(jsonDelta);
                 }
               }
             }
@@ -567,7 +615,7 @@ class ApiSessionRepository implements SessionRepository {
 
               // For tool_use blocks, parse the accumulated JSON
               if (state.toolUseBlocks.containsKey(index)) {
-                final inputJson = state.toolUseBlocks[index]!['input_json'] as String?;
+                final inputJson = state.toolInputJson.remove(index)?.toString();
                 if (inputJson != null && inputJson.isNotEmpty) {
                   try {
                     final decoded = json.decode(inputJson);
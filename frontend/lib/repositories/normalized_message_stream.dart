@@ -0,0 +1,304 @@
+import 'dart:async';
+import 'dart:math';
+
+import '../models/message.dart';
+import '../services/partial_json_service.dart';
+import '../services/power_policy_service.dart';
+import '../services/stream_normalizer_service.dart';
+import '../services/stream_quality_service.dart';
+import '../services/turn_trace_service.dart';
+import 'session_repository.dart';
+
+// 单条流式消息的构建状态（由原生增量驱动）
+class _NormalizedMessageBuilder {
+  final contentBlockTypes = <int, String>{};
+  final textBlocksBuilder = <int, StringBuffer>{};
+  final toolUseBlocks = <int, Map<String, dynamic>>{};
+  final toolInputs = <int, PartialJsonValue>{};
+  final finalizedBlocks = <int>{};
+
+  List<ContentBlock> buildBlocks() {
+    final blocks = <ContentBlock>[];
+    final sortedIndices = contentBlockTypes.keys.toList()..sort();
+
+    for (final index in sortedIndices) {
+      final blockType = contentBlockTypes[index];
+
+      if (blockType == 'text' && textBlocksBuilder.containsKey(index)) {
+        final text = textBlocksBuilder[index]!.toString();
+        if (text.isNotEmpty) {
+          blocks.add(ContentBlock(type: ContentBlockType.text, text: text));
+        }
+      } else if (blockType == 'tool_use' && toolUseBlocks.containsKey(index)) {
+        final toolBlock = toolUseBlocks[index]!;
+        final input = toolBlock['input'] as Map<String, dynamic>;
+        blocks.add(ContentBlock(
+          type: ContentBlockType.toolUse,
+          id: toolBlock['id'] as String?,
+          name: toolBlock['name'] as String?,
+          // 流式中的输入仍在变化，发出快照
+          input: finalizedBlocks.contains(index) ? input : Map<String, dynamic>.from(input),
+        ));
+      }
+    }
+
+    return blocks;
+  }
+}
+
+/// 把原生增量组装为 [MessageStreamEvent]
+///
+/// 聊天响应流和标签页重新接入运行中的会话（见 RunJournalService）共用。
+/// [stopAtDone] 为 true 时 done 增量产生 isDone 并置 [finished]。
+class MessageDeltaApplier {
+  final bool stopAtDone;
+  final _builders = <String, _NormalizedMessageBuilder>{};
+  final _dirty = <String>{}; // 本批次有变化、尚未发出部分消息的消息
+  final _powerPolicy = PowerPolicyService.getInstance();
+  final _streamQuality = StreamQualityService.getInstance();
+  final _sinceLastPartial = Stopwatch()..start();
+
+  /// 已遇到 done/error
+  bool finished = false;
+
+  MessageDeltaApplier({required this.stopAtDone});
+
+  // 使用电池或界面跟不上时合并相邻批次的部分消息更新
+  int get _coalesceMs => max(_powerPolicy.current.streamCoalesceMs, _streamQuality.current.streamCoalesceMs);
+
+  /// 距离被合并暂缓的部分消息应当发出还剩多久；没有暂缓的部分消息时为 null
+  ///
+  /// 流暂停时不会再有批次触发发出，调用方在到期后调用 [flushPartials]，
+  /// 否则最后一段文字会一直不显示。
+  Duration? get flushDelay {
+    if (_dirty.isEmpty) return null;
+    return Duration(milliseconds: max(_coalesceMs - _sinceLastPartial.elapsedMilliseconds, 0));
+  }
+
+  /// 发出有变化的消息的部分消息
+  Iterable<MessageStreamEvent> flushPartials() sync* {
+    for (final id in _dirty) {
+      final blocks = _builders[id]?.buildBlocks() ?? const <ContentBlock>[];
+      if (blocks.isNotEmpty) {
+        yield MessageStreamEvent(
+          partialMessage: Message.fromBlocks(
+            id: id,
+            role: MessageRole.assistant,
+            blocks: blocks,
+          ),
+        );
+      }
+    }
+    _dirty.clear();
+    _sinceLastPartial.reset();
+  }
+
+  /// 应用一批增量；遇到 done/error 时置 [finished]
+  Iterable<MessageStreamEvent> apply(List<Map<String, dynamic>> deltas) sync* {
+    for (final delta in deltas) {
+      final type = delta['t'] as String?;
+      final id = delta['message'] as String?;
+      final index = delta['index'] as int?;
+
+      switch (type) {
+        case 'text':
+          final builder = _builders.putIfAbsent(id!, () => _NormalizedMessageBuilder());
+          builder.contentBlockTypes.putIfAbsent(index!, () => 'text');
+          builder.textBlocksBuilder.putIfAbsent(index, () => StringBuffer()).write(delta['text'] as String);
+          _dirty.add(id);
+          continue;
+        case 'tool':
+          final builder = _builders.putIfAbsent(id!, () => _NormalizedMessageBuilder());
+          final input = PartialJsonValue();
+          builder.contentBlockTypes[index!] = 'tool_use';
+          builder.toolInputs[index] = input;
+          builder.toolUseBlocks[index] = {
+            'id': delta['id'],
+            'name': delta['name'],
+            'input': input.value,
+          };
+          _dirty.add(id);
+          continue;
+        case 'input':
+          final input = _builders[id]?.toolInputs[index];
+          if (input != null) {
+            input.apply([
+              for (final update in delta['updates'] as List) Map<String, dynamic>.from(update as Map),
+            ]);
+            _dirty.add(id!);
+          }
+          continue;
+        case 'stop':
+          final builder = _builders[id];
+          if (builder == null) continue;
+          builder.finalizedBlocks.add(index!);
+          final input = delta['input'];
+          if (input is Map && builder.toolUseBlocks.containsKey(index)) {
+            builder.toolUseBlocks[index]!['input'] = PartialJsonValue.copyValue(input);
+          }
+          builder.toolInputs.remove(index);
+          _dirty.add(id!);
+          continue;
+        case 'batch':
+          _streamQuality.batchApplied(delta['seq'] as int);
+          continue;
+      }
+
+      // 其余增量不属于消息内容，先发出待定的部分消息以保持顺序
+      yield* flushPartials();
+
+      switch (type) {
+        case 'session':
+          yield MessageStreamEvent(sessionId: delta['id'] as String);
+          break;
+        case 'run':
+          yield MessageStreamEvent(runId: delta['id'] as String);
+          break;
+        case 'start':
+          final replaces = delta['replaces'] as String?;
+          if (replaces != null) {
+            // token 模式的占位消息由 stream_event 重建
+            _builders.remove(replaces);
+          }
+          _builders.putIfAbsent(id!, () => _NormalizedMessageBuilder());
+          break;
+        case 'final':
+          final blocks = _builders[id]?.buildBlocks() ?? const <ContentBlock>[];
+          if (blocks.isNotEmpty) {
+            yield MessageStreamEvent(
+              finalMessage: Message.fromBlocks(
+                id: id!,
+                role: MessageRole.assistant,
+                blocks: blocks,
+              ),
+            );
+          }
+          break;
+        case 'message':
+          final blocks = <ContentBlock>[];
+          for (final blockJson in delta['blocks'] as List) {
+            try {
+              blocks.add(ContentBlock.fromJson(PartialJsonValue.copyValue(blockJson)));
+            } catch (e) {
+              print('DEBUG SSE: Failed to parse content block: $e');
+            }
+          }
+          if (blocks.isNotEmpty) {
+            yield MessageStreamEvent(
+              finalMessage: Message.fromBlocks(
+                id: id!,
+                role: delta['role'] == 'user' ? MessageRole.user : MessageRole.assistant,
+                blocks: blocks,
+              ),
+            );
+          }
+          break;
+        case 'stats':
+          yield MessageStreamEvent(
+            stats: MessageStats.fromResultPayload(PartialJsonValue.copyValue(delta['payload'])),
+          );
+          break;
+        case 'done':
+          if (stopAtDone) {
+            yield MessageStreamEvent(isDone: true);
+            finished = true;
+            return;
+          }
+          break;
+        case 'error':
+          yield MessageStreamEvent(
+            error: delta['message'] as String? ?? 'Unknown error',
+            isDone: true,
+          );
+          finished = true;
+          return;
+      }
+    }
+    // 合并间隔未到的部分消息留到下一批或 [flushDelay] 到期；final 与其他事件之前总会先发出
+    if (_sinceLastPartial.elapsedMilliseconds >= _coalesceMs) {
+      yield* flushPartials();
+    }
+  }
+}
+
+/// 将聊天响应体交给原生规范化器，并把返回的增量组装为 [MessageStreamEvent]
+///
+/// [schema] 为 'claude' 或 'codex'。Claude 在 done 事件处结束；Codex 的
+/// done 只表示文本收尾，流会读到响应体结束为止。给出 [sessionId] 和
+/// [prompt]（本轮发送的内容块）时 runner 为这次运行记录日志，供之后打开的
+/// 标签页接入。给出 [trace] 时记录每个分块的原生规范化和增量应用耗时。
+Stream<MessageStreamEvent> normalizeMessageStream(
+  Stream<List<int>> body, {
+  required String schema,
+  String? messageId,
+  String? sessionId,
+  List<dynamic>? prompt,
+  TurnTrace? trace,
+}) async* {
+  final service = StreamNormalizerService.getInstance();
+  final applier = MessageDeltaApplier(stopAtDone: schema != 'codex');
+  final apply = applier.apply;
+
+  final streamId = await service.open(
+    schema: schema,
+    messageId: messageId,
+    sessionId: sessionId,
+    prompt: prompt,
+  );
+  final chunks = StreamIterator(body);
+  var closed = false;
+  try {
+    Future<bool>? next;
+    while (true) {
+      next ??= chunks.moveNext();
+      // 等待下一个分块时，到期的部分消息不等分块到达就发出
+      final delay = applier.flushDelay;
+      if (delay != null) {
+        final arrived = await Future.any([
+          next.then((_) => true),
+          Future.delayed(delay, () => false),
+        ]);
+        if (!arrived) {
+          yield* Stream.fromIterable(applier.flushPartials());
+          continue;
+        }
+      }
+      if (!await next) break;
+      next = null;
+      final chunk = chunks.current;
+      if (trace == null) {
+        yield* Stream.fromIterable(apply(await service.feed(streamId, chunk)));
+      } else {
+        final feedStart = TurnTrace.now;
+        final deltas = await service.feed(streamId, chunk);
+        final applyStart = TurnTrace.now;
+        trace.span('normalize', 'runner.feed', feedStart,
+            endUs: applyStart, args: {'bytes': chunk.length, 'deltas': deltas.length});
+        yield* Stream.fromIterable(apply(deltas));
+        trace.span('normalize', 'dart.apply', applyStart);
+      }
+      if (applier.finished) return;
+    }
+    closed = true;
+    yield* Stream.fromIterable(apply(await service.close(streamId)));
+    if (!applier.finished) {
+      yield* Stream.fromIterable(applier.flushPartials());
+      yield MessageStreamEvent(isDone: true);
+    }
+  } catch (e) {
+    print('Stream error: $e');
+    if (!closed) {
+      // 发出已累积但尚未收尾的内容（Codex 文本）
+      closed = true;
+      yield* Stream.fromIterable(apply(await service.close(streamId)));
+    }
+    if (!applier.finished) {
+      yield MessageStreamEvent(error: e.toString(), isDone: true);
+    }
+  } finally {
+    chunks.cancel();
+    if (!closed) {
+      service.close(streamId);
+    }
+  }
+}
@@ -1,3 +1,4 @@
+import 'dart:async';
 import 'dart:convert';
 import 'dart:io';
 import 'dart:typed_data';
@@ -16,12 +17,19 @@ import '../models/codex_user_settings.dart';
 import '../widgets/message_bubble.dart';
 import '../core/theme/app_theme.dart';
 import '../core/theme/panel_theme.dart';
+import '../core/utils/follow_tail_controller.dart';
 import '../core/utils/platform_helper.dart';
 import '../repositories/api_codex_repository.dart';
 import '../repositories/session_repository.dart';
 import '../services/session_settings_service.dart';
 import '../services/app_settings_service.dart';
+import '../services/clipboard_image_service.dart';
+import '../services/paste_buffer_service.dart';
+import '../services/run_journal_service.dart';
+import '../services/session_export_service.dart';
 import '../services/speech_to_text_service.dart';
+import '../services/stream_quality_service.dart';
+import '../services/token_estimator_service.dart';
 import 'session_settings_screen.dart';
 import 'codex_session_settings_screen.dart';
 
@@ -45,7 +53,7 @@ class ChatScreen extends StatefulWidget {
   State<ChatScreen> createState() => _ChatScreenState();
 }
 
-class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMixin {
+class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMixin, SingleTickerProviderStateMixin {
   final List<Message> _messages = [];
   final TextEditingController _textController = TextEditingController();
   final ScrollController _scrollController = ScrollController();
@@ -58,12 +66,17 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
   MessageStats? _lastMessageStats; // 最后一条消息的统计信息
   bool _showStats = false; // 是否显示统计信息
   bool _userScrolling = false; // 用户是否正在手动滚动
+  late final FollowTailController _followTail; // 流式输出时逐帧贴底
   late Session _currentSession; // 当前session，可能在第一次发送消息时更新
   String? _currentRunId; // 当前运行的任务ID（用于停止任务，仅限 Claude Code）
+  StreamSubscription<MessageStreamEvent>? _runSubscription; // 跟随运行中的会话（见 _followRun）
 
   // Image attachments
   final List<File> _selectedImages = [];
   final List<String> _imageBase64List = [];
+  final List<String?> _imageHandles = []; // 原生剪贴板附件句柄（null 表示已有 base64）
+  final List<PastedText> _pastedTexts = []; // 大段粘贴文本（原文保存在 runner 中）
+  final DraftTokenMeter _draftTokenMeter = DraftTokenMeter(); // 草稿 token 实时估算
   bool _sessionProcessing = false; // 会话是否正在处理中（用于持续对话功能）
 
   // 节流相关 - 优化流式传输UI更新
@@ -81,6 +94,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
   SpeechToTextService? _speechService;
   bool _isVoiceListening = false; // 是否正在语音输入
   bool _voiceSupported = false; // 平台是否支持语音输入
+  String? _voiceBaseText; // 当前这句语音开始前的输入框内容
   static const int _loadMoreCount = 50; // 每次加载更多的数量
   bool _hasMoreMessages = false; // 是否有更多历史消息
   bool _isLoadingMore = false; // 是否正在加载更多
@@ -124,11 +138,17 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
   }
 
   // 获取渲染 Markdown 设置（使用全局设置）
+  // 界面跟不上流式输出时，后台标签页先显示纯文本，切回前台时再渲染
   bool get _effectiveRenderMarkdown {
     final appSettingsService = AppSettingsService();
-    return appSettingsService.renderMarkdown;
+    if (!appSettingsService.renderMarkdown) return false;
+    final deferred = StreamQualityService.getInstance().current.deferBackgroundRendering;
+    return !deferred || _tabVisible;
   }
 
+  // 所在标签页是否可见（标签管理器对后台标签页关闭 TickerMode），在 build 中更新
+  bool _tabVisible = true;
+
   @override
   bool get wantKeepAlive => true; // 保持状态，防止切换标签时丢失消息
 
@@ -139,6 +159,11 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     _loadSavedSettings(); // 加载保存的设置
     // 监听用户手动滚动
     _scrollController.addListener(_onScroll);
+    _followTail = FollowTailController(
+      scrollController: _scrollController,
+      vsync: this,
+      shouldFollow: () => !_userScrolling,
+    );
     // 监听输入框文本变化
     _textController.addListener(_onTextChanged);
     _loadMessages();
@@ -146,6 +171,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
 
     // 监听全局设置变化（用于刷新 UI，例如 renderMarkdown 开关）
     AppSettingsService().addListener(_onSettingsChanged);
+    StreamQualityService.getInstance().quality.addListener(_onSettingsChanged);
 
     // 初始化语音输入服务（仅桌面平台）
     _initVoiceInput();
@@ -164,6 +190,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
       _speechService!.onResult = _onVoiceResult;
       _speechService!.onError = _onVoiceError;
       _speechService!.onListeningStarted = () {
+        _voiceBaseText = null;
         if (mounted) {
           setState(() => _isVoiceListening = true);
         }
@@ -185,17 +212,27 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
   void _onVoiceResult(String text, bool isFinal) {
     if (!mounted) return;
 
-    // 将识别的文字追加到输入框
-    if (text.isNotEmpty) {
-      final currentText = _textController.text;
-      final newText = currentText.isEmpty ? text : '$currentText $text';
-      _textController.text = newText;
-      _textController.selection = TextSelection.fromPosition(
-        TextPosition(offset: newText.length),
-      );
+    // 同一句的识别结果会不断更新，替换上次插入的部分而不是追加
+    final base = _voiceBaseText ??= _textController.text;
+    final separator = _needsVoiceSeparator(base, text) ? ' ' : '';
+    final newText = '$base$separator$text';
+    _textController.text = newText;
+    _textController.selection = TextSelection.fromPosition(
+      TextPosition(offset: newText.length),
+    );
+    if (isFinal) {
+      _voiceBaseText = null;
     }
   }
 
+  /// 语音文字与已有内容之间是否加空格（中文之间、空白之后不加）
+  static final RegExp _cjkChar = RegExp(r'[\u3000-\u303f\u4e00-\u9fff\uff00-\uffef]');
+
+  bool _needsVoiceSeparator(String base, String text) {
+    if (base.isEmpty || text.isEmpty || base.endsWith(' ') || base.endsWith('\n')) return false;
+    return !(_cjkChar.hasMatch(base[base.length - 1]) && _cjkChar.hasMatch(text[0]));
+  }
+
   /// 语音识别错误回调
   void _onVoiceError(String error) {
     if (!mounted) return;
@@ -217,6 +254,8 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     } else {
       // 请求焦点到输入框
       _inputFocusNode.requestFocus();
+      // 口述的标识符按当前项目中的写法输出
+      _speechService!.setProjectRoot(_currentSession.cwd);
       await _speechService!.startListening();
     }
   }
@@ -238,6 +277,8 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
       print('DEBUG ChatScreen: Session changed from ${oldWidget.session.id} to ${widget.session.id}');
       _currentSession = widget.session;
       // 清空状态
+      _runSubscription?.cancel();
+      _runSubscription = null;
       _currentRunId = null;
       _isSending = false;
       _sessionProcessing = false;
@@ -428,11 +469,20 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     if (!mounted) return;
     setState(() => _isLoading = true);
     try {
-      final messages = await widget.repository.getSessionMessages(widget.session.id);
+      // 会话正在运行时（Linux）接入运行日志：本次运行的消息由日志提供，
+      // 会话记录中只取运行开始前的消息
+      final attachment = await RunJournalService.getInstance().attach(widget.session.id);
+      var messages = await widget.repository.getSessionMessages(widget.session.id);
+      if (attachment != null) {
+        messages = messages.where((m) => m.timestamp.isBefore(attachment.startedAt)).toList();
+      }
       print('DEBUG ChatScreen: Loaded ${messages.length} messages');
 
       // 检查组件是否还在树中
-      if (!mounted) return;
+      if (!mounted) {
+        attachment?.events.listen(null).cancel();
+        return;
+      }
 
       // 保存所有消息
       _allMessages = messages;
@@ -452,6 +502,10 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
 
       print('DEBUG ChatScreen: Displaying ${_messages.length} messages, hasMore: $_hasMoreMessages');
 
+      if (attachment != null) {
+        _followRun(attachment);
+      }
+
       // 确保在消息加载后滚动到底部，使用 jumpTo 直接跳转
       WidgetsBinding.instance.addPostFrameCallback((_) {
         if (!mounted) return;
@@ -559,6 +613,46 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
       return; // Only support desktop platforms
     }
 
+    // Linux 上优先走原生通道：图片在 runner 中缩放编码，Dart 只拿到句柄
+    final clipboardImageService = ClipboardImageService.getInstance();
+    if (clipboardImageService.isPlatformSupported) {
+      final attachment = await clipboardImageService.readImage();
+      if (attachment != null) {
+        if (mounted) {
+          setState(() {
+            _selectedImages.add(File(attachment.path));
+            _imageBase64List.add('');
+            _imageHandles.add(attachment.handle);
+            _updateDraftTokens();
+          });
+        } else {
+          clipboardImageService.release(attachment.handle);
+        }
+        return;
+      }
+    }
+
+    // 大段文本不进入输入框，保存在 runner 中并显示为附件
+    final pasteBufferService = PasteBufferService.getInstance();
+    if (pasteBufferService.isPlatformSupported) {
+      final paste = await pasteBufferService.readText();
+      if (paste?.attachment != null) {
+        if (mounted) {
+          setState(() {
+            _pastedTexts.add(paste!.attachment!);
+            _updateDraftTokens();
+          });
+        } else {
+          pasteBufferService.release(paste!.attachment!.handle);
+        }
+        return;
+      }
+      if (paste?.text != null) {
+        _insertPastedText(paste!.text!);
+        return;
+      }
+    }
+
     try {
       final clipboard = SystemClipboard.instance;
       if (clipboard == null) {
@@ -629,25 +723,29 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     try {
       final data = await Clipboard.getData(Clipboard.kTextPlain);
       if (data != null && data.text != null) {
-        final text = data.text!;
-        final selection = _textController.selection;
-        final newText = _textController.text.replaceRange(
-          selection.start,
-          selection.end,
-          text,
-        );
-        _textController.value = TextEditingValue(
-          text: newText,
-          selection: TextSelection.collapsed(
-            offset: selection.start + text.length,
-          ),
-        );
+        _insertPastedText(data.text!);
       }
     } catch (e) {
       print('DEBUG: Error in default text paste: $e');
     }
   }
 
+  // 将粘贴的文本插入到光标处
+  void _insertPastedText(String text) {
+    final selection = _textController.selection;
+    final newText = _textController.text.replaceRange(
+      selection.start,
+      selection.end,
+      text,
+    );
+    _textController.value = TextEditingValue(
+      text: newText,
+      selection: TextSelection.collapsed(
+        offset: selection.start + text.length,
+      ),
+    );
+  }
+
   // Add image from bytes
   Future<void> _addImageFromBytes(Uint8List bytes, String extension) async {
     try {
@@ -666,6 +764,8 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
         setState(() {
           _selectedImages.add(file);
           _imageBase64List.add(base64);
+          _imageHandles.add(null);
+          _updateDraftTokens();
         });
       }
     } catch (e) {
@@ -690,6 +790,8 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
           setState(() {
             _selectedImages.add(file);
             _imageBase64List.add(base64);
+            _imageHandles.add(null);
+            _updateDraftTokens();
           });
         }
       }
@@ -719,6 +821,8 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
         setState(() {
           _selectedImages.add(file);
           _imageBase64List.add(base64);
+          _imageHandles.add(null);
+          _updateDraftTokens();
         });
       }
     } catch (e) {
@@ -733,17 +837,39 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
 
   // Remove selected image
   void _removeImage(int index) {
+    final handle = _imageHandles[index];
+    if (handle != null) {
+      ClipboardImageService.getInstance().release(handle);
+    }
     setState(() {
       _selectedImages.removeAt(index);
       _imageBase64List.removeAt(index);
+      _imageHandles.removeAt(index);
+      _updateDraftTokens();
     });
   }
 
   // Clear all images
   void _clearImages() {
+    for (final handle in _imageHandles) {
+      if (handle != null) {
+        ClipboardImageService.getInstance().release(handle);
+      }
+    }
     setState(() {
       _selectedImages.clear();
       _imageBase64List.clear();
+      _imageHandles.clear();
+      _updateDraftTokens();
+    });
+  }
+
+  // Remove pasted text attachment
+  void _removePastedText(int index) {
+    PasteBufferService.getInstance().release(_pastedTexts[index].handle);
+    setState(() {
+      _pastedTexts.removeAt(index);
+      _updateDraftTokens();
     });
   }
 
@@ -771,8 +897,8 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
       _hideCommandSuggestions();
     }
 
-    // 允许只发送图片（文本可以为空）
-    if (text.trim().isEmpty && _selectedImages.isEmpty) return;
+    // 允许只发送图片或粘贴的文本（输入框可以为空）
+    if (text.trim().isEmpty && _selectedImages.isEmpty && _pastedTexts.isEmpty) return;
 
     // 对于 Claude Code，支持持续消息传递（在流式响应中发送新消息）
     // 注意：_sessionProcessing 标记会话是否在处理，现在允许在处理中发送新消息
@@ -789,27 +915,59 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     // 添加图片blocks
     for (int i = 0; i < _selectedImages.length; i++) {
       final mediaType = _getMediaType(_selectedImages[i].path);
+      var base64Data = _imageBase64List[i];
+      // 原生剪贴板附件在发送时才取 base64
+      final handle = _imageHandles[i];
+      if (handle != null) {
+        base64Data = await ClipboardImageService.getInstance().loadBase64(handle) ?? '';
+        if (base64Data.isEmpty) {
+          print('DEBUG: Skipping clipboard attachment $handle');
+          continue;
+        }
+      }
       contentBlocks.add(ContentBlock.image(
-        base64Data: _imageBase64List[i],
+        base64Data: base64Data,
         mediaType: mediaType,
       ));
     }
 
+    // 大段粘贴文本：请求中是占位符，写出请求体时才替换为原文；
+    // 消息列表中只显示摘要。附件在请求结束后释放
+    final pastedTexts = List<PastedText>.of(_pastedTexts);
+    final displayBlocks = List<ContentBlock>.of(contentBlocks);
+    for (final pasted in pastedTexts) {
+      contentBlocks.add(ContentBlock(
+        type: ContentBlockType.text,
+        text: pasted.placeholder,
+      ));
+      displayBlocks.add(ContentBlock(
+        type: ContentBlockType.text,
+        text: '📋 粘贴的文本（${pasted.summary}）\n${pasted.preview}…',
+      ));
+    }
+
     // 添加文本block（如果有文本）
     if (text.trim().isNotEmpty) {
-      contentBlocks.add(ContentBlock(
+      final textBlock = ContentBlock(
         type: ContentBlockType.text,
         text: text,
-      ));
+      );
+      contentBlocks.add(textBlock);
+      displayBlocks.add(textBlock);
     }
 
     // 创建用户消息
     final userMessage = Message.fromBlocks(
       id: DateTime.now().millisecondsSinceEpoch.toString(),
       role: MessageRole.user,
-      blocks: contentBlocks,
+      blocks: displayBlocks,
     );
 
+    // 后端把运行中会话的事件广播给它的每个连接，本次请求的流会收到运行的
+    // 后续消息，不再跟随运行日志
+    _runSubscription?.cancel();
+    _runSubscription = null;
+
     setState(() {
       _messages.add(userMessage);
       _isSending = true;
@@ -818,6 +976,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     });
     print('DEBUG: Added user message, total messages: ${_messages.length}, opacity: $_messagesOpacity');
     _textController.clear();
+    _pastedTexts.clear(); // 附件交给本次请求，结束后释放
     _clearImages(); // 清空选中的图片
     _scrollToBottom();
 
@@ -868,7 +1027,10 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
 
         eventStream = codexRepo.sendMessageStream(
           sessionId: sessionIdToUse,
-          content: text,
+          content: [
+            for (final pasted in pastedTexts) pasted.placeholder,
+            if (text.trim().isNotEmpty) text,
+          ].join('\n\n'),
           cwd: _currentSession.cwd,
           codexSettings: settings,
         );
@@ -959,18 +1121,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
           final partial = event.partialMessage!;
           final messageId = partial.id;
 
-          // 先检查局部map，再检查全局_messages列表（处理持续对话场景）
-          int? existingIndex = assistantMessagesByIdIndex[messageId];
-          if (existingIndex == null) {
-            // 在_messages中查找是否已存在该消息（可能由其他并行的_handleSubmit添加）
-            for (int i = _messages.length - 1; i >= 0; i--) {
-              if (_messages[i].id == messageId) {
-                existingIndex = i;
-                assistantMessagesByIdIndex[messageId] = i; // 更新局部map
-                break;
-              }
-            }
-          }
+          int? existingIndex = _streamedMessageIndex(messageId, assistantMessagesByIdIndex);
 
           print('UI: ⟳ PARTIAL MSG, ID: $messageId, existingIndex: $existingIndex, total msgs: ${_messages.length}');
 
@@ -997,18 +1148,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
           final final_ = event.finalMessage!;
           final messageId = final_.id;
 
-          // 先检查局部map，再检查全局_messages列表（处理持续对话场景）
-          int? existingIndex = assistantMessagesByIdIndex[messageId];
-          if (existingIndex == null) {
-            // 在_messages中查找是否已存在该消息（可能由其他并行的_handleSubmit添加）
-            for (int i = _messages.length - 1; i >= 0; i--) {
-              if (_messages[i].id == messageId) {
-                existingIndex = i;
-                assistantMessagesByIdIndex[messageId] = i; // 更新局部map
-                break;
-              }
-            }
-          }
+          int? existingIndex = _streamedMessageIndex(messageId, assistantMessagesByIdIndex);
 
           print('UI: ✓ FINAL MSG, ID: $messageId, existingIndex: $existingIndex, total msgs: ${_messages.length}');
 
@@ -1078,9 +1218,90 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
           ),
         );
       }
+    } finally {
+      for (final pasted in pastedTexts) {
+        PasteBufferService.getInstance().release(pasted.handle);
+      }
     }
   }
 
+  // 查找流式消息在 _messages 中的位置：先检查局部map，再检查全局_messages列表
+  // （处理持续对话场景，消息可能由其他并行的_handleSubmit或运行日志添加）
+  int? _streamedMessageIndex(String messageId, Map<String, int> indexById) {
+    final index = indexById[messageId];
+    if (index != null) return index;
+    for (int i = _messages.length - 1; i >= 0; i--) {
+      if (_messages[i].id == messageId) {
+        indexById[messageId] = i; // 更新局部map
+        return i;
+      }
+    }
+    return null;
+  }
+
+  // 跟随运行中的会话（标签页在运行中打开或切回时，见 RunJournalService）
+  void _followRun(RunJournalAttachment attachment) {
+    _runSubscription?.cancel();
+    final messagesByIdIndex = <String, int>{};
+    setState(() {
+      _isSending = true;
+      _sessionProcessing = true;
+    });
+    _runSubscription = attachment.events.listen((event) {
+      if (!mounted) return;
+
+      if (event.runId != null && event.runId!.isNotEmpty && widget.repository is! ApiCodexRepository) {
+        setState(() => _currentRunId = event.runId);
+      }
+
+      if (event.stats != null) {
+        setState(() {
+          _lastMessageStats = event.stats;
+          _showStats = true;
+        });
+      }
+
+      final message = event.partialMessage ?? event.finalMessage;
+      if (message != null) {
+        final existingIndex = _streamedMessageIndex(message.id, messagesByIdIndex);
+        if (existingIndex == null) {
+          _messages.add(message);
+          messagesByIdIndex[message.id] = _messages.length - 1;
+        } else if (existingIndex < _messages.length && _messages[existingIndex].role == message.role) {
+          _messages[existingIndex] = message;
+        }
+        if (event.finalMessage != null) {
+          setState(() {});
+        } else {
+          _throttledUpdate(); // 节流更新UI
+        }
+        _scrollToBottom();
+      }
+
+      if (event.isDone) {
+        _runSubscription = null;
+        setState(() {
+          _isSending = false;
+          _sessionProcessing = false;
+          _currentRunId = null;
+        });
+        if (event.error == null) {
+          widget.onMessageComplete?.call();
+        }
+      }
+    }, onError: (Object error) {
+      // 日志超出上限：运行仍在继续，改为从会话记录重新加载已写入的消息
+      if (!mounted || error is! RunJournalOverflowed) return;
+      _runSubscription = null;
+      setState(() {
+        _isSending = false;
+        _sessionProcessing = false;
+        _currentRunId = null;
+      });
+      _loadMessages();
+    });
+  }
+
   Future<void> _handleStop() async {
     // 只有 Claude Code 支持停止功能
     if (widget.repository is ApiCodexRepository) {
@@ -1143,6 +1364,47 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     }
   }
 
+  /// 导出当前会话（Linux 原生导出，按文件扩展名选择格式）
+  ///
+  /// 未传 claudeDir 时 runner 从 ~/.claude 读取会话文件，与后端默认目录一致。
+  Future<void> _exportSession() async {
+    final session = _currentSession;
+    final outputPath = await FilePicker.platform.saveFile(
+      dialogTitle: '导出会话',
+      fileName: '${session.id}.md',
+      type: FileType.custom,
+      allowedExtensions: ['md', 'html', 'json'],
+    );
+    if (outputPath == null) return;
+
+    final extension = outputPath.split('.').last.toLowerCase();
+    final format = extension == 'html'
+        ? SessionExportFormat.html
+        : extension == 'json'
+            ? SessionExportFormat.json
+            : SessionExportFormat.markdown;
+
+    final result = await SessionExportService.getInstance().exportSession(
+      SessionExportJob(
+        sessionId: session.id,
+        cwd: session.cwd,
+        outputPath: outputPath,
+        format: format,
+        title: session.title,
+      ),
+    );
+    if (!mounted) return;
+
+    ScaffoldMessenger.of(context).showSnackBar(
+      SnackBar(
+        content: Text(result.ok
+            ? '已导出 ${result.messages} 条消息到 ${result.outputPath}'
+            : '导出失败: ${result.error}'),
+        behavior: SnackBarBehavior.floating,
+      ),
+    );
+  }
+
   void _openSettings() async {
     // 检测是否为 Codex 仓库
     final isCodex = widget.repository is ApiCodexRepository;
@@ -1258,21 +1520,10 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     }
   }
 
-  // 平滑滚动到底部（仅在用户未手动滚动时）
+  // 平滑滚动到底部（仅在用户未手动滚动时），每帧最多一次跳转
   void _scrollToBottom() {
     if (_userScrolling) return; // 用户正在手动滚动，不自动滚动
-
-    if (_scrollController.hasClients) {
-      Future.delayed(const Duration(milliseconds: 50), () {
-        if (_scrollController.hasClients && !_userScrolling) {
-          _scrollController.animateTo(
-            _scrollController.position.maxScrollExtent,
-            duration: const Duration(milliseconds: 200),
-            curve: Curves.easeOut,
-          );
-        }
-      });
-    }
+    _followTail.contentChanged();
   }
 
   // 判断消息是否是真正的用户输入消息（排除只包含工具返回结果的消息）
@@ -1370,6 +1621,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
   @override
   Widget build(BuildContext context) {
     super.build(context); // 必须调用以保持状态
+    _tabVisible = TickerMode.of(context);
     return PopScope(
       canPop: widget.onBack == null, // 如果有 onBack 回调，不允许默认 pop
       onPopInvoked: (didPop) {
@@ -1453,6 +1705,13 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
             onPressed: _refreshCurrentSession,
             tooltip: '刷新对话',
           ),
+          if (SessionExportService.getInstance().isPlatformSupported &&
+              widget.repository is! ApiCodexRepository)
+            IconButton(
+              icon: const Icon(Icons.file_download_outlined),
+              onPressed: _exportSession,
+              tooltip: '导出会话',
+            ),
           IconButton(
             icon: const Icon(Icons.settings_outlined),
             onPressed: _openSettings,
@@ -1544,6 +1803,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
                                       message: _messages[messageIndex],
                                       hideToolCalls: _effectiveHideToolCalls,
                                       renderMarkdown: _effectiveRenderMarkdown,
+                                      collapseToolResultChars: StreamQualityService.getInstance().current.collapseToolResultChars,
                                     );
                                   },
                                 ),
@@ -1571,6 +1831,7 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
                                     message: _messages[messageIndex],
                                     hideToolCalls: _effectiveHideToolCalls,
                                     renderMarkdown: _effectiveRenderMarkdown,
+                                    collapseToolResultChars: StreamQualityService.getInstance().current.collapseToolResultChars,
                                   );
                                 },
                               ),
@@ -1664,6 +1925,65 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     );
   }
 
+  String _formatTokenCount(int tokens) {
+    if (tokens >= 1000) {
+      return '${(tokens / 1000).toStringAsFixed(1)}k';
+    }
+    return '$tokens';
+  }
+
+  Widget _buildContextMeter() {
+    return ValueListenableBuilder<int?>(
+      valueListenable: _draftTokenMeter,
+      builder: (context, draftTokens, _) {
+        if (draftTokens == null || draftTokens == 0) {
+          return const SizedBox.shrink();
+        }
+        final stats = _lastMessageStats;
+        final contextTokens = (stats?.inputTokens ?? 0) +
+            (stats?.cacheReadTokens ?? 0) +
+            (stats?.cacheCreationTokens ?? 0);
+        const contextWindow = TokenEstimatorService.defaultContextWindow;
+        final total = contextTokens + draftTokens;
+        final ratio = (total / contextWindow).clamp(0.0, 1.0);
+        final textSecondary = context.appColors.textSecondary;
+        final color = ratio > 0.9
+            ? Colors.red
+            : ratio > 0.75
+                ? Colors.orange
+                : textSecondary;
+
+        return Padding(
+          padding: const EdgeInsets.only(bottom: 6, left: 4, right: 4),
+          child: Row(
+            children: [
+              Expanded(
+                child: ClipRRect(
+                  borderRadius: BorderRadius.circular(2),
+                  child: LinearProgressIndicator(
+                    value: ratio,
+                    minHeight: 3,
+                    backgroundColor: Theme.of(context).dividerColor,
+                    valueColor: AlwaysStoppedAnimation<Color>(color),
+                  ),
+                ),
+              ),
+              const SizedBox(width: 8),
+              Tooltip(
+                message: '草稿约 ${_formatTokenCount(draftTokens)} tokens（估算），'
+                    '当前上下文 ${_formatTokenCount(contextTokens)} tokens',
+                child: Text(
+                  '≈${_formatTokenCount(total)} / ${_formatTokenCount(contextWindow)}',
+                  style: TextStyle(fontSize: 11, color: color),
+                ),
+              ),
+            ],
+          ),
+        );
+      },
+    );
+  }
+
   Widget _buildStatChip({
     required IconData icon,
     required String label,
@@ -2035,6 +2355,29 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
                     },
                   ),
                 ),
+              // 大段粘贴文本附件
+              if (_pastedTexts.isNotEmpty)
+                Container(
+                  width: double.infinity,
+                  margin: const EdgeInsets.only(bottom: 8),
+                  child: Wrap(
+                    spacing: 8,
+                    runSpacing: 8,
+                    children: [
+                      for (int i = 0; i < _pastedTexts.length; i++)
+                        Tooltip(
+                          message: _pastedTexts[i].preview,
+                          child: InputChip(
+                            avatar: const Icon(Icons.description_outlined, size: 18),
+                            label: Text('粘贴的文本 · ${_pastedTexts[i].summary}'),
+                            onDeleted: () => _removePastedText(i),
+                          ),
+                        ),
+                    ],
+                  ),
+                ),
+              // 上下文用量（上一轮的输入 token + 草稿估算）
+              if (_draftTokenMeter.isSupported) _buildContextMeter(),
               // 输入框和按钮
               Row(
                 crossAxisAlignment: CrossAxisAlignment.end,
@@ -2215,8 +2558,19 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
     );
   }
 
+  // 草稿变化时更新 token 估算（计数在原生任务池中完成）
+  void _updateDraftTokens() {
+    _draftTokenMeter.update(
+      _textController.text,
+      _selectedImages.map((file) => DraftImageInfo(path: file.path)).toList(),
+      extraTokens: _pastedTexts.fold<int>(0, (sum, pasted) => sum + pasted.tokens),
+    );
+  }
+
   // 监听文本变化，检测斜杠命令
   void _onTextChanged() {
+    _updateDraftTokens();
+
     // 仅在 Claude Code 模式下启用斜杠命令
     if (widget.repository is ApiCodexRepository) {
       if (_showCommandSuggestions) {
@@ -2379,12 +2733,19 @@ class _ChatScreenState extends State<ChatScreen> with AutomaticKeepAliveClientMi
 
   @override
   void dispose() {
+    _runSubscription?.cancel();
     _hideCommandSuggestions();
     _textController.removeListener(_onTextChanged);
     _textController.dispose();
+    _draftTokenMeter.dispose();
+    for (final pasted in _pastedTexts) {
+      PasteBufferService.getInstance().release(pasted.handle);
+    }
+    _followTail.dispose();
     _scrollController.dispose();
     _inputFocusNode.dispose();
     AppSettingsService().removeListener(_onSettingsChanged);
+    StreamQualityService.getInstance().quality.removeListener(_onSettingsChanged);
     super.dispose();
   }
 }
@@ -4,6 +4,8 @@ import '../../core/theme/app_theme.dart';
 import '../../services/auth_service.dart';
 import '../../services/app_settings_service.dart';
 import '../../services/notification_sound_service.dart';
+import '../../services/frame_pacing_service.dart';
+import '../../services/residency_service.dart';
 import '../../services/config_service.dart';
 import '../../models/user_settings.dart';
 import '../../models/codex_user_settings.dart';
@@ -39,6 +41,9 @@ class _SettingsScreenState extends State<SettingsScreen> {
   late bool _hideToolCalls;
   late bool _renderMarkdown;
   late bool _includeProjectSettings; // 是否包含项目设置
+  final _residencyService = ResidencyService.getInstance();
+  bool? _resident; // 关闭窗口时驻留后台（仅 Linux，加载前为 null）
+  late bool _showFramePacing;
   String _apiEndpoint = 'http://192.168.31.99:8207';
 
   // Claude settings
@@ -60,6 +65,7 @@ class _SettingsScreenState extends State<SettingsScreen> {
     _fontSize = _settingsService.fontSize;
     _hideToolCalls = _settingsService.hideToolCalls;
     _renderMarkdown = _settingsService.renderMarkdown;
+    _showFramePacing = _settingsService.showFramePacing;
 
     // 初始化项目设置开关
     List<String> currentSources = _settingsService.defaultSessionSettings?.settingSources ?? ['user'];
@@ -68,6 +74,12 @@ class _SettingsScreenState extends State<SettingsScreen> {
     // Load API endpoint from config
     _loadApiEndpoint();
 
+    if (_residencyService.isPlatformSupported) {
+      _residencyService.isResident().then((value) {
+        if (mounted) setState(() => _resident = value);
+      });
+    }
+
     // Load global agent settings
     _loadGlobalSettings();
   }
@@ -88,8 +100,15 @@ class _SettingsScreenState extends State<SettingsScreen> {
       final authService = await AuthService.getInstance();
       final userId = authService.username ?? 'admin';
 
+      // 先显示当前用户上次缓存的结果，再从后端刷新
+      if (!mounted) return;
+      setState(() {
+        _claudeSettings = _settingsService.claudeSettingsFor(userId);
+        _codexSettings = _settingsService.codexSettingsFor(userId);
+      });
+
       // Load Claude settings
-      setState(() => _loadingClaudeSettings = true);
+      setState(() => _loadingClaudeSettings = _claudeSettings == null);
       final claudeSettings = await widget.claudeRepository.getUserSettings(userId);
       setState(() {
         _claudeSettings = claudeSettings;
@@ -98,7 +117,7 @@ class _SettingsScreenState extends State<SettingsScreen> {
       _settingsService.setClaudeSettings(claudeSettings);
 
       // Load Codex settings
-      setState(() => _loadingCodexSettings = true);
+      setState(() => _loadingCodexSettings = _codexSettings == null);
       final codexSettings = await widget.codexRepository.getUserSettings(userId);
       setState(() {
         _codexSettings = codexSettings;
@@ -227,6 +246,33 @@ class _SettingsScreenState extends State<SettingsScreen> {
                     ),
                   ),
                 ],
+                if (_resident != null) ...[
+                  Divider(height: 1, color: dividerColor),
+                  SwitchListTile(
+                    title: Text('关闭窗口时驻留后台', style: TextStyle(fontSize: 16, color: textPrimary)),
+                    subtitle: Text('隐藏到托盘并保持引擎运行，再次打开时立即恢复', style: TextStyle(fontSize: 13, color: appColors.textSecondary)),
+                    value: _resident!,
+                    onChanged: (value) async {
+                      setState(() => _resident = value);
+                      final applied = await _residencyService.setResident(value);
+                      if (mounted) setState(() => _resident = applied);
+                    },
+                    activeColor: primaryColor,
+                  ),
+                ],
+                if (FramePacingService.getInstance().isPlatformSupported) ...[
+                  Divider(height: 1, color: dividerColor),
+                  SwitchListTile(
+                    title: Text('显示帧节奏诊断', style: TextStyle(fontSize: 16, color: textPrimary)),
+                    subtitle: Text('在窗口角落显示帧间隔、掉帧和上屏延迟，区分流式输出期间', style: TextStyle(fontSize: 13, color: appColors.textSecondary)),
+                    value: _showFramePacing,
+                    onChanged: (value) {
+                      setState(() => _showFramePacing = value);
+                      _settingsService.setShowFramePacing(value);
+                    },
+                    activeColor: primaryColor,
+                  ),
+                ],
                 Divider(height: 1, color: dividerColor),
                 ListTile(
                   title: Text('API 地址', style: TextStyle(fontSize: 16, color: textPrimary)),
@@ -1631,10 +1631,17 @@ class _TabManagerScreenState extends State<TabManagerScreen>
   /// 返回标签页内容
   /// 注意：之前尝试用 Navigator 包裹以实现分屏内导航，但会导致无限重建问题
   /// 目前直接返回 content，设置页面会覆盖整个屏幕而非仅在分屏内
-  Widget _wrapWithNavigator(TabInfo tab) {
+  ///
+  /// 不可见的标签页关闭 TickerMode：暂停其中的动画，页面也据此判断自己在
+  /// 后台（界面跟不上流式输出时后台标签页暂缓 Markdown 渲染）
+  Widget _wrapWithNavigator(TabInfo tab, {required bool visible}) {
     // 直接返回 content，不使用 Navigator 包裹
-    // 这样可以避免无限加载问题
-    return tab.content;
+    // 这样可以避免无限加载问题；沿用 content 的 key，TabBarView 按它匹配页面
+    return TickerMode(
+      key: tab.content.key,
+      enabled: visible,
+      child: tab.content,
+    );
   }
 
   /// 构建可拖动的分隔条
@@ -1722,9 +1729,15 @@ class _TabManagerScreenState extends State<TabManagerScreen>
               panelType: panelType,
               backgroundColorOverride: contentBackgroundColor,
             ),
-            child: TabBarView(
-              controller: controller,
-              children: tabs.map((tab) => _wrapWithNavigator(tab)).toList(),
+            child: ListenableBuilder(
+              listenable: controller,
+              builder: (context, _) => TabBarView(
+                controller: controller,
+                children: [
+                  for (var i = 0; i < tabs.length; i++)
+                    _wrapWithNavigator(tabs[i], visible: i == controller.index),
+                ],
+              ),
             ),
           ),
         ),
@@ -2,6 +2,10 @@ import 'dart:convert';
 import 'package:http/http.dart' as http;
 import '../models/session_settings.dart';
 import 'auth_service.dart';
+import 'paste_buffer_service.dart';
+import 'soak_service.dart';
+import 'sse_stream.dart';
+import 'turn_trace_service.dart';
 
 class ApiService {
   String baseUrl;
@@ -33,14 +37,19 @@ class ApiService {
   }
 
   Future<List<Map<String, dynamic>>> getSessions() async {
+    final List<dynamic> data = json.decode(await getSessionsJson());
+    return data.cast<Map<String, dynamic>>();
+  }
+
+  /// 会话列表的原始 JSON，交给原生项目索引解析
+  Future<String> getSessionsJson() async {
     final response = await http.get(
       Uri.parse('$baseUrl/sessions'),
       headers: _getHeaders(),
     );
 
     if (response.statusCode == 200) {
-      final List<dynamic> data = json.decode(response.body);
-      return data.cast<Map<String, dynamic>>();
+      return response.body;
     } else {
       throw Exception('Failed to load sessions: ${response.statusCode}');
     }
@@ -64,6 +73,22 @@ class ApiService {
     dynamic message,  // 支持 String 或 Map (包含content数组)
     String? cwd,
     SessionSettings? settings,
+  }) {
+    return decodeSseEvents(chatBytes(
+      sessionId: sessionId,
+      message: message,
+      cwd: cwd,
+      settings: settings,
+    ));
+  }
+
+  /// 发送聊天请求并返回原始 SSE 响应体（供原生事件规范化器直接消费）
+  Stream<List<int>> chatBytes({
+    String? sessionId,
+    dynamic message,  // 支持 String 或 Map (包含content数组)
+    String? cwd,
+    SessionSettings? settings,
+    TurnTrace? trace,
   }) async* {
     final body = <String, dynamic>{};
 
@@ -91,58 +116,27 @@ class ApiService {
       }
     }
 
-    final request = http.Request('POST', Uri.parse('$baseUrl/chat'));
-    request.headers.addAll(_getHeaders());
-    request.body = json.encode(body);
+    final encodedBody = json.encode(body);
+    final headers = _getHeaders();
+    if (trace != null) {
+      headers[TurnTrace.header] = trace.markSent();
+    }
 
-    final streamedResponse = await request.send();
+    // 大段粘贴文本以占位符出现在 body 中，由原生缓冲流式写入请求体
+    final streamedResponse = await PasteBufferService.getInstance().send(
+      'POST',
+      Uri.parse('$baseUrl/chat'),
+      headers,
+      encodedBody,
+    );
+    trace?.markHeaders(streamedResponse.statusCode);
 
     if (streamedResponse.statusCode != 200) {
       throw Exception('Chat request failed: ${streamedResponse.statusCode}');
     }
 
-    String? currentEvent;
-    final buffer = StringBuffer();
-
-    await for (var chunk in streamedResponse.stream.transform(utf8.decoder)) {
-      buffer.write(chunk);
-      final content = buffer.toString();
-      final lines = content.split('\n');
-
-      // Keep the last incomplete line in buffer
-      buffer.clear();
-      if (!content.endsWith('\n')) {
-        buffer.write(lines.last);
-        lines.removeLast();
-      }
-
-      for (var line in lines) {
-        line = line.trim();
-        if (line.isEmpty) {
-          // Empty line marks end of event
-          currentEvent = null;
-          continue;
-        }
-
-        if (line.startsWith('event: ')) {
-          currentEvent = line.substring(7);
-        } else if (line.startsWith('data: ')) {
-          final data = line.substring(6);
-          if (data.trim().isNotEmpty && currentEvent != null) {
-            try {
-              final parsed = json.decode(data);
-              // Yield event with type
-              yield {
-                'event_type': currentEvent,
-                ...parsed,
-              };
-            } catch (e) {
-              // Skip invalid JSON
-            }
-          }
-        }
-      }
-    }
+    final responseBody = trace?.tap(streamedResponse.stream) ?? streamedResponse.stream;
+    yield* TurnRecorder.instance.tap('claude', responseBody);
   }
 
   Future<Map<String, dynamic>> loadSessions({String? claudeDir}) async {
@@ -5,6 +5,7 @@ import 'package:path/path.dart' as path;
 import '../models/user_settings.dart';
 import '../models/codex_user_settings.dart';
 import '../models/session_settings.dart';
+import 'settings_snapshot.dart';
 
 /// Agent 模式
 enum AgentMode {
@@ -42,6 +43,11 @@ enum FontSizeOption {
 class AppSettingsService {
   static final AppSettingsService _instance = AppSettingsService._internal();
 
+  // Linux 设置快照中的键
+  static const String _snapshotKey = 'app_settings';
+  static const String _claudeSnapshotKey = 'claude_user_settings';
+  static const String _codexSnapshotKey = 'codex_user_settings';
+
   factory AppSettingsService() => _instance;
 
   AppSettingsService._internal();
@@ -54,8 +60,9 @@ class AppSettingsService {
   FontSizeOption _fontSize = FontSizeOption.normal; // 默认正常字号
   bool _hideToolCalls = false; // 全局隐藏工具调用设置
   bool _renderMarkdown = true; // 全局渲染 Markdown 设置（默认开启）
+  bool _showFramePacing = false; // 显示帧节奏诊断叠加层（仅 Linux）
 
-  // 全局 Agent 设置（内存缓存，从后端加载）
+  // 全局 Agent 设置（内存缓存，从后端加载；Linux 上保存最近一次结果，启动即可显示）
   ClaudeUserSettings? _claudeSettings;
   CodexUserSettings? _codexSettings;
 
@@ -76,10 +83,14 @@ class AppSettingsService {
   FontSizeOption get fontSize => _fontSize;
   bool get hideToolCalls => _hideToolCalls;
   bool get renderMarkdown => _renderMarkdown;
+  bool get showFramePacing => _showFramePacing;
 
   // Getters - Agent 全局设置
-  ClaudeUserSettings? get claudeSettings => _claudeSettings;
-  CodexUserSettings? get codexSettings => _codexSettings;
+  // 缓存只保存最近一次获取的设置；属于其他用户（切换登录后）时视为没有缓存
+  ClaudeUserSettings? claudeSettingsFor(String userId) =>
+      _claudeSettings?.userId == userId ? _claudeSettings : null;
+  CodexUserSettings? codexSettingsFor(String userId) =>
+      _codexSettings?.userId == userId ? _codexSettings : null;
 
   // Getter - 默认项目设置
   SessionSettings? get defaultSessionSettings => _defaultSessionSettings;
@@ -113,78 +124,118 @@ class AppSettingsService {
 
   // 加载设置
   Future<void> _loadSettings() async {
+    // Linux：从 runner 的设置快照同步读取
+    final snapshot = SettingsSnapshot.getInstance();
+    _loadCachedAgentSettings(snapshot);
     try {
+      final stored = snapshot.readJson(_snapshotKey);
+      if (stored != null) {
+        _applySettings(stored);
+        return;
+      }
+
       final filePath = _getSettingsFilePath();
       final file = File(filePath);
 
       if (await file.exists()) {
         final content = await file.readAsString();
         final json = jsonDecode(content) as Map<String, dynamic>;
+        _applySettings(json);
+        // 旧的 JSON 文件迁移到快照
+        snapshot.writeJson(_snapshotKey, json);
+      }
+    } catch (e) {
+      print('Error loading app settings: $e');
+    }
+  }
 
-        _notificationsEnabled = json['notifications_enabled'] as bool? ?? true;
-        _darkModeEnabled = json['dark_mode_enabled'] as bool? ?? false;
-        _notificationVolume = (json['notification_volume'] as num?)?.toDouble() ?? 0.5;
-
-        // 加载字体
-        final fontFamilyName = json['font_family'] as String?;
-        if (fontFamilyName != null) {
-          _fontFamily = FontFamilyOption.values.firstWhere(
-            (f) => f.name == fontFamilyName,
-            orElse: () => FontFamilyOption.notoSerifSC,
-          );
-        }
+  void _applySettings(Map<String, dynamic> json) {
+    _notificationsEnabled = json['notifications_enabled'] as bool? ?? true;
+    _darkModeEnabled = json['dark_mode_enabled'] as bool? ?? false;
+    _notificationVolume = (json['notification_volume'] as num?)?.toDouble() ?? 0.5;
+
+    // 加载字体
+    final fontFamilyName = json['font_family'] as String?;
+    if (fontFamilyName != null) {
+      _fontFamily = FontFamilyOption.values.firstWhere(
+        (f) => f.name == fontFamilyName,
+        orElse: () => FontFamilyOption.notoSerifSC,
+      );
+    }
 
-        // 加载字号
-        final fontSizeName = json['font_size'] as String?;
-        if (fontSizeName != null) {
-          _fontSize = FontSizeOption.values.firstWhere(
-            (f) => f.name == fontSizeName,
-            orElse: () => FontSizeOption.normal,
-          );
-        }
+    // 加载字号
+    final fontSizeName = json['font_size'] as String?;
+    if (fontSizeName != null) {
+      _fontSize = FontSizeOption.values.firstWhere(
+        (f) => f.name == fontSizeName,
+        orElse: () => FontSizeOption.normal,
+      );
+    }
 
-        // 加载隐藏工具调用设置
-        _hideToolCalls = json['hide_tool_calls'] ?? false;
+    // 加载隐藏工具调用设置
+    _hideToolCalls = json['hide_tool_calls'] ?? false;
 
-        // 加载渲染 Markdown 设置
-        _renderMarkdown = json['render_markdown'] ?? true;
+    // 加载渲染 Markdown 设置
+    _renderMarkdown = json['render_markdown'] ?? true;
 
-        // 加载默认项目设置
-        final defaultSessionJson = json['default_session_settings'] as Map<String, dynamic>?;
-        if (defaultSessionJson != null) {
-          try {
-            _defaultSessionSettings = SessionSettings.fromJson(defaultSessionJson);
-          } catch (e) {
-            print('Error parsing default session settings: $e');
-          }
-        }
+    // 加载帧节奏叠加层设置
+    _showFramePacing = json['show_frame_pacing'] ?? false;
+
+    // 加载默认项目设置
+    final defaultSessionJson = json['default_session_settings'] as Map<String, dynamic>?;
+    if (defaultSessionJson != null) {
+      try {
+        _defaultSessionSettings = SessionSettings.fromJson(defaultSessionJson);
+      } catch (e) {
+        print('Error parsing default session settings: $e');
+      }
+    }
+  }
+
+  // 最近一次从后端获取的全局 Agent 设置
+  void _loadCachedAgentSettings(SettingsSnapshot snapshot) {
+    try {
+      final claudeJson = snapshot.readJson(_claudeSnapshotKey);
+      if (claudeJson != null) {
+        _claudeSettings = ClaudeUserSettings.fromJson(claudeJson);
+      }
+      final codexJson = snapshot.readJson(_codexSnapshotKey);
+      if (codexJson != null) {
+        _codexSettings = CodexUserSettings.fromJson(codexJson);
       }
     } catch (e) {
-      print('Error loading app settings: $e');
+      print('Error loading cached agent settings: $e');
     }
   }
 
   // 保存设置
   Future<void> _saveSettings() async {
+    final json = <String, dynamic>{
+      'notifications_enabled': _notificationsEnabled,
+      'dark_mode_enabled': _darkModeEnabled,
+      'notification_volume': _notificationVolume,
+      'font_family': _fontFamily.name,
+      'font_size': _fontSize.name,
+      'hide_tool_calls': _hideToolCalls,
+      'render_markdown': _renderMarkdown,
+      'show_frame_pacing': _showFramePacing,
+    };
+
+    // 保存默认项目设置
+    if (_defaultSessionSettings != null) {
+      json['default_session_settings'] = _defaultSessionSettings!.toJson();
+    }
+
+    final snapshot = SettingsSnapshot.getInstance();
+    if (snapshot.isPlatformSupported) {
+      snapshot.writeJson(_snapshotKey, json);
+      return;
+    }
+
     try {
       final filePath = _getSettingsFilePath();
       final file = File(filePath);
 
-      final json = {
-        'notifications_enabled': _notificationsEnabled,
-        'dark_mode_enabled': _darkModeEnabled,
-        'notification_volume': _notificationVolume,
-        'font_family': _fontFamily.name,
-        'font_size': _fontSize.name,
-        'hide_tool_calls': _hideToolCalls,
-        'render_markdown': _renderMarkdown,
-      };
-
-      // 保存默认项目设置
-      if (_defaultSessionSettings != null) {
-        json['default_session_settings'] = _defaultSessionSettings!.toJson();
-      }
-
       await file.writeAsString(jsonEncode(json));
     } catch (e) {
       print('Error saving app settings: $e');
@@ -234,25 +285,37 @@ class AppSettingsService {
     _notifyListeners();
   }
 
+  void setShowFramePacing(bool value) {
+    _showFramePacing = value;
+    _saveSettings();
+    _notifyListeners();
+  }
+
   // Setters - Agent 全局设置（缓存到内存）
   void setClaudeSettings(ClaudeUserSettings settings) {
     _claudeSettings = settings;
+    // toJson 不含 user_id，fromJson 需要它
+    SettingsSnapshot.getInstance().writeJson(_claudeSnapshotKey, {
+      ...settings.toJson(),
+      'user_id': settings.userId,
+    });
     _notifyListeners();
   }
 
   void setCodexSettings(CodexUserSettings settings) {
     _codexSettings = settings;
+    SettingsSnapshot.getInstance().writeJson(_codexSnapshotKey, settings.toJson());
     _notifyListeners();
   }
 
   // 获取或创建默认 Claude 设置
   ClaudeUserSettings getOrCreateClaudeSettings(String userId) {
-    return _claudeSettings ?? ClaudeUserSettings.defaults(userId);
+    return claudeSettingsFor(userId) ?? ClaudeUserSettings.defaults(userId);
   }
 
   // 获取或创建默认 Codex 设置
   CodexUserSettings getOrCreateCodexSettings(String userId) {
-    return _codexSettings ?? CodexUserSettings.defaults(userId);
+    return codexSettingsFor(userId) ?? CodexUserSettings.defaults(userId);
   }
 
   // Setter - 默认项目设置
@@ -0,0 +1,149 @@
+import 'dart:io';
+import 'dart:typed_data';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 一条后端日志记录
+class BackendLogRecord {
+  final int sequence;
+  final DateTime time;
+  final String stream; // stdout / stderr
+  final String source; // ClaudeSDK、CodexSDK、[Tag] 前缀或流名
+  final String label; // SDK 消息类型
+  final String runId;
+  final String sessionId;
+  final bool isJson; // text 为压缩后的 SDK 消息 JSON
+  final String text;
+
+  BackendLogRecord({
+    required this.sequence,
+    required this.time,
+    required this.stream,
+    required this.source,
+    required this.label,
+    required this.runId,
+    required this.sessionId,
+    required this.isJson,
+    required this.text,
+  });
+
+  factory BackendLogRecord.fromMap(Map<dynamic, dynamic> map) {
+    return BackendLogRecord(
+      sequence: map['sequence'] as int,
+      time: DateTime.fromMicrosecondsSinceEpoch(map['time'] as int),
+      stream: map['stream'] as String,
+      source: map['source'] as String,
+      label: map['label'] as String,
+      runId: map['runId'] as String,
+      sessionId: map['sessionId'] as String,
+      isJson: map['json'] as bool,
+      text: map['text'] as String,
+    );
+  }
+}
+
+/// 后端输出的结构化存储（Linux 原生实现）
+///
+/// 后端的 stdout/stderr 原样交给 runner，由它把多行的 `[ClaudeSDK:label]`
+/// 记录分帧、按来源/类型/运行/会话建立索引并压缩保存。SDK 记录只在这里保存，
+/// 其余输出仍由 BackendProcessService 打印；按条件查询时只取回需要的记录。
+class BackendLogService {
+  static BackendLogService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/backend_log');
+
+  BackendLogService._();
+
+  static BackendLogService getInstance() {
+    _instance ??= BackendLogService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供日志存储）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 交给 runner 一段原始输出；[stream] 为 'stdout' 或 'stderr'
+  void append(String stream, List<int> data) {
+    _channel.invokeMethod('append', {
+      'stream': stream,
+      'data': data is Uint8List ? data : Uint8List.fromList(data),
+    }).catchError((e) {
+      print('ERROR BackendLogService: Failed to append output: $e');
+    });
+  }
+
+  /// 后端退出时调用，保存未结束的记录
+  void flush() {
+    _channel.invokeMethod('flush').catchError((e) {
+      print('ERROR BackendLogService: Failed to flush: $e');
+    });
+  }
+
+  /// 查询记录（按时间先后）；各条件为空时不过滤
+  /// [before] 为上一页第一条的 sequence，用于向前翻页
+  Future<List<BackendLogRecord>> query({
+    String? source,
+    String? label,
+    String? runId,
+    String? sessionId,
+    int? before,
+    int limit = 200,
+  }) async {
+    if (!isPlatformSupported) return [];
+
+    try {
+      final result = await _channel.invokeListMethod<Map<dynamic, dynamic>>('query', {
+        if (source != null) 'source': source,
+        if (label != null) 'label': label,
+        if (runId != null) 'runId': runId,
+        if (sessionId != null) 'sessionId': sessionId,
+        if (before != null) 'before': before,
+        'limit': limit,
+      });
+      return (result ?? []).map(BackendLogRecord.fromMap).toList();
+    } catch (e) {
+      print('ERROR BackendLogService: Failed to query: $e');
+      return [];
+    }
+  }
+
+  /// 日志中出现过的运行（最近的在前）：runId、sessionId、records、firstTime、lastTime
+  Future<List<Map<String, dynamic>>> runs() async {
+    if (!isPlatformSupported) return [];
+
+    try {
+      final result = await _channel.invokeListMethod<Map<dynamic, dynamic>>('runs');
+      return (result ?? []).map((run) => run.cast<String, dynamic>()).toList();
+    } catch (e) {
+      print('ERROR BackendLogService: Failed to list runs: $e');
+      return [];
+    }
+  }
+
+  /// 存储统计：records、dropped、rawBytes、storedBytes
+  Future<Map<String, dynamic>> stats() async {
+    if (!isPlatformSupported) return {};
+
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('stats');
+      return result ?? {};
+    } catch (e) {
+      print('ERROR BackendLogService: Failed to load stats: $e');
+      return {};
+    }
+  }
+
+  /// 清空已保存的记录
+  Future<void> clear() async {
+    if (!isPlatformSupported) return;
+
+    try {
+      await _channel.invokeMethod('clear');
+    } catch (e) {
+      print('ERROR BackendLogService: Failed to clear: $e');
+    }
+  }
+}
@@ -1,7 +1,9 @@
 import 'dart:io';
 import 'dart:async';
+import 'dart:convert';
 import 'package:path/path.dart' as path;
 import 'package:http/http.dart' as http;
+import 'backend_log_service.dart';
 
 /// 后端进程管理服务（桌面平台：Windows/macOS/Linux）
 /// 负责在应用启动时自动启动后端，应用退出时自动关闭后端
@@ -197,8 +199,16 @@ class BackendProcessService {
 
       // 只有 exe 打包模式才监听输出（cmd 和 node 都使用 detached，无法监听）
       if (!isDevMode && !isNodeBundle) {
-        // 监听输出
+        // 监听输出：Linux 上交给 runner 分帧并建立索引（见 BackendLogService），
+        // 只打印 SDK 记录以外的行；其他平台逐段打印。stderr 始终打印
+        final backendLog = BackendLogService.getInstance();
+        final stdoutEcho = _NonSdkLineEcho('Backend stdout');
         _backendProcess!.stdout.listen((data) {
+          if (backendLog.isPlatformSupported) {
+            backendLog.append('stdout', data);
+            stdoutEcho.add(data);
+            return;
+          }
           final output = String.fromCharCodes(data);
           if (output.trim().isNotEmpty) {
             print('Backend stdout: $output');
@@ -206,6 +216,9 @@ class BackendProcessService {
         }, onError: (error) => print('Backend stdout error: $error'));
 
         _backendProcess!.stderr.listen((data) {
+          if (backendLog.isPlatformSupported) {
+            backendLog.append('stderr', data);
+          }
           final output = String.fromCharCodes(data);
           if (output.trim().isNotEmpty) {
             print('Backend stderr: $output');
@@ -215,6 +228,7 @@ class BackendProcessService {
         // 监听进程退出
         _backendProcess!.exitCode.then((exitCode) {
           print('DEBUG BackendProcessService: Backend exited with code $exitCode');
+          if (backendLog.isPlatformSupported) backendLog.flush();
           _isBackendRunning = false;
         }).catchError((error) {
           print('DEBUG BackendProcessService: Backend exit error: $error');
@@ -420,3 +434,40 @@ class BackendProcessService {
   /// 获取后端 URL
   String get backendUrl => 'http://127.0.0.1:$_currentPort';
 }
+
+/// 逐行打印后端输出中 SDK 记录以外的行
+///
+/// SDK 记录以单独一行的 `[Source:label ...]` 开头，到空行结束（见后端的
+/// logSdkMessage）；它们体积大，只保存在 runner 的日志存储中。
+class _NonSdkLineEcho {
+  static final RegExp _sdkHeader = RegExp(r'^\[[A-Za-z0-9_.-]+:[^ \]]+[^\]]*\]$');
+
+  final String _prefix;
+  final List<int> _partial = []; // 未结束的行（可能截断在多字节字符中间）
+  bool _inSdkRecord = false;
+
+  _NonSdkLineEcho(this._prefix);
+
+  void add(List<int> data) {
+    final end = data.lastIndexOf(10); // '\n'
+    if (end < 0) {
+      _partial.addAll(data);
+      return;
+    }
+    final bytes = [..._partial, ...data.sublist(0, end)];
+    _partial
+      ..clear()
+      ..addAll(data.sublist(end + 1));
+
+    for (var line in utf8.decode(bytes, allowMalformed: true).split('\n')) {
+      if (line.endsWith('\r')) line = line.substring(0, line.length - 1);
+      if (_sdkHeader.hasMatch(line)) {
+        _inSdkRecord = true;
+      } else if (line.isEmpty) {
+        _inSdkRecord = false;
+      } else if (!_inSdkRecord) {
+        print('$_prefix: $line');
+      }
+    }
+  }
+}
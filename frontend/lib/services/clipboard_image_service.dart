@@ -0,0 +1,108 @@
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 原生剪贴板图片附件
+///
+/// 图片已在 runner 中缩放并重新编码，编码结果保存在私有临时文件里；
+/// Dart 侧只持有句柄和文件路径（用于预览），发送时再取 base64。
+class ClipboardImageAttachment {
+  final String handle;
+  final String path;
+  final String mediaType;
+  final int width;
+  final int height;
+  final int sourceWidth;
+  final int sourceHeight;
+  final int byteLength;
+
+  const ClipboardImageAttachment({
+    required this.handle,
+    required this.path,
+    required this.mediaType,
+    required this.width,
+    required this.height,
+    required this.sourceWidth,
+    required this.sourceHeight,
+    required this.byteLength,
+  });
+
+  factory ClipboardImageAttachment.fromMap(Map<String, dynamic> map) {
+    return ClipboardImageAttachment(
+      handle: map['handle'] as String,
+      path: map['path'] as String,
+      mediaType: map['mediaType'] as String? ?? 'image/png',
+      width: map['width'] as int? ?? 0,
+      height: map['height'] as int? ?? 0,
+      sourceWidth: map['sourceWidth'] as int? ?? 0,
+      sourceHeight: map['sourceHeight'] as int? ?? 0,
+      byteLength: map['byteLength'] as int? ?? 0,
+    );
+  }
+}
+
+/// 剪贴板图片快速通道（Linux 原生实现）
+///
+/// 直接通过 GtkClipboard 读取图片，在工作线程中缩放和编码，
+/// 避免把全分辨率截图交给 Dart 再做 base64 编码导致粘贴卡顿。
+class ClipboardImageService {
+  static ClipboardImageService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/clipboard_image');
+
+  ClipboardImageService._();
+
+  static ClipboardImageService getInstance() {
+    _instance ??= ClipboardImageService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 读取剪贴板中的图片；剪贴板没有图片或读取失败时返回 null
+  /// [maxDimension] 为缩放后最长边的像素数
+  Future<ClipboardImageAttachment?> readImage({int? maxDimension}) async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('readImage', {
+        if (maxDimension != null) 'maxDimension': maxDimension,
+      });
+      if (result == null) return null;
+      final attachment = ClipboardImageAttachment.fromMap(result);
+      print('DEBUG ClipboardImageService: ${attachment.sourceWidth}x${attachment.sourceHeight} -> '
+          '${attachment.width}x${attachment.height} ${attachment.mediaType} (${attachment.byteLength} bytes)');
+      return attachment;
+    } catch (e) {
+      print('ERROR ClipboardImageService: Failed to read clipboard image: $e');
+      return null;
+    }
+  }
+
+  /// 发送时获取附件的 base64 编码
+  Future<String?> loadBase64(String handle) async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      return await _channel.invokeMethod<String>('loadBase64', {'handle': handle});
+    } catch (e) {
+      print('ERROR ClipboardImageService: Failed to load $handle: $e');
+      return null;
+    }
+  }
+
+  /// 释放附件（删除临时文件）
+  Future<void> release(String handle) async {
+    if (!isPlatformSupported) return;
+
+    try {
+      await _channel.invokeMethod('release', {'handle': handle});
+    } catch (e) {
+      print('ERROR ClipboardImageService: Failed to release $handle: $e');
+    }
+  }
+}
@@ -2,6 +2,9 @@ import 'dart:convert';
 import 'package:http/http.dart' as http;
 import '../models/session_settings.dart';
 import 'auth_service.dart';
+import 'paste_buffer_service.dart';
+import 'soak_service.dart';
+import 'sse_stream.dart';
 
 class CodexApiService {
   String baseUrl;
@@ -33,14 +36,19 @@ class CodexApiService {
   }
 
   Future<List<Map<String, dynamic>>> getSessions() async {
+    final List<dynamic> data = json.decode(await getSessionsJson());
+    return data.cast<Map<String, dynamic>>();
+  }
+
+  /// 会话列表的原始 JSON，交给原生项目索引解析
+  Future<String> getSessionsJson() async {
     final response = await http.get(
       Uri.parse('$baseUrl/codex/sessions'),
       headers: _getHeaders(),
     );
 
     if (response.statusCode == 200) {
-      final List<dynamic> data = json.decode(response.body);
-      return data.cast<Map<String, dynamic>>();
+      return response.body;
     } else {
       throw Exception('Failed to load codex sessions: ${response.statusCode}');
     }
@@ -79,6 +87,36 @@ class CodexApiService {
     bool? networkAccessEnabled,
     bool? webSearchEnabled,
     bool? skipGitRepoCheck,
+  }) {
+    return decodeSseEvents(chatBytes(
+      sessionId: sessionId,
+      message: message,
+      cwd: cwd,
+      settings: settings,
+      approvalPolicy: approvalPolicy,
+      sandboxMode: sandboxMode,
+      model: model,
+      modelReasoningEffort: modelReasoningEffort,
+      networkAccessEnabled: networkAccessEnabled,
+      webSearchEnabled: webSearchEnabled,
+      skipGitRepoCheck: skipGitRepoCheck,
+    ));
+  }
+
+  /// 发送聊天请求并返回原始 SSE 响应体（供原生事件规范化器直接消费）
+  Stream<List<int>> chatBytes({
+    String? sessionId,
+    required String message,
+    String? cwd,
+    SessionSettings? settings,
+    // Codex-specific parameters
+    String? approvalPolicy,
+    String? sandboxMode,
+    String? model,
+    String? modelReasoningEffort,
+    bool? networkAccessEnabled,
+    bool? webSearchEnabled,
+    bool? skipGitRepoCheck,
   }) async* {
     final body = <String, dynamic>{};
 
@@ -124,58 +162,19 @@ class CodexApiService {
       body['setting_sources'] = settings.settingSources;
     }
 
-    final request = http.Request('POST', Uri.parse('$baseUrl/codex/chat'));
-    request.headers.addAll(_getHeaders());
-    request.body = json.encode(body);
-
-    final streamedResponse = await request.send();
+    // 大段粘贴文本以占位符出现在 body 中，由原生缓冲流式写入请求体
+    final streamedResponse = await PasteBufferService.getInstance().send(
+      'POST',
+      Uri.parse('$baseUrl/codex/chat'),
+      _getHeaders(),
+      json.encode(body),
+    );
 
     if (streamedResponse.statusCode != 200) {
       throw Exception('Codex chat request failed: ${streamedResponse.statusCode}');
     }
 
-    String? currentEvent;
-    final buffer = StringBuffer();
-
-    await for (var chunk in streamedResponse.stream.transform(utf8.decoder)) {
-      buffer.write(chunk);
-      final content = buffer.toString();
-      final lines = content.split('\n');
-
-      // Keep the last incomplete line in buffer
-      buffer.clear();
-      if (!content.endsWith('\n')) {
-        buffer.write(lines.last);
-        lines.removeLast();
-      }
-
-      for (var line in lines) {
-        line = line.trim();
-        if (line.isEmpty) {
-          // Empty line marks end of event
-          currentEvent = null;
-          continue;
-        }
-
-        if (line.startsWith('event: ')) {
-          currentEvent = line.substring(7);
-        } else if (line.startsWith('data: ')) {
-          final data = line.substring(6);
-          if (data.trim().isNotEmpty && currentEvent != null) {
-            try {
-              final parsed = json.decode(data);
-              // Yield event with type
-              yield {
-                'event_type': currentEvent,
-                ...parsed,
-              };
-            } catch (e) {
-              // Skip invalid JSON
-            }
-          }
-        }
-      }
-    }
+    yield* TurnRecorder.instance.tap('codex', streamedResponse.stream);
   }
 
   Future<Map<String, dynamic>> loadSessions({String? codexDir}) async {
@@ -1,9 +1,11 @@
 import 'dart:io';
 import 'dart:convert';
+import 'settings_snapshot.dart';
 
 class ConfigService {
   static ConfigService? _instance;
   static const String _fileName = 'app_config.json';
+  static const String _snapshotKey = 'app_config'; // Linux 设置快照中的键
 
   String _apiBaseUrl = 'http://127.0.0.1:8207'; // 默认值
   String _preferredBackend = 'claude_code'; // 默认使用 Claude Code
@@ -75,7 +77,16 @@ class ConfigService {
   }
 
   Future<void> _loadConfig() async {
+    // Linux：从 runner 的设置快照同步读取
+    final snapshot = SettingsSnapshot.getInstance();
     try {
+      final stored = snapshot.readJson(_snapshotKey);
+      if (stored != null) {
+        _applyConfig(stored);
+        print('DEBUG ConfigService: Loaded config from settings snapshot, API URL: $_apiBaseUrl');
+        return;
+      }
+
       final filePath = _getConfigFilePath();
       print('DEBUG ConfigService: Loading config from: $filePath');
       final file = File(filePath);
@@ -83,10 +94,9 @@ class ConfigService {
         final content = await file.readAsString();
         print('DEBUG ConfigService: Loaded config content: $content');
         final json = jsonDecode(content) as Map<String, dynamic>;
-        _apiBaseUrl = json['apiBaseUrl'] as String? ?? 'http://127.0.0.1:8207';
-        _preferredBackend = json['preferredBackend'] as String? ?? 'claude_code';
-        _debugLogEnabled = json['debugLogEnabled'] as bool? ?? false;
-        _hasAutoConfigured = json['hasAutoConfigured'] as bool? ?? false;
+        _applyConfig(json);
+        // 旧的 JSON 配置迁移到快照
+        snapshot.writeJson(_snapshotKey, json);
         print('DEBUG ConfigService: Loaded API URL: $_apiBaseUrl');
         print('DEBUG ConfigService: Loaded preferred backend: $_preferredBackend');
         print('DEBUG ConfigService: Loaded debug log enabled: $_debugLogEnabled');
@@ -104,16 +114,29 @@ class ConfigService {
     }
   }
 
+  void _applyConfig(Map<String, dynamic> json) {
+    _apiBaseUrl = json['apiBaseUrl'] as String? ?? 'http://127.0.0.1:8207';
+    _preferredBackend = json['preferredBackend'] as String? ?? 'claude_code';
+    _debugLogEnabled = json['debugLogEnabled'] as bool? ?? false;
+    _hasAutoConfigured = json['hasAutoConfigured'] as bool? ?? false;
+  }
+
   Future<void> _saveConfig() async {
+    final json = {
+      'apiBaseUrl': _apiBaseUrl,
+      'preferredBackend': _preferredBackend,
+      'debugLogEnabled': _debugLogEnabled,
+      'hasAutoConfigured': _hasAutoConfigured,
+    };
+    final snapshot = SettingsSnapshot.getInstance();
+    if (snapshot.isPlatformSupported) {
+      snapshot.writeJson(_snapshotKey, json);
+      return;
+    }
+
     try {
       final filePath = _getConfigFilePath();
       final file = File(filePath);
-      final json = {
-        'apiBaseUrl': _apiBaseUrl,
-        'preferredBackend': _preferredBackend,
-        'debugLogEnabled': _debugLogEnabled,
-        'hasAutoConfigured': _hasAutoConfigured,
-      };
       final jsonString = jsonEncode(json);
       print('DEBUG ConfigService: Saving config: $jsonString to: $filePath');
       await file.writeAsString(jsonString);
@@ -0,0 +1,120 @@
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 一组时长的分位数（微秒）
+class FramePercentiles {
+  final int p50;
+  final int p90;
+  final int p99;
+  final int max;
+
+  const FramePercentiles({this.p50 = 0, this.p90 = 0, this.p99 = 0, this.max = 0});
+
+  factory FramePercentiles.fromMap(Map? map) {
+    if (map == null) return const FramePercentiles();
+    return FramePercentiles(
+      p50: map['p50'] as int? ?? 0,
+      p90: map['p90'] as int? ?? 0,
+      p99: map['p99'] as int? ?? 0,
+      max: map['max'] as int? ?? 0,
+    );
+  }
+}
+
+/// 一组帧的统计
+class FrameGroupStats {
+  final int frames;
+  final int missedVblanks;
+  final FramePercentiles interval; // 连续帧之间的间隔
+  final FramePercentiles paint; // 从帧开始到绘制结束
+  final FramePercentiles lateness; // 实际上屏晚于预测的时间
+
+  const FrameGroupStats({
+    this.frames = 0,
+    this.missedVblanks = 0,
+    this.interval = const FramePercentiles(),
+    this.paint = const FramePercentiles(),
+    this.lateness = const FramePercentiles(),
+  });
+
+  factory FrameGroupStats.fromMap(Map? map) {
+    if (map == null) return const FrameGroupStats();
+    return FrameGroupStats(
+      frames: map['frames'] as int? ?? 0,
+      missedVblanks: map['missedVblanks'] as int? ?? 0,
+      interval: FramePercentiles.fromMap(map['intervalUs'] as Map?),
+      paint: FramePercentiles.fromMap(map['paintUs'] as Map?),
+      lateness: FramePercentiles.fromMap(map['latenessUs'] as Map?),
+    );
+  }
+}
+
+/// 最近一段时间窗口内的帧节奏统计
+class FramePacingStats {
+  final int windowSeconds;
+  final int refreshIntervalUs;
+  final int activeStreams;
+  final double eventsPerSecond; // 流式回复的事件速率
+  final FrameGroupStats all;
+  final FrameGroupStats streaming; // 仅统计有回复正在流式输出时的帧
+
+  const FramePacingStats({
+    required this.windowSeconds,
+    required this.refreshIntervalUs,
+    required this.activeStreams,
+    required this.eventsPerSecond,
+    required this.all,
+    required this.streaming,
+  });
+
+  factory FramePacingStats.fromMap(Map map) {
+    return FramePacingStats(
+      windowSeconds: map['windowSeconds'] as int? ?? 0,
+      refreshIntervalUs: map['refreshIntervalUs'] as int? ?? 0,
+      activeStreams: map['activeStreams'] as int? ?? 0,
+      eventsPerSecond: (map['eventsPerSecond'] as num?)?.toDouble() ?? 0,
+      all: FrameGroupStats.fromMap(map['all'] as Map?),
+      streaming: FrameGroupStats.fromMap(map['streaming'] as Map?),
+    );
+  }
+}
+
+/// 帧节奏统计服务（Linux 原生实现）
+///
+/// runner 订阅主窗口的 GdkFrameClock，记录帧间隔、绘制耗时、掉帧和上屏延迟，
+/// 并按当时是否有回复在流式输出分组，用于诊断叠加层。
+class FramePacingService {
+  static FramePacingService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/frame_pacing');
+
+  FramePacingService._();
+
+  static FramePacingService getInstance() {
+    _instance ??= FramePacingService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 最近 [windowSeconds] 秒（最多 10 秒）的统计；不支持或失败时返回 null
+  Future<FramePacingStats?> getStats({int windowSeconds = 10}) async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>(
+        'getStats',
+        {'windowSeconds': windowSeconds},
+      );
+      return result == null ? null : FramePacingStats.fromMap(result);
+    } catch (e) {
+      print('ERROR FramePacingService: Failed to get stats: $e');
+      return null;
+    }
+  }
+}
@@ -0,0 +1,170 @@
+import 'dart:async';
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:typed_data';
+import 'package:flutter/foundation.dart';
+
+// runner 导出的桥接初始化入口（linux/isolate_bridge.h）
+typedef _BridgeInitNative = Void Function(Pointer<Void> postCObject);
+typedef _BridgeInitDart = void Function(Pointer<Void> postCObject);
+
+/// 原生结果的后台处理 isolate（Linux）
+///
+/// 大块原生结果（如缓存的整段会话记录）不经平台线程回复，而由 runner 通过
+/// Dart_PostCObject 直接投递到这个常驻 isolate 的原生端口（外部字节数组，
+/// 不复制）。解码、构建模型等工作在这里完成，UI isolate 只收到可直接渲染
+/// 的结果。
+///
+/// 用法：[run] 的 request 把端口号和任务号交给原生方法调用，materialize 在
+/// 后台 isolate 中把收到的字节转成结果。materialize 必须能发送到其他
+/// isolate（顶层/静态函数，或只捕获可发送值的闭包）。
+class NativeResultWorker {
+  static NativeResultWorker? _instance;
+
+  Future<_WorkerHandle?>? _starting;
+  final Map<int, Completer<Object?>> _pending = {};
+  int _nextJob = 1;
+
+  NativeResultWorker._();
+
+  static NativeResultWorker getInstance() {
+    _instance ??= NativeResultWorker._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供桥接）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 发起一个任务；[request] 返回 false 表示原生侧不会投递结果
+  /// 失败时返回 null
+  Future<R?> run<R>({
+    required Future<bool> Function(int port, int job) request,
+    required R Function(Uint8List bytes) materialize,
+  }) async {
+    final worker = await (_starting ??= _start());
+    if (worker == null) return null;
+
+    final job = _nextJob++;
+    final completer = Completer<Object?>();
+    _pending[job] = completer;
+    // 任务先登记到后台 isolate；原生投递与登记的到达顺序不确定，两边都会等待对方
+    worker.jobs.send(_Job(job, materialize));
+
+    var requested = false;
+    try {
+      requested = await request(worker.nativePort, job);
+    } catch (e) {
+      print('ERROR NativeResultWorker: Request for job $job failed: $e');
+    }
+    if (!requested) {
+      _pending.remove(job);
+      worker.jobs.send(job); // 取消
+      return null;
+    }
+    return await completer.future as R?;
+  }
+
+  Future<_WorkerHandle?> _start() async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      DynamicLibrary.process()
+          .lookupFunction<_BridgeInitNative, _BridgeInitDart>('codeagenthub_isolate_bridge_init')(
+        NativeApi.postCObject.cast(),
+      );
+
+      final results = RawReceivePort();
+      final ready = Completer<_WorkerHandle>();
+      results.handler = (Object? message) {
+        if (!ready.isCompleted) {
+          final ports = message as List;
+          ready.complete(_WorkerHandle(ports[0] as SendPort, ports[1] as int));
+          return;
+        }
+        _handleResult(message as List);
+      };
+      await Isolate.spawn(_workerMain, results.sendPort, debugName: 'native_result_worker');
+      return await ready.future;
+    } catch (e) {
+      print('ERROR NativeResultWorker: Failed to start: $e');
+      return null;
+    }
+  }
+
+  // [job, result] 或 [job, null, error]
+  void _handleResult(List message) {
+    final completer = _pending.remove(message[0] as int);
+    if (completer == null) return;
+    if (message.length > 2) {
+      print('ERROR NativeResultWorker: Job ${message[0]} failed: ${message[2]}');
+      completer.complete(null);
+    } else {
+      completer.complete(message[1]);
+    }
+  }
+}
+
+class _WorkerHandle {
+  final SendPort jobs;
+  final int nativePort;
+
+  _WorkerHandle(this.jobs, this.nativePort);
+}
+
+class _Job {
+  final int id;
+  final Object? Function(Uint8List bytes) materialize;
+
+  _Job(this.id, this.materialize);
+}
+
+// 后台 isolate：原生投递 [job, Uint8List | 错误信息]，UI isolate 投递 _Job 或取消的任务号
+void _workerMain(SendPort results) {
+  final jobs = ReceivePort();
+  final nativeInbox = RawReceivePort();
+  final waitingJobs = <int, _Job>{};
+  final earlyPayloads = <int, Object?>{};
+
+  void complete(_Job job, Object? payload) {
+    if (payload is Uint8List) {
+      try {
+        results.send([job.id, job.materialize(payload)]);
+      } catch (e) {
+        results.send([job.id, null, '$e']);
+      }
+    } else {
+      results.send([job.id, null, '$payload']);
+    }
+  }
+
+  nativeInbox.handler = (Object? message) {
+    final list = message as List;
+    final id = list[0] as int;
+    final job = waitingJobs.remove(id);
+    if (job != null) {
+      complete(job, list[1]);
+    } else {
+      earlyPayloads[id] = list[1];
+    }
+  };
+
+  jobs.listen((Object? message) {
+    if (message is int) {
+      waitingJobs.remove(message);
+      earlyPayloads.remove(message);
+      return;
+    }
+    final job = message as _Job;
+    if (earlyPayloads.containsKey(job.id)) {
+      complete(job, earlyPayloads.remove(job.id));
+    } else {
+      waitingJobs[job.id] = job;
+    }
+  });
+
+  results.send([jobs.sendPort, nativeInbox.sendPort.nativePort]);
+}
@@ -0,0 +1,69 @@
+/// 由字段级更新逐步构建的 JSON 对象
+///
+/// 字段级更新（字段出现、字符串追加、字段完成）由 runner 中的可恢复解析器
+/// 产生，随标准化流的 input 增量送达。
+///
+/// [value] 随更新到达而增长：字段一出现就可读，字符串字段边接收边追加。
+/// [completedFields] 记录已完整接收的顶层字段（例如 file_path 已确定）。
+class PartialJsonValue {
+  final Map<String, dynamic> value = {};
+  final Set<String> completedFields = {};
+
+  void apply(List<Map<String, dynamic>> updates) {
+    for (final update in updates) {
+      final path = update['path'] as List? ?? const [];
+      // 根节点就是 value 本身（tool input 总是对象）
+      if (path.isEmpty) continue;
+
+      // 定位到父容器
+      dynamic parent = value;
+      for (var i = 0; i < path.length - 1; i++) {
+        parent = parent is List ? parent[path[i] as int] : parent[path[i] as String];
+        if (parent == null) break;
+      }
+      if (parent == null) continue;
+      final last = path.last;
+
+      switch (update['op']) {
+        case 'set':
+          final newValue = copyValue(update['value']);
+          if (parent is List) {
+            if (last as int < parent.length) {
+              parent[last] = newValue;
+            } else {
+              parent.add(newValue);
+            }
+          } else if (parent is Map) {
+            parent[last as String] = newValue;
+          }
+          break;
+        case 'append':
+          final text = update['text'] as String? ?? '';
+          if (parent is List) {
+            parent[last as int] = (parent[last] as String? ?? '') + text;
+          } else if (parent is Map) {
+            parent[last as String] = (parent[last] as String? ?? '') + text;
+          }
+          break;
+        case 'complete':
+          if (path.length == 1 && last is String) {
+            completedFields.add(last);
+          }
+          break;
+      }
+    }
+  }
+
+  // 平台通道返回的容器是不可变的 Map<Object?, Object?>，转换为可修改的类型
+  static dynamic copyValue(dynamic v) {
+    if (v is Map) {
+      return <String, dynamic>{
+        for (final entry in v.entries) entry.key as String: copyValue(entry.value),
+      };
+    }
+    if (v is List) {
+      return <dynamic>[for (final item in v) copyValue(item)];
+    }
+    return v;
+  }
+}
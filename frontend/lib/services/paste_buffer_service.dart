@@ -0,0 +1,203 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+import 'package:http/http.dart' as http;
+
+/// 保存在 runner 中的大段粘贴文本
+///
+/// 输入框中只显示行数和大小，文本本身在发送时才写入请求体。
+class PastedText {
+  final String handle;
+  final int bytes;
+  final int lines;
+  final int escapedBytes; // JSON 字符串转义后的长度
+  final int tokens;
+  final String preview; // 第一行非空内容的开头
+
+  const PastedText({
+    required this.handle,
+    required this.bytes,
+    required this.lines,
+    required this.escapedBytes,
+    required this.tokens,
+    required this.preview,
+  });
+
+  factory PastedText.fromMap(Map<String, dynamic> map) {
+    return PastedText(
+      handle: map['handle'] as String,
+      bytes: map['bytes'] as int? ?? 0,
+      lines: map['lines'] as int? ?? 0,
+      escapedBytes: map['escapedBytes'] as int? ?? 0,
+      tokens: map['tokens'] as int? ?? 0,
+      preview: map['preview'] as String? ?? '',
+    );
+  }
+
+  /// 请求中代替文本的占位符，写出请求体时替换为原文
+  String get placeholder => '\u0000paste:$handle\u0000';
+
+  /// 紧凑的大小说明，例如 "1,234 行 · 2.3 MB"
+  String get summary {
+    final String size;
+    if (bytes >= 1024 * 1024) {
+      size = '${(bytes / (1024 * 1024)).toStringAsFixed(1)} MB';
+    } else {
+      size = '${(bytes / 1024).toStringAsFixed(1)} KB';
+    }
+    final digits = lines.toString();
+    final grouped = digits.replaceAllMapped(RegExp(r'\B(?=(\d{3})+$)'), (_) => ',');
+    return '$grouped 行 · $size';
+  }
+}
+
+/// 剪贴板文本的读取结果：小段文本直接插入输入框，大段文本成为附件
+class ClipboardPaste {
+  final String? text;
+  final PastedText? attachment;
+
+  const ClipboardPaste({this.text, this.attachment});
+}
+
+/// 大段粘贴缓冲服务（Linux 原生实现）
+///
+/// 粘贴前先在 runner 中检查剪贴板文本的大小：超过阈值的文本保存在原生端，
+/// 避免把数 MB 的日志交给 TextField 排版；发送时请求体以流的形式写出，
+/// 原文按块取回并已完成 JSON 转义。
+class PasteBufferService {
+  static PasteBufferService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/paste_buffer');
+
+  /// 超过任一阈值的文本转为附件
+  static const int thresholdBytes = 32 * 1024;
+  static const int thresholdLines = 500;
+
+  /// 写出请求体时每次取回的原文字节数
+  static const int _chunkBytes = 1024 * 1024;
+
+  static final RegExp _placeholderPattern = RegExp(r'\\u0000paste:([\w-]+)\\u0000');
+
+  /// 尚未释放的附件，写出请求体时据此识别占位符
+  final Map<String, PastedText> _texts = {};
+
+  PasteBufferService._();
+
+  static PasteBufferService getInstance() {
+    _instance ??= PasteBufferService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 读取剪贴板文本；剪贴板没有文本或读取失败时返回 null
+  Future<ClipboardPaste?> readText() async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('readText', {
+        'thresholdBytes': thresholdBytes,
+        'thresholdLines': thresholdLines,
+      });
+      if (result == null) return null;
+      final attachment = result['attachment'];
+      if (attachment is Map) {
+        final text = PastedText.fromMap(Map<String, dynamic>.from(attachment));
+        _texts[text.handle] = text;
+        print('DEBUG PasteBufferService: ${text.handle} ${text.lines} lines, ${text.bytes} bytes');
+        return ClipboardPaste(attachment: text);
+      }
+      return ClipboardPaste(text: result['text'] as String?);
+    } catch (e) {
+      print('ERROR PasteBufferService: Failed to read clipboard text: $e');
+      return null;
+    }
+  }
+
+  /// 释放附件
+  Future<void> release(String handle) async {
+    if (!isPlatformSupported) return;
+
+    _texts.remove(handle);
+    try {
+      await _channel.invokeMethod('release', {'handle': handle});
+    } catch (e) {
+      print('ERROR PasteBufferService: Failed to release $handle: $e');
+    }
+  }
+
+  /// 发送 JSON 请求
+  ///
+  /// [encodedBody] 中含有附件占位符时，以流式请求发送：占位符之间的内容
+  /// 原样写出，占位符处写入原生端转义好的原文，Content-Length 预先算出。
+  Future<http.StreamedResponse> send(
+    String method,
+    Uri url,
+    Map<String, String> headers,
+    String encodedBody,
+  ) async {
+    final matches = _placeholderPattern
+        .allMatches(encodedBody)
+        .where((match) => _texts.containsKey(match.group(1)))
+        .toList();
+    if (matches.isEmpty) {
+      final request = http.Request(method, url);
+      request.headers.addAll(headers);
+      request.body = encodedBody;
+      return request.send();
+    }
+
+    final parts = <Object>[]; // Uint8List 或 PastedText
+    var contentLength = 0;
+    var literalStart = 0;
+    for (final match in matches) {
+      final literal = utf8.encode(encodedBody.substring(literalStart, match.start));
+      final text = _texts[match.group(1)]!;
+      parts..add(literal)..add(text);
+      contentLength += literal.length + text.escapedBytes;
+      literalStart = match.end;
+    }
+    final tail = utf8.encode(encodedBody.substring(literalStart));
+    parts.add(tail);
+    contentLength += tail.length;
+
+    final request = http.StreamedRequest(method, url);
+    request.headers.addAll(headers);
+    request.contentLength = contentLength;
+    final response = request.send();
+    // 写出失败时请求以错误结束
+    unawaited(_writeParts(parts, request.sink));
+    return response;
+  }
+
+  Future<void> _writeParts(List<Object> parts, EventSink<List<int>> sink) async {
+    try {
+      for (final part in parts) {
+        if (part is PastedText) {
+          for (var offset = 0; offset < part.bytes; offset += _chunkBytes) {
+            final chunk = await _channel.invokeMethod<Uint8List>('readChunk', {
+              'handle': part.handle,
+              'offset': offset,
+              'length': _chunkBytes,
+            });
+            sink.add(chunk!);
+          }
+        } else {
+          sink.add(part as List<int>);
+        }
+      }
+    } catch (e) {
+      print('ERROR PasteBufferService: Failed to write request body: $e');
+      sink.addError(e);
+    } finally {
+      sink.close();
+    }
+  }
+}
@@ -0,0 +1,93 @@
+import 'dart:async';
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 电源策略
+///
+/// 由 runner 根据电源（UPower）和电源模式（power-profiles-daemon）计算。
+class PowerPolicy {
+  final bool onBattery;
+  final String profile; // performance / balanced / power-saver，未知时为空
+  final String level; // full / balanced / saver
+  final int streamCoalesceMs; // 流式回复中部分消息更新的最小间隔
+  final double refreshIntervalScale; // 定时刷新间隔的倍率
+
+  const PowerPolicy({
+    this.onBattery = false,
+    this.profile = '',
+    this.level = 'full',
+    this.streamCoalesceMs = 0,
+    this.refreshIntervalScale = 1.0,
+  });
+
+  factory PowerPolicy.fromMap(Map map) {
+    return PowerPolicy(
+      onBattery: map['onBattery'] as bool? ?? false,
+      profile: map['profile'] as String? ?? '',
+      level: map['level'] as String? ?? 'full',
+      streamCoalesceMs: map['streamCoalesceMs'] as int? ?? 0,
+      refreshIntervalScale: (map['refreshIntervalScale'] as num?)?.toDouble() ?? 1.0,
+    );
+  }
+}
+
+/// 电源策略服务（Linux 原生实现）
+///
+/// 使用电池时降低流式更新频率、拉长定时刷新间隔；runner 同时降低
+/// 原生后台任务的并发和调度优先级。其他平台始终为全速策略。
+class PowerPolicyService {
+  static PowerPolicyService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/power_policy');
+  static const EventChannel _eventChannel = EventChannel('com.codeagenthub/power_policy_events');
+
+  /// 当前策略（变化时通知）
+  final ValueNotifier<PowerPolicy> policy = ValueNotifier(const PowerPolicy());
+
+  StreamSubscription? _subscription;
+
+  PowerPolicyService._() {
+    _setupEventChannel();
+  }
+
+  static PowerPolicyService getInstance() {
+    _instance ??= PowerPolicyService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 当前策略的快捷访问
+  PowerPolicy get current => policy.value;
+
+  void _setupEventChannel() {
+    if (!isPlatformSupported) return;
+
+    _subscription = _eventChannel.receiveBroadcastStream().listen((event) {
+      if (event is Map) {
+        policy.value = PowerPolicy.fromMap(event);
+        print('DEBUG PowerPolicyService: level=${policy.value.level}, onBattery=${policy.value.onBattery}');
+      }
+    }, onError: (error) {
+      print('ERROR PowerPolicyService: Event channel error: $error');
+    });
+
+    _channel.invokeMapMethod<String, dynamic>('getPolicy').then((result) {
+      if (result != null) {
+        policy.value = PowerPolicy.fromMap(result);
+      }
+    }).catchError((e) {
+      print('ERROR PowerPolicyService: Failed to get policy: $e');
+    });
+  }
+
+  void dispose() {
+    _subscription?.cancel();
+    _subscription = null;
+  }
+}
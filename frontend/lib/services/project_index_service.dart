@@ -0,0 +1,135 @@
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+import '../models/project.dart';
+import '../models/session.dart';
+
+/// 按项目分组的会话索引（Linux 原生实现）
+///
+/// runner 在任务池中解析 GET /sessions 的原始响应，按 cwd 分组，
+/// 每个项目的会话按 updated_at 排序并维护会话数、最近活动等汇总；
+/// 重新拉取列表时只调整有变化的会话。项目查询不再需要在 Dart 中
+/// 解码、分组和排序整个会话列表。
+class ProjectIndexService {
+  static ProjectIndexService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/project_index');
+
+  final Map<String, DateTime> _refreshedAt = {};
+  final Map<String, Future<bool>> _pendingRefresh = {};
+
+  ProjectIndexService._();
+
+  static ProjectIndexService getInstance() {
+    _instance ??= ProjectIndexService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生索引）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 用 [fetchSessionsJson] 拉取的会话列表更新索引 [index]（"claude" 或 "codex"）
+  ///
+  /// 索引在 [maxAge] 内更新过时直接复用，同时发起的刷新共用一次请求。
+  /// 拉取失败时抛出异常；索引不可用时返回 false，调用方改用 Dart 实现。
+  Future<bool> refresh(
+    String index,
+    Future<String> Function() fetchSessionsJson, {
+    Duration maxAge = Duration.zero,
+  }) {
+    if (!isPlatformSupported) return Future.value(false);
+
+    final refreshedAt = _refreshedAt[index];
+    if (refreshedAt != null && DateTime.now().difference(refreshedAt) <= maxAge) {
+      return Future.value(true);
+    }
+    return _pendingRefresh[index] ??= _replace(index, fetchSessionsJson).whenComplete(() {
+      _pendingRefresh.remove(index);
+    });
+  }
+
+  Future<bool> _replace(String index, Future<String> Function() fetchSessionsJson) async {
+    final body = await fetchSessionsJson();
+    try {
+      await _channel.invokeMethod('replace', {'index': index, 'sessions': body});
+      _refreshedAt[index] = DateTime.now();
+      return true;
+    } catch (e) {
+      print('ERROR ProjectIndexService: Failed to index $index sessions: $e');
+      _refreshedAt.remove(index);
+      return false;
+    }
+  }
+
+  /// 所有项目，按最近活动时间倒序；失败时返回 null
+  Future<List<Project>?> projects(String index) async {
+    try {
+      final raw = await _channel.invokeListMethod<Map<dynamic, dynamic>>('projects', {'index': index});
+      return raw?.map(_projectFromMap).toList();
+    } catch (e) {
+      print('ERROR ProjectIndexService: Failed to list $index projects: $e');
+      return null;
+    }
+  }
+
+  /// 单个项目；项目不存在或查询失败时返回 null
+  Future<Project?> project(String index, String path) async {
+    try {
+      final raw = await _channel.invokeMapMethod<String, dynamic>('project', {
+        'index': index,
+        'path': path,
+      });
+      return raw == null ? null : _projectFromMap(raw);
+    } catch (e) {
+      print('ERROR ProjectIndexService: Failed to load project $path: $e');
+      return null;
+    }
+  }
+
+  /// 项目的会话，按 updated_at 倒序；失败时返回 null
+  Future<List<Session>?> projectSessions(String index, String path) async {
+    try {
+      final raw = await _channel.invokeMapMethod<String, dynamic>('sessions', {
+        'index': index,
+        'path': path,
+      });
+      if (raw == null) return null;
+      return (raw['sessions'] as List).cast<Map<dynamic, dynamic>>().map((s) {
+        final title = s['title'] as String;
+        return Session(
+          id: s['id'] as String,
+          projectId: path,
+          title: title,
+          name: title,
+          cwd: s['cwd'] as String,
+          createdAt: _fromMicros(s['createdAt']),
+          updatedAt: _fromMicros(s['updatedAt']),
+          messageCount: s['messageCount'] as int,
+        );
+      }).toList();
+    } catch (e) {
+      print('ERROR ProjectIndexService: Failed to load sessions of $path: $e');
+      return null;
+    }
+  }
+
+  static Project _projectFromMap(Map<dynamic, dynamic> raw) {
+    final path = raw['path'] as String;
+    return Project(
+      id: path,
+      name: raw['name'] as String,
+      path: path,
+      createdAt: _fromMicros(raw['createdAt']),
+      lastActiveAt: _fromMicros(raw['lastActiveAt']),
+      sessionCount: raw['sessionCount'] as int,
+    );
+  }
+
+  // 后端时间戳均为 UTC（toISOString），与 DateTime.parse 的结果一致
+  static DateTime _fromMicros(dynamic value) =>
+      DateTime.fromMicrosecondsSinceEpoch(value as int, isUtc: true);
+}
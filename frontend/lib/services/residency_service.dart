@@ -0,0 +1,46 @@
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 后台驻留服务（Linux 原生实现）
+///
+/// 开启后关闭窗口只会隐藏窗口，引擎进入 paused 状态并释放缓存，
+/// 托盘图标可恢复窗口或真正退出；再次启动应用会直接呈现已有窗口。
+/// 设置由 runner 保存，隐藏行为立即生效，单实例激活在下次启动后生效。
+class ResidencyService {
+  static ResidencyService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/residency');
+
+  ResidencyService._();
+
+  static ResidencyService getInstance() {
+    _instance ??= ResidencyService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  Future<bool> isResident() async {
+    try {
+      return await _channel.invokeMethod<bool>('getResident') ?? false;
+    } catch (e) {
+      print('ERROR ResidencyService: Failed to read resident mode: $e');
+      return false;
+    }
+  }
+
+  /// 保存设置，返回生效后的值
+  Future<bool> setResident(bool enabled) async {
+    try {
+      return await _channel.invokeMethod<bool>('setResident', {'enabled': enabled}) ?? false;
+    } catch (e) {
+      print('ERROR ResidencyService: Failed to set resident mode: $e');
+      return !enabled;
+    }
+  }
+}
@@ -0,0 +1,191 @@
+import 'dart:async';
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+import '../repositories/normalized_message_stream.dart';
+import '../repositories/session_repository.dart';
+
+/// 接入运行中会话得到的快照与后续事件
+class RunJournalAttachment {
+  /// 运行开始时间；早于它的消息已在会话记录中
+  final DateTime startedAt;
+
+  /// 运行至今的状态（提示词、已完成和进行中的消息），随后是实时事件；
+  /// 运行结束时以 isDone 事件收尾。日志超出上限被丢弃时运行仍在继续，
+  /// 事件流以 [RunJournalOverflowed] 错误结束，调用方应改为重新加载会话记录。
+  /// 取消订阅即断开接入。
+  final Stream<MessageStreamEvent> events;
+
+  RunJournalAttachment({required this.startedAt, required this.events});
+}
+
+/// 运行日志超出上限：runner 不再记录这次运行，接入无法继续跟随
+class RunJournalOverflowed implements Exception {
+  final String sessionId;
+
+  RunJournalOverflowed(this.sessionId);
+
+  @override
+  String toString() => 'RunJournalOverflowed: $sessionId';
+}
+
+/// 运行日志服务（Linux 原生实现）
+///
+/// runner 在规范化聊天流的同时按会话记录本次运行的增量：进行中的消息保留
+/// 累积的文本和工具输入，已完成的消息以 zstd 压缩保存。运行中打开或切回
+/// 的标签页用 [attach] 取得快照并继续接收实时增量，不必等运行结束后
+/// 重新加载会话记录。
+class RunJournalService {
+  static RunJournalService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/run_journal');
+  static const EventChannel _eventChannel = EventChannel('com.codeagenthub/run_journal_events');
+
+  // 所有接入共用一个平台事件订阅
+  Stream<Map<dynamic, dynamic>>? _events;
+
+  RunJournalService._();
+
+  static RunJournalService getInstance() {
+    _instance ??= RunJournalService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 接入会话 [sessionId] 正在进行的运行；没有运行或日志不可用时返回 null
+  Future<RunJournalAttachment?> attach(String sessionId) async {
+    if (!isPlatformSupported || sessionId.isEmpty) return null;
+
+    _events ??= _eventChannel.receiveBroadcastStream().cast<Map<dynamic, dynamic>>().asBroadcastStream();
+
+    final controller = StreamController<MessageStreamEvent>();
+    final applier = MessageDeltaApplier(stopAtDone: true);
+    final pending = <Map<dynamic, dynamic>>[]; // 快照返回前收到的事件
+    int? snapshotSequence;
+
+    StreamSubscription<Map<dynamic, dynamic>>? subscription;
+    Timer? flushTimer;
+    var released = false;
+    void release() {
+      if (released) return;
+      released = true;
+      flushTimer?.cancel();
+      subscription?.cancel();
+      _detach(sessionId);
+    }
+
+    void close() {
+      controller.close();
+      release();
+    }
+
+    void finish() {
+      if (controller.isClosed) return;
+      if (!applier.finished) {
+        for (final event in applier.flushPartials()) {
+          controller.add(event);
+        }
+        controller.add(MessageStreamEvent(isDone: true));
+      }
+      close();
+    }
+
+    // 运行暂停输出时，被合并暂缓的部分消息到期后发出
+    void scheduleFlush() {
+      flushTimer?.cancel();
+      final delay = applier.flushDelay;
+      if (delay == null || controller.isClosed) return;
+      flushTimer = Timer(delay, () {
+        if (controller.isClosed) return;
+        for (final event in applier.flushPartials()) {
+          controller.add(event);
+        }
+      });
+    }
+
+    void forward(Map<dynamic, dynamic> event) {
+      if (controller.isClosed) return;
+      if (event['closed'] == true) {
+        finish();
+        return;
+      }
+      if (event['overflowed'] == true) {
+        // 运行未结束，不能发出 isDone
+        controller.addError(RunJournalOverflowed(sessionId));
+        close();
+        return;
+      }
+      // 快照已包含序号不超过 snapshotSequence 的增量
+      if ((event['sequence'] as int) <= snapshotSequence!) return;
+      for (final e in applier.apply(_toDeltas(event['deltas']))) {
+        controller.add(e);
+      }
+      if (applier.finished) {
+        close();
+      } else {
+        scheduleFlush();
+      }
+    }
+
+    // 先订阅再取快照，避免漏掉两者之间的事件
+    subscription = _events!.where((event) => event['sessionId'] == sessionId).listen((event) {
+      if (snapshotSequence == null) {
+        pending.add(event);
+      } else {
+        forward(event);
+      }
+    });
+
+    Map<String, dynamic>? snapshot;
+    try {
+      snapshot = await _channel.invokeMapMethod<String, dynamic>('attach', {'sessionId': sessionId});
+    } catch (e) {
+      print('ERROR RunJournalService: Failed to attach $sessionId: $e');
+    }
+    if (snapshot == null) {
+      await subscription.cancel();
+      return null;
+    }
+    controller.onCancel = release;
+
+    snapshotSequence = snapshot['sequence'] as int;
+    for (final event in applier.apply(_toDeltas(snapshot['deltas']))) {
+      controller.add(event);
+    }
+    // 快照中进行中的消息立即显示
+    for (final event in applier.flushPartials()) {
+      controller.add(event);
+    }
+    if (applier.finished) {
+      close();
+    } else {
+      for (final event in pending) {
+        forward(event);
+      }
+    }
+    pending.clear();
+
+    return RunJournalAttachment(
+      startedAt: DateTime.fromMicrosecondsSinceEpoch(snapshot['startedAt'] as int, isUtc: true),
+      events: controller.stream,
+    );
+  }
+
+  Future<void> _detach(String sessionId) async {
+    try {
+      await _channel.invokeMethod('detach', {'sessionId': sessionId});
+    } catch (e) {
+      print('ERROR RunJournalService: Failed to detach $sessionId: $e');
+    }
+  }
+
+  static List<Map<String, dynamic>> _toDeltas(dynamic deltas) {
+    return (deltas as List).map((d) => Map<String, dynamic>.from(d as Map)).toList();
+  }
+}
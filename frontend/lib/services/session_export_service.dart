@@ -0,0 +1,122 @@
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 会话导出格式
+enum SessionExportFormat {
+  markdown,
+  html,
+  json,
+}
+
+/// 单个会话导出任务
+class SessionExportJob {
+  final String sessionId;
+  final String cwd;
+  final String outputPath;
+  final SessionExportFormat format;
+  final String? title;
+
+  SessionExportJob({
+    required this.sessionId,
+    required this.cwd,
+    required this.outputPath,
+    this.format = SessionExportFormat.markdown,
+    this.title,
+  });
+
+  Map<String, dynamic> toArguments() => {
+        'sessionId': sessionId,
+        'cwd': cwd,
+        'outputPath': outputPath,
+        'format': format.name,
+        if (title != null) 'title': title,
+      };
+}
+
+/// 导出结果
+class SessionExportResult {
+  final String outputPath;
+  final bool ok;
+  final int messages;
+  final int bytesWritten;
+  final String? error;
+
+  SessionExportResult({
+    required this.outputPath,
+    required this.ok,
+    this.messages = 0,
+    this.bytesWritten = 0,
+    this.error,
+  });
+
+  factory SessionExportResult.fromMap(Map<dynamic, dynamic> map) {
+    return SessionExportResult(
+      outputPath: map['outputPath'] as String? ?? '',
+      ok: map['ok'] as bool? ?? false,
+      messages: map['messages'] as int? ?? 0,
+      bytesWritten: map['bytesWritten'] as int? ?? 0,
+      error: map['error'] as String?,
+    );
+  }
+}
+
+/// 会话导出服务（Linux 原生实现）
+///
+/// runner 直接流式读取会话 JSONL，逐条渲染为 Markdown / HTML / JSON 并增量写入文件，
+/// 批量导出在原生线程池上并行执行，Dart 侧不加载完整会话记录。
+class SessionExportService {
+  static SessionExportService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/session_export');
+
+  SessionExportService._();
+
+  static SessionExportService getInstance() {
+    _instance ??= SessionExportService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 导出单个会话
+  Future<SessionExportResult> exportSession(SessionExportJob job) async {
+    if (!isPlatformSupported) {
+      return SessionExportResult(outputPath: job.outputPath, ok: false, error: '当前平台不支持');
+    }
+
+    try {
+      final result = await _channel.invokeMapMethod<dynamic, dynamic>(
+        'exportSession',
+        job.toArguments(),
+      );
+      return SessionExportResult.fromMap(result ?? {});
+    } catch (e) {
+      print('ERROR SessionExportService: Export failed: $e');
+      return SessionExportResult(outputPath: job.outputPath, ok: false, error: '$e');
+    }
+  }
+
+  /// 批量导出（各会话并行）
+  Future<List<SessionExportResult>> exportBatch(List<SessionExportJob> jobs) async {
+    if (!isPlatformSupported || jobs.isEmpty) return [];
+
+    try {
+      final results = await _channel.invokeListMethod<dynamic>('exportBatch', {
+        'jobs': jobs.map((job) => job.toArguments()).toList(),
+      });
+      return (results ?? [])
+          .map((r) => SessionExportResult.fromMap(r as Map<dynamic, dynamic>))
+          .toList();
+    } catch (e) {
+      print('ERROR SessionExportService: Batch export failed: $e');
+      return jobs
+          .map((job) => SessionExportResult(outputPath: job.outputPath, ok: false, error: '$e'))
+          .toList();
+    }
+  }
+}
@@ -2,6 +2,7 @@ import 'dart:convert';
 import 'dart:io';
 import '../models/session_settings.dart';
 import '../models/codex_user_settings.dart';
+import 'settings_snapshot.dart';
 
 /// 会话设置服务 - 本地持久化存储每个会话的设置
 class SessionSettingsService {
@@ -9,6 +10,8 @@ class SessionSettingsService {
   factory SessionSettingsService() => _instance;
   SessionSettingsService._();
 
+  static const String _snapshotKey = 'session_settings'; // Linux 设置快照中的键
+
   bool _initialized = false;
 
   // 存储：sessionId -> SessionSettings (Claude Code)
@@ -42,64 +45,82 @@ class SessionSettingsService {
 
   // 加载设置
   Future<void> _loadSettings() async {
+    // Linux：从 runner 的设置快照同步读取
+    final snapshot = SettingsSnapshot.getInstance();
     try {
+      final stored = snapshot.readJson(_snapshotKey);
+      if (stored != null) {
+        _applySettings(stored);
+        return;
+      }
+
       final filePath = _getSettingsFilePath();
       final file = File(filePath);
 
       if (await file.exists()) {
         final content = await file.readAsString();
         final json = jsonDecode(content) as Map<String, dynamic>;
+        _applySettings(json);
+        // 旧的 JSON 文件迁移到快照
+        snapshot.writeJson(_snapshotKey, json);
+      }
+    } catch (e) {
+      print('Error loading session settings: $e');
+    }
+  }
 
-        // 加载 Claude Code 会话设置
-        if (json['claude_sessions'] != null) {
-          final claudeSessions = json['claude_sessions'] as Map<String, dynamic>;
-          claudeSessions.forEach((sessionId, settingsJson) {
-            try {
-              _claudeSessionSettings[sessionId] = SessionSettings.fromJson(
-                settingsJson as Map<String, dynamic>,
-              );
-            } catch (e) {
-              print('Error loading Claude session settings for $sessionId: $e');
-            }
-          });
+  void _applySettings(Map<String, dynamic> json) {
+    // 加载 Claude Code 会话设置
+    if (json['claude_sessions'] != null) {
+      final claudeSessions = json['claude_sessions'] as Map<String, dynamic>;
+      claudeSessions.forEach((sessionId, settingsJson) {
+        try {
+          _claudeSessionSettings[sessionId] = SessionSettings.fromJson(
+            settingsJson as Map<String, dynamic>,
+          );
+        } catch (e) {
+          print('Error loading Claude session settings for $sessionId: $e');
         }
+      });
+    }
 
-        // 加载 Codex 会话设置
-        if (json['codex_sessions'] != null) {
-          final codexSessions = json['codex_sessions'] as Map<String, dynamic>;
-          codexSessions.forEach((sessionId, settingsJson) {
-            try {
-              _codexSessionSettings[sessionId] = CodexUserSettings.fromJson(
-                settingsJson as Map<String, dynamic>,
-              );
-            } catch (e) {
-              print('Error loading Codex session settings for $sessionId: $e');
-            }
-          });
+    // 加载 Codex 会话设置
+    if (json['codex_sessions'] != null) {
+      final codexSessions = json['codex_sessions'] as Map<String, dynamic>;
+      codexSessions.forEach((sessionId, settingsJson) {
+        try {
+          _codexSessionSettings[sessionId] = CodexUserSettings.fromJson(
+            settingsJson as Map<String, dynamic>,
+          );
+        } catch (e) {
+          print('Error loading Codex session settings for $sessionId: $e');
         }
-
-        print('Loaded settings for ${_claudeSessionSettings.length} Claude sessions and ${_codexSessionSettings.length} Codex sessions');
-      }
-    } catch (e) {
-      print('Error loading session settings: $e');
+      });
     }
+
+    print('Loaded settings for ${_claudeSessionSettings.length} Claude sessions and ${_codexSessionSettings.length} Codex sessions');
   }
 
   // 保存设置
   Future<void> _saveSettings() async {
+    final json = <String, dynamic>{
+      'claude_sessions': _claudeSessionSettings.map(
+        (sessionId, settings) => MapEntry(sessionId, settings.toJson()),
+      ),
+      'codex_sessions': _codexSessionSettings.map(
+        (sessionId, settings) => MapEntry(sessionId, settings.toJson()),
+      ),
+    };
+    final snapshot = SettingsSnapshot.getInstance();
+    if (snapshot.isPlatformSupported) {
+      snapshot.writeJson(_snapshotKey, json);
+      return;
+    }
+
     try {
       final filePath = _getSettingsFilePath();
       final file = File(filePath);
 
-      final json = {
-        'claude_sessions': _claudeSessionSettings.map(
-          (sessionId, settings) => MapEntry(sessionId, settings.toJson()),
-        ),
-        'codex_sessions': _codexSessionSettings.map(
-          (sessionId, settings) => MapEntry(sessionId, settings.toJson()),
-        ),
-      };
-
       await file.writeAsString(jsonEncode(json));
       print('Saved settings for ${_claudeSessionSettings.length} Claude sessions and ${_codexSessionSettings.length} Codex sessions');
     } catch (e) {
@@ -0,0 +1,120 @@
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io';
+import 'package:ffi/ffi.dart';
+import 'package:flutter/foundation.dart';
+
+// runner 导出的设置存储入口（linux/settings_store.h）
+typedef _SettingsReadNative = Int64 Function(Pointer<Utf8> key, Pointer<Uint8> buffer, Int64 capacity);
+typedef _SettingsReadDart = int Function(Pointer<Utf8> key, Pointer<Uint8> buffer, int capacity);
+typedef _SettingsWriteNative = Void Function(Pointer<Utf8> key, Pointer<Uint8> data, Int64 size);
+typedef _SettingsWriteDart = void Function(Pointer<Utf8> key, Pointer<Uint8> data, int size);
+typedef _SettingsFlushNative = Void Function();
+typedef _SettingsFlushDart = void Function();
+
+/// 本地设置快照（Linux 原生实现）
+///
+/// 所有本地设置（应用配置、界面设置、会话设置、上次获取的用户设置）保存在
+/// runner 的一个版本化二进制快照中。runner 在引擎启动前一次性映射该文件，
+/// 这里通过 FFI 同步读写，启动时不再逐个异步读取 JSON 文件；写入立即生效，
+/// 由 runner 在后台线程原子替换文件。
+///
+/// 每个键保存一个 JSON 对象。其他平台 [isPlatformSupported] 为 false，
+/// 各服务继续使用原来的 JSON 文件。
+class SettingsSnapshot {
+  static SettingsSnapshot? _instance;
+
+  _SettingsReadDart? _read;
+  _SettingsWriteDart? _write;
+  _SettingsFlushDart? _flush;
+  bool _lookedUp = false;
+
+  SettingsSnapshot._();
+
+  static SettingsSnapshot getInstance() {
+    _instance ??= SettingsSnapshot._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供快照）
+  bool get isPlatformSupported {
+    if (kIsWeb || !Platform.isLinux) return false;
+    _lookup();
+    return _read != null;
+  }
+
+  /// 读取 [key] 下的 JSON 对象；不存在或无法解析时返回 null
+  Map<String, dynamic>? readJson(String key) {
+    if (!isPlatformSupported) return null;
+
+    final nativeKey = key.toNativeUtf8();
+    var capacity = 4096;
+    var buffer = malloc<Uint8>(capacity);
+    try {
+      var size = _read!(nativeKey, buffer, capacity);
+      if (size > capacity) {
+        malloc.free(buffer);
+        capacity = size;
+        buffer = malloc<Uint8>(capacity);
+        size = _read!(nativeKey, buffer, capacity);
+      }
+      if (size < 0) return null;
+      final decoded = jsonDecode(utf8.decode(buffer.asTypedList(size)));
+      return decoded is Map<String, dynamic> ? decoded : null;
+    } catch (e) {
+      print('ERROR SettingsSnapshot: Failed to read $key: $e');
+      return null;
+    } finally {
+      malloc.free(buffer);
+      malloc.free(nativeKey);
+    }
+  }
+
+  /// 保存 [key] 下的 JSON 对象
+  void writeJson(String key, Map<String, dynamic> value) {
+    if (!isPlatformSupported) return;
+
+    final bytes = utf8.encode(jsonEncode(value));
+    final nativeKey = key.toNativeUtf8();
+    final data = malloc<Uint8>(bytes.isEmpty ? 1 : bytes.length);
+    try {
+      data.asTypedList(bytes.length).setAll(0, bytes);
+      _write!(nativeKey, data, bytes.length);
+    } finally {
+      malloc.free(data);
+      malloc.free(nativeKey);
+    }
+  }
+
+  /// 删除 [key]
+  void remove(String key) {
+    if (!isPlatformSupported) return;
+
+    final nativeKey = key.toNativeUtf8();
+    try {
+      _write!(nativeKey, nullptr, -1);
+    } finally {
+      malloc.free(nativeKey);
+    }
+  }
+
+  /// 立即写盘（退出前调用；exit() 不会经过 runner 的关闭流程）
+  void flush() {
+    if (!isPlatformSupported) return;
+    _flush!();
+  }
+
+  void _lookup() {
+    if (_lookedUp) return;
+    _lookedUp = true;
+    try {
+      final process = DynamicLibrary.process();
+      _read = process.lookupFunction<_SettingsReadNative, _SettingsReadDart>('codeagenthub_settings_read');
+      _write = process.lookupFunction<_SettingsWriteNative, _SettingsWriteDart>('codeagenthub_settings_write');
+      _flush = process.lookupFunction<_SettingsFlushNative, _SettingsFlushDart>('codeagenthub_settings_flush');
+    } catch (e) {
+      _read = null;
+      print('ERROR SettingsSnapshot: Native settings store unavailable: $e');
+    }
+  }
+}
@@ -4,6 +4,7 @@ import '../models/project.dart';
 import '../models/session.dart';
 import '../repositories/project_repository.dart';
 import '../repositories/codex_repository.dart';
+import 'power_policy_service.dart';
 
 /// 共享项目数据服务（单例）
 /// 用于在多个 HomeScreen 实例之间共享项目列表和最近对话数据
@@ -41,6 +42,10 @@ class SharedProjectDataService {
   // 刷新间隔（默认30秒）
   Duration _refreshInterval = const Duration(seconds: 30);
 
+  // 实际刷新间隔：使用电池时按电源策略拉长
+  Duration get _effectiveRefreshInterval =>
+      _refreshInterval * PowerPolicyService.getInstance().current.refreshIntervalScale;
+
   // 是否正在加载 - 项目列表
   bool _isLoadingClaude = false;
   bool _isLoadingCodex = false;
@@ -88,14 +93,16 @@ class SharedProjectDataService {
       _refreshInterval = refreshInterval;
     }
 
-    // 启动自动刷新定时器
+    // 启动自动刷新定时器（电源策略变化时按新间隔重启）
+    PowerPolicyService.getInstance().policy.removeListener(_startAutoRefresh);
+    PowerPolicyService.getInstance().policy.addListener(_startAutoRefresh);
     _startAutoRefresh();
   }
 
   /// 启动自动刷新
   void _startAutoRefresh() {
     _autoRefreshTimer?.cancel();
-    _autoRefreshTimer = Timer.periodic(_refreshInterval, (_) {
+    _autoRefreshTimer = Timer.periodic(_effectiveRefreshInterval, (_) {
       // 自动刷新不强制，只有过期才刷新
       _checkAndRefresh(isCodex: false, force: false);
       _checkAndRefresh(isCodex: true, force: false);
@@ -106,7 +113,7 @@ class SharedProjectDataService {
   Future<void> _checkAndRefresh({required bool isCodex, required bool force}) async {
     final lastRefresh = isCodex ? _lastCodexRefresh : _lastClaudeRefresh;
     final isExpired = lastRefresh == null ||
-        DateTime.now().difference(lastRefresh) > _refreshInterval;
+        DateTime.now().difference(lastRefresh) > _effectiveRefreshInterval;
 
     if (force || isExpired) {
       await refresh(isCodex: isCodex, force: true);
@@ -122,7 +129,7 @@ class SharedProjectDataService {
   bool isCacheValid({required bool isCodex}) {
     final lastRefresh = isCodex ? _lastCodexRefresh : _lastClaudeRefresh;
     if (lastRefresh == null) return false;
-    return DateTime.now().difference(lastRefresh) <= _refreshInterval;
+    return DateTime.now().difference(lastRefresh) <= _effectiveRefreshInterval;
   }
 
   /// 刷新项目列表
@@ -271,7 +278,7 @@ class SharedProjectDataService {
 
     if (!force && lastRefresh != null) {
       final timeSinceRefresh = DateTime.now().difference(lastRefresh);
-      if (timeSinceRefresh < _refreshInterval) {
+      if (timeSinceRefresh < _effectiveRefreshInterval) {
         // 未过期且缓存非空，返回缓存数据
         return cachedSessions;
       }
@@ -358,6 +365,7 @@ class SharedProjectDataService {
 
   /// 释放资源
   void dispose() {
+    PowerPolicyService.getInstance().policy.removeListener(_startAutoRefresh);
     _autoRefreshTimer?.cancel();
     claudeProjectsNotifier.dispose();
     codexProjectsNotifier.dispose();
@@ -0,0 +1,176 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+import 'package:http/http.dart' as http;
+import '../models/message.dart';
+import '../repositories/api_codex_repository.dart';
+import '../repositories/api_session_repository.dart';
+import 'api_service.dart';
+import 'codex_api_service.dart';
+import 'soak_service.dart';
+
+/// 录制的一轮对话
+class _RecordedTurn {
+  final String schema;
+  final List<int> body;
+
+  const _RecordedTurn(this.schema, this.body);
+}
+
+/// 把录制的响应体分块返回的 HTTP 客户端，模拟后端的流式输出
+class _ReplayClient extends http.BaseClient {
+  static const int _chunkBytes = 2048;
+
+  final _RecordedTurn turn;
+
+  _ReplayClient(this.turn);
+
+  @override
+  Future<http.StreamedResponse> send(http.BaseRequest request) async {
+    await request.finalize().drain<void>();
+    return http.StreamedResponse(_chunks(), 200, request: request);
+  }
+
+  Stream<List<int>> _chunks() async* {
+    for (var offset = 0; offset < turn.body.length; offset += _chunkBytes) {
+      final end = offset + _chunkBytes < turn.body.length ? offset + _chunkBytes : turn.body.length;
+      yield turn.body.sublist(offset, end);
+      // 让出事件循环，和真实网络一样与其他标签页交错
+      await Future<void>.delayed(Duration.zero);
+    }
+  }
+}
+
+/// 一个标签页：与聊天界面相同地维护消息列表，回放若干轮后开始新会话
+class _SoakTab {
+  final ApiSessionRepository claude = ApiSessionRepository(ApiService(baseUrl: 'http://soak.invalid'));
+  final ApiCodexRepository codex = ApiCodexRepository(CodexApiService(baseUrl: 'http://soak.invalid'));
+  final List<Message> messages = [];
+  int turnsInSession = 0;
+
+  void _apply(Message? partial, Message? finalMessage) {
+    final message = finalMessage ?? partial;
+    if (message == null) return;
+    final index = messages.lastIndexWhere((m) => m.id == message.id);
+    if (index >= 0) {
+      messages[index] = message;
+    } else {
+      messages.add(message);
+    }
+  }
+
+  Future<void> play(_RecordedTurn turn, int turnsPerSession) async {
+    if (turnsInSession >= turnsPerSession) {
+      messages.clear();
+      turnsInSession = 0;
+    }
+    turnsInSession++;
+
+    await http.runWithClient(() async {
+      if (turn.schema == 'codex') {
+        await for (final event in codex.sendMessageStream(sessionId: 'soak', content: 'soak')) {
+          _apply(event.partialMessage, event.finalMessage);
+          if (event.error != null) throw Exception(event.error);
+        }
+      } else {
+        await for (final event in claude.sendMessageStream(sessionId: 'soak', content: 'soak')) {
+          _apply(event.partialMessage, event.finalMessage);
+          if (event.error != null) throw Exception(event.error);
+        }
+      }
+    }, () => _ReplayClient(turn));
+  }
+}
+
+Future<List<_RecordedTurn>> _loadRecording(String path) async {
+  final turns = <_RecordedTurn>[];
+  for (final line in await File(path).readAsLines()) {
+    if (line.trim().isEmpty) continue;
+    try {
+      final record = json.decode(line) as Map<String, dynamic>;
+      turns.add(_RecordedTurn(
+        record['schema'] as String? ?? 'claude',
+        utf8.encode(record['sse'] as String),
+      ));
+    } catch (e) {
+      print('ERROR SoakRunner: Skipping malformed recording line: $e');
+    }
+  }
+  return turns;
+}
+
+/// 浸泡测试：多个标签页并发循环回放录制的对话，直到达到配置的时长
+///
+/// 返回进程退出码：0 表示没有指标持续增长，2 表示有，1 表示无法运行。
+Future<int> runSoak(SoakConfig config) async {
+  final soak = SoakService.getInstance();
+  final turns = await _loadRecording(config.recording);
+  if (turns.isEmpty) {
+    print('ERROR SoakRunner: No turns in ${config.recording}');
+    await soak.finish();
+    return 1;
+  }
+  print('DEBUG SoakRunner: ${turns.length} turns, ${config.tabs} tabs, ${config.duration.inMinutes} min');
+
+  final probe = DartHeapProbe(trackedClasses: const [
+    'Message',
+    'MessageStreamEvent',
+    'CodexMessageStreamEvent',
+    '_MessageBuildState',
+    '_CodexMessageBuildState',
+    '_NormalizedMessageBuilder',
+  ]);
+  if (!await probe.connect()) {
+    print('WARN SoakRunner: VM service unavailable, Dart heap is not sampled (run a profile build)');
+  }
+
+  final tabs = List.generate(config.tabs, (_) => _SoakTab());
+  var completedTurns = 0;
+  var failedTurns = 0;
+  final deadline = DateTime.now().add(config.duration);
+
+  Future<void> reportGauges() async {
+    await soak.report(
+      gauges: {
+        ...await probe.sample(),
+        'retainedMessages': tabs.fold<int>(0, (sum, tab) => sum + tab.messages.length),
+      },
+      counters: {'turns': completedTurns, 'failedTurns': failedTurns},
+    );
+  }
+
+  // 上报频率是采样频率的两倍，保证每个样本都带着较新的 Dart 指标
+  final sampler = Timer.periodic(config.sampleInterval ~/ 2, (_) => reportGauges());
+  await reportGauges();
+
+  await Future.wait([
+    for (var i = 0; i < tabs.length; i++)
+      () async {
+        // 各标签页从不同的轮次开始，错开负载
+        var next = i * turns.length ~/ tabs.length;
+        while (DateTime.now().isBefore(deadline)) {
+          try {
+            await tabs[i].play(turns[next % turns.length], config.turnsPerSession);
+            completedTurns++;
+          } catch (e) {
+            failedTurns++;
+            print('ERROR SoakRunner: Tab $i turn failed: $e');
+          }
+          next++;
+        }
+      }(),
+  ]);
+
+  sampler.cancel();
+  await reportGauges();
+  await probe.close();
+
+  final result = await soak.finish();
+  if (result == null) return 1;
+  print('SoakRunner: $completedTurns turns ($failedTurns failed), ${result.samples} samples, report: ${result.report}');
+  if (result.flagged.isNotEmpty) {
+    print('SoakRunner: Steady growth in ${result.flagged.join(', ')}');
+    return 2;
+  }
+  return 0;
+}
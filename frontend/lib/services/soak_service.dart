@@ -0,0 +1,228 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:developer' as developer;
+import 'dart:io';
+import 'dart:isolate';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 浸泡测试配置（由 runner 从 CODEAGENTHUB_SOAK 指向的配置文件读取）
+class SoakConfig {
+  final String recording; // 录制的对话轮次（JSONL）
+  final Duration duration;
+  final int tabs;
+  final int turnsPerSession; // 每个标签页回放多少轮后开始新会话
+  final Duration sampleInterval;
+  final String report;
+
+  const SoakConfig({
+    required this.recording,
+    required this.duration,
+    required this.tabs,
+    required this.turnsPerSession,
+    required this.sampleInterval,
+    required this.report,
+  });
+
+  factory SoakConfig.fromMap(Map<String, dynamic> map) {
+    return SoakConfig(
+      recording: map['recording'] as String,
+      duration: Duration(minutes: map['durationMinutes'] as int? ?? 60),
+      tabs: map['tabs'] as int? ?? 4,
+      turnsPerSession: map['turnsPerSession'] as int? ?? 20,
+      sampleInterval: Duration(seconds: map['sampleSeconds'] as int? ?? 30),
+      report: map['report'] as String? ?? '',
+    );
+  }
+}
+
+/// 浸泡测试结果
+class SoakResult {
+  final String report;
+  final int samples;
+  final List<String> flagged; // 持续增长的指标
+
+  const SoakResult({required this.report, required this.samples, required this.flagged});
+}
+
+/// 浸泡测试服务（Linux 原生实现）
+///
+/// runner 定时采样 RSS、原生分配器、打开的文件描述符和线程数；
+/// Dart 侧上报堆用量和存活对象数，结束时由 runner 生成趋势报告。
+class SoakService {
+  static SoakService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/soak');
+
+  SoakService._();
+
+  static SoakService getInstance() {
+    _instance ??= SoakService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 未处于浸泡测试模式时返回 null
+  Future<SoakConfig?> getConfig() async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('getConfig');
+      return result == null ? null : SoakConfig.fromMap(result);
+    } catch (e) {
+      print('ERROR SoakService: Failed to get config: $e');
+      return null;
+    }
+  }
+
+  /// 上报 Dart 侧指标；[gauges] 参与趋势分析，[counters] 只记录
+  Future<void> report({
+    Map<String, num> gauges = const {},
+    Map<String, num> counters = const {},
+  }) async {
+    try {
+      await _channel.invokeMethod('report', {'gauges': gauges, 'counters': counters});
+    } catch (e) {
+      print('ERROR SoakService: Failed to report: $e');
+    }
+  }
+
+  /// 停止采样并写出报告
+  Future<SoakResult?> finish() async {
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('finish');
+      if (result == null) return null;
+      return SoakResult(
+        report: result['report'] as String? ?? '',
+        samples: result['samples'] as int? ?? 0,
+        flagged: List<String>.from(result['flagged'] as List? ?? const []),
+      );
+    } catch (e) {
+      print('ERROR SoakService: Failed to finish: $e');
+      return null;
+    }
+  }
+}
+
+/// 通过 VM service 读取 Dart 堆用量（profile / debug 模式可用）
+///
+/// 每次探测都先触发一次完整 GC，因此得到的是存活数据的大小，
+/// 同时统计指定类的存活实例数。
+class DartHeapProbe {
+  final List<String> trackedClasses;
+
+  WebSocket? _socket;
+  String? _isolateId;
+  int _nextId = 0;
+  final Map<String, Completer<Map<String, dynamic>>> _pending = {};
+
+  DartHeapProbe({this.trackedClasses = const []});
+
+  /// 连接 VM service；不可用时（如 release 模式）返回 false
+  Future<bool> connect() async {
+    try {
+      final info = await developer.Service.getInfo();
+      final serverUri = info.serverUri;
+      _isolateId = developer.Service.getIsolateId(Isolate.current);
+      if (serverUri == null || _isolateId == null) return false;
+
+      final path = serverUri.path.endsWith('/') ? serverUri.path : '${serverUri.path}/';
+      _socket = await WebSocket.connect(serverUri.replace(scheme: 'ws', path: '${path}ws').toString());
+      _socket!.listen((data) {
+        final message = json.decode(data as String) as Map<String, dynamic>;
+        final completer = _pending.remove(message['id']);
+        if (completer == null) return;
+        if (message['error'] != null) {
+          completer.completeError(Exception(message['error'].toString()));
+        } else {
+          completer.complete(Map<String, dynamic>.from(message['result'] as Map));
+        }
+      }, onDone: () {
+        for (final completer in _pending.values) {
+          completer.completeError(StateError('VM service closed'));
+        }
+        _pending.clear();
+      });
+      return true;
+    } catch (e) {
+      print('ERROR DartHeapProbe: Failed to connect to VM service: $e');
+      return false;
+    }
+  }
+
+  Future<Map<String, dynamic>> _call(String method, Map<String, dynamic> params) {
+    final id = '${_nextId++}';
+    final completer = Completer<Map<String, dynamic>>();
+    _pending[id] = completer;
+    _socket!.add(json.encode({'jsonrpc': '2.0', 'id': id, 'method': method, 'params': params}));
+    return completer.future;
+  }
+
+  /// 返回 GC 后的堆用量和被跟踪类的实例数；未连接时返回空表
+  Future<Map<String, num>> sample() async {
+    if (_socket == null) return const {};
+
+    try {
+      final profile = await _call('getAllocationProfile', {'isolateId': _isolateId, 'gc': true});
+      final usage = profile['memoryUsage'] as Map? ?? const {};
+      final gauges = <String, num>{
+        'dartHeapUsedBytes': usage['heapUsage'] as int? ?? 0,
+        'dartExternalBytes': usage['externalUsage'] as int? ?? 0,
+      };
+      for (final member in profile['members'] as List? ?? const []) {
+        final name = (member['class'] as Map?)?['name'];
+        if (trackedClasses.contains(name)) {
+          final current = member['instancesCurrent'] as int? ?? 0;
+          gauges['live$name'] = (gauges['live$name'] ?? 0) + current;
+        }
+      }
+      return gauges;
+    } catch (e) {
+      print('ERROR DartHeapProbe: Failed to sample heap: $e');
+      return const {};
+    }
+  }
+
+  Future<void> close() async {
+    await _socket?.close();
+    _socket = null;
+  }
+}
+
+/// 录制聊天响应体，供浸泡测试回放
+///
+/// 设置环境变量 CODEAGENTHUB_RECORD_TURNS 为文件路径后，每轮对话的原始
+/// SSE 响应体追加为一行 JSON：{"schema": "claude" | "codex", "sse": "..."}。
+class TurnRecorder {
+  static final TurnRecorder instance = TurnRecorder._();
+
+  final String? _path = kIsWeb ? null : Platform.environment['CODEAGENTHUB_RECORD_TURNS'];
+
+  TurnRecorder._();
+
+  /// 原样转发 [body]，结束时把完整内容写入录制文件
+  Stream<List<int>> tap(String schema, Stream<List<int>> body) async* {
+    final path = _path;
+    if (path == null || path.isEmpty) {
+      yield* body;
+      return;
+    }
+
+    final bytes = BytesBuilder(copy: false);
+    await for (final chunk in body) {
+      bytes.add(chunk);
+      yield chunk;
+    }
+    try {
+      final line = json.encode({'schema': schema, 'sse': utf8.decode(bytes.takeBytes(), allowMalformed: true)});
+      await File(path).writeAsString('$line\n', mode: FileMode.append, flush: true);
+    } catch (e) {
+      print('ERROR TurnRecorder: Failed to record turn: $e');
+    }
+  }
+}
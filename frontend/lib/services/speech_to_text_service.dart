@@ -272,6 +272,13 @@ class SpeechToTextService {
     }
   }
 
+  /// 设置当前项目目录，口述的标识符按项目中的写法输出（仅 Windows 原生识别）
+  Future<void> setProjectRoot(String root) async {
+    if (_useWindowsNative) {
+      await WindowsSpeechRecognition.getInstance().setVocabularyRoot(root);
+    }
+  }
+
   /// 切换语言（仅对非 Windows 平台有效）
   Future<void> setLocale(String localeId) async {
     _currentLocaleId = localeId;
@@ -0,0 +1,43 @@
+import 'dart:convert';
+
+/// 将后端 SSE 响应体解码为事件流
+///
+/// 每个 `data:` 行解析为 JSON 对象，并附加 `event_type` 字段（来自前面的
+/// `event:` 行）。/chat 与 /codex/chat 共用此解码器。
+Stream<Map<String, dynamic>> decodeSseEvents(Stream<List<int>> body) async* {
+  String? currentEvent;
+  var pending = '';
+
+  await for (final chunk in body.transform(utf8.decoder)) {
+    final lines = (pending + chunk).split('\n');
+    // Keep the last incomplete line for the next chunk
+    pending = lines.removeLast();
+
+    for (var line in lines) {
+      line = line.trim();
+      if (line.isEmpty) {
+        // Empty line marks end of event
+        currentEvent = null;
+        continue;
+      }
+
+      if (line.startsWith('event: ')) {
+        currentEvent = line.substring(7);
+      } else if (line.startsWith('data: ')) {
+        final data = line.substring(6);
+        if (data.trim().isNotEmpty && currentEvent != null) {
+          try {
+            final parsed = json.decode(data);
+            // Yield event with type
+            yield {
+              'event_type': currentEvent,
+              ...parsed,
+            };
+          } catch (e) {
+            // Skip invalid JSON
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,82 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 流事件规范化服务（Linux 原生实现）
+///
+/// /chat 与 /codex/chat 的原始 SSE 响应体按网络分块交给 runner，
+/// 由原生规范化器完成分帧、JSON 解析和 Claude/Codex 两种事件模式的状态机，
+/// 每个分块返回一组紧凑的消息增量（text、tool、input、stop、final 等，
+/// 格式见 linux/stream_normalizer.h）。
+class StreamNormalizerService {
+  static StreamNormalizerService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/stream_normalizer');
+
+  int _nextStreamId = 0;
+
+  StreamNormalizerService._();
+
+  static StreamNormalizerService getInstance() {
+    _instance ??= StreamNormalizerService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 打开一个规范化流，返回流 ID
+  ///
+  /// [schema] 为 'claude' 或 'codex'；[messageId] 是 Codex 本轮助手消息的 ID。
+  /// [sessionId]（新会话为空）和 [prompt]（本轮发送的内容块）用于 runner
+  /// 的运行日志，见 RunJournalService。
+  Future<String> open({
+    required String schema,
+    String? messageId,
+    String? sessionId,
+    List<dynamic>? prompt,
+  }) async {
+    final streamId = 'stream_${_nextStreamId++}';
+    await _channel.invokeMethod('open', {
+      'streamId': streamId,
+      'schema': schema,
+      'messageId': messageId ?? '',
+      'sessionId': sessionId ?? '',
+      'prompt': jsonEncode(prompt ?? const []),
+    });
+    return streamId;
+  }
+
+  /// 送入一个响应体分块，返回由它产生的增量
+  ///
+  /// 同一流的调用必须依次等待完成，原生侧按调用顺序处理。
+  Future<List<Map<String, dynamic>>> feed(String streamId, List<int> chunk) async {
+    final deltas = await _channel.invokeListMethod<Map>('feed', {
+      'streamId': streamId,
+      'data': chunk is Uint8List ? chunk : Uint8List.fromList(chunk),
+    });
+    return _toDeltas(deltas);
+  }
+
+  /// 结束并释放流，返回剩余的增量（如 Codex 未收尾的文本）
+  Future<List<Map<String, dynamic>>> close(String streamId) async {
+    try {
+      final deltas = await _channel.invokeListMethod<Map>('close', {
+        'streamId': streamId,
+      });
+      return _toDeltas(deltas);
+    } catch (e) {
+      print('ERROR StreamNormalizerService: Failed to close $streamId: $e');
+      return [];
+    }
+  }
+
+  static List<Map<String, dynamic>> _toDeltas(List<Map>? deltas) {
+    return deltas?.map((d) => Map<String, dynamic>.from(d)).toList() ?? [];
+  }
+}
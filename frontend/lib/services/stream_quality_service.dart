@@ -0,0 +1,138 @@
+import 'dart:async';
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/scheduler.dart';
+import 'package:flutter/services.dart';
+
+/// 流式渲染质量
+///
+/// 由 runner 根据界面应用流式增量的延迟（增量入队到显示它的帧绘制完成）计算。
+class StreamQuality {
+  final String level; // full / reduced / minimal
+  final int streamCoalesceMs; // 流式回复中部分消息更新的最小间隔
+  final bool deferBackgroundRendering; // 后台标签页暂不渲染 Markdown 和代码高亮
+  final int collapseToolResultChars; // 超过该长度的工具结果默认折叠，0 表示不折叠
+  final int applyLatencyP90Us; // 最近窗口内应用延迟的 p90
+  final int backlogUs; // 最早一批尚未应用的增量已等待的时长
+  final int pendingBatches;
+
+  const StreamQuality({
+    this.level = 'full',
+    this.streamCoalesceMs = 0,
+    this.deferBackgroundRendering = false,
+    this.collapseToolResultChars = 0,
+    this.applyLatencyP90Us = 0,
+    this.backlogUs = 0,
+    this.pendingBatches = 0,
+  });
+
+  factory StreamQuality.fromMap(Map map) {
+    return StreamQuality(
+      level: map['level'] as String? ?? 'full',
+      streamCoalesceMs: map['streamCoalesceMs'] as int? ?? 0,
+      deferBackgroundRendering: map['deferBackgroundRendering'] as bool? ?? false,
+      collapseToolResultChars: map['collapseToolResultChars'] as int? ?? 0,
+      applyLatencyP90Us: map['applyLatencyP90Us'] as int? ?? 0,
+      backlogUs: map['backlogUs'] as int? ?? 0,
+      pendingBatches: map['pendingBatches'] as int? ?? 0,
+    );
+  }
+}
+
+/// 流式渲染质量服务（Linux 原生实现）
+///
+/// runner 给每批流式增量编号（batch 增量），这里在显示它们的帧构建完成后
+/// 回报已应用的批次。多个标签页同时输出导致界面跟不上时，runner 逐级
+/// 降低质量：加大部分消息的合并间隔、后台标签页暂缓 Markdown 渲染、折叠
+/// 大段工具结果；负载下降后逐级恢复。其他平台始终为完整质量。
+class StreamQualityService {
+  static StreamQualityService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/stream_quality');
+  static const EventChannel _eventChannel = EventChannel('com.codeagenthub/stream_quality_events');
+
+  /// 当前质量（级别变化时通知）
+  final ValueNotifier<StreamQuality> quality = ValueNotifier(const StreamQuality());
+
+  StreamSubscription? _subscription;
+  final _appliedBatches = <int>[];
+  bool _reportScheduled = false;
+
+  StreamQualityService._() {
+    _setupEventChannel();
+  }
+
+  static StreamQualityService getInstance() {
+    _instance ??= StreamQualityService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 当前质量的快捷访问
+  StreamQuality get current => quality.value;
+
+  /// 记录已应用的批次；同一帧内的批次在帧构建完成后一起回报
+  void batchApplied(int seq) {
+    if (!isPlatformSupported) return;
+    _appliedBatches.add(seq);
+    if (_reportScheduled) return;
+    _reportScheduled = true;
+    SchedulerBinding.instance.addPostFrameCallback((_) => _reportApplied());
+    SchedulerBinding.instance.ensureVisualUpdate();
+  }
+
+  void _reportApplied() {
+    _reportScheduled = false;
+    if (_appliedBatches.isEmpty) return;
+    final batches = List<int>.of(_appliedBatches);
+    _appliedBatches.clear();
+    _channel.invokeMethod('applied', {'batches': batches}).catchError((e) {
+      print('ERROR StreamQualityService: Failed to report batches: $e');
+    });
+  }
+
+  /// 读取当前级别和延迟统计（诊断用）
+  Future<StreamQuality?> getState() async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('getState');
+      return result != null ? StreamQuality.fromMap(result) : null;
+    } catch (e) {
+      print('ERROR StreamQualityService: Failed to get state: $e');
+      return null;
+    }
+  }
+
+  void _setupEventChannel() {
+    if (!isPlatformSupported) return;
+
+    _subscription = _eventChannel.receiveBroadcastStream().listen((event) {
+      if (event is Map) {
+        quality.value = StreamQuality.fromMap(event);
+        print('DEBUG StreamQualityService: level=${quality.value.level}, '
+            'p90=${quality.value.applyLatencyP90Us}us');
+      }
+    }, onError: (error) {
+      print('ERROR StreamQualityService: Event channel error: $error');
+    });
+
+    _channel.invokeMapMethod<String, dynamic>('getState').then((result) {
+      if (result != null) {
+        quality.value = StreamQuality.fromMap(result);
+      }
+    }).catchError((e) {
+      print('ERROR StreamQualityService: Failed to get state: $e');
+    });
+  }
+
+  void dispose() {
+    _subscription?.cancel();
+    _subscription = null;
+  }
+}
@@ -0,0 +1,117 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'package:ffi/ffi.dart';
+import 'package:flutter/foundation.dart';
+
+// runner 导出的批量解析入口（linux/iso_timestamp.h）
+typedef _ParseIsoTimestampsNative = Int64 Function(
+  Pointer<Uint8> text,
+  Pointer<Int64> ends,
+  Int64 count,
+  Pointer<Int64> micros,
+  Pointer<Uint8> kinds,
+);
+typedef _ParseIsoTimestampsDart = int Function(
+  Pointer<Uint8> text,
+  Pointer<Int64> ends,
+  int count,
+  Pointer<Int64> micros,
+  Pointer<Uint8> kinds,
+);
+
+/// ISO-8601 时间戳批量解析（Linux 原生实现）
+///
+/// 会话记录中每条消息都带时间戳，逐条 DateTime.parse 在长会话加载时很显眼。
+/// 这里把一整列时间戳交给 runner 一次解析为 epoch 微秒（FFI 同步调用，
+/// 与 runner 的会话索引共用同一解析器）。原生解析器不接受的写法回退到
+/// DateTime.tryParse，结果与逐条解析一致：带时区的为 UTC，不带的为本地时间。
+class TimestampKernel {
+  static TimestampKernel? _instance;
+
+  _ParseIsoTimestampsDart? _parse;
+  bool _lookedUp = false;
+
+  TimestampKernel._();
+
+  static TimestampKernel getInstance() {
+    _instance ??= TimestampKernel._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 导出解析入口）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 解析一列时间戳；null 或无法解析的值对应 null
+  List<DateTime?> parseColumn(List<String?> values) {
+    final parse = _lookup();
+    if (parse == null || values.isEmpty) {
+      return [for (final value in values) value == null ? null : DateTime.tryParse(value)];
+    }
+
+    var capacity = 1;
+    for (final value in values) {
+      capacity += value?.length ?? 0;
+    }
+    final count = values.length;
+    final text = malloc<Uint8>(capacity);
+    final ends = malloc<Int64>(count);
+    final micros = malloc<Int64>(count);
+    final kinds = malloc<Uint8>(count);
+    try {
+      final textBytes = text.asTypedList(capacity);
+      final endList = ends.asTypedList(count);
+      var offset = 0;
+      for (var i = 0; i < count; i++) {
+        final value = values[i];
+        if (value != null) {
+          final start = offset;
+          var bits = 0;
+          for (final unit in value.codeUnits) {
+            textBytes[offset++] = unit;
+            bits |= unit;
+          }
+          // 非 ASCII 的值留空，由 DateTime.tryParse 处理
+          if (bits > 0x7f) offset = start;
+        }
+        endList[i] = offset;
+      }
+
+      parse(text, ends, count, micros, kinds);
+
+      final microList = micros.asTypedList(count);
+      final kindList = kinds.asTypedList(count);
+      return List<DateTime?>.generate(count, (i) {
+        switch (kindList[i]) {
+          case 1:
+            return DateTime.fromMicrosecondsSinceEpoch(microList[i]);
+          case 2:
+            return DateTime.fromMicrosecondsSinceEpoch(microList[i], isUtc: true);
+          default:
+            final value = values[i];
+            return value == null ? null : DateTime.tryParse(value);
+        }
+      });
+    } finally {
+      malloc.free(text);
+      malloc.free(ends);
+      malloc.free(micros);
+      malloc.free(kinds);
+    }
+  }
+
+  _ParseIsoTimestampsDart? _lookup() {
+    if (_lookedUp) return _parse;
+    _lookedUp = true;
+    if (!isPlatformSupported) return null;
+    try {
+      _parse = DynamicLibrary.process()
+          .lookupFunction<_ParseIsoTimestampsNative, _ParseIsoTimestampsDart>('codeagenthub_parse_iso_timestamps');
+    } catch (e) {
+      print('ERROR TimestampKernel: Native parser unavailable: $e');
+    }
+    return _parse;
+  }
+}
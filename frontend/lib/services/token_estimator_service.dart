@@ -0,0 +1,131 @@
+import 'dart:io';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 草稿 token 估算结果
+class TokenEstimate {
+  final int total;
+  final List<int> blocks; // 与请求中的内容块一一对应
+
+  const TokenEstimate({required this.total, required this.blocks});
+}
+
+/// 草稿中的图片（提供宽高，或由原生端读取文件头）
+class DraftImageInfo {
+  final String? path;
+  final int? width;
+  final int? height;
+
+  const DraftImageInfo({this.path, this.width, this.height});
+}
+
+/// Token 估算服务（Linux 原生实现）
+///
+/// 在 runner 的任务池中按 BPE 预分词规则估算文本和图片的 token 数，
+/// 文本按段缓存计数，输入时只重新计算被修改的段落。
+class TokenEstimatorService {
+  static TokenEstimatorService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/token_estimator');
+
+  /// 默认上下文窗口大小
+  static const int defaultContextWindow = 200000;
+
+  TokenEstimatorService._();
+
+  static TokenEstimatorService getInstance() {
+    _instance ??= TokenEstimatorService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 估算草稿内容块的 token 数，失败时返回 null
+  Future<TokenEstimate?> estimate({
+    List<String> texts = const [],
+    List<DraftImageInfo> images = const [],
+  }) async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('estimate', {
+        'blocks': [
+          for (final image in images)
+            {
+              'type': 'image',
+              if (image.path != null) 'path': image.path,
+              if (image.width != null) 'width': image.width,
+              if (image.height != null) 'height': image.height,
+            },
+          for (final text in texts) {'type': 'text', 'text': text},
+        ],
+      });
+      if (result == null) return null;
+      return TokenEstimate(
+        total: result['total'] as int? ?? 0,
+        blocks: List<int>.from(result['blocks'] as List? ?? const []),
+      );
+    } catch (e) {
+      print('ERROR TokenEstimatorService: Failed to estimate tokens: $e');
+      return null;
+    }
+  }
+}
+
+/// 输入框的实时 token 计量
+///
+/// 同一时间只有一个估算请求在途；输入期间的多次变更合并为最新的一次，
+/// 因此 UI 线程只负责发送草稿，不做任何计数。
+class DraftTokenMeter extends ValueNotifier<int?> {
+  final TokenEstimatorService _service = TokenEstimatorService.getInstance();
+
+  bool _inFlight = false;
+  bool _disposed = false;
+  String? _pendingText;
+  List<DraftImageInfo> _pendingImages = const [];
+  int _pendingExtraTokens = 0;
+
+  DraftTokenMeter() : super(null);
+
+  bool get isSupported => _service.isPlatformSupported;
+
+  /// 草稿变化时调用；[extraTokens] 为已在别处计数的内容（如粘贴的大段文本）
+  void update(String text, List<DraftImageInfo> images, {int extraTokens = 0}) {
+    if (!isSupported) return;
+    _pendingText = text;
+    _pendingImages = images;
+    _pendingExtraTokens = extraTokens;
+    if (!_inFlight) {
+      _run();
+    }
+  }
+
+  Future<void> _run() async {
+    while (_pendingText != null && !_disposed) {
+      final text = _pendingText!;
+      final images = _pendingImages;
+      final extraTokens = _pendingExtraTokens;
+      _pendingText = null;
+      _inFlight = true;
+      final estimate = await _service.estimate(
+        texts: text.isEmpty ? const [] : [text],
+        images: images,
+      );
+      _inFlight = false;
+      if (_disposed) return;
+      if (estimate != null) {
+        value = estimate.total + extraTokens;
+      }
+    }
+  }
+
+  @override
+  void dispose() {
+    _disposed = true;
+    super.dispose();
+  }
+}
@@ -0,0 +1,173 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+import 'native_result_worker.dart';
+
+/// 本地会话记录缓存（Linux 原生实现）
+///
+/// 记录以 zstd 压缩块保存在 runner 中，大段重复内容（文件内容、工具输出）
+/// 按内容分块去重，块索引支持随机读取任意一条消息。
+/// 用于离线查看和快速重新打开会话。
+class TranscriptCacheService {
+  static TranscriptCacheService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/transcript_cache');
+
+  TranscriptCacheService._();
+
+  static TranscriptCacheService getInstance() {
+    _instance ??= TranscriptCacheService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生缓存）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  /// 用 [records] 替换会话的缓存；[append] 为 true 时追加到已有记录之后
+  /// 返回缓存后的记录总数，失败时返回 null
+  Future<int?> storeRecords(
+    String sessionId,
+    List<Map<String, dynamic>> records, {
+    bool append = false,
+  }) async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      return await _channel.invokeMethod<int>('write', {
+        'sessionId': sessionId,
+        'records': records.map(json.encode).toList(),
+        'append': append,
+      });
+    } catch (e) {
+      print('ERROR TranscriptCacheService: Failed to store $sessionId: $e');
+      return null;
+    }
+  }
+
+  /// 将完整记录列表同步到缓存：已缓存的前缀不变时只追加新增的尾部记录
+  ///
+  /// 以缓存的最后一条记录与 [records] 中同一位置的记录是否相同判断前缀；
+  /// 不同（会话被改写或压缩过）时整体重写。
+  Future<void> syncRecords(String sessionId, List<Map<String, dynamic>> records) async {
+    if (!isPlatformSupported) return;
+
+    final cached = await recordCount(sessionId);
+    if (cached == 0 && records.isEmpty) return;
+    if (cached > 0 && cached <= records.length) {
+      final last = await readRecords(sessionId, start: cached - 1, count: 1);
+      if (last != null && last.length == 1 && json.encode(last.first) == json.encode(records[cached - 1])) {
+        if (cached < records.length) {
+          await storeRecords(sessionId, records.sublist(cached), append: true);
+        }
+        return;
+      }
+    }
+    await storeRecords(sessionId, records);
+  }
+
+  /// 读取从 [start] 开始的最多 [count] 条记录；会话未缓存时返回 null
+  Future<List<Map<String, dynamic>>?> readRecords(
+    String sessionId, {
+    int start = 0,
+    int? count,
+  }) async {
+    if (!isPlatformSupported) return null;
+
+    try {
+      final raw = await _channel.invokeListMethod<String>('readRange', {
+        'sessionId': sessionId,
+        'start': start,
+        if (count != null) 'count': count,
+      });
+      if (raw == null) return null;
+      return raw.map((line) => json.decode(line) as Map<String, dynamic>).toList();
+    } catch (e) {
+      print('DEBUG TranscriptCacheService: No cached records for $sessionId: $e');
+      return null;
+    }
+  }
+
+  /// 在后台 isolate 中读取会话的全部缓存记录并由 [materialize] 转成结果
+  ///
+  /// runner 把记录作为一块 JSONL 直接投递给 [NativeResultWorker]，JSON 解码
+  /// 和 [materialize] 都不占用 UI isolate。[materialize] 需能发送到其他 isolate
+  /// （如静态方法）。会话未缓存或读取失败时返回 null
+  Future<R?> readRecordsInBackground<R>(
+    String sessionId,
+    R Function(String sessionId, List<Map<String, dynamic>> records) materialize,
+  ) async {
+    if (!isPlatformSupported) return null;
+
+    return NativeResultWorker.getInstance().run<R>(
+      request: (port, job) async {
+        try {
+          await _channel.invokeMethod<int>('readRange', {
+            'sessionId': sessionId,
+            'replyPort': port,
+            'job': job,
+          });
+          return true;
+        } catch (e) {
+          print('DEBUG TranscriptCacheService: No cached records for $sessionId: $e');
+          return false;
+        }
+      },
+      materialize: _decodeInBackground(sessionId, materialize),
+    );
+  }
+
+  // 在静态上下文中创建闭包，只捕获可发送的值
+  static R Function(Uint8List) _decodeInBackground<R>(
+    String sessionId,
+    R Function(String sessionId, List<Map<String, dynamic>> records) materialize,
+  ) {
+    return (bytes) {
+      final records = const LineSplitter()
+          .convert(utf8.decode(bytes))
+          .map((line) => json.decode(line) as Map<String, dynamic>)
+          .toList();
+      return materialize(sessionId, records);
+    };
+  }
+
+  /// 已缓存的记录数（未缓存为 0）
+  Future<int> recordCount(String sessionId) async {
+    if (!isPlatformSupported) return 0;
+
+    try {
+      return await _channel.invokeMethod<int>('count', {'sessionId': sessionId}) ?? 0;
+    } catch (e) {
+      return 0;
+    }
+  }
+
+  /// 删除会话缓存
+  Future<void> remove(String sessionId) async {
+    if (!isPlatformSupported) return;
+
+    try {
+      await _channel.invokeMethod('remove', {'sessionId': sessionId});
+    } catch (e) {
+      print('ERROR TranscriptCacheService: Failed to remove $sessionId: $e');
+    }
+  }
+
+  /// 缓存统计信息（会话数、原始字节数、实际占用字节数等）
+  Future<Map<String, dynamic>> stats() async {
+    if (!isPlatformSupported) return {};
+
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('stats');
+      return result ?? {};
+    } catch (e) {
+      print('ERROR TranscriptCacheService: Failed to load stats: $e');
+      return {};
+    }
+  }
+}
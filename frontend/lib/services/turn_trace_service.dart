@@ -0,0 +1,179 @@
+import 'dart:convert';
+import 'dart:developer' as developer;
+import 'dart:io';
+import 'dart:math';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// 一轮对话的客户端追踪记录
+///
+/// 时间使用 Dart Timeline 时钟（微秒），与 runner 的单调时钟相同。
+/// 请求头 X-Turn-Trace 携带追踪 ID 和发送时间，后端在结束事件之前以
+/// trace 事件返回它的 span，由 runner 对齐两边的时钟后合并。
+class TurnTrace {
+  static const String header = 'X-Turn-Trace';
+  static const int _maxSpans = 20000;
+
+  final String id;
+  final String schema;
+  int sentUs = 0;
+  int headersUs = 0;
+  Map<String, dynamic>? backend; // 后端 trace 事件的内容
+  final List<Map<String, dynamic>> _spans = [];
+  int _dropped = 0;
+
+  TurnTrace(this.id, this.schema);
+
+  static int get now => developer.Timeline.now;
+
+  /// 记录一个区间；省略 [endUs] 表示到现在为止
+  void span(String track, String name, int startUs, {int? endUs, Map<String, dynamic>? args}) {
+    _add({
+      'track': track,
+      'name': name,
+      'ts': startUs,
+      'dur': (endUs ?? now) - startUs,
+      if (args != null) 'args': args,
+    });
+  }
+
+  /// 记录一个瞬时事件
+  void instant(String track, String name, {Map<String, dynamic>? args}) {
+    _add({
+      'track': track,
+      'name': name,
+      'ts': now,
+      if (args != null) 'args': args,
+    });
+  }
+
+  void _add(Map<String, dynamic> span) {
+    if (_spans.length >= _maxSpans) {
+      _dropped++;
+      return;
+    }
+    _spans.add(span);
+  }
+
+  /// 在发送请求前调用，返回请求头的值
+  String markSent() {
+    sentUs = now;
+    return '$id $sentUs';
+  }
+
+  /// 收到响应头时调用
+  void markHeaders(int statusCode) {
+    headersUs = now;
+    span('request', 'http.request', sentUs, endUs: headersUs, args: {'status': statusCode});
+  }
+
+  /// 原样转发响应体，记录每个分块的到达，并取出后端的 trace 事件
+  Stream<List<int>> tap(Stream<List<int>> body) async* {
+    final lines = const Utf8Decoder(allowMalformed: true)
+        .startChunkedConversion(const LineSplitter().startChunkedConversion(_TraceEventSink(this)));
+    var index = 0;
+    try {
+      await for (final chunk in body) {
+        instant('network', 'http.chunk', args: {'index': index++, 'bytes': chunk.length});
+        lines.add(chunk);
+        yield chunk;
+      }
+    } finally {
+      lines.close();
+    }
+  }
+
+  Map<String, dynamic> toJson() => {
+        'id': id,
+        'schema': schema,
+        'sentUs': sentUs,
+        'headersUs': headersUs,
+        'spans': _spans,
+        'dropped': _dropped,
+        'backend': backend,
+      };
+}
+
+/// 在 SSE 行中找到 `event: trace` 后的 data 行
+class _TraceEventSink implements Sink<String> {
+  final TurnTrace trace;
+  bool _inTraceEvent = false;
+
+  _TraceEventSink(this.trace);
+
+  @override
+  void add(String line) {
+    if (line.startsWith('event: ')) {
+      _inTraceEvent = line == 'event: trace';
+    } else if (_inTraceEvent && line.startsWith('data: ')) {
+      _inTraceEvent = false;
+      try {
+        trace.backend = json.decode(line.substring(6)) as Map<String, dynamic>;
+      } catch (e) {
+        print('ERROR TurnTrace: Invalid backend trace: $e');
+      }
+    }
+  }
+
+  @override
+  void close() {}
+}
+
+/// 对话追踪服务（Linux 原生实现）
+///
+/// 设置环境变量 CODEAGENTHUB_TRACE_TURNS 为目录后，每轮 Claude 对话结束时
+/// runner 把后端与客户端的 span 合并为一个 Chrome trace 文件写入该目录。
+class TurnTraceService {
+  static TurnTraceService? _instance;
+
+  static const MethodChannel _channel = MethodChannel('com.codeagenthub/turn_trace');
+
+  Future<bool>? _enabled;
+  final _random = Random();
+
+  TurnTraceService._();
+
+  static TurnTraceService getInstance() {
+    _instance ??= TurnTraceService._();
+    return _instance!;
+  }
+
+  /// 是否支持（仅 Linux runner 提供原生实现）
+  bool get isPlatformSupported {
+    if (kIsWeb) return false;
+    return Platform.isLinux;
+  }
+
+  Future<bool> _isEnabled() async {
+    if (!isPlatformSupported) return false;
+    try {
+      return await _channel.invokeMethod<bool>('isEnabled') ?? false;
+    } catch (e) {
+      print('ERROR TurnTraceService: Failed to query tracing: $e');
+      return false;
+    }
+  }
+
+  /// 开始一轮追踪；未启用时返回 null
+  Future<TurnTrace?> begin(String schema) async {
+    if (!await (_enabled ??= _isEnabled())) return null;
+    final id = List.generate(8, (_) => _random.nextInt(256).toRadixString(16).padLeft(2, '0')).join();
+    return TurnTrace(id, schema);
+  }
+
+  /// 交给 runner 合并并写出，返回 trace 文件路径
+  Future<String?> finish(TurnTrace trace) async {
+    if (trace.sentUs == 0) return null; // 请求没有发出
+    trace.span('request', 'client.turn', trace.sentUs);
+    try {
+      final path = await _channel.invokeMethod<String>('write', {
+        'turn': json.encode(trace.toJson()),
+      });
+      print('DEBUG TurnTraceService: Wrote $path');
+      return path;
+    } catch (e) {
+      print('ERROR TurnTraceService: Failed to write trace ${trace.id}: $e');
+      return null;
+    }
+  }
+}
@@ -4,6 +4,7 @@ import 'package:flutter/services.dart';
 
 /// Windows 原生语音识别服务（使用 SAPI）
 /// 仅在 Windows 平台可用，离线可用
+/// 识别过程中持续返回假设（isFinal 为 false），runner 已整理好空格、标点和口述的标识符
 class WindowsSpeechRecognition {
   static WindowsSpeechRecognition? _instance;
 
@@ -49,7 +50,8 @@ class WindowsSpeechRecognition {
         if (type == 'result') {
           final text = event['text'] as String? ?? '';
           final isFinal = event['isFinal'] as bool? ?? true;
-          if (text.isNotEmpty) {
+          // 空的最终结果表示撤回之前的假设
+          if (text.isNotEmpty || isFinal) {
             onResult?.call(text, isFinal);
           }
         } else if (type == 'error') {
@@ -142,6 +144,17 @@ class WindowsSpeechRecognition {
     }
   }
 
+  /// 设置当前项目目录，runner 在后台提取其中的标识符，用于识别口述的代码
+  Future<void> setVocabularyRoot(String root) async {
+    if (!isPlatformSupported || root.isEmpty) return;
+
+    try {
+      await _channel.invokeMethod('setVocabularyRoot', {'root': root});
+    } catch (e) {
+      print('ERROR WindowsSpeechRecognition: Failed to set vocabulary root: $e');
+    }
+  }
+
   /// 释放资源
   void dispose() {
     stopListening();
@@ -0,0 +1,100 @@
+import 'dart:async';
+import 'package:flutter/material.dart';
+import '../services/frame_pacing_service.dart';
+import '../services/stream_quality_service.dart';
+
+/// 帧节奏诊断叠加层
+///
+/// 每秒从 runner 读取一次最近 10 秒的帧统计和当前流式渲染质量，显示在
+/// 窗口右上角；不拦截任何输入。
+class FramePacingOverlay extends StatefulWidget {
+  const FramePacingOverlay({super.key});
+
+  @override
+  State<FramePacingOverlay> createState() => _FramePacingOverlayState();
+}
+
+class _FramePacingOverlayState extends State<FramePacingOverlay> {
+  final _service = FramePacingService.getInstance();
+  final _qualityService = StreamQualityService.getInstance();
+  Timer? _timer;
+  FramePacingStats? _stats;
+  StreamQuality? _quality;
+
+  @override
+  void initState() {
+    super.initState();
+    if (!_service.isPlatformSupported) return;
+    _poll();
+    _timer = Timer.periodic(const Duration(seconds: 1), (_) => _poll());
+  }
+
+  @override
+  void dispose() {
+    _timer?.cancel();
+    super.dispose();
+  }
+
+  Future<void> _poll() async {
+    final stats = await _service.getStats();
+    final quality = await _qualityService.getState();
+    if (mounted && stats != null) {
+      setState(() {
+        _stats = stats;
+        _quality = quality;
+      });
+    }
+  }
+
+  static String _ms(int us) => (us / 1000).toStringAsFixed(1);
+
+  String _group(String label, FrameGroupStats group, int windowSeconds) {
+    final fps = windowSeconds > 0 ? group.frames / windowSeconds : 0;
+    return '$label ${fps.toStringAsFixed(0)} fps  missed ${group.missedVblanks}\n'
+        '  interval p50 ${_ms(group.interval.p50)} p99 ${_ms(group.interval.p99)} max ${_ms(group.interval.max)}\n'
+        '  paint    p50 ${_ms(group.paint.p50)} p99 ${_ms(group.paint.p99)} max ${_ms(group.paint.max)}\n'
+        '  late     p50 ${_ms(group.lateness.p50)} p99 ${_ms(group.lateness.p99)}';
+  }
+
+  String _qualityLine(StreamQuality? quality) {
+    if (quality == null) return '';
+    return '\nquality ${quality.level}  apply p90 ${_ms(quality.applyLatencyP90Us)}  '
+        'backlog ${_ms(quality.backlogUs)} (${quality.pendingBatches})';
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final stats = _stats;
+    if (stats == null) return const SizedBox.shrink();
+
+    final refresh = stats.refreshIntervalUs > 0 ? '${_ms(stats.refreshIntervalUs)} ms' : '?';
+    final text = 'vblank $refresh  streams ${stats.activeStreams}  '
+        'events ${stats.eventsPerSecond.toStringAsFixed(1)}/s\n'
+        '${_group('all', stats.all, stats.windowSeconds)}\n'
+        '${_group('streaming', stats.streaming, stats.windowSeconds)}'
+        '${_qualityLine(_quality)}';
+
+    return Positioned(
+      top: 8,
+      right: 8,
+      child: IgnorePointer(
+        child: Container(
+          padding: const EdgeInsets.all(8),
+          decoration: BoxDecoration(
+            color: Colors.black.withOpacity(0.7),
+            borderRadius: BorderRadius.circular(6),
+          ),
+          child: DefaultTextStyle(
+            style: const TextStyle(
+              color: Colors.white,
+              fontSize: 11,
+              fontFamily: 'monospace',
+              decoration: TextDecoration.none,
+            ),
+            child: Text(text),
+          ),
+        ),
+      ),
+    );
+  }
+}
@@ -10,12 +10,14 @@ class MessageBubble extends StatefulWidget {
   final Message message;
   final bool hideToolCalls;
   final bool renderMarkdown;
+  final int collapseToolResultChars; // 超过该长度的工具结果默认折叠，0 表示不折叠
 
   const MessageBubble({
     super.key,
     required this.message,
     this.hideToolCalls = false,
     this.renderMarkdown = true,
+    this.collapseToolResultChars = 0,
   });
 
   @override
@@ -23,6 +25,12 @@ class MessageBubble extends StatefulWidget {
 }
 
 class _MessageBubbleState extends State<MessageBubble> with AutomaticKeepAliveClientMixin {
+  // 折叠时显示的工具结果长度
+  static const _collapsedPreviewChars = 400;
+
+  // 用户手动展开的工具结果
+  final _expandedToolResults = Set<ContentBlock>.identity();
+
   @override
   bool get wantKeepAlive => true; // 保持widget状态，避免重建
 
@@ -145,6 +153,7 @@ class _MessageBubbleState extends State<MessageBubble> with AutomaticKeepAliveCl
         if (widget.hideToolCalls) return const SizedBox.shrink();
         return _buildToolResultBlock(
           context,
+          block: block,
           content: block.content,
           isError: block.isError ?? false,
         );
@@ -912,7 +921,12 @@ class _MessageBubbleState extends State<MessageBubble> with AutomaticKeepAliveCl
     );
   }
 
-  Widget _buildToolResultBlock(BuildContext context, {required dynamic content, required bool isError}) {
+  Widget _buildToolResultBlock(
+    BuildContext context, {
+    required ContentBlock block,
+    required dynamic content,
+    required bool isError,
+  }) {
     // 提取文本内容
     String displayContent = '';
     if (content is String) {
@@ -941,6 +955,12 @@ class _MessageBubbleState extends State<MessageBubble> with AutomaticKeepAliveCl
     final errorColor = Theme.of(context).colorScheme.error;
     final dividerColor = Theme.of(context).dividerColor;
 
+    // 界面跟不上流式输出时，大段工具结果只显示开头，点击后展开
+    final collapseChars = widget.collapseToolResultChars;
+    final collapsed = collapseChars > 0 &&
+        displayContent.length > collapseChars &&
+        !_expandedToolResults.contains(block);
+
     return Container(
       margin: const EdgeInsets.only(bottom: 8),
       padding: const EdgeInsets.all(8),
@@ -1005,12 +1025,27 @@ class _MessageBubbleState extends State<MessageBubble> with AutomaticKeepAliveCl
           ),
           const SizedBox(height: 4),
           Text(
-            displayContent,
+            collapsed ? '${displayContent.substring(0, _collapsedPreviewChars)}…' : displayContent,
             style: TextStyle(
               color: appColors.textSecondary,
               fontSize: 13,
             ),
           ),
+          if (collapsed)
+            InkWell(
+              onTap: () => setState(() => _expandedToolResults.add(block)),
+              borderRadius: BorderRadius.circular(4),
+              child: Padding(
+                padding: const EdgeInsets.symmetric(vertical: 4),
+                child: Text(
+                  '展开全部（${displayContent.length} 字符）',
+                  style: TextStyle(
+                    color: Theme.of(context).colorScheme.primary,
+                    fontSize: 12,
+                  ),
+                ),
+              ),
+            ),
         ],
       ),
     );
@@ -0,0 +1,769 @@
+#include "backend_log.h"
+
+#include <zstd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+
+#include "json_value.h"
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/backend_log";
+
+// The store keeps roughly the most recent output within this budget.
+constexpr size_t kMaxStoredBytes = 8 * 1024 * 1024;
+// Blocks are compressed once they hold this much text.
+constexpr size_t kBlockBytes = 256 * 1024;
+// Longer records and unterminated lines are cut.
+constexpr size_t kMaxRecordBytes = 1024 * 1024;
+constexpr int kCompressionLevel = 3;
+constexpr uint32_t kNoBlock = UINT32_MAX;
+// Approximate heap cost of one hash map node, for index accounting.
+constexpr size_t kHashNodeBytes = 32;
+
+// An interned name is held by names_ and as a name_ids_ key.
+size_t NameBytes(const std::string& name) {
+  return 2 * (sizeof(std::string) + name.size()) + kHashNodeBytes;
+}
+
+const char* StreamName(BackendLog::Stream stream) {
+  return stream == BackendLog::kStderr ? "stderr" : "stdout";
+}
+
+bool IsTagChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.';
+}
+
+// "[Source:label key=value ...]" on a line of its own.
+bool ParseSdkHeader(const char* line, size_t size, std::string* source,
+                    std::string* label, std::string* run,
+                    std::string* session) {
+  if (size < 4 || line[0] != '[' || line[size - 1] != ']') {
+    return false;
+  }
+  const char* end = line + size - 1;
+  const char* p = line + 1;
+  const char* source_end = p;
+  while (source_end < end && IsTagChar(*source_end)) {
+    ++source_end;
+  }
+  if (source_end == p || source_end == end || *source_end != ':') {
+    return false;
+  }
+  const char* label_begin = source_end + 1;
+  const char* label_end = label_begin;
+  while (label_end < end && *label_end != ' ') {
+    ++label_end;
+  }
+  if (label_end == label_begin) {
+    return false;
+  }
+  source->assign(p, source_end);
+  label->assign(label_begin, label_end);
+  run->clear();
+  session->clear();
+
+  p = label_end;
+  while (p < end) {
+    while (p < end && *p == ' ') {
+      ++p;
+    }
+    const char* token_end = p;
+    while (token_end < end && *token_end != ' ') {
+      ++token_end;
+    }
+    const char* equals =
+        static_cast<const char*>(memchr(p, '=', token_end - p));
+    if (equals != nullptr) {
+      const size_t key_size = equals - p;
+      if (key_size == 3 && memcmp(p, "run", 3) == 0) {
+        run->assign(equals + 1, token_end);
+      } else if (key_size == 7 && memcmp(p, "session", 7) == 0) {
+        session->assign(equals + 1, token_end);
+      }
+    }
+    p = token_end;
+  }
+  return true;
+}
+
+// "[Tag] message": the tag, or empty.
+std::string PlainTag(const char* line, size_t size) {
+  if (size < 3 || line[0] != '[') {
+    return std::string();
+  }
+  size_t end = 1;
+  while (end < size && IsTagChar(line[end])) {
+    ++end;
+  }
+  if (end == 1 || end >= size || line[end] != ']') {
+    return std::string();
+  }
+  return std::string(line + 1, end - 1);
+}
+
+}  // namespace
+
+BackendLog::BackendLog(size_t max_stored_bytes)
+    : max_stored_bytes_(max_stored_bytes) {
+  names_.emplace_back();  // Id 0: none.
+}
+
+void BackendLog::Append(Stream stream, const char* data, size_t size,
+                        int64_t now_us) {
+  StreamState& state = streams_[stream];
+  size_t start = 0;
+  while (start < size) {
+    const char* newline =
+        static_cast<const char*>(memchr(data + start, '\n', size - start));
+    if (newline == nullptr) {
+      const size_t room = kMaxRecordBytes - std::min(kMaxRecordBytes,
+                                                     state.partial_line.size());
+      state.partial_line.append(data + start, std::min(room, size - start));
+      break;
+    }
+    const size_t end = newline - data;
+    if (state.partial_line.empty()) {
+      AppendLine(stream, data + start, end - start, now_us);
+    } else {
+      state.partial_line.append(data + start, end - start);
+      AppendLine(stream, state.partial_line.data(), state.partial_line.size(),
+                 now_us);
+      state.partial_line.clear();
+    }
+    start = end + 1;
+  }
+  // A plain record ends with the chunk: each console call is written at once,
+  // so its continuation lines arrive with it.
+  if (state.pending.open && !state.pending.sdk) {
+    Commit(stream, &state.pending);
+  }
+}
+
+void BackendLog::Flush(int64_t now_us) {
+  for (int i = 0; i < 2; ++i) {
+    const Stream stream = static_cast<Stream>(i);
+    StreamState& state = streams_[i];
+    if (!state.partial_line.empty()) {
+      std::string line = std::move(state.partial_line);
+      state.partial_line.clear();
+      AppendLine(stream, line.data(), line.size(), now_us);
+    }
+    Commit(stream, &state.pending);
+  }
+}
+
+void BackendLog::AppendLine(Stream stream, const char* line, size_t size,
+                            int64_t now_us) {
+  if (size > 0 && line[size - 1] == '\r') {
+    --size;
+  }
+  Pending& pending = streams_[stream].pending;
+
+  Pending header;
+  const bool is_header = ParseSdkHeader(line, size, &header.source,
+                                        &header.label, &header.run,
+                                        &header.session);
+  if (pending.open && pending.sdk && !is_header) {
+    // SDK payloads never contain blank lines; one ends the record.
+    if (size == 0) {
+      Commit(stream, &pending);
+    } else if (pending.text.size() + size < kMaxRecordBytes) {
+      pending.text.append(line, size);
+      pending.text += '\n';
+    }
+    return;
+  }
+  if (is_header) {
+    Commit(stream, &pending);
+    pending = std::move(header);
+    pending.open = true;
+    pending.sdk = true;
+    pending.time_us = now_us;
+    return;
+  }
+  if (size == 0) {
+    Commit(stream, &pending);
+    return;
+  }
+  if (pending.open && (line[0] == ' ' || line[0] == '\t')) {
+    if (pending.text.size() + size < kMaxRecordBytes) {
+      pending.text += '\n';
+      pending.text.append(line, size);
+    }
+    return;
+  }
+  Commit(stream, &pending);
+  pending.open = true;
+  pending.time_us = now_us;
+  pending.source = PlainTag(line, size);
+  if (pending.source.empty()) {
+    pending.source = StreamName(stream);
+  }
+  pending.text.assign(line, size);
+}
+
+void BackendLog::Commit(Stream stream, Pending* pending) {
+  if (!pending->open) {
+    return;
+  }
+  std::string session = pending->session;
+  bool json = false;
+  std::string text;
+  if (pending->sdk) {
+    JsonValue payload;
+    std::string error;
+    if (ParseJson(pending->text, &payload, &error)) {
+      text = payload.Serialize();
+      json = true;
+      if (session.empty()) {
+        // The first messages of a new session are logged before the backend
+        // knows its id.
+        const JsonValue* id = payload.Find("session_id");
+        if (id == nullptr || !id->is_string()) {
+          id = payload.Find("thread_id");
+        }
+        if (id != nullptr && id->is_string()) {
+          session = id->AsString();
+        }
+      }
+    } else {
+      text = std::move(pending->text);
+      while (!text.empty() && text.back() == '\n') {
+        text.pop_back();
+      }
+    }
+  } else {
+    text = std::move(pending->text);
+  }
+  Store(stream, *pending, text, json, session);
+  *pending = Pending();
+}
+
+void BackendLog::Store(Stream stream, const Pending& pending,
+                       const std::string& text, bool json,
+                       const std::string& session) {
+  Entry entry;
+  entry.time_us = pending.time_us;
+  entry.stream = stream;
+  entry.json = json;
+  entry.fields[kSource] = Intern(pending.source);
+  entry.fields[kLabel] = Intern(pending.label);
+  entry.fields[kRun] = Intern(pending.run);
+  entry.fields[kSession] = Intern(session);
+  if (entry.fields[kRun] != 0) {
+    if (entry.fields[kSession] != 0) {
+      if (run_sessions_.count(entry.fields[kRun]) == 0) {
+        stored_bytes_ += kHashNodeBytes;
+      }
+      run_sessions_[entry.fields[kRun]] = entry.fields[kSession];
+    } else {
+      auto known = run_sessions_.find(entry.fields[kRun]);
+      if (known != run_sessions_.end()) {
+        entry.fields[kSession] = known->second;
+      }
+    }
+  }
+
+  if (blocks_.empty() || blocks_.back().sealed) {
+    blocks_.emplace_back();
+  }
+  Block& block = blocks_.back();
+  const size_t length = std::min(text.size(), kMaxRecordBytes);
+  entry.block = first_block_ + static_cast<uint32_t>(blocks_.size() - 1);
+  entry.offset = static_cast<uint32_t>(block.text.size());
+  entry.length = static_cast<uint32_t>(length);
+  block.text.append(text, 0, length);
+  block.raw_size = block.text.size();
+  stored_bytes_ += length;
+  raw_bytes_ += length;
+
+  const uint64_t sequence = first_sequence_ + entries_.size();
+  entries_.push_back(entry);
+  stored_bytes_ += sizeof(Entry);
+  for (int field = 0; field < kFieldCount; ++field) {
+    if (entry.fields[field] != 0) {
+      std::vector<uint64_t>& sequences = postings_[field][entry.fields[field]];
+      if (sequences.empty()) {
+        stored_bytes_ += kHashNodeBytes + sizeof(sequences);
+      }
+      sequences.push_back(sequence);
+      stored_bytes_ += sizeof(uint64_t);
+    }
+  }
+
+  if (block.text.size() >= kBlockBytes) {
+    SealOpenBlock();
+  }
+  while (stored_bytes_ > max_stored_bytes_ && blocks_.size() > 1) {
+    EvictOldest();
+  }
+}
+
+void BackendLog::SealOpenBlock() {
+  Block& block = blocks_.back();
+  std::string compressed(ZSTD_compressBound(block.text.size()), '\0');
+  const size_t result =
+      ZSTD_compress(&compressed[0], compressed.size(), block.text.data(),
+                    block.text.size(), kCompressionLevel);
+  if (ZSTD_isError(result)) {
+    // Keep it raw; it is still readable, just larger.
+    g_warning("Failed to compress backend log block: %s",
+              ZSTD_getErrorName(result));
+    blocks_.emplace_back();
+    return;
+  }
+  compressed.resize(result);
+  compressed.shrink_to_fit();
+  stored_bytes_ -= block.text.size();
+  stored_bytes_ += compressed.size();
+  block.text = std::move(compressed);
+  block.sealed = true;
+}
+
+void BackendLog::EvictOldest() {
+  stored_bytes_ -= blocks_.front().text.size();
+  blocks_.pop_front();
+  ++first_block_;
+  while (!entries_.empty() && entries_.front().block < first_block_) {
+    entries_.pop_front();
+    stored_bytes_ -= sizeof(Entry);
+    ++first_sequence_;
+    ++dropped_;
+  }
+  std::vector<uint32_t> emptied;
+  for (auto& postings : postings_) {
+    for (auto it = postings.begin(); it != postings.end();) {
+      std::vector<uint64_t>& sequences = it->second;
+      auto keep = std::lower_bound(sequences.begin(), sequences.end(),
+                                   first_sequence_);
+      stored_bytes_ -= (keep - sequences.begin()) * sizeof(uint64_t);
+      sequences.erase(sequences.begin(), keep);
+      if (sequences.empty()) {
+        stored_bytes_ -= kHashNodeBytes + sizeof(sequences);
+        emptied.push_back(it->first);
+        it = postings.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  if (!emptied.empty()) {
+    ForgetUnusedNames(emptied);
+  }
+}
+
+void BackendLog::ForgetUnusedNames(const std::vector<uint32_t>& candidates) {
+  // A run none of whose records is left no longer needs its session.
+  for (auto it = run_sessions_.begin(); it != run_sessions_.end();) {
+    if (postings_[kRun].count(it->first) == 0) {
+      stored_bytes_ -= kHashNodeBytes;
+      it = run_sessions_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  std::unordered_set<uint32_t> sessions;
+  for (const auto& entry : run_sessions_) {
+    sessions.insert(entry.second);
+  }
+  for (uint32_t id : candidates) {
+    if (names_[id].empty() || sessions.count(id) > 0) {
+      continue;
+    }
+    bool used = false;
+    for (const auto& postings : postings_) {
+      used = used || postings.count(id) > 0;
+    }
+    if (used) {
+      continue;
+    }
+    stored_bytes_ -= NameBytes(names_[id]);
+    name_ids_.erase(names_[id]);
+    std::string().swap(names_[id]);
+    free_name_ids_.push_back(id);
+  }
+}
+
+std::vector<BackendLog::Record> BackendLog::Query(const Filter& filter,
+                                                  uint64_t before,
+                                                  size_t limit) {
+  std::vector<Record> records;
+  const std::string* values[kFieldCount] = {&filter.source, &filter.label,
+                                            &filter.run, &filter.session};
+  uint32_t wanted[kFieldCount] = {};
+  const std::vector<uint64_t>* shortest = nullptr;
+  for (int field = 0; field < kFieldCount; ++field) {
+    if (values[field]->empty()) {
+      continue;
+    }
+    wanted[field] = Find(*values[field]);
+    auto found = postings_[field].find(wanted[field]);
+    if (wanted[field] == 0 || found == postings_[field].end()) {
+      return records;
+    }
+    if (shortest == nullptr || found->second.size() < shortest->size()) {
+      shortest = &found->second;
+    }
+  }
+
+  const uint64_t end_sequence = first_sequence_ + entries_.size();
+  const uint64_t upper =
+      before == 0 || before > end_sequence ? end_sequence : before;
+  auto matches = [&](const Entry& entry) {
+    for (int field = 0; field < kFieldCount; ++field) {
+      if (wanted[field] != 0 && entry.fields[field] != wanted[field]) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Walk back from |upper| through the smallest posting list.
+  std::vector<uint64_t> sequences;
+  if (shortest != nullptr) {
+    auto it = std::lower_bound(shortest->begin(), shortest->end(), upper);
+    while (it != shortest->begin() && sequences.size() < limit) {
+      --it;
+      if (matches(entries_[*it - first_sequence_])) {
+        sequences.push_back(*it);
+      }
+    }
+  } else {
+    for (uint64_t sequence = upper;
+         sequence > first_sequence_ && sequences.size() < limit; --sequence) {
+      sequences.push_back(sequence - 1);
+    }
+  }
+  std::reverse(sequences.begin(), sequences.end());
+
+  std::string scratch;
+  uint32_t cached_block = kNoBlock;
+  records.reserve(sequences.size());
+  for (uint64_t sequence : sequences) {
+    const Entry& entry = entries_[sequence - first_sequence_];
+    const std::string* text = BlockText(entry.block, &scratch, &cached_block);
+    if (text == nullptr) {
+      continue;
+    }
+    Record record;
+    record.sequence = sequence;
+    record.time_us = entry.time_us;
+    record.stream = entry.stream;
+    record.json = entry.json;
+    record.source = Name(entry.fields[kSource]);
+    record.label = Name(entry.fields[kLabel]);
+    record.run = Name(entry.fields[kRun]);
+    record.session = Name(entry.fields[kSession]);
+    record.text.assign(*text, entry.offset, entry.length);
+    records.push_back(std::move(record));
+  }
+  return records;
+}
+
+std::vector<BackendLog::RunSummary> BackendLog::Runs() {
+  std::vector<RunSummary> runs;
+  for (const auto& posting : postings_[kRun]) {
+    const std::vector<uint64_t>& sequences = posting.second;
+    RunSummary summary;
+    summary.run = Name(posting.first);
+    auto session = run_sessions_.find(posting.first);
+    if (session != run_sessions_.end()) {
+      summary.session = Name(session->second);
+    }
+    summary.records = sequences.size();
+    summary.first_us = entries_[sequences.front() - first_sequence_].time_us;
+    summary.last_us = entries_[sequences.back() - first_sequence_].time_us;
+    runs.push_back(std::move(summary));
+  }
+  std::sort(runs.begin(), runs.end(),
+            [](const RunSummary& a, const RunSummary& b) {
+              return a.last_us > b.last_us;
+            });
+  return runs;
+}
+
+void BackendLog::Clear() {
+  dropped_ += entries_.size();
+  first_sequence_ += entries_.size();
+  first_block_ += static_cast<uint32_t>(blocks_.size());
+  entries_.clear();
+  blocks_.clear();
+  stored_bytes_ = 0;
+  for (auto& postings : postings_) {
+    postings.clear();
+  }
+  run_sessions_.clear();
+  names_.resize(1);
+  name_ids_.clear();
+  free_name_ids_.clear();
+}
+
+BackendLog::Stats BackendLog::GetStats() const {
+  Stats stats;
+  stats.records = entries_.size();
+  stats.dropped = dropped_;
+  stats.raw_bytes = raw_bytes_;
+  stats.stored_bytes = stored_bytes_;
+  return stats;
+}
+
+uint32_t BackendLog::Intern(const std::string& value) {
+  if (value.empty()) {
+    return 0;
+  }
+  auto found = name_ids_.find(value);
+  if (found != name_ids_.end()) {
+    return found->second;
+  }
+  uint32_t id;
+  if (!free_name_ids_.empty()) {
+    id = free_name_ids_.back();
+    free_name_ids_.pop_back();
+    names_[id] = value;
+  } else {
+    id = static_cast<uint32_t>(names_.size());
+    names_.push_back(value);
+  }
+  name_ids_.emplace(value, id);
+  stored_bytes_ += NameBytes(value);
+  return id;
+}
+
+uint32_t BackendLog::Find(const std::string& value) const {
+  auto found = name_ids_.find(value);
+  return found != name_ids_.end() ? found->second : 0;
+}
+
+const std::string* BackendLog::BlockText(uint32_t block, std::string* scratch,
+                                         uint32_t* cached_block) {
+  const Block& stored = blocks_[block - first_block_];
+  if (!stored.sealed) {
+    return &stored.text;
+  }
+  if (*cached_block != block) {
+    scratch->resize(stored.raw_size);
+    const size_t result = ZSTD_decompress(&(*scratch)[0], scratch->size(),
+                                          stored.text.data(),
+                                          stored.text.size());
+    if (ZSTD_isError(result) || result != stored.raw_size) {
+      g_warning("Unreadable backend log block %u", block);
+      *cached_block = kNoBlock;
+      return nullptr;
+    }
+    *cached_block = block;
+  }
+  return scratch;
+}
+
+// Channel glue. Output chunks are framed in arrival order by one drain task
+// at a time; queries run on the pool.
+
+namespace {
+
+FlMethodChannel* g_backend_log_channel = nullptr;
+
+struct Chunk {
+  BackendLog::Stream stream = BackendLog::kStdout;
+  std::string data;
+  bool flush = false;
+  int64_t time_us = 0;
+};
+
+std::mutex g_backend_log_mutex;
+BackendLog* g_backend_log = nullptr;  // Guarded by g_backend_log_mutex.
+
+std::mutex g_chunks_mutex;
+std::deque<Chunk> g_chunks;
+bool g_draining = false;  // Guarded by g_chunks_mutex.
+
+BackendLog* GetBackendLog() {
+  if (g_backend_log == nullptr) {
+    g_backend_log = new BackendLog(kMaxStoredBytes);
+  }
+  return g_backend_log;
+}
+
+void DrainChunks() {
+  while (true) {
+    Chunk chunk;
+    {
+      std::lock_guard<std::mutex> lock(g_chunks_mutex);
+      if (g_chunks.empty()) {
+        g_draining = false;
+        return;
+      }
+      chunk = std::move(g_chunks.front());
+      g_chunks.pop_front();
+    }
+    std::lock_guard<std::mutex> lock(g_backend_log_mutex);
+    if (chunk.flush) {
+      GetBackendLog()->Flush(chunk.time_us);
+    } else {
+      GetBackendLog()->Append(chunk.stream, chunk.data.data(),
+                              chunk.data.size(), chunk.time_us);
+    }
+  }
+}
+
+void EnqueueChunk(Chunk chunk) {
+  bool start = false;
+  {
+    std::lock_guard<std::mutex> lock(g_chunks_mutex);
+    g_chunks.push_back(std::move(chunk));
+    start = !g_draining;
+    g_draining = true;
+  }
+  if (start) {
+    TaskPool::Get().PostBackground(DrainChunks);
+  }
+}
+
+FlValue* RecordToValue(const BackendLog::Record& record) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(
+      value, "sequence",
+      fl_value_new_int(static_cast<int64_t>(record.sequence)));
+  fl_value_set_string_take(value, "time", fl_value_new_int(record.time_us));
+  fl_value_set_string_take(value, "stream",
+                           fl_value_new_string(StreamName(record.stream)));
+  fl_value_set_string_take(value, "source",
+                           fl_value_new_string(record.source.c_str()));
+  fl_value_set_string_take(value, "label",
+                           fl_value_new_string(record.label.c_str()));
+  fl_value_set_string_take(value, "runId",
+                           fl_value_new_string(record.run.c_str()));
+  fl_value_set_string_take(value, "sessionId",
+                           fl_value_new_string(record.session.c_str()));
+  fl_value_set_string_take(value, "json", fl_value_new_bool(record.json));
+  fl_value_set_string_take(value, "text",
+                           fl_value_new_string(record.text.c_str()));
+  return value;
+}
+
+FlValue* RunToValue(const BackendLog::RunSummary& run) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "runId", fl_value_new_string(run.run.c_str()));
+  fl_value_set_string_take(value, "sessionId",
+                           fl_value_new_string(run.session.c_str()));
+  fl_value_set_string_take(value, "records",
+                           fl_value_new_int(static_cast<int64_t>(run.records)));
+  fl_value_set_string_take(value, "firstTime", fl_value_new_int(run.first_us));
+  fl_value_set_string_take(value, "lastTime", fl_value_new_int(run.last_us));
+  return value;
+}
+
+FlValue* StatsToValue(const BackendLog::Stats& stats) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "records",
+                           fl_value_new_int(static_cast<int64_t>(stats.records)));
+  fl_value_set_string_take(value, "dropped",
+                           fl_value_new_int(static_cast<int64_t>(stats.dropped)));
+  fl_value_set_string_take(
+      value, "rawBytes",
+      fl_value_new_int(static_cast<int64_t>(stats.raw_bytes)));
+  fl_value_set_string_take(
+      value, "storedBytes",
+      fl_value_new_int(static_cast<int64_t>(stats.stored_bytes)));
+  return value;
+}
+
+void HandleBackendLogCall(FlMethodChannel* channel, FlMethodCall* method_call,
+                          gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method == "append") {
+    FlValue* data = args != nullptr && fl_value_get_type(args) ==
+                                           FL_VALUE_TYPE_MAP
+                        ? fl_value_lookup_string(args, "data")
+                        : nullptr;
+    if (data == nullptr ||
+        fl_value_get_type(data) != FL_VALUE_TYPE_UINT8_LIST) {
+      RespondError(method_call, "INVALID_ARGUMENTS", "data is required");
+      return;
+    }
+    Chunk chunk;
+    chunk.stream = LookupStringArg(args, "stream") == "stderr"
+                       ? BackendLog::kStderr
+                       : BackendLog::kStdout;
+    chunk.data.assign(
+        reinterpret_cast<const char*>(fl_value_get_uint8_list(data)),
+        fl_value_get_length(data));
+    chunk.time_us = g_get_real_time();
+    EnqueueChunk(std::move(chunk));
+    RespondSuccess(method_call, nullptr);
+    return;
+  }
+  if (method == "flush") {
+    Chunk chunk;
+    chunk.flush = true;
+    chunk.time_us = g_get_real_time();
+    EnqueueChunk(std::move(chunk));
+    RespondSuccess(method_call, nullptr);
+    return;
+  }
+  if (method != "query" && method != "runs" && method != "clear" &&
+      method != "stats") {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+    return;
+  }
+
+  BackendLog::Filter filter;
+  filter.source = LookupStringArg(args, "source");
+  filter.label = LookupStringArg(args, "label");
+  filter.run = LookupStringArg(args, "runId");
+  filter.session = LookupStringArg(args, "sessionId");
+  const int64_t before = LookupIntArg(args, "before", 0);
+  const int64_t limit = LookupIntArg(args, "limit", 200);
+
+  g_object_ref(method_call);
+  TaskPool::Get().Post([method, filter, before, limit, method_call]() {
+    FlValue* result = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(g_backend_log_mutex);
+      BackendLog* log = GetBackendLog();
+      if (method == "query") {
+        result = fl_value_new_list();
+        for (const auto& record :
+             log->Query(filter, static_cast<uint64_t>(std::max<int64_t>(
+                                    before, 0)),
+                        static_cast<size_t>(std::max<int64_t>(limit, 0)))) {
+          fl_value_append_take(result, RecordToValue(record));
+        }
+      } else if (method == "runs") {
+        result = fl_value_new_list();
+        for (const auto& run : log->Runs()) {
+          fl_value_append_take(result, RunToValue(run));
+        }
+      } else if (method == "clear") {
+        log->Clear();
+      } else {
+        result = StatsToValue(log->GetStats());
+      }
+    }
+    RunOnMainThread([method_call, result]() {
+      RespondSuccess(method_call, result);
+      g_object_unref(method_call);
+    });
+  });
+}
+
+}  // namespace
+
+void RegisterBackendLogChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_backend_log_channel = fl_method_channel_new(messenger, kChannelName,
+                                                FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_backend_log_channel, HandleBackendLogCall, nullptr, nullptr);
+}
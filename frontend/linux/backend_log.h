@@ -0,0 +1,158 @@
+#ifndef RUNNER_BACKEND_LOG_H_
+#define RUNNER_BACKEND_LOG_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Structured store for the backend's stdout and stderr. Output arrives in
+// arbitrary chunks and is framed into records:
+//
+//   [ClaudeSDK:assistant run=<id> session=<id>]   SDK message (logSdkMessage
+//   { ...pretty JSON... }                         in the backend), ended by a
+//                                                 blank line
+//   [Claude] starting run ...                     any other line; indented
+//       at ...                                    lines continue the record
+//
+// SDK payloads are stored minified. Records are kept in blocks that are
+// zstd-compressed once full, and the oldest blocks are dropped past the
+// memory budget, which covers the index too. Every record is indexed by
+// source (the bracketed tag, or the stream name), label, run id and session
+// id, so a query for one run reads only that run's records; names no longer
+// carried by any stored record are forgotten. Not thread-safe.
+class BackendLog {
+ public:
+  enum Stream : uint8_t { kStdout = 0, kStderr = 1 };
+
+  struct Filter {
+    std::string source;
+    std::string label;
+    std::string run;
+    std::string session;
+  };
+
+  struct Record {
+    uint64_t sequence = 0;
+    int64_t time_us = 0;
+    Stream stream = kStdout;
+    bool json = false;  // |text| is a minified SDK payload.
+    std::string source;
+    std::string label;
+    std::string run;
+    std::string session;
+    std::string text;
+  };
+
+  struct Stats {
+    uint64_t records = 0;
+    uint64_t dropped = 0;
+    uint64_t raw_bytes = 0;     // Stored text before compression.
+    uint64_t stored_bytes = 0;  // Blocks, open block and index.
+  };
+
+  explicit BackendLog(size_t max_stored_bytes);
+
+  // Frames |size| bytes of output. Records completed by the chunk are stored;
+  // an SDK record whose terminating blank line has not arrived stays open.
+  void Append(Stream stream, const char* data, size_t size, int64_t now_us);
+
+  // Stores whatever is still open (for example when the backend exits).
+  void Flush(int64_t now_us);
+
+  // Up to |limit| records matching every non-empty field of |filter|, with
+  // sequence below |before| (0 for the newest), oldest first.
+  std::vector<Record> Query(const Filter& filter, uint64_t before,
+                            size_t limit);
+
+  // Session of each run seen, and the run's record count.
+  struct RunSummary {
+    std::string run;
+    std::string session;
+    uint64_t records = 0;
+    int64_t first_us = 0;
+    int64_t last_us = 0;
+  };
+  std::vector<RunSummary> Runs();
+
+  void Clear();
+  Stats GetStats() const;
+
+ private:
+  enum Field { kSource = 0, kLabel, kRun, kSession, kFieldCount };
+
+  struct Entry {
+    int64_t time_us = 0;
+    uint32_t fields[kFieldCount] = {};  // Interned; 0 is "none".
+    uint32_t block = 0;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+    Stream stream = kStdout;
+    bool json = false;
+  };
+
+  struct Block {
+    std::string text;  // Raw while open, compressed once sealed.
+    size_t raw_size = 0;
+    bool sealed = false;
+  };
+
+  // A record being framed on one stream.
+  struct Pending {
+    bool open = false;
+    bool sdk = false;
+    int64_t time_us = 0;
+    std::string source;
+    std::string label;
+    std::string run;
+    std::string session;
+    std::string text;
+  };
+
+  struct StreamState {
+    std::string partial_line;
+    Pending pending;
+  };
+
+  void AppendLine(Stream stream, const char* line, size_t size,
+                  int64_t now_us);
+  void Commit(Stream stream, Pending* pending);
+  void Store(Stream stream, const Pending& pending, const std::string& text,
+             bool json, const std::string& session);
+  void SealOpenBlock();
+  void EvictOldest();
+  void ForgetUnusedNames(const std::vector<uint32_t>& candidates);
+  uint32_t Intern(const std::string& value);
+  uint32_t Find(const std::string& value) const;
+  const std::string& Name(uint32_t id) const { return names_[id]; }
+  const std::string* BlockText(uint32_t block, std::string* scratch,
+                               uint32_t* cached_block);
+
+  const size_t max_stored_bytes_;
+  StreamState streams_[2];
+
+  std::deque<Entry> entries_;  // Sequence first_sequence_ + i.
+  uint64_t first_sequence_ = 1;
+  std::deque<Block> blocks_;  // Block id first_block_ + i.
+  uint32_t first_block_ = 0;
+  size_t stored_bytes_ = 0;
+  uint64_t raw_bytes_ = 0;
+  uint64_t dropped_ = 0;
+
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, uint32_t> name_ids_;
+  std::vector<uint32_t> free_name_ids_;  // Forgotten names, for reuse.
+  // Interned value to the sequences that carry it, per field. Sequences of
+  // dropped records are trimmed lazily.
+  std::unordered_map<uint32_t, std::vector<uint64_t>> postings_[kFieldCount];
+  std::unordered_map<uint32_t, uint32_t> run_sessions_;
+};
+
+// Registers the "com.codeagenthub/backend_log" method channel.
+void RegisterBackendLogChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_BACKEND_LOG_H_
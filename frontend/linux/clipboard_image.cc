@@ -0,0 +1,376 @@
+#include "clipboard_image.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
+
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/clipboard_image";
+
+struct Attachment {
+  std::string path;
+  std::string media_type;
+};
+
+// Attachments created in this run. Files left by instances that are no longer
+// running are removed when the channel is registered.
+std::mutex g_attachments_mutex;
+std::unordered_map<std::string, Attachment> g_attachments;
+std::atomic<uint64_t> g_next_attachment{1};
+
+std::string AttachmentDir() {
+  g_autofree gchar* dir = g_build_filename(
+      g_get_user_cache_dir(), "codeagenthub", "clipboard", nullptr);
+  return dir;
+}
+
+// Files older than this are removed even if their pid is alive again, which
+// can only be a recycled pid after this long.
+const time_t kStaleAttachmentSeconds = 7 * 24 * 60 * 60;
+
+// Whether a file named "clip-<pid>-<n>.<ext>" may still be referenced: its
+// creator is another instance that is still running.
+bool OwnerIsRunning(const char* name) {
+  if (strncmp(name, "clip-", 5) != 0) {
+    return false;
+  }
+  char* end = nullptr;
+  const long pid = strtol(name + 5, &end, 10);
+  if (end == name + 5 || *end != '-' || pid <= 0 || pid == getpid()) {
+    return false;
+  }
+  return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+void RemoveStaleAttachments(const std::string& dir) {
+  DIR* handle = opendir(dir.c_str());
+  if (handle == nullptr) {
+    return;
+  }
+  const time_t now = time(nullptr);
+  while (dirent* entry = readdir(handle)) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    const std::string path = dir + "/" + entry->d_name;
+    struct stat st;
+    if (OwnerIsRunning(entry->d_name) && stat(path.c_str(), &st) == 0 &&
+        now - st.st_mtime < kStaleAttachmentSeconds) {
+      continue;
+    }
+    unlink(path.c_str());
+  }
+  closedir(handle);
+}
+
+bool WriteAttachmentFile(const std::string& path, const gchar* data,
+                         gsize size, std::string* error) {
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                      0600);
+  if (fd < 0) {
+    *error = "Cannot create " + path + ": " + strerror(errno);
+    return false;
+  }
+  gsize written = 0;
+  while (written < size) {
+    const ssize_t n = write(fd, data + written, size - written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      *error = "Cannot write " + path + ": " + strerror(errno);
+      close(fd);
+      unlink(path.c_str());
+      return false;
+    }
+    written += static_cast<gsize>(n);
+  }
+  close(fd);
+  return true;
+}
+
+// Encodes |pixbuf| with gdk-pixbuf's saver for |type|. |buffer| receives a
+// g_malloc'd block.
+bool SavePixbuf(GdkPixbuf* pixbuf, const char* type, int jpeg_quality,
+                gchar** buffer, gsize* size, std::string* error) {
+  g_autoptr(GError) gerror = nullptr;
+  gboolean ok;
+  if (strcmp(type, "jpeg") == 0) {
+    const std::string quality = std::to_string(jpeg_quality);
+    ok = gdk_pixbuf_save_to_buffer(pixbuf, buffer, size, type, &gerror,
+                                   "quality", quality.c_str(), nullptr);
+  } else {
+    // Screenshots are mostly flat colour; a low compression level is several
+    // times faster and only marginally larger.
+    ok = gdk_pixbuf_save_to_buffer(pixbuf, buffer, size, type, &gerror,
+                                   "compression", "3", nullptr);
+  }
+  if (!ok) {
+    *error = std::string("Cannot encode ") + type + ": " +
+             (gerror != nullptr ? gerror->message : "unknown error");
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool EncodeClipboardImage(GdkPixbuf* pixbuf,
+                          const ClipboardImageOptions& options,
+                          ClipboardImage* image, std::string* error) {
+  image->source_width = gdk_pixbuf_get_width(pixbuf);
+  image->source_height = gdk_pixbuf_get_height(pixbuf);
+  if (image->source_width <= 0 || image->source_height <= 0) {
+    *error = "Clipboard image is empty";
+    return false;
+  }
+
+  const int longest = std::max(image->source_width, image->source_height);
+  GdkPixbuf* scaled = pixbuf;
+  if (options.max_dimension > 0 && longest > options.max_dimension) {
+    const double ratio = static_cast<double>(options.max_dimension) / longest;
+    image->width = std::max(
+        1, static_cast<int>(std::lround(image->source_width * ratio)));
+    image->height = std::max(
+        1, static_cast<int>(std::lround(image->source_height * ratio)));
+    scaled = gdk_pixbuf_scale_simple(pixbuf, image->width, image->height,
+                                     GDK_INTERP_BILINEAR);
+    if (scaled == nullptr) {
+      *error = "Cannot scale clipboard image";
+      return false;
+    }
+  } else {
+    image->width = image->source_width;
+    image->height = image->source_height;
+  }
+
+  gchar* buffer = nullptr;
+  gsize size = 0;
+  const char* extension = "png";
+  image->media_type = "image/png";
+  bool ok = SavePixbuf(scaled, "png", options.jpeg_quality, &buffer, &size,
+                       error);
+  // Photos and gradients compress poorly as PNG; if the image has no alpha
+  // to preserve, keep whichever encoding is smaller.
+  if (ok && size > options.png_budget && !gdk_pixbuf_get_has_alpha(scaled)) {
+    gchar* jpeg = nullptr;
+    gsize jpeg_size = 0;
+    std::string jpeg_error;
+    if (SavePixbuf(scaled, "jpeg", options.jpeg_quality, &jpeg, &jpeg_size,
+                   &jpeg_error) &&
+        jpeg_size < size) {
+      g_free(buffer);
+      buffer = jpeg;
+      size = jpeg_size;
+      extension = "jpg";
+      image->media_type = "image/jpeg";
+    } else {
+      g_free(jpeg);
+    }
+  }
+  if (scaled != pixbuf) {
+    g_object_unref(scaled);
+  }
+  if (!ok) {
+    return false;
+  }
+
+  const std::string dir = AttachmentDir();
+  if (g_mkdir_with_parents(dir.c_str(), 0700) != 0) {
+    g_free(buffer);
+    *error = "Cannot create " + dir;
+    return false;
+  }
+  image->handle = "clip-" + std::to_string(getpid()) + "-" +
+                  std::to_string(g_next_attachment++);
+  image->path = dir + "/" + image->handle + "." + extension;
+  image->byte_length = size;
+  ok = WriteAttachmentFile(image->path, buffer, size, error);
+  g_free(buffer);
+  if (!ok) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(g_attachments_mutex);
+  g_attachments[image->handle] = Attachment{image->path, image->media_type};
+  return true;
+}
+
+bool LoadClipboardImageBase64(const std::string& handle, std::string* base64,
+                              std::string* error) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(g_attachments_mutex);
+    auto it = g_attachments.find(handle);
+    if (it == g_attachments.end()) {
+      *error = "Unknown attachment " + handle;
+      return false;
+    }
+    path = it->second.path;
+  }
+
+  gchar* contents = nullptr;
+  gsize size = 0;
+  g_autoptr(GError) gerror = nullptr;
+  if (!g_file_get_contents(path.c_str(), &contents, &size, &gerror)) {
+    *error = "Cannot read " + path + ": " +
+             (gerror != nullptr ? gerror->message : "unknown error");
+    return false;
+  }
+  g_autofree gchar* encoded =
+      g_base64_encode(reinterpret_cast<const guchar*>(contents), size);
+  g_free(contents);
+  base64->assign(encoded);
+  return true;
+}
+
+void ReleaseClipboardImage(const std::string& handle) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(g_attachments_mutex);
+    auto it = g_attachments.find(handle);
+    if (it == g_attachments.end()) {
+      return;
+    }
+    path = it->second.path;
+    g_attachments.erase(it);
+  }
+  unlink(path.c_str());
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_clipboard_image_channel = nullptr;
+
+struct ReadRequest {
+  FlMethodCall* method_call;
+  ClipboardImageOptions options;
+};
+
+FlValue* ImageToValue(const ClipboardImage& image) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "handle",
+                           fl_value_new_string(image.handle.c_str()));
+  fl_value_set_string_take(value, "path",
+                           fl_value_new_string(image.path.c_str()));
+  fl_value_set_string_take(value, "mediaType",
+                           fl_value_new_string(image.media_type.c_str()));
+  fl_value_set_string_take(value, "width", fl_value_new_int(image.width));
+  fl_value_set_string_take(value, "height", fl_value_new_int(image.height));
+  fl_value_set_string_take(value, "sourceWidth",
+                           fl_value_new_int(image.source_width));
+  fl_value_set_string_take(value, "sourceHeight",
+                           fl_value_new_int(image.source_height));
+  fl_value_set_string_take(value, "byteLength",
+                           fl_value_new_int(image.byte_length));
+  return value;
+}
+
+// Runs on the main thread once GTK has converted the clipboard contents. The
+// conversion itself is the only work done here; scaling and encoding happen
+// on the pool.
+void OnClipboardImage(GtkClipboard* clipboard, GdkPixbuf* pixbuf,
+                      gpointer user_data) {
+  auto* request = static_cast<ReadRequest*>(user_data);
+  if (pixbuf == nullptr) {
+    RespondSuccess(request->method_call, fl_value_new_null());
+    g_object_unref(request->method_call);
+    delete request;
+    return;
+  }
+
+  // GTK drops its reference when this callback returns.
+  g_object_ref(pixbuf);
+  TaskPool::Get().Post([request, pixbuf]() {
+    auto image = std::make_shared<ClipboardImage>();
+    auto error = std::make_shared<std::string>();
+    const bool ok =
+        EncodeClipboardImage(pixbuf, request->options, image.get(),
+                             error.get());
+    g_object_unref(pixbuf);
+    RunOnMainThread([request, image, error, ok]() {
+      if (ok) {
+        RespondSuccess(request->method_call, ImageToValue(*image));
+      } else {
+        RespondError(request->method_call, "CLIPBOARD_IMAGE_ERROR", *error);
+      }
+      g_object_unref(request->method_call);
+      delete request;
+    });
+  });
+}
+
+void HandleClipboardImageCall(FlMethodChannel* channel,
+                              FlMethodCall* method_call, gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method == "readImage") {
+    auto* request = new ReadRequest{method_call, ClipboardImageOptions()};
+    request->options.max_dimension = static_cast<int>(LookupIntArg(
+        args, "maxDimension", request->options.max_dimension));
+    request->options.jpeg_quality = static_cast<int>(std::clamp<int64_t>(
+        LookupIntArg(args, "jpegQuality", request->options.jpeg_quality), 1,
+        100));
+    g_object_ref(method_call);
+    gtk_clipboard_request_image(gtk_clipboard_get(GDK_SELECTION_CLIPBOARD),
+                                OnClipboardImage, request);
+  } else if (method == "loadBase64") {
+    const std::string handle = LookupStringArg(args, "handle");
+    if (handle.empty()) {
+      RespondError(method_call, "INVALID_ARGUMENTS", "handle is required");
+      return;
+    }
+    g_object_ref(method_call);
+    TaskPool::Get().Post([method_call, handle]() {
+      auto base64 = std::make_shared<std::string>();
+      auto error = std::make_shared<std::string>();
+      const bool ok = LoadClipboardImageBase64(handle, base64.get(),
+                                               error.get());
+      RunOnMainThread([method_call, base64, error, ok]() {
+        if (ok) {
+          RespondSuccess(method_call, fl_value_new_string_sized(
+                                          base64->data(), base64->size()));
+        } else {
+          RespondError(method_call, "CLIPBOARD_IMAGE_ERROR", *error);
+        }
+        g_object_unref(method_call);
+      });
+    });
+  } else if (method == "release") {
+    ReleaseClipboardImage(LookupStringArg(args, "handle"));
+    RespondSuccess(method_call, nullptr);
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+}  // namespace
+
+void RegisterClipboardImageChannel(FlBinaryMessenger* messenger) {
+  RemoveStaleAttachments(AttachmentDir());
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_clipboard_image_channel = fl_method_channel_new(
+      messenger, kChannelName, FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_clipboard_image_channel, HandleClipboardImageCall, nullptr, nullptr);
+}
@@ -0,0 +1,52 @@
+#ifndef RUNNER_CLIPBOARD_IMAGE_H_
+#define RUNNER_CLIPBOARD_IMAGE_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+#include <cstdint>
+#include <string>
+
+struct ClipboardImageOptions {
+  // Longest edge after downscaling; larger images are scaled down to it.
+  int max_dimension = 1568;
+  int jpeg_quality = 85;
+  // Opaque images whose PNG encoding exceeds this are also tried as JPEG and
+  // the smaller encoding is kept.
+  size_t png_budget = 512 * 1024;
+};
+
+// A downscaled, re-encoded clipboard image. The encoded bytes live in a
+// private temp file so Dart only ever holds the handle and the file path
+// (for the preview thumbnail), never the decoded bitmap.
+struct ClipboardImage {
+  std::string handle;
+  std::string path;
+  std::string media_type;
+  int width = 0;
+  int height = 0;
+  int source_width = 0;
+  int source_height = 0;
+  uint64_t byte_length = 0;
+};
+
+// Scales |pixbuf| to fit |options.max_dimension| and encodes it into a new
+// attachment file. Safe to call from a worker thread; |pixbuf| must not be
+// shared with the main thread while this runs.
+bool EncodeClipboardImage(GdkPixbuf* pixbuf,
+                          const ClipboardImageOptions& options,
+                          ClipboardImage* image, std::string* error);
+
+// Returns the base64 encoding of the attachment |handle|, read back from its
+// file. Used at send time so the request body is built without a second copy
+// living in Dart for the lifetime of the draft.
+bool LoadClipboardImageBase64(const std::string& handle, std::string* base64,
+                              std::string* error);
+
+// Drops the attachment and deletes its file. Unknown handles are ignored.
+void ReleaseClipboardImage(const std::string& handle);
+
+// Registers the "com.codeagenthub/clipboard_image" method channel.
+void RegisterClipboardImageChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_CLIPBOARD_IMAGE_H_
@@ -0,0 +1,357 @@
+#include "frame_pacing.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "method_call_utils.h"
+#include "stream_quality.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/frame_pacing";
+
+// A longer pause between frames means the clock went idle (nothing asked for
+// a frame), not that a frame was late.
+const int64_t kIdleGapUs = 500 * 1000;
+
+GdkFrameClock* g_frame_clock = nullptr;
+gint64 g_last_timed_frame = -1;
+
+void AddCount(std::atomic<uint32_t>* counter, uint32_t amount) {
+  counter->fetch_add(amount, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+size_t FrameHistogram::BucketFor(uint64_t value) {
+  if (value < 8) {
+    return static_cast<size_t>(value);
+  }
+  const int msb = 63 - __builtin_clzll(value);
+  const size_t bucket =
+      static_cast<size_t>(msb - 2) * 8 + ((value >> (msb - 3)) & 7);
+  return std::min(bucket, kBuckets - 1);
+}
+
+uint64_t FrameHistogram::BucketUpperBound(size_t bucket) {
+  if (bucket < 8) {
+    return bucket;
+  }
+  const int shift = static_cast<int>(bucket / 8) - 1;
+  const uint64_t lower = (8 + bucket % 8) << shift;
+  return lower + (uint64_t{1} << shift) - 1;
+}
+
+void FrameHistogram::Add(uint64_t value) {
+  counts_[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameHistogram::AddTo(uint64_t* counts) const {
+  for (size_t i = 0; i < kBuckets; ++i) {
+    counts[i] += counts_[i].load(std::memory_order_relaxed);
+  }
+}
+
+void FrameHistogram::Clear() {
+  for (auto& count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+}
+
+FramePercentiles ComputePercentiles(const uint64_t* counts) {
+  FramePercentiles result;
+  uint64_t total = 0;
+  for (size_t i = 0; i < FrameHistogram::kBuckets; ++i) {
+    total += counts[i];
+  }
+  if (total == 0) {
+    return result;
+  }
+  const uint64_t p50_rank = static_cast<uint64_t>(std::ceil(total * 0.50));
+  const uint64_t p90_rank = static_cast<uint64_t>(std::ceil(total * 0.90));
+  const uint64_t p99_rank = static_cast<uint64_t>(std::ceil(total * 0.99));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < FrameHistogram::kBuckets; ++i) {
+    if (counts[i] == 0) {
+      continue;
+    }
+    const uint64_t before = seen;
+    seen += counts[i];
+    const uint64_t value = FrameHistogram::BucketUpperBound(i);
+    if (before < p50_rank && seen >= p50_rank) {
+      result.p50 = value;
+    }
+    if (before < p90_rank && seen >= p90_rank) {
+      result.p90 = value;
+    }
+    if (before < p99_rank && seen >= p99_rank) {
+      result.p99 = value;
+    }
+    result.max = value;
+  }
+  return result;
+}
+
+FramePacingRecorder& FramePacingRecorder::Get() {
+  static FramePacingRecorder* recorder = new FramePacingRecorder();
+  return *recorder;
+}
+
+FramePacingRecorder::Slice& FramePacingRecorder::SliceAt(int64_t now_us) {
+  const int64_t second = now_us / G_USEC_PER_SEC;
+  Slice& slice = slices_[second % kSlices];
+  int64_t seen = slice.second.load(std::memory_order_acquire);
+  if (seen != second &&
+      slice.second.compare_exchange_strong(seen, second,
+                                           std::memory_order_acq_rel)) {
+    // This slice last held a second kSlices or more ago.
+    for (Group& group : slice.groups) {
+      group.interval.Clear();
+      group.paint.Clear();
+      group.lateness.Clear();
+      group.frames.store(0, std::memory_order_relaxed);
+      group.missed_vblanks.store(0, std::memory_order_relaxed);
+    }
+    slice.events.store(0, std::memory_order_relaxed);
+  }
+  return slice;
+}
+
+void FramePacingRecorder::RecordFrame(int64_t frame_time_us,
+                                      int64_t painted_at_us,
+                                      int64_t refresh_interval_us) {
+  if (refresh_interval_us > 0) {
+    refresh_interval_us_.store(refresh_interval_us, std::memory_order_relaxed);
+  }
+  const bool streaming = active_streams_.load(std::memory_order_relaxed) > 0;
+  Group& group = SliceAt(frame_time_us).groups[streaming ? 1 : 0];
+  AddCount(&group.frames, 1);
+
+  const int64_t paint_us = std::max<int64_t>(painted_at_us - frame_time_us, 0);
+  group.paint.Add(paint_us);
+  if (refresh_interval_us > 0 && paint_us > refresh_interval_us) {
+    AddCount(&group.missed_vblanks,
+            static_cast<uint32_t>(paint_us / refresh_interval_us));
+  }
+
+  if (last_frame_time_us_ != 0) {
+    const int64_t interval_us = frame_time_us - last_frame_time_us_;
+    if (interval_us > 0 && interval_us < kIdleGapUs) {
+      group.interval.Add(interval_us);
+    }
+  }
+  last_frame_time_us_ = frame_time_us;
+}
+
+void FramePacingRecorder::RecordLateness(int64_t frame_time_us,
+                                         int64_t lateness_us) {
+  const bool streaming = active_streams_.load(std::memory_order_relaxed) > 0;
+  SliceAt(frame_time_us)
+      .groups[streaming ? 1 : 0]
+      .lateness.Add(std::max<int64_t>(lateness_us, 0));
+}
+
+void FramePacingRecorder::StreamOpened() {
+  active_streams_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FramePacingRecorder::StreamClosed() {
+  active_streams_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void FramePacingRecorder::StreamEvents(int64_t now_us, size_t count) {
+  AddCount(&SliceAt(now_us).events, static_cast<uint32_t>(count));
+}
+
+FramePacingStats FramePacingRecorder::Snapshot(int64_t now_us,
+                                               int window_seconds) const {
+  FramePacingStats stats;
+  stats.window_seconds = std::clamp(window_seconds, 1, kSlices);
+  stats.refresh_interval_us =
+      refresh_interval_us_.load(std::memory_order_relaxed);
+  stats.active_streams =
+      std::max(active_streams_.load(std::memory_order_relaxed), 0);
+
+  const int64_t newest = now_us / G_USEC_PER_SEC;
+  const int64_t oldest = newest - stats.window_seconds + 1;
+  uint64_t interval[2][FrameHistogram::kBuckets] = {};
+  uint64_t paint[2][FrameHistogram::kBuckets] = {};
+  uint64_t lateness[2][FrameHistogram::kBuckets] = {};
+  FrameGroupStats* groups[2] = {&stats.all, &stats.streaming};
+  uint64_t events = 0;
+  for (const Slice& slice : slices_) {
+    const int64_t second = slice.second.load(std::memory_order_acquire);
+    if (second < oldest || second > newest) {
+      continue;
+    }
+    events += slice.events.load(std::memory_order_relaxed);
+    for (int streaming = 0; streaming < 2; ++streaming) {
+      const Group& group = slice.groups[streaming];
+      const uint64_t frames = group.frames.load(std::memory_order_relaxed);
+      const uint64_t missed =
+          group.missed_vblanks.load(std::memory_order_relaxed);
+      // "all" covers both groups; "streaming" only the second.
+      for (int target = 0; target <= streaming; ++target) {
+        groups[target]->frames += frames;
+        groups[target]->missed_vblanks += missed;
+        group.interval.AddTo(interval[target]);
+        group.paint.AddTo(paint[target]);
+        group.lateness.AddTo(lateness[target]);
+      }
+    }
+  }
+  for (int target = 0; target < 2; ++target) {
+    groups[target]->interval = ComputePercentiles(interval[target]);
+    groups[target]->paint = ComputePercentiles(paint[target]);
+    groups[target]->lateness = ComputePercentiles(lateness[target]);
+  }
+  stats.events_per_second =
+      static_cast<double>(events) / stats.window_seconds;
+  return stats;
+}
+
+void FramePacingStreamOpened() {
+  FramePacingRecorder::Get().StreamOpened();
+}
+
+void FramePacingStreamClosed() {
+  FramePacingRecorder::Get().StreamClosed();
+}
+
+void FramePacingStreamEvents(size_t count) {
+  if (count > 0) {
+    FramePacingRecorder::Get().StreamEvents(g_get_monotonic_time(), count);
+  }
+}
+
+namespace {
+
+// Runs on the main thread after every painted frame.
+void OnAfterPaint(GdkFrameClock* clock, gpointer user_data) {
+  FramePacingRecorder& recorder = FramePacingRecorder::Get();
+  const gint64 frame_time = gdk_frame_clock_get_frame_time(clock);
+  gint64 refresh_interval = 0;
+  gint64 presentation_time = 0;
+  gdk_frame_clock_get_refresh_info(clock, frame_time, &refresh_interval,
+                                   &presentation_time);
+  recorder.RecordFrame(frame_time, g_get_monotonic_time(), refresh_interval);
+  StreamQualityFramePresented();
+
+  // Presentation times arrive a few frames later; walk the frames that
+  // completed since the last call.
+  const gint64 current = gdk_frame_clock_get_frame_counter(clock);
+  gint64 counter = std::max(gdk_frame_clock_get_history_start(clock),
+                            g_last_timed_frame + 1);
+  for (; counter < current; ++counter) {
+    GdkFrameTimings* timings = gdk_frame_clock_get_timings(clock, counter);
+    if (timings == nullptr || !gdk_frame_timings_get_complete(timings)) {
+      break;
+    }
+    const gint64 presented = gdk_frame_timings_get_presentation_time(timings);
+    const gint64 predicted =
+        gdk_frame_timings_get_predicted_presentation_time(timings);
+    if (presented != 0 && predicted != 0) {
+      recorder.RecordLateness(gdk_frame_timings_get_frame_time(timings),
+                              presented - predicted);
+    }
+    g_last_timed_frame = counter;
+  }
+}
+
+void ConnectFrameClock(GtkWidget* widget) {
+  GdkFrameClock* clock = gtk_widget_get_frame_clock(widget);
+  if (clock == nullptr || clock == g_frame_clock) {
+    return;
+  }
+  if (g_frame_clock != nullptr) {
+    g_signal_handlers_disconnect_by_func(
+        g_frame_clock, reinterpret_cast<gpointer>(OnAfterPaint), nullptr);
+  }
+  g_frame_clock = clock;
+  g_last_timed_frame = -1;
+  g_signal_connect(clock, "after-paint", G_CALLBACK(OnAfterPaint), nullptr);
+}
+
+void OnWidgetRealize(GtkWidget* widget, gpointer user_data) {
+  ConnectFrameClock(widget);
+}
+
+}  // namespace
+
+void AttachFramePacing(GtkWidget* widget) {
+  g_signal_connect(widget, "realize", G_CALLBACK(OnWidgetRealize), nullptr);
+  if (gtk_widget_get_realized(widget)) {
+    ConnectFrameClock(widget);
+  }
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_frame_pacing_channel = nullptr;
+
+FlValue* PercentilesToFlValue(const FramePercentiles& percentiles) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "p50", fl_value_new_int(percentiles.p50));
+  fl_value_set_string_take(value, "p90", fl_value_new_int(percentiles.p90));
+  fl_value_set_string_take(value, "p99", fl_value_new_int(percentiles.p99));
+  fl_value_set_string_take(value, "max", fl_value_new_int(percentiles.max));
+  return value;
+}
+
+FlValue* GroupToFlValue(const FrameGroupStats& group) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "frames", fl_value_new_int(group.frames));
+  fl_value_set_string_take(value, "missedVblanks",
+                           fl_value_new_int(group.missed_vblanks));
+  fl_value_set_string_take(value, "intervalUs",
+                           PercentilesToFlValue(group.interval));
+  fl_value_set_string_take(value, "paintUs",
+                           PercentilesToFlValue(group.paint));
+  fl_value_set_string_take(value, "latenessUs",
+                           PercentilesToFlValue(group.lateness));
+  return value;
+}
+
+FlValue* StatsToFlValue(const FramePacingStats& stats) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "windowSeconds",
+                           fl_value_new_int(stats.window_seconds));
+  fl_value_set_string_take(value, "refreshIntervalUs",
+                           fl_value_new_int(stats.refresh_interval_us));
+  fl_value_set_string_take(value, "activeStreams",
+                           fl_value_new_int(stats.active_streams));
+  fl_value_set_string_take(value, "eventsPerSecond",
+                           fl_value_new_float(stats.events_per_second));
+  fl_value_set_string_take(value, "all", GroupToFlValue(stats.all));
+  fl_value_set_string_take(value, "streaming",
+                           GroupToFlValue(stats.streaming));
+  return value;
+}
+
+void HandleFramePacingCall(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method == "getStats") {
+    const int window_seconds = static_cast<int>(LookupIntArg(
+        args, "windowSeconds", FramePacingRecorder::kSlices));
+    RespondSuccess(method_call,
+                   StatsToFlValue(FramePacingRecorder::Get().Snapshot(
+                       g_get_monotonic_time(), window_seconds)));
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+}  // namespace
+
+void RegisterFramePacingChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_frame_pacing_channel = fl_method_channel_new(messenger, kChannelName,
+                                                 FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_frame_pacing_channel, HandleFramePacingCall, nullptr, nullptr);
+}
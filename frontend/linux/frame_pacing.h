@@ -0,0 +1,117 @@
+#ifndef RUNNER_FRAME_PACING_H_
+#define RUNNER_FRAME_PACING_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Log-linear histogram of microsecond durations: exact below 8us, then eight
+// buckets per power of two (at most 12.5% relative error) up to about 16s.
+// Adding is lock-free and wait-free; readers sum a racy but consistent-enough
+// copy.
+class FrameHistogram {
+ public:
+  static constexpr size_t kBuckets = 8 * 22;
+
+  static size_t BucketFor(uint64_t value);
+  // The largest value that falls into |bucket|.
+  static uint64_t BucketUpperBound(size_t bucket);
+
+  void Add(uint64_t value);
+  void AddTo(uint64_t* counts) const;
+  void Clear();
+
+ private:
+  std::atomic<uint32_t> counts_[kBuckets] = {};
+};
+
+struct FramePercentiles {
+  uint64_t p50 = 0;
+  uint64_t p90 = 0;
+  uint64_t p99 = 0;
+  uint64_t max = 0;
+};
+
+// Percentiles of a summed histogram; zero when it is empty.
+FramePercentiles ComputePercentiles(const uint64_t* counts);
+
+struct FrameGroupStats {
+  uint64_t frames = 0;
+  uint64_t missed_vblanks = 0;
+  FramePercentiles interval;  // Between consecutive frames of a busy run.
+  FramePercentiles paint;     // From frame start to the end of painting.
+  FramePercentiles lateness;  // Presentation behind the predicted time.
+};
+
+struct FramePacingStats {
+  int window_seconds = 0;
+  int64_t refresh_interval_us = 0;
+  int active_streams = 0;
+  double events_per_second = 0;
+  FrameGroupStats all;
+  // Frames painted while at least one reply was streaming.
+  FrameGroupStats streaming;
+};
+
+// Rolling frame statistics over the last kSlices seconds, kept in one-second
+// slices that are recycled in place. Frames are recorded on the main thread;
+// stream activity arrives from the task pool. Nothing takes a lock: a writer
+// that races another one rotating a slice may lose its sample.
+class FramePacingRecorder {
+ public:
+  static constexpr int kSlices = 10;
+
+  // Called at the end of each painted frame. |frame_time_us| is the frame
+  // clock's frame time, |painted_at_us| the monotonic time painting ended.
+  void RecordFrame(int64_t frame_time_us, int64_t painted_at_us,
+                   int64_t refresh_interval_us);
+  // Called once a frame's presentation time is known.
+  void RecordLateness(int64_t frame_time_us, int64_t lateness_us);
+
+  void StreamOpened();
+  void StreamClosed();
+  void StreamEvents(int64_t now_us, size_t count);
+
+  FramePacingStats Snapshot(int64_t now_us, int window_seconds) const;
+
+  static FramePacingRecorder& Get();
+
+ private:
+  struct Group {
+    FrameHistogram interval;
+    FrameHistogram paint;
+    FrameHistogram lateness;
+    std::atomic<uint32_t> frames{0};
+    std::atomic<uint32_t> missed_vblanks{0};
+  };
+  struct Slice {
+    std::atomic<int64_t> second{-1};
+    Group groups[2];  // Quiet, streaming.
+    std::atomic<uint32_t> events{0};
+  };
+
+  Slice& SliceAt(int64_t now_us);
+
+  Slice slices_[kSlices];
+  std::atomic<int> active_streams_{0};
+  std::atomic<int64_t> refresh_interval_us_{0};
+  // Main thread only.
+  int64_t last_frame_time_us_ = 0;
+};
+
+// Stream activity the frame statistics are correlated with. Thread-safe.
+void FramePacingStreamOpened();
+void FramePacingStreamClosed();
+void FramePacingStreamEvents(size_t count);
+
+// Starts recording the frames of |widget|'s toplevel, now or once it is
+// realized.
+void AttachFramePacing(GtkWidget* widget);
+
+// Registers the "com.codeagenthub/frame_pacing" method channel.
+void RegisterFramePacingChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_FRAME_PACING_H_
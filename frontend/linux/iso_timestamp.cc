@@ -0,0 +1,262 @@
+#include "iso_timestamp.h"
+
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+struct Fields {
+  int64_t year = 0;
+  int64_t month = 0;
+  int64_t day = 0;
+  int64_t hour = 0;
+  int64_t minute = 0;
+  int64_t second = 0;
+  int64_t fraction = 0;  // Microseconds.
+};
+
+// Days from 1970-01-01 to the given civil date (proleptic Gregorian).
+int64_t DaysFromCivil(int64_t year, int64_t month, int64_t day) {
+  year -= month <= 2 ? 1 : 0;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const int64_t year_of_era = year - era * 400;
+  const int64_t day_of_year =
+      (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 -
+                             year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
+
+// Reads exactly |digits| decimal digits at |*pos|.
+bool ReadDigits(const char* text, size_t size, size_t* pos, int digits,
+                int64_t* value) {
+  if (*pos + digits > size) {
+    return false;
+  }
+  int64_t result = 0;
+  for (int i = 0; i < digits; ++i) {
+    const char c = text[*pos + i];
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    result = result * 10 + (c - '0');
+  }
+  *pos += digits;
+  *value = result;
+  return true;
+}
+
+int64_t Digits2(const char* p) { return (p[0] - '0') * 10 + (p[1] - '0'); }
+
+uint64_t Load8(const char* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// Whether the eight bytes at |p| follow |layout|, where '0' stands for any
+// digit: all eight are checked at once in a 64-bit word.
+bool MatchesLayout(const char* p, const char* layout) {
+  uint64_t digit_mask = 0;
+  for (int i = 0; i < 8; ++i) {
+    const uint64_t byte = layout[i] == '0' ? 0xff : 0;
+    memcpy(reinterpret_cast<char*>(&digit_mask) + i, &byte, 1);
+  }
+  const uint64_t value = Load8(p);
+  const uint64_t expected = Load8(layout);
+  const uint64_t high_nibbles = 0xf0f0f0f0f0f0f0f0ull & digit_mask;
+  const uint64_t sixes = 0x0606060606060606ull & digit_mask;
+  // Separators match exactly; digits are 0x30-0x39, so their high nibble is
+  // 3 both before and after adding 6.
+  return ((value ^ expected) & ~digit_mask) == 0 &&
+         (value & high_nibbles) == (expected & high_nibbles) &&
+         ((value + sixes) & high_nibbles) == (expected & high_nibbles);
+}
+
+// "YYYY-MM-DDTHH:MM:SS", the layout nearly every timestamp has, checked as
+// three overlapping words before any digit is converted.
+bool ReadCanonicalDateTime(const char* p, Fields* fields) {
+  if (!MatchesLayout(p, "0000-00-") || !MatchesLayout(p + 8, "00T00:00") ||
+      !MatchesLayout(p + 11, "00:00:00")) {
+    return false;
+  }
+  fields->year = Digits2(p) * 100 + Digits2(p + 2);
+  fields->month = Digits2(p + 5);
+  fields->day = Digits2(p + 8);
+  fields->hour = Digits2(p + 11);
+  fields->minute = Digits2(p + 14);
+  fields->second = Digits2(p + 17);
+  return true;
+}
+
+// Any other layout: date only, or minutes without seconds.
+bool ReadDateTime(const char* text, size_t size, size_t* pos, Fields* fields,
+                  bool* has_seconds) {
+  *has_seconds = false;
+  if (!ReadDigits(text, size, pos, 4, &fields->year) || *pos >= size ||
+      text[(*pos)++] != '-' ||
+      !ReadDigits(text, size, pos, 2, &fields->month) || *pos >= size ||
+      text[(*pos)++] != '-' ||
+      !ReadDigits(text, size, pos, 2, &fields->day)) {
+    return false;
+  }
+  if (*pos < size &&
+      (text[*pos] == 'T' || text[*pos] == 't' || text[*pos] == ' ')) {
+    ++*pos;
+    if (!ReadDigits(text, size, pos, 2, &fields->hour) || *pos >= size ||
+        text[(*pos)++] != ':' ||
+        !ReadDigits(text, size, pos, 2, &fields->minute)) {
+      return false;
+    }
+    if (*pos < size && text[*pos] == ':') {
+      ++*pos;
+      if (!ReadDigits(text, size, pos, 2, &fields->second)) {
+        return false;
+      }
+      *has_seconds = true;
+    }
+  }
+  return true;
+}
+
+// UTC offset of local time, cached by local civil hour. mktime() takes the
+// timezone lock and walks the zone rules on every call, and timestamps
+// without a zone come from a handful of hours per transcript.
+bool LocalOffsetSeconds(const Fields& fields, int64_t* offset) {
+  struct Slot {
+    int64_t civil_hour = 0;
+    int64_t offset = 0;
+    bool valid = false;
+  };
+  thread_local Slot cache[8];
+
+  const int64_t civil_hour =
+      DaysFromCivil(fields.year, fields.month, fields.day) * 24 + fields.hour;
+  Slot& slot = cache[civil_hour & 7];
+  if (!slot.valid || slot.civil_hour != civil_hour) {
+    struct tm local = {};
+    local.tm_year = static_cast<int>(fields.year - 1900);
+    local.tm_mon = static_cast<int>(fields.month - 1);
+    local.tm_mday = static_cast<int>(fields.day);
+    local.tm_hour = static_cast<int>(fields.hour);
+    local.tm_isdst = -1;
+    const time_t seconds = mktime(&local);
+    if (seconds == static_cast<time_t>(-1)) {
+      return false;
+    }
+    slot.civil_hour = civil_hour;
+    slot.offset = civil_hour * 3600 - static_cast<int64_t>(seconds);
+    slot.valid = true;
+  }
+  *offset = slot.offset;
+  return true;
+}
+
+}  // namespace
+
+bool ParseIsoTimestamp(const char* text, size_t size, int64_t* micros,
+                       bool* has_zone) {
+  Fields fields;
+  size_t pos = 0;
+  bool has_seconds = true;
+  if (size >= 19 && ReadCanonicalDateTime(text, &fields)) {
+    pos = 19;
+  } else {
+    fields = Fields();
+    if (!ReadDateTime(text, size, &pos, &fields, &has_seconds)) {
+      return false;
+    }
+  }
+  if (fields.month < 1 || fields.month > 12 || fields.day < 1 ||
+      fields.day > 31 || fields.hour > 24 || fields.minute > 59 ||
+      fields.second > 59) {
+    return false;
+  }
+
+  if (has_seconds && pos < size && (text[pos] == '.' || text[pos] == ',')) {
+    ++pos;
+    // Microsecond precision, as in Dart; further digits are dropped.
+    int digits = 0;
+    while (pos < size && text[pos] >= '0' && text[pos] <= '9') {
+      if (digits < 6) {
+        fields.fraction = fields.fraction * 10 + (text[pos] - '0');
+        ++digits;
+      }
+      ++pos;
+    }
+    if (digits == 0) {
+      return false;
+    }
+    for (; digits < 6; ++digits) {
+      fields.fraction *= 10;
+    }
+  }
+
+  const int64_t civil_seconds =
+      DaysFromCivil(fields.year, fields.month, fields.day) * 86400 +
+      fields.hour * 3600 + fields.minute * 60 + fields.second;
+
+  if (pos == size) {
+    // No zone: local time.
+    int64_t offset = 0;
+    if (!LocalOffsetSeconds(fields, &offset)) {
+      return false;
+    }
+    *micros = (civil_seconds - offset) * 1000000 + fields.fraction;
+    if (has_zone != nullptr) {
+      *has_zone = false;
+    }
+    return true;
+  }
+
+  int64_t offset_minutes = 0;
+  const char zone = text[pos++];
+  if (zone == '+' || zone == '-') {
+    int64_t offset_hours = 0;
+    int64_t offset_rest = 0;
+    if (!ReadDigits(text, size, &pos, 2, &offset_hours)) {
+      return false;
+    }
+    if (pos < size && text[pos] == ':') {
+      ++pos;
+    }
+    if (pos < size && !ReadDigits(text, size, &pos, 2, &offset_rest)) {
+      return false;
+    }
+    offset_minutes = offset_hours * 60 + offset_rest;
+    if (zone == '-') {
+      offset_minutes = -offset_minutes;
+    }
+  } else if (zone != 'Z' && zone != 'z') {
+    return false;
+  }
+  if (pos != size) {
+    return false;
+  }
+  *micros = (civil_seconds - offset_minutes * 60) * 1000000 + fields.fraction;
+  if (has_zone != nullptr) {
+    *has_zone = true;
+  }
+  return true;
+}
+
+int64_t codeagenthub_parse_iso_timestamps(const char* text,
+                                          const int64_t* ends, int64_t count,
+                                          int64_t* micros, uint8_t* kinds) {
+  int64_t parsed = 0;
+  int64_t start = 0;
+  for (int64_t i = 0; i < count; ++i) {
+    const int64_t end = ends[i];
+    bool has_zone = false;
+    if (end >= start && ParseIsoTimestamp(text + start, end - start,
+                                          &micros[i], &has_zone)) {
+      kinds[i] = has_zone ? kIsoTimestampZoned : kIsoTimestampLocal;
+      ++parsed;
+    } else {
+      micros[i] = 0;
+      kinds[i] = kIsoTimestampInvalid;
+    }
+    start = end;
+  }
+  return parsed;
+}
@@ -0,0 +1,35 @@
+#ifndef RUNNER_ISO_TIMESTAMP_H_
+#define RUNNER_ISO_TIMESTAMP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Parses the ISO-8601 timestamps the backend and the CLI transcripts use
+// (date, optional time with fraction, optional "Z" or UTC offset; local time
+// without one) into microseconds since the epoch. Digits past microseconds
+// are dropped, as in Dart. |has_zone|, when given, tells whether the text
+// named its zone. Thread-safe.
+bool ParseIsoTimestamp(const char* text, size_t size, int64_t* micros,
+                       bool* has_zone = nullptr);
+
+inline bool ParseIsoTimestamp(const std::string& text, int64_t* micros) {
+  return ParseIsoTimestamp(text.data(), text.size(), micros);
+}
+
+// Batch entry point for dart:ffi (see lib/services/timestamp_kernel.dart).
+// |text| holds |count| timestamps back to back; timestamp i ends at byte
+// |ends[i]|. For each one, |micros[i]| receives the time and |kinds[i]| one
+// of the values below. Returns how many parsed.
+enum IsoTimestampKind : uint8_t {
+  kIsoTimestampInvalid = 0,
+  kIsoTimestampLocal = 1,  // No zone in the text; read as local time.
+  kIsoTimestampZoned = 2,
+};
+
+extern "C" __attribute__((visibility("default"))) int64_t
+codeagenthub_parse_iso_timestamps(const char* text, const int64_t* ends,
+                                  int64_t count, int64_t* micros,
+                                  uint8_t* kinds);
+
+#endif  // RUNNER_ISO_TIMESTAMP_H_
@@ -0,0 +1,69 @@
+#include "isolate_bridge.h"
+
+#include <dart_native_api.h>
+
+#include <atomic>
+#include <utility>
+
+namespace {
+
+using PostCObjectFunction = bool (*)(Dart_Port, Dart_CObject*);
+
+std::atomic<PostCObjectFunction> g_post_cobject{nullptr};
+
+void FreeBytes(void* /*isolate_callback_data*/, void* peer) {
+  delete static_cast<std::string*>(peer);
+}
+
+bool PostPair(int64_t port, int64_t job, Dart_CObject* payload) {
+  const PostCObjectFunction post = g_post_cobject.load();
+  if (post == nullptr) {
+    return false;
+  }
+  Dart_CObject job_object;
+  job_object.type = Dart_CObject_kInt64;
+  job_object.value.as_int64 = job;
+  Dart_CObject* values[] = {&job_object, payload};
+  Dart_CObject message;
+  message.type = Dart_CObject_kArray;
+  message.value.as_array.length = 2;
+  message.value.as_array.values = values;
+  return post(port, &message);
+}
+
+}  // namespace
+
+bool IsolateBridgeReady() { return g_post_cobject.load() != nullptr; }
+
+bool PostBytesToIsolate(int64_t port, int64_t job, std::string bytes) {
+  // The receiving isolate owns the buffer from here and frees it through
+  // FreeBytes once the typed data is collected.
+  auto* owned = new std::string(std::move(bytes));
+  Dart_CObject payload;
+  payload.type = Dart_CObject_kExternalTypedData;
+  payload.value.as_external_typed_data.type = Dart_TypedData_kUint8;
+  payload.value.as_external_typed_data.length =
+      static_cast<intptr_t>(owned->size());
+  payload.value.as_external_typed_data.data =
+      reinterpret_cast<uint8_t*>(&(*owned)[0]);
+  payload.value.as_external_typed_data.peer = owned;
+  payload.value.as_external_typed_data.callback = FreeBytes;
+  if (!PostPair(port, job, &payload)) {
+    // Not delivered: the buffer is still ours.
+    delete owned;
+    return false;
+  }
+  return true;
+}
+
+bool PostErrorToIsolate(int64_t port, int64_t job,
+                        const std::string& message) {
+  Dart_CObject payload;
+  payload.type = Dart_CObject_kString;
+  payload.value.as_string = message.c_str();
+  return PostPair(port, job, &payload);
+}
+
+void codeagenthub_isolate_bridge_init(void* post_cobject) {
+  g_post_cobject.store(reinterpret_cast<PostCObjectFunction>(post_cobject));
+}
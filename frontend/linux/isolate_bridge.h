@@ -0,0 +1,27 @@
+#ifndef RUNNER_ISOLATE_BRIDGE_H_
+#define RUNNER_ISOLATE_BRIDGE_H_
+
+#include <cstdint>
+#include <string>
+
+// Delivers large results straight to a Dart isolate's native port instead of
+// answering on the platform thread, so a background isolate can decode them
+// and build models without involving the UI isolate (see
+// lib/services/native_result_worker.dart). Dart hands over
+// NativeApi.postCObject once; a method call then names the receiving port and
+// a job id. Every post is the array [job, payload], where the payload is
+// external Uint8 typed data, handed over without a copy, or an error string.
+// Thread-safe.
+
+// Whether Dart has initialized the bridge.
+bool IsolateBridgeReady();
+
+// Both return false if the port is closed or the bridge is not initialized.
+bool PostBytesToIsolate(int64_t port, int64_t job, std::string bytes);
+bool PostErrorToIsolate(int64_t port, int64_t job, const std::string& message);
+
+// Called once from Dart through dart:ffi with NativeApi.postCObject.
+extern "C" __attribute__((visibility("default"))) void
+codeagenthub_isolate_bridge_init(void* post_cobject);
+
+#endif  // RUNNER_ISOLATE_BRIDGE_H_
@@ -0,0 +1,606 @@
+#include "json_value.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr int kMaxDepth = 256;
+
+const std::string& EmptyString() {
+  static const std::string empty;
+  return empty;
+}
+
+const JsonValue& NullValue() {
+  static const JsonValue null_value;
+  return null_value;
+}
+
+class Parser {
+ public:
+  Parser(const char* data, size_t size) : data_(data), end_(data + size) {}
+
+  bool ParseDocument(JsonValue* out, std::string* error) {
+    SkipWhitespace();
+    if (!ParseValue(out, 0)) {
+      *error = error_;
+      return false;
+    }
+    SkipWhitespace();
+    if (data_ != end_) {
+      *error = "Unexpected trailing characters";
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  bool Fail(const char* message) {
+    error_ = message;
+    return false;
+  }
+
+  void SkipWhitespace() {
+    while (data_ != end_ &&
+           (*data_ == ' ' || *data_ == '\n' || *data_ == '\r' ||
+            *data_ == '\t')) {
+      ++data_;
+    }
+  }
+
+  bool Consume(const char* literal) {
+    const size_t length = strlen(literal);
+    if (static_cast<size_t>(end_ - data_) < length ||
+        memcmp(data_, literal, length) != 0) {
+      return false;
+    }
+    data_ += length;
+    return true;
+  }
+
+  bool ParseValue(JsonValue* out, int depth) {
+    if (depth > kMaxDepth) {
+      return Fail("JSON nesting too deep");
+    }
+    if (data_ == end_) {
+      return Fail("Unexpected end of JSON");
+    }
+    switch (*data_) {
+      case '{':
+        return ParseObject(out, depth);
+      case '[':
+        return ParseArray(out, depth);
+      case '"': {
+        std::string value;
+        if (!ParseString(&value)) {
+          return false;
+        }
+        *out = JsonValue::String(std::move(value));
+        return true;
+      }
+      case 't':
+        if (!Consume("true")) {
+          return Fail("Invalid literal");
+        }
+        *out = JsonValue::Bool(true);
+        return true;
+      case 'f':
+        if (!Consume("false")) {
+          return Fail("Invalid literal");
+        }
+        *out = JsonValue::Bool(false);
+        return true;
+      case 'n':
+        if (!Consume("null")) {
+          return Fail("Invalid literal");
+        }
+        *out = JsonValue();
+        return true;
+      default:
+        return ParseNumber(out);
+    }
+  }
+
+  bool ParseObject(JsonValue* out, int depth) {
+    ++data_;
+    *out = JsonValue::Object();
+    SkipWhitespace();
+    if (data_ != end_ && *data_ == '}') {
+      ++data_;
+      return true;
+    }
+    for (;;) {
+      SkipWhitespace();
+      if (data_ == end_ || *data_ != '"') {
+        return Fail("Expected object key");
+      }
+      std::string key;
+      if (!ParseString(&key)) {
+        return false;
+      }
+      SkipWhitespace();
+      if (data_ == end_ || *data_ != ':') {
+        return Fail("Expected ':'");
+      }
+      ++data_;
+      SkipWhitespace();
+      out->members().emplace_back(std::move(key), JsonValue());
+      if (!ParseValue(&out->members().back().second, depth + 1)) {
+        return false;
+      }
+      SkipWhitespace();
+      if (data_ == end_) {
+        return Fail("Unterminated object");
+      }
+      if (*data_ == ',') {
+        ++data_;
+        continue;
+      }
+      if (*data_ == '}') {
+        ++data_;
+        return true;
+      }
+      return Fail("Expected ',' or '}'");
+    }
+  }
+
+  bool ParseArray(JsonValue* out, int depth) {
+    ++data_;
+    *out = JsonValue::Array();
+    SkipWhitespace();
+    if (data_ != end_ && *data_ == ']') {
+      ++data_;
+      return true;
+    }
+    for (;;) {
+      SkipWhitespace();
+      out->items().emplace_back();
+      if (!ParseValue(&out->items().back(), depth + 1)) {
+        return false;
+      }
+      SkipWhitespace();
+      if (data_ == end_) {
+        return Fail("Unterminated array");
+      }
+      if (*data_ == ',') {
+        ++data_;
+        continue;
+      }
+      if (*data_ == ']') {
+        ++data_;
+        return true;
+      }
+      return Fail("Expected ',' or ']'");
+    }
+  }
+
+  bool ParseHex4(uint32_t* value) {
+    if (end_ - data_ < 4) {
+      return Fail("Truncated \\u escape");
+    }
+    uint32_t result = 0;
+    for (int i = 0; i < 4; ++i) {
+      const char c = *data_++;
+      result <<= 4;
+      if (c >= '0' && c <= '9') {
+        result |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        result |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        result |= c - 'A' + 10;
+      } else {
+        return Fail("Invalid \\u escape");
+      }
+    }
+    *value = result;
+    return true;
+  }
+
+  bool ParseString(std::string* out) {
+    ++data_;
+    for (;;) {
+      // Copy the run of plain characters in one go.
+      const char* run = data_;
+      while (data_ != end_ && *data_ != '"' && *data_ != '\\' &&
+             static_cast<unsigned char>(*data_) >= 0x20) {
+        ++data_;
+      }
+      out->append(run, data_ - run);
+      if (data_ == end_) {
+        return Fail("Unterminated string");
+      }
+      const char c = *data_++;
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\') {
+        return Fail("Control character in string");
+      }
+      if (data_ == end_) {
+        return Fail("Unterminated escape");
+      }
+      const char escape = *data_++;
+      switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          out->push_back(escape);
+          break;
+        case 'b':
+          out->push_back('\b');
+          break;
+        case 'f':
+          out->push_back('\f');
+          break;
+        case 'n':
+          out->push_back('\n');
+          break;
+        case 'r':
+          out->push_back('\r');
+          break;
+        case 't':
+          out->push_back('\t');
+          break;
+        case 'u': {
+          uint32_t code_point;
+          if (!ParseHex4(&code_point)) {
+            return false;
+          }
+          if (code_point >= 0xd800 && code_point < 0xdc00 &&
+              end_ - data_ >= 6 && data_[0] == '\\' && data_[1] == 'u') {
+            const char* saved = data_;
+            data_ += 2;
+            uint32_t low;
+            if (!ParseHex4(&low)) {
+              return false;
+            }
+            if (low >= 0xdc00 && low < 0xe000) {
+              code_point = 0x10000 + ((code_point - 0xd800) << 10) +
+                           (low - 0xdc00);
+            } else {
+              data_ = saved;
+            }
+          }
+          if (code_point >= 0xd800 && code_point < 0xe000) {
+            code_point = 0xfffd;  // Lone surrogate.
+          }
+          AppendUtf8(out, code_point);
+          break;
+        }
+        default:
+          return Fail("Invalid escape");
+      }
+    }
+  }
+
+  bool ParseNumber(JsonValue* out) {
+    const char* start = data_;
+    bool integral = true;
+    if (data_ != end_ && *data_ == '-') {
+      ++data_;
+    }
+    if (data_ == end_ || *data_ < '0' || *data_ > '9') {
+      return Fail("Invalid value");
+    }
+    while (data_ != end_ && *data_ >= '0' && *data_ <= '9') {
+      ++data_;
+    }
+    if (data_ != end_ && *data_ == '.') {
+      integral = false;
+      ++data_;
+      while (data_ != end_ && *data_ >= '0' && *data_ <= '9') {
+        ++data_;
+      }
+    }
+    if (data_ != end_ && (*data_ == 'e' || *data_ == 'E')) {
+      integral = false;
+      ++data_;
+      if (data_ != end_ && (*data_ == '+' || *data_ == '-')) {
+        ++data_;
+      }
+      while (data_ != end_ && *data_ >= '0' && *data_ <= '9') {
+        ++data_;
+      }
+    }
+    const std::string text(start, data_ - start);
+    if (integral && text.size() < 19) {
+      *out = JsonValue::Integer(strtoll(text.c_str(), nullptr, 10));
+    } else {
+      *out = JsonValue::Number(strtod(text.c_str(), nullptr));
+    }
+    return true;
+  }
+
+  const char* data_;
+  const char* end_;
+  std::string error_;
+};
+
+}  // namespace
+
+JsonValue JsonValue::Bool(bool value) {
+  JsonValue result;
+  result.type_ = Type::kBool;
+  result.bool_ = value;
+  return result;
+}
+
+JsonValue JsonValue::Number(double value) {
+  JsonValue result;
+  result.type_ = Type::kNumber;
+  result.number_ = value;
+  return result;
+}
+
+JsonValue JsonValue::Integer(int64_t value) {
+  JsonValue result;
+  result.type_ = Type::kNumber;
+  result.is_integer_ = true;
+  result.integer_ = value;
+  result.number_ = static_cast<double>(value);
+  return result;
+}
+
+JsonValue JsonValue::String(std::string value) {
+  JsonValue result;
+  result.type_ = Type::kString;
+  result.string_ = std::move(value);
+  return result;
+}
+
+JsonValue JsonValue::Array() {
+  JsonValue result;
+  result.type_ = Type::kArray;
+  return result;
+}
+
+JsonValue JsonValue::Object() {
+  JsonValue result;
+  result.type_ = Type::kObject;
+  return result;
+}
+
+bool JsonValue::AsBool(bool fallback) const {
+  return type_ == Type::kBool ? bool_ : fallback;
+}
+
+double JsonValue::AsDouble(double fallback) const {
+  return type_ == Type::kNumber ? number_ : fallback;
+}
+
+int64_t JsonValue::AsInt(int64_t fallback) const {
+  if (type_ != Type::kNumber) {
+    return fallback;
+  }
+  return is_integer_ ? integer_ : static_cast<int64_t>(number_);
+}
+
+const std::string& JsonValue::AsString() const {
+  return type_ == Type::kString ? string_ : EmptyString();
+}
+
+const JsonValue* JsonValue::Find(const std::string& key) const {
+  if (type_ != Type::kObject) {
+    return nullptr;
+  }
+  for (const auto& member : members_) {
+    if (member.first == key) {
+      return &member.second;
+    }
+  }
+  return nullptr;
+}
+
+JsonValue* JsonValue::Find(const std::string& key) {
+  return const_cast<JsonValue*>(
+      static_cast<const JsonValue*>(this)->Find(key));
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const {
+  const JsonValue* value = Find(key);
+  return value != nullptr ? *value : NullValue();
+}
+
+void JsonValue::Set(const std::string& key, JsonValue value) {
+  JsonValue* existing = Find(key);
+  if (existing != nullptr) {
+    *existing = std::move(value);
+  } else {
+    members_.emplace_back(key, std::move(value));
+  }
+}
+
+void JsonValue::Append(JsonValue value) {
+  items_.push_back(std::move(value));
+}
+
+std::string JsonValue::Serialize() const {
+  std::string out;
+  SerializeTo(&out);
+  return out;
+}
+
+void JsonValue::SerializeTo(std::string* out) const {
+  switch (type_) {
+    case Type::kNull:
+      out->append("null");
+      break;
+    case Type::kBool:
+      out->append(bool_ ? "true" : "false");
+      break;
+    case Type::kNumber: {
+      if (is_integer_) {
+        out->append(std::to_string(integer_));
+      } else if (!std::isfinite(number_)) {
+        out->append("null");
+      } else {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.15g", number_);
+        if (strtod(buffer, nullptr) != number_) {
+          snprintf(buffer, sizeof(buffer), "%.17g", number_);
+        }
+        out->append(buffer);
+      }
+      break;
+    }
+    case Type::kString:
+      AppendJsonString(out, string_);
+      break;
+    case Type::kArray:
+      out->push_back('[');
+      for (size_t i = 0; i < items_.size(); ++i) {
+        if (i > 0) {
+          out->push_back(',');
+        }
+        items_[i].SerializeTo(out);
+      }
+      out->push_back(']');
+      break;
+    case Type::kObject:
+      out->push_back('{');
+      for (size_t i = 0; i < members_.size(); ++i) {
+        if (i > 0) {
+          out->push_back(',');
+        }
+        AppendJsonString(out, members_[i].first);
+        out->push_back(':');
+        members_[i].second.SerializeTo(out);
+      }
+      out->push_back('}');
+      break;
+  }
+}
+
+std::string JsonValue::SerializePretty() const {
+  std::string out;
+  SerializePrettyTo(&out, 0);
+  return out;
+}
+
+void JsonValue::SerializePrettyTo(std::string* out, int depth) const {
+  const bool empty = (type_ == Type::kArray && items_.empty()) ||
+                     (type_ == Type::kObject && members_.empty());
+  if ((type_ != Type::kArray && type_ != Type::kObject) || empty) {
+    SerializeTo(out);
+    return;
+  }
+  const std::string indent(2 * (depth + 1), ' ');
+  const bool is_array = type_ == Type::kArray;
+  const size_t count = is_array ? items_.size() : members_.size();
+  out->append(is_array ? "[\n" : "{\n");
+  for (size_t i = 0; i < count; ++i) {
+    out->append(indent);
+    if (is_array) {
+      items_[i].SerializePrettyTo(out, depth + 1);
+    } else {
+      AppendJsonString(out, members_[i].first);
+      out->append(": ");
+      members_[i].second.SerializePrettyTo(out, depth + 1);
+    }
+    out->append(i + 1 < count ? ",\n" : "\n");
+  }
+  out->append(2 * depth, ' ');
+  out->push_back(is_array ? ']' : '}');
+}
+
+void AppendUtf8(std::string* out, uint32_t code_point) {
+  if (code_point < 0x80) {
+    out->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out->push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else if (code_point < 0x10000) {
+    out->push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  } else {
+    out->push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+}
+
+bool ParseJson(const char* data, size_t size, JsonValue* out,
+               std::string* error) {
+  Parser parser(data, size);
+  return parser.ParseDocument(out, error);
+}
+
+void AppendJsonString(std::string* out, const char* value, size_t size) {
+  out->push_back('"');
+  AppendJsonStringContents(out, value, size);
+  out->push_back('"');
+}
+
+void AppendJsonStringContents(std::string* out, const char* value,
+                              size_t size) {
+  static const char kHex[] = "0123456789abcdef";
+  const char* run = value;
+  const char* end = value + size;
+  for (const char* p = value; p != end; ++p) {
+    const unsigned char c = static_cast<unsigned char>(*p);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    out->append(run, p - run);
+    run = p + 1;
+    switch (c) {
+      case '"':
+        out->append("\\\"");
+        break;
+      case '\\':
+        out->append("\\\\");
+        break;
+      case '\n':
+        out->append("\\n");
+        break;
+      case '\r':
+        out->append("\\r");
+        break;
+      case '\t':
+        out->append("\\t");
+        break;
+      case '\b':
+        out->append("\\b");
+        break;
+      case '\f':
+        out->append("\\f");
+        break;
+      default:
+        out->append("\\u00");
+        out->push_back(kHex[c >> 4]);
+        out->push_back(kHex[c & 0xf]);
+        break;
+    }
+  }
+  out->append(run, end - run);
+}
+
+size_t JsonStringContentsLength(const char* value, size_t size) {
+  size_t length = size;
+  for (const char* p = value; p != value + size; ++p) {
+    const unsigned char c = static_cast<unsigned char>(*p);
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    switch (c) {
+      case '"':
+      case '\\':
+      case '\n':
+      case '\r':
+      case '\t':
+      case '\b':
+      case '\f':
+        length += 1;
+        break;
+      default:
+        length += 5;
+        break;
+    }
+  }
+  return length;
+}
@@ -0,0 +1,107 @@
+#ifndef RUNNER_JSON_VALUE_H_
+#define RUNNER_JSON_VALUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON document model for the runner's native services. Objects keep
+// member order so normalized output stays diff-friendly, and integers are kept
+// exact instead of being rounded through a double.
+class JsonValue {
+ public:
+  enum class Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+  using Members = std::vector<std::pair<std::string, JsonValue>>;
+
+  JsonValue() = default;
+
+  static JsonValue Bool(bool value);
+  static JsonValue Number(double value);
+  static JsonValue Integer(int64_t value);
+  static JsonValue String(std::string value);
+  static JsonValue Array();
+  static JsonValue Object();
+
+  Type type() const { return type_; }
+  bool is_null() const { return type_ == Type::kNull; }
+  bool is_bool() const { return type_ == Type::kBool; }
+  bool is_number() const { return type_ == Type::kNumber; }
+  bool is_integer() const { return type_ == Type::kNumber && is_integer_; }
+  bool is_string() const { return type_ == Type::kString; }
+  bool is_array() const { return type_ == Type::kArray; }
+  bool is_object() const { return type_ == Type::kObject; }
+
+  bool AsBool(bool fallback = false) const;
+  double AsDouble(double fallback = 0) const;
+  int64_t AsInt(int64_t fallback = 0) const;
+  // Returns the string value, or an empty string for other types.
+  const std::string& AsString() const;
+  // Grows a string value in place, for parsers that see it in pieces.
+  std::string* mutable_string() { return &string_; }
+
+  const std::vector<JsonValue>& items() const { return items_; }
+  std::vector<JsonValue>& items() { return items_; }
+  const Members& members() const { return members_; }
+  Members& members() { return members_; }
+
+  // Returns the member named |key|, or nullptr if absent or not an object.
+  const JsonValue* Find(const std::string& key) const;
+  JsonValue* Find(const std::string& key);
+  // Returns the member named |key|, or a shared null value.
+  const JsonValue& operator[](const std::string& key) const;
+
+  // Replaces or adds the member |key|; the value must be an object.
+  void Set(const std::string& key, JsonValue value);
+  void Append(JsonValue value);
+
+  std::string Serialize() const;
+  void SerializeTo(std::string* out) const;
+  // Indented form for human-readable output such as exports.
+  std::string SerializePretty() const;
+
+ private:
+  void SerializePrettyTo(std::string* out, int depth) const;
+
+  Type type_ = Type::kNull;
+  bool bool_ = false;
+  bool is_integer_ = false;
+  int64_t integer_ = 0;
+  double number_ = 0;
+  std::string string_;
+  std::vector<JsonValue> items_;
+  Members members_;
+};
+
+// Parses a complete JSON document. Trailing whitespace is allowed; anything
+// else after the value is an error.
+bool ParseJson(const char* data, size_t size, JsonValue* out,
+               std::string* error);
+
+inline bool ParseJson(const std::string& text, JsonValue* out,
+                      std::string* error) {
+  return ParseJson(text.data(), text.size(), out, error);
+}
+
+// Appends |value| as a quoted, escaped JSON string literal.
+void AppendJsonString(std::string* out, const char* value, size_t size);
+
+inline void AppendJsonString(std::string* out, const std::string& value) {
+  AppendJsonString(out, value.data(), value.size());
+}
+
+// Appends the escaped contents of a JSON string literal, without the quotes.
+// Bytes are escaped one at a time, so |value| may be cut anywhere, even
+// inside a UTF-8 sequence, and the pieces appended separately.
+void AppendJsonStringContents(std::string* out, const char* value,
+                              size_t size);
+
+// The number of bytes AppendJsonStringContents() appends for |value|.
+size_t JsonStringContentsLength(const char* value, size_t size);
+
+// Appends |code_point| encoded as UTF-8.
+void AppendUtf8(std::string* out, uint32_t code_point);
+
+#endif  // RUNNER_JSON_VALUE_H_
@@ -0,0 +1,116 @@
+#include "method_call_utils.h"
+
+namespace {
+
+FlValue* LookupArg(FlValue* args, const char* key) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return nullptr;
+  }
+  return fl_value_lookup_string(args, key);
+}
+
+}  // namespace
+
+std::string LookupStringArg(FlValue* args, const char* key,
+                            const std::string& fallback) {
+  FlValue* value = LookupArg(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return fallback;
+  }
+  return fl_value_get_string(value);
+}
+
+int64_t LookupIntArg(FlValue* args, const char* key, int64_t fallback) {
+  FlValue* value = LookupArg(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_INT) {
+    return fallback;
+  }
+  return fl_value_get_int(value);
+}
+
+double LookupDoubleArg(FlValue* args, const char* key, double fallback) {
+  FlValue* value = LookupArg(args, key);
+  if (value == nullptr) {
+    return fallback;
+  }
+  if (fl_value_get_type(value) == FL_VALUE_TYPE_FLOAT) {
+    return fl_value_get_float(value);
+  }
+  if (fl_value_get_type(value) == FL_VALUE_TYPE_INT) {
+    return static_cast<double>(fl_value_get_int(value));
+  }
+  return fallback;
+}
+
+bool LookupBoolArg(FlValue* args, const char* key, bool fallback) {
+  FlValue* value = LookupArg(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_BOOL) {
+    return fallback;
+  }
+  return fl_value_get_bool(value);
+}
+
+std::vector<std::string> LookupStringListArg(FlValue* args, const char* key) {
+  std::vector<std::string> result;
+  FlValue* value = LookupArg(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_LIST) {
+    return result;
+  }
+  const size_t length = fl_value_get_length(value);
+  result.reserve(length);
+  for (size_t i = 0; i < length; ++i) {
+    FlValue* item = fl_value_get_list_value(value, i);
+    if (fl_value_get_type(item) == FL_VALUE_TYPE_STRING) {
+      result.emplace_back(fl_value_get_string(item));
+    }
+  }
+  return result;
+}
+
+void RespondSuccess(FlMethodCall* method_call, FlValue* result) {
+  g_autoptr(FlValue) owned_result = result;
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond_success(method_call, owned_result, &error)) {
+    g_warning("Failed to send method call response: %s", error->message);
+  }
+}
+
+void RespondError(FlMethodCall* method_call, const char* code,
+                  const std::string& message) {
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond_error(method_call, code, message.c_str(),
+                                    nullptr, &error)) {
+    g_warning("Failed to send method call error: %s", error->message);
+  }
+}
+
+FlValue* JsonToFlValue(const JsonValue& value) {
+  switch (value.type()) {
+    case JsonValue::Type::kNull:
+      return fl_value_new_null();
+    case JsonValue::Type::kBool:
+      return fl_value_new_bool(value.AsBool());
+    case JsonValue::Type::kNumber:
+      return value.is_integer() ? fl_value_new_int(value.AsInt())
+                                : fl_value_new_float(value.AsDouble());
+    case JsonValue::Type::kString:
+      return fl_value_new_string_sized(value.AsString().data(),
+                                       value.AsString().size());
+    case JsonValue::Type::kArray: {
+      FlValue* list = fl_value_new_list();
+      for (const JsonValue& item : value.items()) {
+        fl_value_append_take(list, JsonToFlValue(item));
+      }
+      return list;
+    }
+    case JsonValue::Type::kObject: {
+      FlValue* map = fl_value_new_map();
+      for (const auto& member : value.members()) {
+        fl_value_set_string_take(map, member.first.c_str(),
+                                 JsonToFlValue(member.second));
+      }
+      return map;
+    }
+  }
+  return fl_value_new_null();
+}
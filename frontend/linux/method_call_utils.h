@@ -0,0 +1,38 @@
+#ifndef RUNNER_METHOD_CALL_UTILS_H_
+#define RUNNER_METHOD_CALL_UTILS_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "json_value.h"
+
+// Small helpers shared by the runner's method channel handlers. Arguments
+// always arrive as a StandardMessageCodec map; missing or mistyped entries
+// fall back to the supplied default instead of failing the call.
+
+std::string LookupStringArg(FlValue* args, const char* key,
+                            const std::string& fallback = std::string());
+
+int64_t LookupIntArg(FlValue* args, const char* key, int64_t fallback);
+
+double LookupDoubleArg(FlValue* args, const char* key, double fallback);
+
+bool LookupBoolArg(FlValue* args, const char* key, bool fallback);
+
+// Returns the string entries of a list argument; non-string items are skipped.
+std::vector<std::string> LookupStringListArg(FlValue* args, const char* key);
+
+// Responds to |method_call| with |result| (ownership is taken). Errors while
+// responding are logged; the Dart side has usually just gone away.
+void RespondSuccess(FlMethodCall* method_call, FlValue* result);
+
+void RespondError(FlMethodCall* method_call, const char* code,
+                  const std::string& message);
+
+// Converts a parsed JSON value to the equivalent StandardMessageCodec value.
+FlValue* JsonToFlValue(const JsonValue& value);
+
+#endif  // RUNNER_METHOD_CALL_UTILS_H_
@@ -5,7 +5,23 @@
 #include <gdk/gdkx.h>
 #endif
 
+#include "backend_log.h"
+#include "clipboard_image.h"
 #include "flutter/generated_plugin_registrant.h"
+#include "frame_pacing.h"
+#include "paste_buffer.h"
+#include "power_policy.h"
+#include "project_index.h"
+#include "resident_mode.h"
+#include "run_journal.h"
+#include "session_export.h"
+#include "settings_store.h"
+#include "soak_monitor.h"
+#include "stream_normalizer.h"
+#include "stream_quality.h"
+#include "token_estimator.h"
+#include "transcript_cache.h"
+#include "turn_trace.h"
 
 struct _MyApplication {
   GtkApplication parent_instance;
@@ -17,6 +33,11 @@ G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 // Implements GApplication::activate.
 static void my_application_activate(GApplication* application) {
   MyApplication* self = MY_APPLICATION(application);
+  // A resident instance already has a warm engine; just show it again.
+  if (PresentResidentWindow()) {
+    return;
+  }
+
   GtkWindow* window =
       GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(application)));
 
@@ -48,7 +69,18 @@ static void my_application_activate(GApplication* application) {
   }
 
   gtk_window_set_default_size(window, 1280, 720);
-  gtk_widget_show(GTK_WIDGET(window));
+  // A headless soak run never maps the window; the view is realized below so
+  // the engine still starts.
+  SoakConfig soak_config;
+  const bool soak_mode = LoadSoakConfig(&soak_config);
+  const bool headless = soak_mode && soak_config.headless;
+  if (!headless) {
+    gtk_widget_show(GTK_WIDGET(window));
+  }
+  AttachResidentWindow(window);
+
+  // Settings are read synchronously from Dart during startup.
+  LoadSettingsStore();
 
   g_autoptr(FlDartProject) project = fl_dart_project_new();
   fl_dart_project_set_dart_entrypoint_arguments(project, self->dart_entrypoint_arguments);
@@ -56,9 +88,31 @@ static void my_application_activate(GApplication* application) {
   FlView* view = fl_view_new(project);
   gtk_widget_show(GTK_WIDGET(view));
   gtk_container_add(GTK_CONTAINER(window), GTK_WIDGET(view));
+  if (headless) {
+    gtk_widget_realize(GTK_WIDGET(view));
+  }
+  AttachFramePacing(GTK_WIDGET(view));
 
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
 
+  FlBinaryMessenger* messenger =
+      fl_engine_get_binary_messenger(fl_view_get_engine(view));
+  RegisterTranscriptCacheChannel(messenger);
+  RegisterProjectIndexChannel(messenger);
+  RegisterSessionExportChannel(messenger);
+  RegisterClipboardImageChannel(messenger);
+  RegisterPasteBufferChannel(messenger);
+  RegisterTokenEstimatorChannel(messenger);
+  RegisterStreamNormalizerChannel(messenger);
+  RegisterStreamQualityChannel(messenger);
+  RegisterRunJournalChannel(messenger);
+  RegisterResidencyChannel(messenger);
+  RegisterPowerPolicyChannel(messenger);
+  RegisterFramePacingChannel(messenger);
+  RegisterTurnTraceChannel(messenger);
+  RegisterBackendLogChannel(messenger);
+  RegisterSoakChannel(messenger, soak_mode ? &soak_config : nullptr);
+
   gtk_widget_grab_focus(GTK_WIDGET(view));
 }
 
@@ -68,6 +122,13 @@ static gboolean my_application_local_command_line(GApplication* application, gch
   // Strip out the first argument as it is the binary name.
   self->dart_entrypoint_arguments = g_strdupv(*arguments + 1);
 
+  // A launch with arguments (e.g. --path) starts its own engine so the Dart
+  // single-instance logic can hand them over; a plain relaunch of a resident
+  // application is forwarded to the running instance instead.
+  if (self->dart_entrypoint_arguments[0] != nullptr) {
+    g_application_set_flags(application, G_APPLICATION_NON_UNIQUE);
+  }
+
   g_autoptr(GError) error = nullptr;
   if (!g_application_register(application, nullptr, &error)) {
      g_warning("Failed to register: %s", error->message);
@@ -95,6 +156,7 @@ static void my_application_shutdown(GApplication* application) {
   //MyApplication* self = MY_APPLICATION(object);
 
   // Perform any actions required at application shutdown.
+  FlushSettingsStore();
 
   G_APPLICATION_CLASS(my_application_parent_class)->shutdown(application);
 }
@@ -117,8 +179,15 @@ static void my_application_class_init(MyApplicationClass* klass) {
 static void my_application_init(MyApplication* self) {}
 
 MyApplication* my_application_new() {
-  return MY_APPLICATION(g_object_new(my_application_get_type(),
-                                     "application-id", APPLICATION_ID,
-                                     "flags", G_APPLICATION_NON_UNIQUE,
-                                     nullptr));
+  // In resident mode the application is unique, so launching it again
+  // activates the running instance over D-Bus.
+#if GLIB_CHECK_VERSION(2, 74, 0)
+  const GApplicationFlags unique_flags = G_APPLICATION_DEFAULT_FLAGS;
+#else
+  const GApplicationFlags unique_flags = G_APPLICATION_FLAGS_NONE;
+#endif
+  return MY_APPLICATION(g_object_new(
+      my_application_get_type(), "application-id", APPLICATION_ID, "flags",
+      LoadResidentModeSetting() ? unique_flags : G_APPLICATION_NON_UNIQUE,
+      nullptr));
 }
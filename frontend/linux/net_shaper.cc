@@ -0,0 +1,347 @@
+#include "net_shaper.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const size_t kReadBufferSize = 64 * 1024;
+
+int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Resolves |host|:|port| and returns a socket that is bound and listening
+// (|listen|) or connected to it, or -1.
+int OpenSocket(const std::string& host, int port, bool listen,
+               std::string* error) {
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = listen ? AI_PASSIVE : 0;
+  addrinfo* addresses = nullptr;
+  const std::string service = std::to_string(port);
+  const int status =
+      getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses);
+  if (status != 0) {
+    *error = host + ": " + gai_strerror(status);
+    return -1;
+  }
+  int fd = -1;
+  for (addrinfo* address = addresses; address != nullptr;
+       address = address->ai_next) {
+    fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC,
+                address->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    int one = 1;
+    bool ok;
+    if (listen) {
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      ok = bind(fd, address->ai_addr, address->ai_addrlen) == 0 &&
+           ::listen(fd, SOMAXCONN) == 0;
+    } else {
+      ok = connect(fd, address->ai_addr, address->ai_addrlen) == 0;
+    }
+    if (ok) {
+      // Fragments must leave as separate segments.
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      break;
+    }
+    *error = host + ":" + service + ": " + strerror(errno);
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(addresses);
+  return fd;
+}
+
+bool SendAll(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    const ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+// One proxied connection. Each direction has a reader that timestamps and
+// schedules incoming data and a writer that releases it when due, so the
+// added latency does not hold up reading.
+class Connection {
+ public:
+  Connection(int client, int upstream, const NetShaperConfig& config,
+             uint32_t seed, int64_t drop_after)
+      : client_(client),
+        upstream_(upstream),
+        up_(config, seed),
+        down_(config, seed + 1),
+        drop_after_(drop_after) {}
+
+  ~Connection() {
+    close(client_);
+    close(upstream_);
+  }
+
+  void Run(int id) {
+    std::thread up_reader([this]() { Read(upstream_direction()); });
+    std::thread up_writer([this]() { Write(upstream_direction(), -1); });
+    std::thread down_reader([this]() { Read(downstream_direction()); });
+    Write(downstream_direction(), drop_after_);
+    down_reader.join();
+    up_reader.join();
+    up_writer.join();
+    fprintf(stderr, "net_shaper: #%d closed (%lld bytes up, %lld down%s)\n",
+            id, static_cast<long long>(up_queue_.delivered),
+            static_cast<long long>(down_queue_.delivered),
+            dropped_ ? ", reset" : "");
+  }
+
+ private:
+  struct Chunk {
+    std::string data;
+    int64_t due_us = 0;
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Chunk> chunks;
+    bool eof = false;
+    int64_t delivered = 0;
+  };
+
+  struct Direction {
+    int from;
+    int to;
+    ShapedStream* shape;
+    Queue* queue;
+  };
+
+  Direction upstream_direction() {
+    return {client_, upstream_, &up_, &up_queue_};
+  }
+  Direction downstream_direction() {
+    return {upstream_, client_, &down_, &down_queue_};
+  }
+
+  void Read(Direction direction) {
+    std::vector<char> buffer(kReadBufferSize);
+    std::vector<ShapedStream::Piece> pieces;
+    while (!aborted_) {
+      const ssize_t size =
+          recv(direction.from, buffer.data(), buffer.size(), 0);
+      if (size < 0 && errno == EINTR) {
+        continue;
+      }
+      if (size <= 0) {
+        break;
+      }
+      pieces.clear();
+      direction.shape->Schedule(size, NowUs(), &pieces);
+      std::lock_guard<std::mutex> lock(direction.queue->mutex);
+      for (const ShapedStream::Piece& piece : pieces) {
+        direction.queue->chunks.push_back(
+            {std::string(buffer.data() + piece.offset, piece.size),
+             piece.due_us});
+      }
+      direction.queue->ready.notify_one();
+    }
+    std::lock_guard<std::mutex> lock(direction.queue->mutex);
+    direction.queue->eof = true;
+    direction.queue->ready.notify_one();
+  }
+
+  void Write(Direction direction, int64_t drop_after) {
+    Queue* queue = direction.queue;
+    while (true) {
+      Chunk chunk;
+      {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        queue->ready.wait(lock, [queue, this]() {
+          return !queue->chunks.empty() || queue->eof || aborted_;
+        });
+        if (aborted_ || queue->chunks.empty()) {
+          break;
+        }
+        chunk = std::move(queue->chunks.front());
+        queue->chunks.pop_front();
+      }
+      const int64_t wait_us = chunk.due_us - NowUs();
+      if (wait_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(wait_us));
+      }
+      size_t size = chunk.data.size();
+      const bool drop =
+          drop_after >= 0 && queue->delivered + static_cast<int64_t>(size) >
+                                 drop_after;
+      if (drop) {
+        size = static_cast<size_t>(drop_after - queue->delivered);
+      }
+      if (!SendAll(direction.to, chunk.data.data(), size)) {
+        Abort(false);
+        return;
+      }
+      queue->delivered += size;
+      if (drop) {
+        Abort(true);
+        return;
+      }
+    }
+    if (!aborted_) {
+      // Pass the end of the stream on once everything before it is out.
+      shutdown(direction.to, SHUT_WR);
+    }
+  }
+
+  // Tears the connection down; |reset| makes the client see a reset rather
+  // than an orderly close, like a dropped VPN link.
+  void Abort(bool reset) {
+    if (aborted_.exchange(true)) {
+      return;
+    }
+    dropped_ = reset;
+    if (reset) {
+      // No FIN: the close in the destructor then sends a reset.
+      linger hard = {1, 0};
+      setsockopt(client_, SOL_SOCKET, SO_LINGER, &hard, sizeof(hard));
+      shutdown(client_, SHUT_RD);
+    } else {
+      shutdown(client_, SHUT_RDWR);
+    }
+    shutdown(upstream_, SHUT_RDWR);
+    for (Queue* queue : {&up_queue_, &down_queue_}) {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      queue->ready.notify_all();
+    }
+  }
+
+  const int client_;
+  const int upstream_;
+  ShapedStream up_;
+  ShapedStream down_;
+  const int64_t drop_after_;
+  Queue up_queue_;
+  Queue down_queue_;
+  std::atomic<bool> aborted_{false};
+  bool dropped_ = false;
+};
+
+}  // namespace
+
+ShapedStream::ShapedStream(const NetShaperConfig& config, uint32_t seed)
+    : config_(config), random_(seed) {}
+
+void ShapedStream::Schedule(size_t size, int64_t now_us,
+                            std::vector<Piece>* pieces) {
+  size_t offset = 0;
+  while (offset < size) {
+    size_t piece = size - offset;
+    if (config_.max_fragment > 0) {
+      std::uniform_int_distribution<size_t> fragment(
+          1, std::min(config_.max_fragment, piece));
+      piece = fragment(random_);
+    }
+
+    int64_t departs_us = now_us;
+    if (config_.bandwidth_bytes_per_second > 0) {
+      link_free_us_ = std::max(link_free_us_, now_us) +
+                      static_cast<int64_t>(piece) * 1000000 /
+                          config_.bandwidth_bytes_per_second;
+      departs_us = link_free_us_;
+    }
+    int64_t due_us = departs_us + int64_t{config_.latency_ms} * 1000;
+    if (config_.jitter_ms > 0) {
+      std::uniform_int_distribution<int64_t> jitter(
+          0, int64_t{config_.jitter_ms} * 1000);
+      due_us += jitter(random_);
+    }
+    last_due_us_ = std::max(last_due_us_, due_us);
+
+    pieces->push_back({offset, piece, last_due_us_});
+    offset += piece;
+  }
+}
+
+int64_t PickDropPoint(const NetShaperConfig& config, std::mt19937* random) {
+  if (config.drop_rate <= 0 ||
+      std::uniform_real_distribution<double>(0, 1)(*random) >=
+          config.drop_rate) {
+    return -1;
+  }
+  const int64_t low = std::max<int64_t>(config.drop_min_bytes, 0);
+  const int64_t high = std::max(config.drop_max_bytes, low);
+  return std::uniform_int_distribution<int64_t>(low, high)(*random);
+}
+
+bool RunNetShaper(const NetShaperConfig& config, std::string* error) {
+  const int listener =
+      OpenSocket(config.listen_host, config.listen_port, true, error);
+  if (listener < 0) {
+    return false;
+  }
+  const uint32_t seed =
+      config.seed != 0 ? config.seed : std::random_device()();
+  std::mt19937 random(seed);
+  fprintf(stderr, "net_shaper: %s:%d -> %s:%d (seed %u)\n",
+          config.listen_host.c_str(), config.listen_port,
+          config.upstream_host.c_str(), config.upstream_port, seed);
+
+  for (int id = 1;; ++id) {
+    const int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      *error = std::string("accept: ") + strerror(errno);
+      close(listener);
+      return false;
+    }
+    int one = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    std::string connect_error;
+    const int upstream = OpenSocket(config.upstream_host,
+                                    config.upstream_port, false,
+                                    &connect_error);
+    if (upstream < 0) {
+      fprintf(stderr, "net_shaper: #%d upstream failed: %s\n", id,
+              connect_error.c_str());
+      close(client);
+      continue;
+    }
+
+    const int64_t drop_after = PickDropPoint(config, &random);
+    if (drop_after >= 0) {
+      fprintf(stderr, "net_shaper: #%d will reset after %lld bytes\n", id,
+              static_cast<long long>(drop_after));
+    }
+    auto connection = std::make_shared<Connection>(client, upstream, config,
+                                                   random(), drop_after);
+    std::thread([connection, id]() { connection->Run(id); }).detach();
+  }
+}
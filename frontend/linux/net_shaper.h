@@ -0,0 +1,76 @@
+#ifndef RUNNER_NET_SHAPER_H_
+#define RUNNER_NET_SHAPER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// net_shaper is a local TCP proxy for streaming tests. It sits between the
+// app and the backend and degrades the link the way a remote backend over a
+// VPN does, so coalescing, reconnection and SSE parsing can be exercised
+// offline. Point the app's API address at the proxy:
+//
+//   net_shaper --upstream 127.0.0.1:8207 --listen 8208
+//              --latency-ms 60 --jitter-ms 40 --bandwidth-kbps 256
+//              --max-fragment 512 --drop-rate 0.2 --drop-after 4096-65536
+//
+// It is built alongside the runner but is not part of the bundle.
+struct NetShaperConfig {
+  std::string listen_host = "127.0.0.1";
+  int listen_port = 8208;
+  std::string upstream_host = "127.0.0.1";
+  int upstream_port = 8207;
+  // One-way delay added in both directions.
+  int latency_ms = 0;
+  // Extra delay drawn uniformly from [0, jitter_ms] for every piece. Pieces
+  // are never reordered, so a late piece also holds back the ones behind it.
+  int jitter_ms = 0;
+  // Bytes per second in each direction; 0 leaves the link unlimited.
+  int64_t bandwidth_bytes_per_second = 0;
+  // Splits data into pieces of 1..max_fragment bytes, each written on its
+  // own; 0 forwards reads whole.
+  size_t max_fragment = 0;
+  // Fraction of connections that are reset part-way through the response,
+  // after a number of response bytes drawn from [drop_min_bytes,
+  // drop_max_bytes].
+  double drop_rate = 0;
+  int64_t drop_min_bytes = 0;
+  int64_t drop_max_bytes = 0;
+  // Seeds the random choices; 0 picks a fresh seed.
+  uint32_t seed = 0;
+};
+
+// Delivery schedule for one direction of one connection.
+class ShapedStream {
+ public:
+  struct Piece {
+    size_t offset = 0;
+    size_t size = 0;
+    int64_t due_us = 0;  // Earliest time to write the piece.
+  };
+
+  ShapedStream(const NetShaperConfig& config, uint32_t seed);
+
+  // Splits |size| bytes that were read at |now_us| into pieces. Due times
+  // never decrease, across calls as well.
+  void Schedule(size_t size, int64_t now_us, std::vector<Piece>* pieces);
+
+ private:
+  const NetShaperConfig config_;
+  std::mt19937 random_;
+  // When the bandwidth cap has finished sending everything scheduled so far.
+  int64_t link_free_us_ = 0;
+  int64_t last_due_us_ = 0;
+};
+
+// The number of response bytes after which a connection is reset, or -1 to
+// leave it alone.
+int64_t PickDropPoint(const NetShaperConfig& config, std::mt19937* random);
+
+// Accepts and proxies connections until the process is killed. Returns false
+// with |error| set if the listening socket cannot be set up.
+bool RunNetShaper(const NetShaperConfig& config, std::string* error);
+
+#endif  // RUNNER_NET_SHAPER_H_
@@ -0,0 +1,110 @@
+#include <glib.h>
+
+#include <cstdio>
+#include <string>
+
+#include "net_shaper.h"
+
+namespace {
+
+// Parses "HOST:PORT" or a bare "PORT".
+bool ParseAddress(const gchar* value, std::string* host, int* port) {
+  if (value == nullptr) {
+    return true;
+  }
+  std::string text = value;
+  const size_t colon = text.rfind(':');
+  if (colon != std::string::npos) {
+    *host = text.substr(0, colon);
+    text = text.substr(colon + 1);
+  }
+  gchar* end = nullptr;
+  const gint64 parsed = g_ascii_strtoll(text.c_str(), &end, 10);
+  if (end == text.c_str() || *end != '\0' || parsed <= 0 || parsed > 65535) {
+    return false;
+  }
+  *port = static_cast<int>(parsed);
+  return true;
+}
+
+// Parses "MIN-MAX" or a single byte count.
+bool ParseRange(const gchar* value, int64_t* low, int64_t* high) {
+  if (value == nullptr) {
+    return true;
+  }
+  gchar* end = nullptr;
+  *low = g_ascii_strtoll(value, &end, 10);
+  *high = *low;
+  if (*end == '-') {
+    const gchar* second = end + 1;
+    *high = g_ascii_strtoll(second, &end, 10);
+    if (end == second) {
+      return false;
+    }
+  }
+  return end != value && *end == '\0' && *low >= 0 && *high >= *low;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  NetShaperConfig config;
+  g_autofree gchar* listen = nullptr;
+  g_autofree gchar* upstream = nullptr;
+  g_autofree gchar* drop_after = nullptr;
+  gint bandwidth_kbps = 0;
+  gint max_fragment = 0;
+  gint seed = 0;
+  GOptionEntry entries[] = {
+      {"listen", 'l', 0, G_OPTION_ARG_STRING, &listen,
+       "Address to listen on (default 127.0.0.1:8208)", "[HOST:]PORT"},
+      {"upstream", 'u', 0, G_OPTION_ARG_STRING, &upstream,
+       "Backend address (default 127.0.0.1:8207)", "[HOST:]PORT"},
+      {"latency-ms", 0, 0, G_OPTION_ARG_INT, &config.latency_ms,
+       "One-way delay added in each direction", "MS"},
+      {"jitter-ms", 0, 0, G_OPTION_ARG_INT, &config.jitter_ms,
+       "Extra random delay per piece, order preserved", "MS"},
+      {"bandwidth-kbps", 0, 0, G_OPTION_ARG_INT, &bandwidth_kbps,
+       "Bandwidth cap per direction in KiB/s", "KBPS"},
+      {"max-fragment", 0, 0, G_OPTION_ARG_INT, &max_fragment,
+       "Split data into random pieces of at most this many bytes", "BYTES"},
+      {"drop-rate", 0, 0, G_OPTION_ARG_DOUBLE, &config.drop_rate,
+       "Fraction of connections reset mid-response", "0..1"},
+      {"drop-after", 0, 0, G_OPTION_ARG_STRING, &drop_after,
+       "Response bytes before a reset (default 1024-65536)", "MIN-MAX"},
+      {"seed", 0, 0, G_OPTION_ARG_INT, &seed,
+       "Seed for the random choices, to replay a run", "N"},
+      {nullptr, 0, 0, G_OPTION_ARG_NONE, nullptr, nullptr, nullptr},
+  };
+
+  g_autoptr(GOptionContext) context =
+      g_option_context_new("- shape the link between the app and the backend");
+  g_option_context_add_main_entries(context, entries, nullptr);
+  g_autoptr(GError) error = nullptr;
+  if (!g_option_context_parse(context, &argc, &argv, &error)) {
+    fprintf(stderr, "net_shaper: %s\n", error->message);
+    return 2;
+  }
+
+  config.drop_min_bytes = 1024;
+  config.drop_max_bytes = 64 * 1024;
+  if (!ParseAddress(listen, &config.listen_host, &config.listen_port) ||
+      !ParseAddress(upstream, &config.upstream_host, &config.upstream_port) ||
+      !ParseRange(drop_after, &config.drop_min_bytes,
+                  &config.drop_max_bytes) ||
+      config.latency_ms < 0 || config.jitter_ms < 0 || bandwidth_kbps < 0 ||
+      max_fragment < 0 || config.drop_rate < 0 || config.drop_rate > 1) {
+    fprintf(stderr, "net_shaper: invalid option value, see --help\n");
+    return 2;
+  }
+  config.bandwidth_bytes_per_second = int64_t{bandwidth_kbps} * 1024;
+  config.max_fragment = static_cast<size_t>(max_fragment);
+  config.seed = static_cast<uint32_t>(seed);
+
+  std::string message;
+  if (!RunNetShaper(config, &message)) {
+    fprintf(stderr, "net_shaper: %s\n", message.c_str());
+    return 1;
+  }
+  return 0;
+}
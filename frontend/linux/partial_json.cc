@@ -0,0 +1,397 @@
+#include "partial_json.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr size_t kMaxDepth = 256;
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool IsNumberChar(char c) {
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+         c == 'e' || c == 'E';
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Length of a UTF-8 sequence cut off at the end of |text| after |start|,
+// which the next fragment completes.
+size_t IncompleteUtf8Tail(const std::string& text, size_t start) {
+  size_t i = text.size();
+  size_t continuation = 0;
+  while (i > start && continuation < 3 &&
+         (static_cast<unsigned char>(text[i - 1]) & 0xc0) == 0x80) {
+    --i;
+    ++continuation;
+  }
+  if (i == start) {
+    return 0;
+  }
+  const unsigned char lead = static_cast<unsigned char>(text[i - 1]);
+  const size_t length = lead >= 0xf0   ? 4
+                        : lead >= 0xe0 ? 3
+                        : lead >= 0xc0 ? 2
+                                       : 1;
+  return length > continuation + 1 ? continuation + 1 : 0;
+}
+
+}  // namespace
+
+bool PartialJsonParser::Fail(const char* message) {
+  state_ = State::kFailed;
+  error_ = message;
+  string_value_ = nullptr;
+  return false;
+}
+
+std::string* PartialJsonParser::StringTarget() {
+  return in_key_ ? &key_ : string_value_->mutable_string();
+}
+
+void PartialJsonParser::DropLoneSurrogate() {
+  if (high_surrogate_ != 0) {
+    AppendUtf8(StringTarget(), 0xfffd);
+    high_surrogate_ = 0;
+  }
+}
+
+void PartialJsonParser::AppendCodeUnit(uint32_t unit) {
+  std::string* out = StringTarget();
+  if (high_surrogate_ != 0) {
+    if (unit >= 0xdc00 && unit < 0xe000) {
+      AppendUtf8(out, 0x10000 + ((high_surrogate_ - 0xd800) << 10) +
+                          (unit - 0xdc00));
+      high_surrogate_ = 0;
+      return;
+    }
+    DropLoneSurrogate();
+  }
+  if (unit >= 0xd800 && unit < 0xdc00) {
+    high_surrogate_ = unit;  // Wait for the low half, maybe in a later delta.
+    return;
+  }
+  if (unit >= 0xdc00 && unit < 0xe000) {
+    unit = 0xfffd;
+  }
+  AppendUtf8(out, unit);
+}
+
+void PartialJsonParser::FlushAppend(bool closed,
+                                    std::vector<PartialJsonUpdate>* updates) {
+  if (string_value_ == nullptr) {
+    return;
+  }
+  const std::string& text = string_value_->AsString();
+  size_t end = text.size();
+  if (!closed) {
+    end -= IncompleteUtf8Tail(text, append_start_);
+  }
+  if (end <= append_start_) {
+    return;
+  }
+  PartialJsonUpdate update;
+  update.op = PartialJsonUpdate::Op::kAppend;
+  update.path = path_;
+  update.text = text.substr(append_start_, end - append_start_);
+  updates->push_back(std::move(update));
+  append_start_ = end;
+}
+
+JsonValue* PartialJsonParser::BeginValue(
+    JsonValue value, std::vector<PartialJsonUpdate>* updates) {
+  JsonValue* slot;
+  if (containers_.empty()) {
+    root_ = std::move(value);
+    slot = &root_;
+  } else {
+    JsonValue* parent = containers_.back();
+    JsonPathSegment segment;
+    if (parent->is_array()) {
+      parent->Append(std::move(value));
+      slot = &parent->items().back();
+      segment.is_index = true;
+      segment.index = parent->items().size() - 1;
+    } else {
+      parent->Set(key_, std::move(value));
+      slot = parent->Find(key_);
+      segment.key = key_;
+    }
+    path_.push_back(std::move(segment));
+  }
+
+  PartialJsonUpdate update;
+  update.op = PartialJsonUpdate::Op::kSet;
+  update.path = path_;
+  update.value = *slot;  // A scalar, or an empty string or container.
+  updates->push_back(std::move(update));
+  return slot;
+}
+
+void PartialJsonParser::EndValue(bool closed,
+                                 std::vector<PartialJsonUpdate>* updates) {
+  if (closed) {
+    PartialJsonUpdate update;
+    update.op = PartialJsonUpdate::Op::kComplete;
+    update.path = path_;
+    updates->push_back(std::move(update));
+  }
+  if (!path_.empty()) {
+    path_.pop_back();
+  }
+  state_ = containers_.empty() ? State::kDone : State::kCommaOrEnd;
+}
+
+bool PartialJsonParser::EndScalar(std::vector<PartialJsonUpdate>* updates) {
+  JsonValue value;
+  std::string error;
+  if (!ParseJson(scalar_, &value, &error)) {
+    return Fail("Invalid value");
+  }
+  BeginValue(std::move(value), updates);
+  EndValue(false, updates);
+  return true;
+}
+
+bool PartialJsonParser::Feed(const char* data, size_t size,
+                             std::vector<PartialJsonUpdate>* updates) {
+  const char* p = data;
+  const char* end = data + size;
+  while (p < end && state_ != State::kFailed) {
+    switch (state_) {
+      case State::kString: {
+        // Copy the run of plain characters in one go.
+        const char* run = p;
+        while (p < end && *p != '"' && *p != '\\' &&
+               static_cast<unsigned char>(*p) >= 0x20) {
+          ++p;
+        }
+        if (p > run) {
+          DropLoneSurrogate();
+          StringTarget()->append(run, p - run);
+        }
+        if (p == end) {
+          break;
+        }
+        const char c = *p++;
+        if (c == '\\') {
+          state_ = State::kEscape;
+        } else if (c != '"') {
+          Fail("Control character in string");
+        } else {
+          DropLoneSurrogate();
+          if (in_key_) {
+            in_key_ = false;
+            state_ = State::kColon;
+          } else {
+            FlushAppend(true, updates);
+            string_value_ = nullptr;
+            EndValue(true, updates);
+          }
+        }
+        break;
+      }
+      case State::kEscape: {
+        const char c = *p++;
+        state_ = State::kString;
+        switch (c) {
+          case '"':
+          case '\\':
+          case '/':
+            AppendCodeUnit(static_cast<unsigned char>(c));
+            break;
+          case 'b':
+            AppendCodeUnit('\b');
+            break;
+          case 'f':
+            AppendCodeUnit('\f');
+            break;
+          case 'n':
+            AppendCodeUnit('\n');
+            break;
+          case 'r':
+            AppendCodeUnit('\r');
+            break;
+          case 't':
+            AppendCodeUnit('\t');
+            break;
+          case 'u':
+            unicode_ = 0;
+            unicode_digits_ = 0;
+            state_ = State::kUnicode;
+            break;
+          default:
+            Fail("Invalid escape");
+        }
+        break;
+      }
+      case State::kUnicode: {
+        const int digit = HexValue(*p++);
+        if (digit < 0) {
+          Fail("Invalid \\u escape");
+          break;
+        }
+        unicode_ = (unicode_ << 4) | static_cast<uint32_t>(digit);
+        if (++unicode_digits_ == 4) {
+          state_ = State::kString;
+          AppendCodeUnit(unicode_);
+        }
+        break;
+      }
+      case State::kNumber:
+        while (p < end && IsNumberChar(*p)) {
+          scalar_.push_back(*p++);
+        }
+        // The number only ends at the next non-number character, which is
+        // handled by the state EndScalar returns to.
+        if (p < end) {
+          EndScalar(updates);
+        }
+        break;
+      case State::kLiteral: {
+        while (p < end && *p >= 'a' && *p <= 'z') {
+          scalar_.push_back(*p++);
+        }
+        bool prefix = false;
+        for (const char* literal : {"true", "false", "null"}) {
+          if (strncmp(literal, scalar_.c_str(), scalar_.size()) == 0) {
+            prefix = true;
+            if (scalar_.size() == strlen(literal)) {
+              EndScalar(updates);
+            }
+          }
+        }
+        if (!prefix || (state_ == State::kLiteral && p < end)) {
+          Fail("Invalid literal");
+        }
+        break;
+      }
+      default: {
+        const char c = *p;
+        if (IsWhitespace(c)) {
+          ++p;
+          break;
+        }
+        switch (state_) {
+          case State::kArrayFirst:
+          case State::kValue:
+            if (state_ == State::kArrayFirst && c == ']') {
+              ++p;
+              containers_.pop_back();
+              EndValue(true, updates);
+            } else if (c == '{' || c == '[') {
+              if (containers_.size() >= kMaxDepth) {
+                Fail("JSON nesting too deep");
+                break;
+              }
+              ++p;
+              containers_.push_back(BeginValue(
+                  c == '{' ? JsonValue::Object() : JsonValue::Array(),
+                  updates));
+              state_ = c == '{' ? State::kObjectFirst : State::kArrayFirst;
+            } else if (c == '"') {
+              ++p;
+              string_value_ = BeginValue(JsonValue::String(""), updates);
+              append_start_ = 0;
+              in_key_ = false;
+              state_ = State::kString;
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+              scalar_.clear();
+              state_ = State::kNumber;
+            } else if (c == 't' || c == 'f' || c == 'n') {
+              scalar_.clear();
+              state_ = State::kLiteral;
+            } else {
+              Fail("Invalid value");
+            }
+            break;
+          case State::kObjectFirst:
+          case State::kObjectKey:
+            ++p;
+            if (state_ == State::kObjectFirst && c == '}') {
+              containers_.pop_back();
+              EndValue(true, updates);
+            } else if (c == '"') {
+              in_key_ = true;
+              key_.clear();
+              state_ = State::kString;
+            } else {
+              Fail("Expected object key");
+            }
+            break;
+          case State::kColon:
+            ++p;
+            if (c == ':') {
+              state_ = State::kValue;
+            } else {
+              Fail("Expected ':'");
+            }
+            break;
+          case State::kCommaOrEnd: {
+            ++p;
+            const bool is_array = containers_.back()->is_array();
+            if (c == ',') {
+              state_ = is_array ? State::kValue : State::kObjectKey;
+            } else if (c == (is_array ? ']' : '}')) {
+              containers_.pop_back();
+              EndValue(true, updates);
+            } else {
+              Fail(is_array ? "Expected ',' or ']'" : "Expected ',' or '}'");
+            }
+            break;
+          }
+          case State::kDone:
+            Fail("Unexpected trailing characters");
+            break;
+          default:
+            break;
+        }
+        break;
+      }
+    }
+  }
+  // Report what a string value received in this fragment as one append,
+  // holding back a multi-byte character that the fragment split.
+  FlushAppend(false, updates);
+  return state_ != State::kFailed;
+}
+
+bool PartialJsonParser::Finish(std::vector<PartialJsonUpdate>* updates) {
+  if (state_ == State::kNumber) {
+    EndScalar(updates);
+  }
+  return complete();
+}
+
+JsonValue PartialJsonUpdatesToJson(
+    const std::vector<PartialJsonUpdate>& updates) {
+  JsonValue list = JsonValue::Array();
+  for (const PartialJsonUpdate& update : updates) {
+    JsonValue item = JsonValue::Object();
+    if (update.op == PartialJsonUpdate::Op::kAppend) {
+      item.Set("op", JsonValue::String("append"));
+      item.Set("text", JsonValue::String(update.text));
+    } else if (update.op == PartialJsonUpdate::Op::kComplete) {
+      item.Set("op", JsonValue::String("complete"));
+    } else {
+      item.Set("op", JsonValue::String("set"));
+      item.Set("value", update.value);
+    }
+    JsonValue path = JsonValue::Array();
+    for (const JsonPathSegment& segment : update.path) {
+      path.Append(segment.is_index
+                      ? JsonValue::Integer(static_cast<int64_t>(segment.index))
+                      : JsonValue::String(segment.key));
+    }
+    item.Set("path", std::move(path));
+    list.Append(std::move(item));
+  }
+  return list;
+}
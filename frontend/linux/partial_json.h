@@ -0,0 +1,120 @@
+#ifndef RUNNER_PARTIAL_JSON_H_
+#define RUNNER_PARTIAL_JSON_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "json_value.h"
+
+struct JsonPathSegment {
+  bool is_index = false;
+  std::string key;
+  size_t index = 0;
+};
+
+using JsonPath = std::vector<JsonPathSegment>;
+
+// A field-level change produced while a document streams in.
+struct PartialJsonUpdate {
+  enum class Op {
+    kSet,       // |path| now holds |value|: a finished scalar, an empty
+                // string that is about to grow, or a newly opened container.
+    kAppend,    // |text| was appended to the string at |path|.
+    kComplete,  // The string or container at |path| is closed.
+  };
+
+  Op op = Op::kSet;
+  JsonPath path;
+  JsonValue value;
+  std::string text;
+};
+
+// Resumable JSON parser for documents that arrive in arbitrary fragments,
+// such as tool_use input_json_delta events. Each byte is examined once: the
+// parser keeps its lexer state between Feed() calls and grows a partial value
+// tree in place, so a delta costs time proportional to its own length rather
+// than to the accumulated document.
+class PartialJsonParser {
+ public:
+  PartialJsonParser() = default;
+
+  // Consumes the next fragment and appends the resulting updates. Consecutive
+  // string characters within one fragment produce a single kAppend. Returns
+  // false once the input is malformed; later calls are ignored.
+  bool Feed(const char* data, size_t size,
+            std::vector<PartialJsonUpdate>* updates);
+
+  // Signals end of input. A bare number at the root can only be closed here.
+  // Returns true if a complete document was parsed.
+  bool Finish(std::vector<PartialJsonUpdate>* updates);
+
+  bool complete() const { return state_ == State::kDone; }
+  bool failed() const { return state_ == State::kFailed; }
+  const std::string& error() const { return error_; }
+
+  // The value tree parsed so far; strings hold their received prefix.
+  const JsonValue& value() const { return root_; }
+
+ private:
+  enum class State {
+    kValue,            // Expecting a value.
+    kArrayFirst,       // After '[': a value or ']'.
+    kObjectFirst,      // After '{': a key or '}'.
+    kObjectKey,        // After ',' in an object.
+    kColon,            // After a key.
+    kCommaOrEnd,       // After a value inside a container.
+    kString,           // Inside a string value or key.
+    kEscape,           // After a backslash.
+    kUnicode,          // Inside \uXXXX.
+    kNumber,
+    kLiteral,          // true, false or null.
+    kDone,
+    kFailed,
+  };
+
+  bool Fail(const char* message);
+  // Places |value| at the next slot (root, array item or object member),
+  // extends path_ to it and returns a pointer to it.
+  JsonValue* BeginValue(JsonValue value,
+                        std::vector<PartialJsonUpdate>* updates);
+  // Leaves the value at path_ and returns to the enclosing container's state.
+  // |closed| emits kComplete for a string or container; scalars were already
+  // reported whole by BeginValue.
+  void EndValue(bool closed, std::vector<PartialJsonUpdate>* updates);
+  bool EndScalar(std::vector<PartialJsonUpdate>* updates);
+  // Emits the string text received since the last flush. Unless |closed|,
+  // a trailing partial UTF-8 sequence waits for the next fragment.
+  void FlushAppend(bool closed, std::vector<PartialJsonUpdate>* updates);
+  // Appends a UTF-16 code unit from a \u escape or a plain escape, pairing
+  // surrogates that may be split across fragments.
+  void AppendCodeUnit(uint32_t unit);
+  void DropLoneSurrogate();
+  std::string* StringTarget();
+
+  State state_ = State::kValue;
+  std::string error_;
+
+  JsonValue root_;
+  std::vector<JsonValue*> containers_;
+  JsonPath path_;
+
+  bool in_key_ = false;
+  std::string key_;
+  JsonValue* string_value_ = nullptr;
+  size_t append_start_ = 0;  // Length of the string at the last flush.
+
+  uint32_t unicode_ = 0;
+  int unicode_digits_ = 0;
+  uint32_t high_surrogate_ = 0;
+
+  std::string scalar_;  // Text of the number or literal being read.
+};
+
+// Encodes |updates| as a list of {op, path, value | text} objects, the form
+// sent to Dart.
+JsonValue PartialJsonUpdatesToJson(
+    const std::vector<PartialJsonUpdate>& updates);
+
+#endif  // RUNNER_PARTIAL_JSON_H_
@@ -0,0 +1,250 @@
+#include "paste_buffer.h"
+
+#include <gtk/gtk.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "json_value.h"
+#include "method_call_utils.h"
+#include "task_pool.h"
+#include "token_estimator.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/paste_buffer";
+
+// Text below both limits goes straight into the input field.
+const int64_t kDefaultThresholdBytes = 32 * 1024;
+const int64_t kDefaultThresholdLines = 500;
+const size_t kPreviewBytes = 80;
+
+// Pasted texts of this run, shared with readers that are still escaping a
+// chunk when the text is released.
+std::mutex g_texts_mutex;
+std::unordered_map<std::string, std::shared_ptr<const std::string>> g_texts;
+std::atomic<uint64_t> g_next_text{1};
+
+std::string MakePreview(const char* data, size_t size) {
+  const char* end = data + size;
+  const char* line = data;
+  while (line != end) {
+    const char* newline =
+        static_cast<const char*>(memchr(line, '\n', end - line));
+    const char* line_end = newline != nullptr ? newline : end;
+    const char* first = line;
+    while (first != line_end && g_ascii_isspace(*first)) {
+      ++first;
+    }
+    if (first != line_end) {
+      size_t length = std::min<size_t>(line_end - first, kPreviewBytes);
+      // Do not end inside a UTF-8 sequence.
+      if (first + length != line_end) {
+        while (length > 0 && (static_cast<unsigned char>(first[length]) &
+                              0xc0) == 0x80) {
+          --length;
+        }
+      }
+      std::string preview(first, length);
+      for (char& c : preview) {
+        if (static_cast<unsigned char>(c) < 0x20) {
+          c = ' ';
+        }
+      }
+      while (!preview.empty() && preview.back() == ' ') {
+        preview.pop_back();
+      }
+      return preview;
+    }
+    line = newline != nullptr ? newline + 1 : end;
+  }
+  return std::string();
+}
+
+}  // namespace
+
+uint64_t CountTextLines(const char* data, size_t size) {
+  uint64_t lines = 0;
+  const char* end = data + size;
+  for (const char* p = data; p != end; ++lines) {
+    const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+    p = newline != nullptr ? newline + 1 : end;
+  }
+  return lines;
+}
+
+PastedText StorePastedText(std::string text) {
+  PastedText pasted;
+  pasted.handle = "paste-" + std::to_string(getpid()) + "-" +
+                  std::to_string(g_next_text++);
+  pasted.bytes = text.size();
+  pasted.lines = CountTextLines(text.data(), text.size());
+  pasted.escaped_bytes = JsonStringContentsLength(text.data(), text.size());
+  pasted.tokens = EstimateTextTokens(text.data(), text.size());
+  pasted.preview = MakePreview(text.data(), text.size());
+
+  auto stored = std::make_shared<const std::string>(std::move(text));
+  std::lock_guard<std::mutex> lock(g_texts_mutex);
+  g_texts[pasted.handle] = std::move(stored);
+  return pasted;
+}
+
+bool ReadPastedTextEscaped(const std::string& handle, uint64_t offset,
+                           uint64_t length, std::string* out) {
+  std::shared_ptr<const std::string> text;
+  {
+    std::lock_guard<std::mutex> lock(g_texts_mutex);
+    auto it = g_texts.find(handle);
+    if (it == g_texts.end()) {
+      return false;
+    }
+    text = it->second;
+  }
+  if (offset >= text->size()) {
+    return true;
+  }
+  length = std::min<uint64_t>(length, text->size() - offset);
+  AppendJsonStringContents(out, text->data() + offset, length);
+  return true;
+}
+
+void ReleasePastedText(const std::string& handle) {
+  std::shared_ptr<const std::string> text;
+  std::lock_guard<std::mutex> lock(g_texts_mutex);
+  auto it = g_texts.find(handle);
+  if (it != g_texts.end()) {
+    // Freed outside the lock unless a reader still holds it.
+    text = std::move(it->second);
+    g_texts.erase(it);
+  }
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_paste_buffer_channel = nullptr;
+
+struct ReadRequest {
+  FlMethodCall* method_call;
+  int64_t threshold_bytes;
+  int64_t threshold_lines;
+};
+
+FlValue* PastedTextToValue(const PastedText& pasted) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "handle",
+                           fl_value_new_string(pasted.handle.c_str()));
+  fl_value_set_string_take(value, "bytes", fl_value_new_int(pasted.bytes));
+  fl_value_set_string_take(value, "lines", fl_value_new_int(pasted.lines));
+  fl_value_set_string_take(value, "escapedBytes",
+                           fl_value_new_int(pasted.escaped_bytes));
+  fl_value_set_string_take(value, "tokens", fl_value_new_int(pasted.tokens));
+  fl_value_set_string_take(value, "preview",
+                           fl_value_new_string(pasted.preview.c_str()));
+  return value;
+}
+
+// Runs on the main thread with the clipboard converted to UTF-8. Small text
+// is handed back for the input field as usual; only the copy of a large
+// text is made here, measuring it happens on the pool.
+void OnClipboardText(GtkClipboard* clipboard, const gchar* text,
+                     gpointer user_data) {
+  auto* request = static_cast<ReadRequest*>(user_data);
+  if (text == nullptr) {
+    RespondSuccess(request->method_call, fl_value_new_null());
+    g_object_unref(request->method_call);
+    delete request;
+    return;
+  }
+
+  const size_t size = strlen(text);
+  if (static_cast<int64_t>(size) < request->threshold_bytes &&
+      static_cast<int64_t>(CountTextLines(text, size)) <
+          request->threshold_lines) {
+    FlValue* value = fl_value_new_map();
+    fl_value_set_string_take(value, "text",
+                             fl_value_new_string_sized(text, size));
+    RespondSuccess(request->method_call, value);
+    g_object_unref(request->method_call);
+    delete request;
+    return;
+  }
+
+  auto copy = std::make_shared<std::string>(text, size);
+  TaskPool::Get().Post([request, copy]() {
+    auto pasted =
+        std::make_shared<PastedText>(StorePastedText(std::move(*copy)));
+    RunOnMainThread([request, pasted]() {
+      FlValue* value = fl_value_new_map();
+      fl_value_set_string_take(value, "attachment",
+                               PastedTextToValue(*pasted));
+      RespondSuccess(request->method_call, value);
+      g_object_unref(request->method_call);
+      delete request;
+    });
+  });
+}
+
+void HandlePasteBufferCall(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method == "readText") {
+    auto* request = new ReadRequest{
+        method_call,
+        LookupIntArg(args, "thresholdBytes", kDefaultThresholdBytes),
+        LookupIntArg(args, "thresholdLines", kDefaultThresholdLines)};
+    g_object_ref(method_call);
+    gtk_clipboard_request_text(gtk_clipboard_get(GDK_SELECTION_CLIPBOARD),
+                               OnClipboardText, request);
+  } else if (method == "readChunk") {
+    const std::string handle = LookupStringArg(args, "handle");
+    const int64_t offset = LookupIntArg(args, "offset", 0);
+    const int64_t length = LookupIntArg(args, "length", 0);
+    if (handle.empty() || offset < 0 || length <= 0) {
+      RespondError(method_call, "INVALID_ARGUMENTS",
+                   "handle, offset and length are required");
+      return;
+    }
+    g_object_ref(method_call);
+    TaskPool::Get().Post([method_call, handle, offset, length]() {
+      auto chunk = std::make_shared<std::string>();
+      const bool ok =
+          ReadPastedTextEscaped(handle, offset, length, chunk.get());
+      RunOnMainThread([method_call, handle, chunk, ok]() {
+        if (ok) {
+          RespondSuccess(method_call,
+                         fl_value_new_uint8_list(
+                             reinterpret_cast<const uint8_t*>(chunk->data()),
+                             chunk->size()));
+        } else {
+          RespondError(method_call, "PASTE_BUFFER_ERROR",
+                       "Unknown pasted text " + handle);
+        }
+        g_object_unref(method_call);
+      });
+    });
+  } else if (method == "release") {
+    ReleasePastedText(LookupStringArg(args, "handle"));
+    RespondSuccess(method_call, nullptr);
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+}  // namespace
+
+void RegisterPasteBufferChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_paste_buffer_channel = fl_method_channel_new(messenger, kChannelName,
+                                                 FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_paste_buffer_channel, HandlePasteBufferCall, nullptr, nullptr);
+}
@@ -0,0 +1,42 @@
+#ifndef RUNNER_PASTE_BUFFER_H_
+#define RUNNER_PASTE_BUFFER_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+#include <string>
+
+// Clipboard text too large for the input field. The text stays in the
+// runner; Dart shows a chip built from these counts and only pulls the
+// content, already JSON-escaped, while writing the request body.
+struct PastedText {
+  std::string handle;
+  uint64_t bytes = 0;
+  uint64_t lines = 0;
+  // Length of the text once escaped for a JSON string literal.
+  uint64_t escaped_bytes = 0;
+  uint64_t tokens = 0;
+  // The first non-blank line, cut to a short UTF-8 prefix.
+  std::string preview;
+};
+
+// Number of lines in |data|; a trailing line without a newline counts.
+uint64_t CountTextLines(const char* data, size_t size);
+
+// Measures |text| and keeps it under a new handle. Safe to call from a
+// worker thread.
+PastedText StorePastedText(std::string text);
+
+// Appends the JSON string escape of bytes [offset, offset + length) of the
+// pasted text |handle| to |out|. The range is clamped to the text. Returns
+// false if the handle is unknown.
+bool ReadPastedTextEscaped(const std::string& handle, uint64_t offset,
+                           uint64_t length, std::string* out);
+
+// Drops the pasted text. Unknown handles are ignored.
+void ReleasePastedText(const std::string& handle);
+
+// Registers the "com.codeagenthub/paste_buffer" method channel.
+void RegisterPasteBufferChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_PASTE_BUFFER_H_
@@ -0,0 +1,305 @@
+#include "power_policy.h"
+
+#include <gio/gio.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/power_policy";
+const char kEventChannelName[] = "com.codeagenthub/power_policy_events";
+const char kStateFileEnv[] = "CODEAGENTHUB_POWER_STATE";
+const char kStateGroup[] = "power";
+
+// power-profiles-daemon is reachable under its current name and, on older
+// systems, only under the original one.
+const char* const kProfilesServices[][2] = {
+    {"org.freedesktop.UPower.PowerProfiles",
+     "/org/freedesktop/UPower/PowerProfiles"},
+    {"net.hadess.PowerProfiles", "/net/hadess/PowerProfiles"},
+};
+
+std::mutex g_policy_mutex;
+PowerPolicy g_policy;
+bool g_policy_applied = false;
+
+// Inputs; only touched on the main thread.
+bool g_on_battery = false;
+std::string g_profile;
+
+GDBusProxy* g_upower_proxy = nullptr;
+GDBusProxy* g_profiles_proxy = nullptr;
+GFileMonitor* g_state_monitor = nullptr;
+
+FlEventChannel* g_power_events_channel = nullptr;
+bool g_power_events_listening = false;
+
+const char* PowerLevelName(PowerLevel level) {
+  switch (level) {
+    case PowerLevel::kFull:
+      return "full";
+    case PowerLevel::kBalanced:
+      return "balanced";
+    case PowerLevel::kSaver:
+      return "saver";
+  }
+  return "full";
+}
+
+FlValue* PowerPolicyToFlValue(const PowerPolicy& policy) {
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "onBattery",
+                           fl_value_new_bool(policy.on_battery));
+  fl_value_set_string_take(result, "profile",
+                           fl_value_new_string(policy.profile.c_str()));
+  fl_value_set_string_take(result, "level",
+                           fl_value_new_string(PowerLevelName(policy.level)));
+  fl_value_set_string_take(result, "streamCoalesceMs",
+                           fl_value_new_int(policy.stream_coalesce_ms));
+  fl_value_set_string_take(result, "refreshIntervalScale",
+                           fl_value_new_float(policy.refresh_interval_scale));
+  return result;
+}
+
+// Recomputes the policy from the current inputs and, if it changed, applies
+// it to the task pool and tells Dart.
+void UpdatePolicy() {
+  const PowerPolicy policy = ComputePowerPolicy(g_on_battery, g_profile);
+  {
+    std::lock_guard<std::mutex> lock(g_policy_mutex);
+    if (g_policy_applied && g_policy.on_battery == policy.on_battery &&
+        g_policy.profile == policy.profile) {
+      return;
+    }
+    g_policy = policy;
+    g_policy_applied = true;
+  }
+  TaskPool::Get().SetBackgroundLimits(policy.background_threads,
+                                      policy.level != PowerLevel::kFull);
+  if (g_power_events_listening) {
+    g_autoptr(FlValue) event = PowerPolicyToFlValue(policy);
+    g_autoptr(GError) error = nullptr;
+    if (!fl_event_channel_send(g_power_events_channel, event, nullptr,
+                               &error)) {
+      g_warning("Failed to send power policy: %s", error->message);
+    }
+  }
+}
+
+// UPower and power-profiles-daemon.
+
+void ReadOnBattery() {
+  g_autoptr(GVariant) value =
+      g_dbus_proxy_get_cached_property(g_upower_proxy, "OnBattery");
+  if (value != nullptr &&
+      g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN)) {
+    g_on_battery = g_variant_get_boolean(value);
+  }
+}
+
+void ReadActiveProfile() {
+  g_autoptr(GVariant) value =
+      g_dbus_proxy_get_cached_property(g_profiles_proxy, "ActiveProfile");
+  if (value != nullptr && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)) {
+    g_profile = g_variant_get_string(value, nullptr);
+  }
+}
+
+void OnUPowerPropertiesChanged(GDBusProxy* proxy, GVariant* changed,
+                               GStrv invalidated, gpointer user_data) {
+  ReadOnBattery();
+  UpdatePolicy();
+}
+
+void OnProfilesPropertiesChanged(GDBusProxy* proxy, GVariant* changed,
+                                 GStrv invalidated, gpointer user_data) {
+  ReadActiveProfile();
+  UpdatePolicy();
+}
+
+void OnUPowerProxyReady(GObject* source, GAsyncResult* result,
+                        gpointer user_data) {
+  g_autoptr(GError) error = nullptr;
+  g_upower_proxy = g_dbus_proxy_new_for_bus_finish(result, &error);
+  if (g_upower_proxy == nullptr) {
+    g_debug("UPower unavailable: %s", error->message);
+    return;
+  }
+  g_signal_connect(g_upower_proxy, "g-properties-changed",
+                   G_CALLBACK(OnUPowerPropertiesChanged), nullptr);
+  ReadOnBattery();
+  UpdatePolicy();
+}
+
+void ConnectPowerProfiles(size_t service);
+
+void OnProfilesProxyReady(GObject* source, GAsyncResult* result,
+                          gpointer user_data) {
+  const size_t service = GPOINTER_TO_SIZE(user_data);
+  g_autoptr(GError) error = nullptr;
+  GDBusProxy* proxy = g_dbus_proxy_new_for_bus_finish(result, &error);
+  g_autofree gchar* owner =
+      proxy != nullptr ? g_dbus_proxy_get_name_owner(proxy) : nullptr;
+  if (owner == nullptr) {
+    g_clear_object(&proxy);
+    if (service + 1 < G_N_ELEMENTS(kProfilesServices)) {
+      ConnectPowerProfiles(service + 1);
+    }
+    return;
+  }
+  g_profiles_proxy = proxy;
+  g_signal_connect(g_profiles_proxy, "g-properties-changed",
+                   G_CALLBACK(OnProfilesPropertiesChanged), nullptr);
+  ReadActiveProfile();
+  UpdatePolicy();
+}
+
+void ConnectPowerProfiles(size_t service) {
+  const char* name = kProfilesServices[service][0];
+  g_dbus_proxy_new_for_bus(G_BUS_TYPE_SYSTEM, G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+                           nullptr, name, kProfilesServices[service][1], name,
+                           nullptr, OnProfilesProxyReady,
+                           GSIZE_TO_POINTER(service));
+}
+
+// File stand-in for tests.
+
+void ReadStateFile(const char* path) {
+  g_autoptr(GKeyFile) key_file = g_key_file_new();
+  g_on_battery = false;
+  g_profile.clear();
+  if (!g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, nullptr)) {
+    return;
+  }
+  g_on_battery =
+      g_key_file_get_boolean(key_file, kStateGroup, "on_battery", nullptr);
+  g_autofree gchar* profile =
+      g_key_file_get_string(key_file, kStateGroup, "profile", nullptr);
+  if (profile != nullptr) {
+    g_profile = profile;
+  }
+}
+
+void OnStateFileChanged(GFileMonitor* monitor, GFile* file, GFile* other_file,
+                        GFileMonitorEvent event, gpointer user_data) {
+  if (event != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT &&
+      event != G_FILE_MONITOR_EVENT_CREATED &&
+      event != G_FILE_MONITOR_EVENT_DELETED) {
+    return;
+  }
+  g_autofree gchar* path = g_file_get_path(file);
+  ReadStateFile(path);
+  UpdatePolicy();
+}
+
+void StartTracking() {
+  const gchar* state_file = g_getenv(kStateFileEnv);
+  if (state_file != nullptr && state_file[0] != '\0') {
+    ReadStateFile(state_file);
+    g_autoptr(GFile) file = g_file_new_for_path(state_file);
+    g_autoptr(GError) error = nullptr;
+    g_state_monitor =
+        g_file_monitor_file(file, G_FILE_MONITOR_NONE, nullptr, &error);
+    if (g_state_monitor == nullptr) {
+      g_warning("Cannot watch %s: %s", state_file, error->message);
+    } else {
+      g_signal_connect(g_state_monitor, "changed",
+                       G_CALLBACK(OnStateFileChanged), nullptr);
+    }
+    UpdatePolicy();
+    return;
+  }
+
+  // Until the bus answers, assume mains power.
+  UpdatePolicy();
+  g_dbus_proxy_new_for_bus(G_BUS_TYPE_SYSTEM, G_DBUS_PROXY_FLAGS_NONE, nullptr,
+                           "org.freedesktop.UPower", "/org/freedesktop/UPower",
+                           "org.freedesktop.UPower", nullptr,
+                           OnUPowerProxyReady, nullptr);
+  ConnectPowerProfiles(0);
+}
+
+}  // namespace
+
+PowerPolicy ComputePowerPolicy(bool on_battery, const std::string& profile) {
+  PowerPolicy policy;
+  policy.on_battery = on_battery;
+  policy.profile = profile;
+  if (profile == "power-saver") {
+    policy.level = PowerLevel::kSaver;
+  } else if (on_battery && profile != "performance") {
+    policy.level = PowerLevel::kBalanced;
+  }
+
+  const size_t threads = TaskPool::Get().thread_count();
+  switch (policy.level) {
+    case PowerLevel::kFull:
+      break;
+    case PowerLevel::kBalanced:
+      policy.stream_coalesce_ms = 50;
+      policy.refresh_interval_scale = 2.0;
+      policy.background_threads = std::max<size_t>(threads / 2, 1);
+      break;
+    case PowerLevel::kSaver:
+      policy.stream_coalesce_ms = 150;
+      policy.refresh_interval_scale = 4.0;
+      policy.background_threads = 1;
+      break;
+  }
+  return policy;
+}
+
+PowerPolicy CurrentPowerPolicy() {
+  std::lock_guard<std::mutex> lock(g_policy_mutex);
+  return g_policy;
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_power_policy_channel = nullptr;
+
+void HandlePowerPolicyCall(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  if (method == "getPolicy") {
+    RespondSuccess(method_call, PowerPolicyToFlValue(CurrentPowerPolicy()));
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+FlMethodErrorResponse* OnPowerEventsListen(FlEventChannel* channel,
+                                           FlValue* args, gpointer user_data) {
+  g_power_events_listening = true;
+  return nullptr;
+}
+
+FlMethodErrorResponse* OnPowerEventsCancel(FlEventChannel* channel,
+                                           FlValue* args, gpointer user_data) {
+  g_power_events_listening = false;
+  return nullptr;
+}
+
+}  // namespace
+
+void RegisterPowerPolicyChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_power_policy_channel = fl_method_channel_new(messenger, kChannelName,
+                                                 FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_power_policy_channel, HandlePowerPolicyCall, nullptr, nullptr);
+
+  g_power_events_channel = fl_event_channel_new(messenger, kEventChannelName,
+                                                FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(g_power_events_channel,
+                                       OnPowerEventsListen, OnPowerEventsCancel,
+                                       nullptr, nullptr);
+
+  StartTracking();
+}
@@ -0,0 +1,48 @@
+#ifndef RUNNER_POWER_POLICY_H_
+#define RUNNER_POWER_POLICY_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <string>
+
+enum class PowerLevel {
+  kFull,      // On mains power, or the performance profile.
+  kBalanced,  // On battery with the balanced profile.
+  kSaver,     // The power-saver profile, on battery or not.
+};
+
+// How hard the app should work given the power source and profile. Dart
+// reads the rates; the runner applies the scheduling part to TaskPool.
+struct PowerPolicy {
+  bool on_battery = false;
+  std::string profile;  // power-profiles-daemon profile, empty if unknown.
+  PowerLevel level = PowerLevel::kFull;
+
+  // Minimum spacing of partial message updates while a reply streams.
+  int stream_coalesce_ms = 0;
+  // Multiplier applied to periodic refresh intervals.
+  double refresh_interval_scale = 1.0;
+  // Background work runs as SCHED_BATCH on at most this many pool threads;
+  // 0 means no limit.
+  size_t background_threads = 0;
+};
+
+PowerPolicy ComputePowerPolicy(bool on_battery, const std::string& profile);
+
+// The policy currently in force. Safe to call from any thread.
+PowerPolicy CurrentPowerPolicy();
+
+// Starts tracking the power source through UPower and the active profile
+// through power-profiles-daemon, on the system bus. When the environment
+// variable CODEAGENTHUB_POWER_STATE names a key file, that file is watched
+// instead, so tests can drive the policy:
+//
+//   [power]
+//   on_battery=true
+//   profile=power-saver
+//
+// Registers the "com.codeagenthub/power_policy" method channel and the
+// "com.codeagenthub/power_policy_events" event channel.
+void RegisterPowerPolicyChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_POWER_POLICY_H_
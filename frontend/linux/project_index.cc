@@ -0,0 +1,358 @@
+#include "project_index.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "iso_timestamp.h"
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/project_index";
+
+bool Newer(const ProjectIndex::Session& a, const ProjectIndex::Session& b) {
+  if (a.updated_at != b.updated_at) {
+    return a.updated_at > b.updated_at;
+  }
+  return a.id < b.id;
+}
+
+std::string LastPathComponent(const std::string& path) {
+  const size_t separator = path.find_last_of("/\\");
+  return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+}  // namespace
+
+ProjectIndex& ProjectIndex::Get(const std::string& name) {
+  static std::mutex* mutex = new std::mutex();
+  static auto* indexes =
+      new std::map<std::string, std::unique_ptr<ProjectIndex>>();
+  std::lock_guard<std::mutex> lock(*mutex);
+  std::unique_ptr<ProjectIndex>& index = (*indexes)[name];
+  if (!index) {
+    index = std::make_unique<ProjectIndex>();
+  }
+  return *index;
+}
+
+bool ProjectIndex::Replace(const JsonValue& sessions, Changes* changes,
+                           std::string* error) {
+  if (!sessions.is_array()) {
+    *error = "session list is not an array";
+    return false;
+  }
+  std::vector<Session> incoming;
+  incoming.reserve(sessions.items().size());
+  for (const JsonValue& item : sessions.items()) {
+    const JsonValue& id = item["session_id"];
+    const JsonValue& cwd = item["cwd"];
+    if (!id.is_string() || !cwd.is_string()) {
+      *error = "session without session_id or cwd";
+      return false;
+    }
+    Session session;
+    session.id = id.AsString();
+    session.cwd = cwd.AsString();
+    session.title = item["title"].AsString();
+    session.message_count = item["message_count"].AsInt(0);
+    if (!ParseIsoTimestamp(item["created_at"].AsString(),
+                           &session.created_at) ||
+        !ParseIsoTimestamp(item["updated_at"].AsString(),
+                           &session.updated_at)) {
+      *error = "invalid timestamp in session " + session.id;
+      return false;
+    }
+    incoming.push_back(std::move(session));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t generation = ++generation_;
+  *changes = Changes();
+  for (Session& session : incoming) {
+    auto found = sessions_.find(session.id);
+    if (found == sessions_.end()) {
+      auto entry = std::make_unique<Entry>();
+      entry->session = std::move(session);
+      entry->generation = generation;
+      Insert(entry.get());
+      const std::string id = entry->session.id;
+      sessions_.emplace(id, std::move(entry));
+      ++changes->added;
+      continue;
+    }
+    Entry* entry = found->second.get();
+    entry->generation = generation;
+    const Session& current = entry->session;
+    if (current.cwd == session.cwd && current.title == session.title &&
+        current.created_at == session.created_at &&
+        current.updated_at == session.updated_at &&
+        current.message_count == session.message_count) {
+      continue;
+    }
+    Erase(entry);
+    entry->session = std::move(session);
+    Insert(entry);
+    ++changes->updated;
+  }
+  for (auto it = sessions_.begin(); it != sessions_.end();) {
+    if (it->second->generation == generation) {
+      ++it;
+      continue;
+    }
+    Erase(it->second.get());
+    it = sessions_.erase(it);
+    ++changes->removed;
+  }
+  return true;
+}
+
+std::vector<ProjectIndex::Project> ProjectIndex::Projects() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Project> projects;
+  projects.reserve(projects_.size());
+  for (auto& project : projects_) {
+    projects.push_back(Summarize(project.first, &project.second));
+  }
+  std::sort(projects.begin(), projects.end(),
+            [](const Project& a, const Project& b) {
+              if (a.last_active_at != b.last_active_at) {
+                return a.last_active_at > b.last_active_at;
+              }
+              return a.path < b.path;
+            });
+  return projects;
+}
+
+bool ProjectIndex::FindProject(const std::string& path, Project* project) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = projects_.find(path);
+  if (found == projects_.end()) {
+    return false;
+  }
+  *project = Summarize(path, &found->second);
+  return true;
+}
+
+int64_t ProjectIndex::ProjectSessions(const std::string& path, int64_t offset,
+                                      int64_t limit,
+                                      std::vector<Session>* sessions) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = projects_.find(path);
+  if (found == projects_.end()) {
+    return 0;
+  }
+  const std::vector<const Entry*>& entries = found->second.sessions;
+  const size_t begin =
+      static_cast<size_t>(std::clamp<int64_t>(
+          offset, 0, static_cast<int64_t>(entries.size())));
+  const size_t end =
+      limit < 0 ? entries.size()
+                : begin + std::min<size_t>(static_cast<size_t>(limit),
+                                           entries.size() - begin);
+  sessions->reserve(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    sessions->push_back(entries[i]->session);
+  }
+  return static_cast<int64_t>(entries.size());
+}
+
+void ProjectIndex::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  projects_.clear();
+  sessions_.clear();
+}
+
+void ProjectIndex::Insert(const Entry* entry) {
+  ProjectEntry& project = projects_[entry->session.cwd];
+  auto position = std::lower_bound(
+      project.sessions.begin(), project.sessions.end(), entry,
+      [](const Entry* a, const Entry* b) {
+        return Newer(a->session, b->session);
+      });
+  project.sessions.insert(position, entry);
+  project.message_count += entry->session.message_count;
+  if (project.sessions.size() == 1) {
+    project.created_at = entry->session.created_at;
+    project.created_at_valid = true;
+  } else if (project.created_at_valid &&
+             entry->session.created_at < project.created_at) {
+    project.created_at = entry->session.created_at;
+  }
+}
+
+void ProjectIndex::Erase(const Entry* entry) {
+  auto found = projects_.find(entry->session.cwd);
+  if (found == projects_.end()) {
+    return;
+  }
+  ProjectEntry& project = found->second;
+  auto position = std::lower_bound(
+      project.sessions.begin(), project.sessions.end(), entry,
+      [](const Entry* a, const Entry* b) {
+        return Newer(a->session, b->session);
+      });
+  if (position == project.sessions.end() || *position != entry) {
+    return;
+  }
+  project.sessions.erase(position);
+  if (project.sessions.empty()) {
+    projects_.erase(found);
+    return;
+  }
+  project.message_count -= entry->session.message_count;
+  if (entry->session.created_at == project.created_at) {
+    project.created_at_valid = false;
+  }
+}
+
+ProjectIndex::Project ProjectIndex::Summarize(const std::string& path,
+                                              ProjectEntry* project) {
+  if (!project->created_at_valid) {
+    project->created_at = project->sessions.front()->session.created_at;
+    for (const Entry* entry : project->sessions) {
+      project->created_at =
+          std::min(project->created_at, entry->session.created_at);
+    }
+    project->created_at_valid = true;
+  }
+  Project summary;
+  summary.path = path;
+  summary.name = LastPathComponent(path);
+  summary.session_count = static_cast<int64_t>(project->sessions.size());
+  summary.message_count = project->message_count;
+  summary.created_at = project->created_at;
+  summary.last_active_at = project->sessions.front()->session.updated_at;
+  return summary;
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_project_index_channel = nullptr;
+
+FlValue* ProjectToFlValue(const ProjectIndex::Project& project) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "path",
+                           fl_value_new_string(project.path.c_str()));
+  fl_value_set_string_take(value, "name",
+                           fl_value_new_string(project.name.c_str()));
+  fl_value_set_string_take(value, "sessionCount",
+                           fl_value_new_int(project.session_count));
+  fl_value_set_string_take(value, "messageCount",
+                           fl_value_new_int(project.message_count));
+  fl_value_set_string_take(value, "createdAt",
+                           fl_value_new_int(project.created_at));
+  fl_value_set_string_take(value, "lastActiveAt",
+                           fl_value_new_int(project.last_active_at));
+  return value;
+}
+
+FlValue* SessionToFlValue(const ProjectIndex::Session& session) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "id",
+                           fl_value_new_string(session.id.c_str()));
+  fl_value_set_string_take(value, "cwd",
+                           fl_value_new_string(session.cwd.c_str()));
+  fl_value_set_string_take(value, "title",
+                           fl_value_new_string(session.title.c_str()));
+  fl_value_set_string_take(value, "createdAt",
+                           fl_value_new_int(session.created_at));
+  fl_value_set_string_take(value, "updatedAt",
+                           fl_value_new_int(session.updated_at));
+  fl_value_set_string_take(value, "messageCount",
+                           fl_value_new_int(session.message_count));
+  return value;
+}
+
+void HandleReplace(FlMethodCall* method_call, const std::string& name,
+                   FlValue* args) {
+  FlValue* body = args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+                      ? fl_value_lookup_string(args, "sessions")
+                      : nullptr;
+  if (body == nullptr || fl_value_get_type(body) != FL_VALUE_TYPE_STRING) {
+    RespondError(method_call, "INVALID_ARGUMENTS",
+                 "sessions JSON string is required");
+    return;
+  }
+  auto text = std::make_shared<std::string>(fl_value_get_string(body));
+  g_object_ref(method_call);
+  TaskPool::Get().Post([method_call, name, text]() {
+    JsonValue sessions;
+    ProjectIndex::Changes changes;
+    std::string error;
+    const bool ok = ParseJson(*text, &sessions, &error) &&
+                    ProjectIndex::Get(name).Replace(sessions, &changes,
+                                                    &error);
+    RunOnMainThread([method_call, ok, changes, error]() {
+      if (!ok) {
+        RespondError(method_call, "INVALID_SESSIONS", error);
+      } else {
+        FlValue* result = fl_value_new_map();
+        fl_value_set_string_take(result, "added",
+                                 fl_value_new_int(changes.added));
+        fl_value_set_string_take(result, "updated",
+                                 fl_value_new_int(changes.updated));
+        fl_value_set_string_take(result, "removed",
+                                 fl_value_new_int(changes.removed));
+        RespondSuccess(method_call, result);
+      }
+      g_object_unref(method_call);
+    });
+  });
+}
+
+void HandleProjectIndexCall(FlMethodChannel* channel,
+                            FlMethodCall* method_call, gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+  const std::string name = LookupStringArg(args, "index", "claude");
+
+  if (method == "replace") {
+    HandleReplace(method_call, name, args);
+  } else if (method == "projects") {
+    FlValue* result = fl_value_new_list();
+    for (const auto& project : ProjectIndex::Get(name).Projects()) {
+      fl_value_append_take(result, ProjectToFlValue(project));
+    }
+    RespondSuccess(method_call, result);
+  } else if (method == "project") {
+    ProjectIndex::Project project;
+    RespondSuccess(method_call, ProjectIndex::Get(name).FindProject(
+                                    LookupStringArg(args, "path"), &project)
+                                    ? ProjectToFlValue(project)
+                                    : fl_value_new_null());
+  } else if (method == "sessions") {
+    std::vector<ProjectIndex::Session> sessions;
+    const int64_t total = ProjectIndex::Get(name).ProjectSessions(
+        LookupStringArg(args, "path"), LookupIntArg(args, "offset", 0),
+        LookupIntArg(args, "limit", -1), &sessions);
+    FlValue* list = fl_value_new_list();
+    for (const auto& session : sessions) {
+      fl_value_append_take(list, SessionToFlValue(session));
+    }
+    FlValue* result = fl_value_new_map();
+    fl_value_set_string_take(result, "total", fl_value_new_int(total));
+    fl_value_set_string_take(result, "sessions", list);
+    RespondSuccess(method_call, result);
+  } else if (method == "clear") {
+    ProjectIndex::Get(name).Clear();
+    RespondSuccess(method_call, nullptr);
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+}  // namespace
+
+void RegisterProjectIndexChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_project_index_channel = fl_method_channel_new(
+      messenger, kChannelName, FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_project_index_channel, HandleProjectIndexCall, nullptr, nullptr);
+}
@@ -0,0 +1,94 @@
+#ifndef RUNNER_PROJECT_INDEX_H_
+#define RUNNER_PROJECT_INDEX_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "json_value.h"
+
+// The backend's session list grouped into projects by working directory.
+// Every project keeps its sessions sorted by last update, newest first, and
+// its aggregates up to date, so a project query only touches that project.
+// Replace() patches the index from a newly fetched list: only sessions that
+// were added, changed or dropped are moved. Thread-safe.
+class ProjectIndex {
+ public:
+  struct Session {
+    std::string id;
+    std::string cwd;
+    std::string title;
+    int64_t created_at = 0;  // Microseconds since the epoch.
+    int64_t updated_at = 0;
+    int64_t message_count = 0;
+  };
+
+  struct Project {
+    std::string path;
+    std::string name;  // Last path component.
+    int64_t session_count = 0;
+    int64_t message_count = 0;
+    int64_t created_at = 0;      // Earliest session creation.
+    int64_t last_active_at = 0;  // Latest session update.
+  };
+
+  struct Changes {
+    int64_t added = 0;
+    int64_t updated = 0;
+    int64_t removed = 0;
+  };
+
+  // Returns the index named |name| ("claude", "codex"), creating it empty.
+  static ProjectIndex& Get(const std::string& name);
+
+  // Makes the index hold exactly |sessions|, the array GET /sessions returns.
+  // Fails without changing anything if an entry has no session id or cwd, or
+  // a timestamp that does not parse.
+  bool Replace(const JsonValue& sessions, Changes* changes,
+               std::string* error);
+
+  // All projects, most recently active first.
+  std::vector<Project> Projects();
+
+  bool FindProject(const std::string& path, Project* project);
+
+  // Copies up to |limit| sessions of project |path| (all if negative),
+  // newest first, skipping |offset|. Returns the project's session count.
+  int64_t ProjectSessions(const std::string& path, int64_t offset,
+                          int64_t limit, std::vector<Session>* sessions);
+
+  void Clear();
+
+ private:
+  struct Entry {
+    Session session;
+    uint64_t generation = 0;  // Last Replace() that listed the session.
+  };
+
+  struct ProjectEntry {
+    std::vector<const Entry*> sessions;  // Newest update first, then by id.
+    int64_t message_count = 0;
+    // Earliest creation; recomputed lazily after that session leaves.
+    int64_t created_at = 0;
+    bool created_at_valid = false;
+  };
+
+  void Insert(const Entry* entry);
+  void Erase(const Entry* entry);
+  Project Summarize(const std::string& path, ProjectEntry* project);
+
+  std::mutex mutex_;
+  uint64_t generation_ = 0;
+  std::unordered_map<std::string, std::unique_ptr<Entry>> sessions_;
+  std::unordered_map<std::string, ProjectEntry> projects_;
+};
+
+// Registers the "com.codeagenthub/project_index" method channel.
+void RegisterProjectIndexChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_PROJECT_INDEX_H_
@@ -0,0 +1,231 @@
+#include "resident_mode.h"
+
+#include <string>
+
+#include "method_call_utils.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/residency";
+const char kSettingsGroup[] = "window";
+const char kResidentKey[] = "resident";
+
+GtkWindow* g_window = nullptr;
+bool g_resident = false;
+bool g_hidden = false;
+// Set between "Quit" in the status icon menu and the delete-event it causes,
+// so that one close goes through to the Dart side (which asks about stopping
+// the backend) instead of hiding. The event consumes it: if the quit is
+// cancelled there, the close button hides to the tray again.
+bool g_quitting = false;
+
+FlBasicMessageChannel* g_lifecycle_channel = nullptr;
+FlBasicMessageChannel* g_system_channel = nullptr;
+GtkStatusIcon* g_status_icon = nullptr;
+GtkWidget* g_status_menu = nullptr;
+
+std::string SettingsPath() {
+  g_autofree gchar* path = g_build_filename(
+      g_get_user_config_dir(), "codeagenthub", "runner.ini", nullptr);
+  return path;
+}
+
+bool SaveResidentModeSetting(bool resident, std::string* error) {
+  const std::string path = SettingsPath();
+  g_autofree gchar* dir = g_path_get_dirname(path.c_str());
+  if (g_mkdir_with_parents(dir, 0700) != 0) {
+    *error = std::string("Cannot create ") + dir;
+    return false;
+  }
+  g_autoptr(GKeyFile) key_file = g_key_file_new();
+  // Keep whatever else is in the file.
+  g_key_file_load_from_file(key_file, path.c_str(), G_KEY_FILE_KEEP_COMMENTS,
+                            nullptr);
+  g_key_file_set_boolean(key_file, kSettingsGroup, kResidentKey, resident);
+  g_autoptr(GError) save_error = nullptr;
+  if (!g_key_file_save_to_file(key_file, path.c_str(), &save_error)) {
+    *error = save_error->message;
+    return false;
+  }
+  return true;
+}
+
+void SendLifecycleState(const char* state) {
+  if (g_lifecycle_channel == nullptr) {
+    return;
+  }
+  g_autoptr(FlValue) message = fl_value_new_string(state);
+  fl_basic_message_channel_send(g_lifecycle_channel, message, nullptr, nullptr,
+                                nullptr);
+}
+
+// Same message the framework receives from the OS on low memory: image
+// caches and other purgeable state are released.
+void SendMemoryPressure() {
+  if (g_system_channel == nullptr) {
+    return;
+  }
+  g_autoptr(FlValue) message = fl_value_new_map();
+  fl_value_set_string_take(message, "type",
+                           fl_value_new_string("memoryPressure"));
+  fl_basic_message_channel_send(g_system_channel, message, nullptr, nullptr,
+                                nullptr);
+}
+
+void QuitFromStatusIcon() {
+  if (g_window == nullptr) {
+    return;
+  }
+  g_quitting = true;
+  PresentResidentWindow();
+  gtk_window_close(g_window);
+}
+
+void OnShowActivated(GtkMenuItem* item, gpointer user_data) {
+  PresentResidentWindow();
+}
+
+void OnQuitActivated(GtkMenuItem* item, gpointer user_data) {
+  QuitFromStatusIcon();
+}
+
+void OnStatusIconActivate(GtkStatusIcon* status_icon, gpointer user_data) {
+  PresentResidentWindow();
+}
+
+void OnStatusIconPopupMenu(GtkStatusIcon* status_icon, guint button,
+                           guint activate_time, gpointer user_data) {
+  if (g_status_menu == nullptr) {
+    g_status_menu = gtk_menu_new();
+    GtkWidget* show_item = gtk_menu_item_new_with_label("Show CodeAgent Hub");
+    GtkWidget* quit_item = gtk_menu_item_new_with_label("Quit");
+    g_signal_connect(show_item, "activate", G_CALLBACK(OnShowActivated),
+                     nullptr);
+    g_signal_connect(quit_item, "activate", G_CALLBACK(OnQuitActivated),
+                     nullptr);
+    gtk_menu_shell_append(GTK_MENU_SHELL(g_status_menu), show_item);
+    gtk_menu_shell_append(GTK_MENU_SHELL(g_status_menu), quit_item);
+    gtk_widget_show_all(g_status_menu);
+  }
+  gtk_menu_popup_at_pointer(GTK_MENU(g_status_menu), nullptr);
+}
+
+// GtkStatusIcon is deprecated but is the only tray entry GTK 3 offers
+// without an extra dependency. Desktops without a tray still get the window
+// back by relaunching the application.
+void ShowStatusIcon(bool visible) {
+  G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+  if (g_status_icon == nullptr) {
+    if (!visible) {
+      return;
+    }
+    const gchar* icon_name = gtk_window_get_icon_name(g_window);
+    g_status_icon = gtk_status_icon_new_from_icon_name(
+        icon_name != nullptr ? icon_name : "application-x-executable");
+    gtk_status_icon_set_tooltip_text(g_status_icon, "CodeAgent Hub");
+    g_signal_connect(g_status_icon, "activate",
+                     G_CALLBACK(OnStatusIconActivate), nullptr);
+    g_signal_connect(g_status_icon, "popup-menu",
+                     G_CALLBACK(OnStatusIconPopupMenu), nullptr);
+  }
+  gtk_status_icon_set_visible(g_status_icon, visible);
+  G_GNUC_END_IGNORE_DEPRECATIONS
+}
+
+gboolean OnDeleteEvent(GtkWidget* widget, GdkEvent* event,
+                       gpointer user_data) {
+  if (g_quitting) {
+    g_quitting = false;
+    return FALSE;
+  }
+  if (!g_resident) {
+    return FALSE;
+  }
+  // The hidden window keeps the GtkApplication alive.
+  gtk_widget_hide(widget);
+  g_hidden = true;
+  SendLifecycleState("AppLifecycleState.paused");
+  SendMemoryPressure();
+  ShowStatusIcon(true);
+  return TRUE;
+}
+
+}  // namespace
+
+bool LoadResidentModeSetting() {
+  g_autoptr(GKeyFile) key_file = g_key_file_new();
+  if (!g_key_file_load_from_file(key_file, SettingsPath().c_str(),
+                                 G_KEY_FILE_NONE, nullptr)) {
+    return false;
+  }
+  g_resident = g_key_file_get_boolean(key_file, kSettingsGroup, kResidentKey,
+                                      nullptr);
+  return g_resident;
+}
+
+void AttachResidentWindow(GtkWindow* window) {
+  g_window = window;
+  g_signal_connect(window, "delete-event", G_CALLBACK(OnDeleteEvent),
+                   nullptr);
+}
+
+bool PresentResidentWindow() {
+  if (g_window == nullptr) {
+    return false;
+  }
+  if (g_hidden) {
+    g_hidden = false;
+    gtk_widget_show(GTK_WIDGET(g_window));
+    SendLifecycleState("AppLifecycleState.resumed");
+    ShowStatusIcon(false);
+  }
+  gtk_window_present(g_window);
+  return true;
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_residency_channel = nullptr;
+
+void HandleResidencyCall(FlMethodChannel* channel, FlMethodCall* method_call,
+                         gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method == "getResident") {
+    RespondSuccess(method_call, fl_value_new_bool(g_resident));
+  } else if (method == "setResident") {
+    const bool resident = LookupBoolArg(args, "enabled", false);
+    std::string error;
+    if (!SaveResidentModeSetting(resident, &error)) {
+      RespondError(method_call, "RESIDENCY_ERROR", error);
+      return;
+    }
+    // Hiding on close applies at once; registering as a unique application,
+    // so that a relaunch re-presents this window, applies from the next
+    // start.
+    g_resident = resident;
+    RespondSuccess(method_call, fl_value_new_bool(g_resident));
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+}  // namespace
+
+void RegisterResidencyChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_residency_channel = fl_method_channel_new(messenger, kChannelName,
+                                              FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_residency_channel, HandleResidencyCall, nullptr, nullptr);
+
+  g_autoptr(FlStringCodec) string_codec = fl_string_codec_new();
+  g_lifecycle_channel = fl_basic_message_channel_new(
+      messenger, "flutter/lifecycle", FL_MESSAGE_CODEC(string_codec));
+  g_autoptr(FlJsonMessageCodec) json_codec = fl_json_message_codec_new();
+  g_system_channel = fl_basic_message_channel_new(
+      messenger, "flutter/system", FL_MESSAGE_CODEC(json_codec));
+}
@@ -0,0 +1,31 @@
+#ifndef RUNNER_RESIDENT_MODE_H_
+#define RUNNER_RESIDENT_MODE_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+// Resident mode keeps the engine warm when the window is closed: the window
+// is hidden instead of destroyed, the engine is told it is paused and to
+// trim its caches, and a status icon offers to show the window again or to
+// quit for real. Relaunching the application (or activating it over D-Bus)
+// re-presents the existing window.
+//
+// The setting lives in $XDG_CONFIG_HOME/codeagenthub/runner.ini because the
+// runner needs it before the engine starts, to decide whether the
+// application registers as unique.
+bool LoadResidentModeSetting();
+
+// Hooks |window| up for resident mode. Must be called before plugins are
+// registered, so that closing is intercepted ahead of the window_manager
+// plugin's own delete-event handler.
+void AttachResidentWindow(GtkWindow* window);
+
+// Shows the window again if resident mode had hidden it. Returns false if no
+// window has been attached yet.
+bool PresentResidentWindow();
+
+// Registers the "com.codeagenthub/residency" method channel and the engine
+// channels used to pause it.
+void RegisterResidencyChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_RESIDENT_MODE_H_
@@ -0,0 +1,571 @@
+#include "run_journal.h"
+
+#include <zstd.h>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/run_journal";
+const char kEventChannelName[] = "com.codeagenthub/run_journal_events";
+
+// A run whose journal grows past this stops being journaled; views opened
+// during it fall back to the transcript.
+constexpr size_t kMaxStoredBytes = 16 * 1024 * 1024;
+// Runs journaled at once; one per open stream, so this is a safety net.
+constexpr size_t kMaxJournals = 64;
+constexpr int kCompressionLevel = 3;
+
+JsonValue Delta(const char* type, const std::string& message) {
+  JsonValue delta = JsonValue::Object();
+  delta.Set("t", JsonValue::String(type));
+  delta.Set("message", JsonValue::String(message));
+  return delta;
+}
+
+JsonValue BlockDelta(const char* type, const std::string& message,
+                     int64_t index) {
+  JsonValue delta = Delta(type, message);
+  delta.Set("index", JsonValue::Integer(index));
+  return delta;
+}
+
+// Memory |value| holds, counting the nodes themselves and not just their
+// text; tool input arrives as many small updates.
+size_t HeldBytes(const JsonValue& value) {
+  size_t bytes = sizeof(JsonValue) + value.AsString().size();
+  for (const JsonValue& item : value.items()) {
+    bytes += HeldBytes(item);
+  }
+  for (const auto& member : value.members()) {
+    bytes += member.first.size() + HeldBytes(member.second);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+RunJournal::RunJournal(int64_t started_at_us, JsonValue prompt_blocks)
+    : started_at_us_(started_at_us) {
+  AppendPrompt(std::move(prompt_blocks));
+}
+
+JsonValue RunJournal::AppendPrompt(JsonValue blocks) {
+  JsonValue delta =
+      Delta("message", "prompt_" + std::to_string(started_at_us_) + "_" +
+                           std::to_string(next_prompt_++));
+  delta.Set("role", JsonValue::String("user"));
+  delta.Set("blocks", std::move(blocks));
+  Append(delta);
+  return delta;
+}
+
+bool RunJournal::Append(const JsonValue& delta) {
+  if (overflowed_) {
+    return false;
+  }
+  ++sequence_;
+  const std::string& type = delta["t"].AsString();
+  const std::string& message = delta["message"].AsString();
+  const int64_t index = delta["index"].AsInt(0);
+
+  if (type == "session") {
+    session_ = delta;
+  } else if (type == "run") {
+    run_ = delta;
+  } else if (type == "stats") {
+    stats_ = delta;
+  } else if (type == "done" || type == "error") {
+    terminal_ = delta;
+  } else if (type == "start") {
+    const std::string& replaces = delta["replaces"].AsString();
+    Item* replaced = replaces.empty() ? nullptr : FindOpen(replaces);
+    if (replaced != nullptr) {
+      // A token-mode placeholder rebuilt from stream events.
+      replaced->dropped = true;
+      stored_bytes_ -= replaced->open_bytes;
+      open_items_.erase(replaces);
+    }
+    OpenItem(message);
+  } else if (type == "text") {
+    Item* item = OpenItem(message);
+    Block& block = item->blocks[index];
+    if (block.type.empty()) {
+      block.type = "text";
+    }
+    const std::string& text = delta["text"].AsString();
+    block.text += text;
+    item->open_bytes += text.size();
+    stored_bytes_ += text.size();
+  } else if (type == "tool") {
+    Item* item = OpenItem(message);
+    Block& block = item->blocks[index];
+    ResizeOpen(item, block.text.size() + block.input_bytes, 0);
+    block = Block();
+    block.type = "tool_use";
+    block.tool_id = delta["id"];
+    block.tool_name = delta["name"];
+  } else if (type == "input" || type == "stop") {
+    Item* item = FindOpen(message);
+    auto found = item != nullptr ? item->blocks.find(index)
+                                 : std::map<int64_t, Block>::iterator();
+    if (item == nullptr || found == item->blocks.end()) {
+      return true;
+    }
+    Block& block = found->second;
+    if (type == "input") {
+      size_t bytes = 0;
+      for (const JsonValue& update : delta["updates"].items()) {
+        block.input_updates.push_back(update);
+        bytes += HeldBytes(update);
+      }
+      ResizeOpen(item, block.input_bytes, block.input_bytes + bytes);
+      block.input_bytes += bytes;
+    } else {
+      block.stopped = true;
+      const JsonValue* input = delta.Find("input");
+      if (input != nullptr && input->is_object()) {
+        block.input = *input;
+        block.input_updates.clear();
+        const size_t bytes = HeldBytes(block.input);
+        ResizeOpen(item, block.input_bytes, bytes);
+        block.input_bytes = bytes;
+      }
+    }
+  } else if (type == "final") {
+    Item* item = FindOpen(message);
+    if (item != nullptr) {
+      std::vector<JsonValue> deltas;
+      OpenDeltas(*item, &deltas);
+      deltas.push_back(delta);
+      stored_bytes_ -= item->open_bytes;
+      Seal(item, deltas);
+      open_items_.erase(message);
+    }
+  } else if (type == "message") {
+    items_.push_back(std::make_unique<Item>());
+    items_.back()->message = message;
+    Seal(items_.back().get(), {delta});
+  }
+
+  overflowed_ = stored_bytes_ > kMaxStoredBytes;
+  if (overflowed_) {
+    items_.clear();
+    open_items_.clear();
+  }
+  return !overflowed_;
+}
+
+std::vector<JsonValue> RunJournal::Snapshot() const {
+  return Expand(Capture());
+}
+
+std::vector<RunJournal::CapturedItem> RunJournal::Capture() const {
+  std::vector<CapturedItem> captured;
+  CapturedItem head;
+  if (!session_.is_null()) {
+    head.deltas.push_back(session_);
+  }
+  if (!run_.is_null()) {
+    head.deltas.push_back(run_);
+  }
+  captured.push_back(std::move(head));
+  for (const auto& item : items_) {
+    if (item->dropped) {
+      continue;
+    }
+    CapturedItem entry;
+    entry.message = item->message;
+    if (item->sealed) {
+      entry.compressed = item->compressed;
+      entry.raw_size = item->raw_size;
+    } else {
+      OpenDeltas(*item, &entry.deltas);
+    }
+    captured.push_back(std::move(entry));
+  }
+  CapturedItem tail;
+  if (!stats_.is_null()) {
+    tail.deltas.push_back(stats_);
+  }
+  if (!terminal_.is_null()) {
+    tail.deltas.push_back(terminal_);
+  }
+  captured.push_back(std::move(tail));
+  return captured;
+}
+
+// static
+std::vector<JsonValue> RunJournal::Expand(
+    const std::vector<CapturedItem>& captured) {
+  std::vector<JsonValue> deltas;
+  for (const CapturedItem& item : captured) {
+    if (item.compressed.empty()) {
+      deltas.insert(deltas.end(), item.deltas.begin(), item.deltas.end());
+      continue;
+    }
+    std::string raw(item.raw_size, '\0');
+    JsonValue sealed;
+    std::string error;
+    const size_t result =
+        ZSTD_decompress(&raw[0], raw.size(), item.compressed.data(),
+                        item.compressed.size());
+    if (ZSTD_isError(result) || result != raw.size() ||
+        !ParseJson(raw, &sealed, &error)) {
+      g_warning("Dropping unreadable journal entry for %s",
+                item.message.c_str());
+      continue;
+    }
+    for (JsonValue& delta : sealed.items()) {
+      deltas.push_back(std::move(delta));
+    }
+  }
+  return deltas;
+}
+
+RunJournal::Item* RunJournal::FindOpen(const std::string& message) {
+  auto found = open_items_.find(message);
+  return found != open_items_.end() ? found->second : nullptr;
+}
+
+RunJournal::Item* RunJournal::OpenItem(const std::string& message) {
+  Item* item = FindOpen(message);
+  if (item == nullptr) {
+    items_.push_back(std::make_unique<Item>());
+    item = items_.back().get();
+    item->message = message;
+    open_items_[message] = item;
+  }
+  return item;
+}
+
+void RunJournal::ResizeOpen(Item* item, size_t old_bytes, size_t new_bytes) {
+  item->open_bytes = item->open_bytes - old_bytes + new_bytes;
+  stored_bytes_ = stored_bytes_ - old_bytes + new_bytes;
+}
+
+void RunJournal::OpenDeltas(const Item& item,
+                            std::vector<JsonValue>* deltas) const {
+  deltas->push_back(Delta("start", item.message));
+  for (const auto& entry : item.blocks) {
+    const Block& block = entry.second;
+    if (block.type == "text") {
+      JsonValue text = BlockDelta("text", item.message, entry.first);
+      text.Set("text", JsonValue::String(block.text));
+      deltas->push_back(std::move(text));
+    } else {
+      JsonValue tool = BlockDelta("tool", item.message, entry.first);
+      tool.Set("id", block.tool_id);
+      tool.Set("name", block.tool_name);
+      deltas->push_back(std::move(tool));
+      if (!block.input_updates.empty()) {
+        JsonValue input = BlockDelta("input", item.message, entry.first);
+        JsonValue updates = JsonValue::Array();
+        for (const JsonValue& update : block.input_updates) {
+          updates.Append(update);
+        }
+        input.Set("updates", std::move(updates));
+        deltas->push_back(std::move(input));
+      }
+    }
+    if (block.stopped) {
+      JsonValue stop = BlockDelta("stop", item.message, entry.first);
+      if (!block.input.is_null()) {
+        stop.Set("input", block.input);
+      }
+      deltas->push_back(std::move(stop));
+    }
+  }
+}
+
+void RunJournal::Seal(Item* item, const std::vector<JsonValue>& deltas) {
+  JsonValue list = JsonValue::Array();
+  for (const JsonValue& delta : deltas) {
+    list.Append(delta);
+  }
+  const std::string raw = list.Serialize();
+  item->compressed.resize(ZSTD_compressBound(raw.size()));
+  const size_t result =
+      ZSTD_compress(&item->compressed[0], item->compressed.size(), raw.data(),
+                    raw.size(), kCompressionLevel);
+  if (ZSTD_isError(result)) {
+    g_warning("Failed to compress journal entry: %s",
+              ZSTD_getErrorName(result));
+    item->dropped = true;
+    item->compressed.clear();
+  } else {
+    item->compressed.resize(result);
+    item->compressed.shrink_to_fit();
+  }
+  item->raw_size = raw.size();
+  item->sealed = true;
+  item->blocks.clear();
+  item->open_bytes = 0;
+  stored_bytes_ += item->compressed.size();
+}
+
+// Journals by stream and session, and the channel glue.
+
+namespace {
+
+FlMethodChannel* g_run_journal_channel = nullptr;
+FlEventChannel* g_run_journal_events_channel = nullptr;
+bool g_run_journal_events_listening = false;  // Main thread only.
+
+struct JournalRecord {
+  explicit JournalRecord(const JsonValue& prompt)
+      : journal(g_get_real_time(), prompt) {}
+
+  RunJournal journal;
+  std::string session_id;
+  int listeners = 0;  // Attached views.
+};
+
+std::mutex g_journals_mutex;
+std::unordered_map<std::string, std::shared_ptr<JournalRecord>>
+    g_journals_by_stream;
+std::unordered_map<std::string, std::shared_ptr<JournalRecord>>
+    g_journals_by_session;
+
+// Sends |event| to Dart from any thread.
+void PostJournalEvent(FlValue* event) {
+  RunOnMainThread([event]() {
+    g_autoptr(FlValue) owned_event = event;
+    if (!g_run_journal_events_listening) {
+      return;
+    }
+    g_autoptr(GError) error = nullptr;
+    if (!fl_event_channel_send(g_run_journal_events_channel, owned_event,
+                               nullptr, &error)) {
+      g_warning("Failed to send journal event: %s", error->message);
+    }
+  });
+}
+
+FlValue* DeltasEvent(const std::string& session_id, uint64_t sequence,
+                     const std::vector<JsonValue>& deltas) {
+  FlValue* event = fl_value_new_map();
+  fl_value_set_string_take(event, "sessionId",
+                           fl_value_new_string(session_id.c_str()));
+  fl_value_set_string_take(event, "sequence",
+                           fl_value_new_int(static_cast<int64_t>(sequence)));
+  FlValue* list = fl_value_new_list();
+  for (const JsonValue& delta : deltas) {
+    fl_value_append_take(list, JsonToFlValue(delta));
+  }
+  fl_value_set_string_take(event, "deltas", list);
+  return event;
+}
+
+// Ends the listeners' attachment: {sessionId, |reason|: true}, where the
+// reason is "closed" when the stream ended and "overflowed" when the run goes
+// on but its journal was dropped.
+FlValue* EndEvent(const std::string& session_id, const char* reason) {
+  FlValue* event = fl_value_new_map();
+  fl_value_set_string_take(event, "sessionId",
+                           fl_value_new_string(session_id.c_str()));
+  fl_value_set_string_take(event, reason, fl_value_new_bool(true));
+  return event;
+}
+
+// Drops |record| from both maps. Caller holds g_journals_mutex.
+void ForgetJournalLocked(const std::shared_ptr<JournalRecord>& record,
+                         const char* reason = "closed") {
+  for (auto it = g_journals_by_stream.begin();
+       it != g_journals_by_stream.end();) {
+    it = it->second == record ? g_journals_by_stream.erase(it) : ++it;
+  }
+  auto found = g_journals_by_session.find(record->session_id);
+  if (found != g_journals_by_session.end() && found->second == record) {
+    g_journals_by_session.erase(found);
+  }
+  if (record->listeners > 0) {
+    PostJournalEvent(EndEvent(record->session_id, reason));
+  }
+}
+
+void HandleAttach(FlMethodCall* method_call, const std::string& session_id) {
+  g_object_ref(method_call);
+  // Decompressing a long run is not free; snapshot on the pool, outside the
+  // journals lock.
+  TaskPool::Get().Post([method_call, session_id]() {
+    auto snapshot = std::make_shared<std::vector<JsonValue>>();
+    std::vector<RunJournal::CapturedItem> captured;
+    int64_t started_at = 0;
+    uint64_t sequence = 0;
+    bool found = false;
+    {
+      // Streams append under this lock, so only copy here.
+      std::lock_guard<std::mutex> lock(g_journals_mutex);
+      auto it = g_journals_by_session.find(session_id);
+      if (it != g_journals_by_session.end() &&
+          !it->second->journal.overflowed()) {
+        found = true;
+        ++it->second->listeners;
+        captured = it->second->journal.Capture();
+        started_at = it->second->journal.started_at_us();
+        sequence = it->second->journal.sequence();
+      }
+    }
+    if (found) {
+      *snapshot = RunJournal::Expand(captured);
+    }
+    RunOnMainThread([method_call, snapshot, started_at, sequence, found]() {
+      if (!found) {
+        RespondSuccess(method_call, nullptr);
+      } else {
+        FlValue* result = fl_value_new_map();
+        fl_value_set_string_take(result, "startedAt",
+                                 fl_value_new_int(started_at));
+        fl_value_set_string_take(
+            result, "sequence",
+            fl_value_new_int(static_cast<int64_t>(sequence)));
+        FlValue* list = fl_value_new_list();
+        for (const JsonValue& delta : *snapshot) {
+          fl_value_append_take(list, JsonToFlValue(delta));
+        }
+        fl_value_set_string_take(result, "deltas", list);
+        RespondSuccess(method_call, result);
+      }
+      g_object_unref(method_call);
+    });
+  });
+}
+
+void HandleRunJournalCall(FlMethodChannel* channel, FlMethodCall* method_call,
+                          gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+  const std::string session_id = LookupStringArg(args, "sessionId");
+  if (session_id.empty()) {
+    RespondError(method_call, "INVALID_ARGUMENTS", "sessionId is required");
+    return;
+  }
+
+  if (method == "attach") {
+    HandleAttach(method_call, session_id);
+  } else if (method == "detach") {
+    {
+      std::lock_guard<std::mutex> lock(g_journals_mutex);
+      auto it = g_journals_by_session.find(session_id);
+      if (it != g_journals_by_session.end() && it->second->listeners > 0) {
+        --it->second->listeners;
+      }
+    }
+    RespondSuccess(method_call, nullptr);
+  } else if (method == "isActive") {
+    bool active;
+    {
+      std::lock_guard<std::mutex> lock(g_journals_mutex);
+      active = g_journals_by_session.count(session_id) > 0;
+    }
+    RespondSuccess(method_call, fl_value_new_bool(active));
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+FlMethodErrorResponse* OnRunJournalEventsListen(FlEventChannel* channel,
+                                                FlValue* args,
+                                                gpointer user_data) {
+  g_run_journal_events_listening = true;
+  return nullptr;
+}
+
+FlMethodErrorResponse* OnRunJournalEventsCancel(FlEventChannel* channel,
+                                                FlValue* args,
+                                                gpointer user_data) {
+  g_run_journal_events_listening = false;
+  return nullptr;
+}
+
+}  // namespace
+
+void RunJournalStreamOpened(const std::string& stream_id,
+                            const std::string& session_id,
+                            const JsonValue& prompt_blocks) {
+  std::lock_guard<std::mutex> lock(g_journals_mutex);
+  auto reopened = g_journals_by_stream.find(stream_id);
+  if (reopened != g_journals_by_stream.end()) {
+    ForgetJournalLocked(std::shared_ptr<JournalRecord>(reopened->second));
+  }
+  if (!session_id.empty()) {
+    auto found = g_journals_by_session.find(session_id);
+    if (found != g_journals_by_session.end()) {
+      // The backend injects this message into the running session.
+      JournalRecord& record = *found->second;
+      const JsonValue delta = record.journal.AppendPrompt(prompt_blocks);
+      if (record.listeners > 0 && !record.journal.overflowed()) {
+        PostJournalEvent(
+            DeltasEvent(session_id, record.journal.sequence(), {delta}));
+      }
+      return;
+    }
+  }
+  if (g_journals_by_stream.size() >= kMaxJournals) {
+    g_warning("Too many journaled runs; not journaling %s",
+              stream_id.c_str());
+    return;
+  }
+  auto record = std::make_shared<JournalRecord>(prompt_blocks);
+  record->session_id = session_id;
+  g_journals_by_stream[stream_id] = record;
+  if (!session_id.empty()) {
+    g_journals_by_session[session_id] = record;
+  }
+}
+
+void RunJournalStreamDeltas(const std::string& stream_id,
+                            const std::vector<JsonValue>& deltas) {
+  if (deltas.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(g_journals_mutex);
+  auto found = g_journals_by_stream.find(stream_id);
+  if (found == g_journals_by_stream.end()) {
+    return;
+  }
+  std::shared_ptr<JournalRecord> record = found->second;
+  for (const JsonValue& delta : deltas) {
+    if (record->session_id.empty() && delta["t"].AsString() == "session") {
+      record->session_id = delta["id"].AsString();
+      g_journals_by_session[record->session_id] = record;
+    }
+    if (!record->journal.Append(delta)) {
+      ForgetJournalLocked(record, "overflowed");
+      return;
+    }
+  }
+  if (record->listeners > 0) {
+    PostJournalEvent(
+        DeltasEvent(record->session_id, record->journal.sequence(), deltas));
+  }
+}
+
+void RunJournalStreamClosed(const std::string& stream_id) {
+  std::lock_guard<std::mutex> lock(g_journals_mutex);
+  auto found = g_journals_by_stream.find(stream_id);
+  if (found != g_journals_by_stream.end()) {
+    ForgetJournalLocked(std::shared_ptr<JournalRecord>(found->second));
+  }
+}
+
+void RegisterRunJournalChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_run_journal_channel = fl_method_channel_new(messenger, kChannelName,
+                                                FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_run_journal_channel, HandleRunJournalCall, nullptr, nullptr);
+
+  g_run_journal_events_channel = fl_event_channel_new(
+      messenger, kEventChannelName, FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(g_run_journal_events_channel,
+                                       OnRunJournalEventsListen,
+                                       OnRunJournalEventsCancel, nullptr,
+                                       nullptr);
+}
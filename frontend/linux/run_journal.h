@@ -0,0 +1,117 @@
+#ifndef RUNNER_RUN_JOURNAL_H_
+#define RUNNER_RUN_JOURNAL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "json_value.h"
+
+// What a chat view has seen of one run, kept so that a view opened while the
+// run is still going can catch up without reloading the transcript. The
+// journal is fed the normalized deltas of the run's stream (see
+// stream_normalizer.h) and keeps them materialized: streamed messages that
+// are still open hold their accumulated text and tool input, and completed
+// messages are stored as zstd-compressed delta lists. Snapshot() replays the
+// state as deltas the stream consumer already understands.
+class RunJournal {
+ public:
+  // The prompt that started the run is recorded as a user message.
+  RunJournal(int64_t started_at_us, JsonValue prompt_blocks);
+
+  // Applies one delta. Returns false once the journal has outgrown its
+  // memory budget; it then stops recording and Snapshot() is not usable.
+  bool Append(const JsonValue& delta);
+
+  // Records a user message sent into the running session and returns the
+  // delta that stands for it.
+  JsonValue AppendPrompt(JsonValue blocks);
+
+  // The materialized state, in stream order.
+  std::vector<JsonValue> Snapshot() const;
+
+  // Snapshot() in two steps, so that a caller guarding the journal with a
+  // lock only holds it for Capture(): open messages are copied as deltas and
+  // completed ones as their compressed bytes, which Expand() decompresses
+  // and parses.
+  struct CapturedItem {
+    std::string message;
+    std::vector<JsonValue> deltas;
+    std::string compressed;
+    size_t raw_size = 0;
+  };
+  std::vector<CapturedItem> Capture() const;
+  static std::vector<JsonValue> Expand(
+      const std::vector<CapturedItem>& captured);
+
+  int64_t started_at_us() const { return started_at_us_; }
+  uint64_t sequence() const { return sequence_; }
+  bool overflowed() const { return overflowed_; }
+  size_t stored_bytes() const { return stored_bytes_; }
+
+ private:
+  struct Block {
+    std::string type;  // "text" or "tool_use".
+    std::string text;
+    JsonValue tool_id;
+    JsonValue tool_name;
+    std::vector<JsonValue> input_updates;
+    JsonValue input;  // Complete input from the stop delta.
+    size_t input_bytes = 0;  // Held by input_updates or input.
+    bool stopped = false;
+  };
+
+  struct Item {
+    std::string message;
+    // Open streamed message, and the text and tool input it holds.
+    std::map<int64_t, Block> blocks;
+    size_t open_bytes = 0;
+    // Completed message: its snapshot deltas, serialized and compressed.
+    std::string compressed;
+    size_t raw_size = 0;
+    bool sealed = false;
+    bool dropped = false;  // Replaced placeholder.
+  };
+
+  Item* FindOpen(const std::string& message);
+  Item* OpenItem(const std::string& message);
+  void ResizeOpen(Item* item, size_t old_bytes, size_t new_bytes);
+  void OpenDeltas(const Item& item, std::vector<JsonValue>* deltas) const;
+  void Seal(Item* item, const std::vector<JsonValue>& deltas);
+
+  const int64_t started_at_us_;
+  uint64_t sequence_ = 0;
+  uint64_t next_prompt_ = 0;
+  bool overflowed_ = false;
+  size_t stored_bytes_ = 0;
+
+  JsonValue session_;
+  JsonValue run_;
+  JsonValue stats_;
+  JsonValue terminal_;  // The done or error delta.
+  std::vector<std::unique_ptr<Item>> items_;
+  std::unordered_map<std::string, Item*> open_items_;
+};
+
+// Hooks for the stream normalizer channel. A stream opened with a session id
+// that already has a journal only adds its prompt to it, since the backend
+// broadcasts the run's events to every connection of the session. Safe to
+// call from any thread.
+void RunJournalStreamOpened(const std::string& stream_id,
+                            const std::string& session_id,
+                            const JsonValue& prompt_blocks);
+void RunJournalStreamDeltas(const std::string& stream_id,
+                            const std::vector<JsonValue>& deltas);
+void RunJournalStreamClosed(const std::string& stream_id);
+
+// Registers the "com.codeagenthub/run_journal" method channel and the
+// "com.codeagenthub/run_journal_events" event channel.
+void RegisterRunJournalChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_RUN_JOURNAL_H_
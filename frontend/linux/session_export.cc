@@ -0,0 +1,801 @@
+#include "session_export.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "json_value.h"
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/session_export";
+
+// Rendered output is flushed to disk whenever the buffer grows past this.
+constexpr size_t kFlushBytes = 256 * 1024;
+
+// One displayable message extracted from a transcript record, mirroring the
+// filtering ApiSessionRepository.getSessionMessages applies.
+struct ExportMessage {
+  std::string id;
+  std::string role;  // "user", "assistant" or "tool".
+  std::string timestamp;
+  std::vector<const JsonValue*> blocks;
+  const JsonValue* text = nullptr;  // Plain string content.
+};
+
+bool ExtractMessage(const JsonValue& record, ExportMessage* message) {
+  const std::string& type = record["type"].AsString();
+  if (type != "user" && type != "assistant") {
+    return false;
+  }
+  const JsonValue& inner = record["message"];
+  if (inner["role"].AsString() != type) {
+    return false;
+  }
+  message->id = record["uuid"].AsString();
+  message->timestamp = record["timestamp"].AsString();
+  message->role = type;
+  message->blocks.clear();
+  message->text = nullptr;
+
+  const JsonValue& content = inner["content"];
+  if (content.is_string()) {
+    if (content.AsString().empty()) {
+      return false;
+    }
+    message->text = &content;
+    return true;
+  }
+  if (!content.is_array()) {
+    return false;
+  }
+  bool only_tool_results = true;
+  for (const auto& block : content.items()) {
+    const std::string& block_type = block["type"].AsString();
+    if (block_type == "text" || block_type == "thinking" ||
+        block_type == "tool_use" || block_type == "tool_result" ||
+        block_type == "image") {
+      message->blocks.push_back(&block);
+      only_tool_results = only_tool_results && block_type == "tool_result";
+    }
+  }
+  if (message->blocks.empty()) {
+    return false;
+  }
+  if (type == "user" && only_tool_results) {
+    message->role = "tool";
+  }
+  return true;
+}
+
+// Flattens tool_result content (a string or a list of text blocks).
+std::string ToolResultText(const JsonValue& block) {
+  const JsonValue& content = block["content"];
+  if (content.is_string()) {
+    return content.AsString();
+  }
+  std::string text;
+  for (const auto& item : content.items()) {
+    if (item.is_string()) {
+      text += item.AsString();
+    } else if (item["type"].AsString() == "text") {
+      if (!text.empty()) {
+        text.push_back('\n');
+      }
+      text += item["text"].AsString();
+    }
+  }
+  return text;
+}
+
+const char* RoleLabel(const std::string& role) {
+  if (role == "user") {
+    return "User";
+  }
+  if (role == "tool") {
+    return "Tool result";
+  }
+  return "Assistant";
+}
+
+class SessionRenderer {
+ public:
+  virtual ~SessionRenderer() = default;
+  virtual void Begin(const std::string& title, std::string* out) = 0;
+  virtual void Render(const ExportMessage& message, std::string* out) = 0;
+  virtual void End(std::string* out) = 0;
+};
+
+// Markdown ----------------------------------------------------------------
+
+// Picks a fence longer than any backtick run inside |text|.
+std::string FenceFor(const std::string& text) {
+  size_t longest = 0;
+  size_t run = 0;
+  for (char c : text) {
+    run = c == '`' ? run + 1 : 0;
+    longest = std::max(longest, run);
+  }
+  return std::string(std::max<size_t>(3, longest + 1), '`');
+}
+
+void AppendFenced(const std::string& text, const char* language,
+                  std::string* out) {
+  const std::string fence = FenceFor(text);
+  *out += fence;
+  *out += language;
+  *out += '\n';
+  *out += text;
+  if (text.empty() || text.back() != '\n') {
+    *out += '\n';
+  }
+  *out += fence;
+  *out += "\n\n";
+}
+
+class MarkdownRenderer : public SessionRenderer {
+ public:
+  void Begin(const std::string& title, std::string* out) override {
+    *out += "# " + (title.empty() ? std::string("Session") : title) + "\n\n";
+  }
+
+  void Render(const ExportMessage& message, std::string* out) override {
+    *out += "## ";
+    *out += RoleLabel(message.role);
+    if (!message.timestamp.empty()) {
+      *out += " · " + message.timestamp;
+    }
+    *out += "\n\n";
+    if (message.text != nullptr) {
+      *out += message.text->AsString();
+      *out += "\n\n";
+      return;
+    }
+    for (const JsonValue* block : message.blocks) {
+      RenderBlock(*block, out);
+    }
+  }
+
+  void End(std::string* out) override {}
+
+ private:
+  void RenderBlock(const JsonValue& block, std::string* out) {
+    const std::string& type = block["type"].AsString();
+    if (type == "text") {
+      *out += block["text"].AsString();
+      *out += "\n\n";
+    } else if (type == "thinking") {
+      *out += "> *Thinking*\n>\n";
+      const std::string& thinking = block["thinking"].AsString();
+      size_t start = 0;
+      while (start <= thinking.size()) {
+        size_t end = thinking.find('\n', start);
+        if (end == std::string::npos) {
+          end = thinking.size();
+        }
+        *out += "> ";
+        out->append(thinking, start, end - start);
+        *out += '\n';
+        start = end + 1;
+      }
+      *out += '\n';
+    } else if (type == "tool_use") {
+      *out += "**Tool:** `" + block["name"].AsString() + "`\n\n";
+      AppendFenced(block["input"].SerializePretty(), "json", out);
+    } else if (type == "tool_result") {
+      *out += block["is_error"].AsBool() ? "**Tool error:**\n\n"
+                                         : "**Tool output:**\n\n";
+      AppendFenced(ToolResultText(block), "text", out);
+    } else if (type == "image") {
+      *out += "*[image: " + block["source"]["media_type"].AsString() +
+              "]*\n\n";
+    }
+  }
+};
+
+// HTML --------------------------------------------------------------------
+
+void AppendEscaped(const char* text, size_t size, std::string* out) {
+  const char* run = text;
+  const char* end = text + size;
+  for (const char* p = text; p != end; ++p) {
+    const char* entity = nullptr;
+    switch (*p) {
+      case '&':
+        entity = "&amp;";
+        break;
+      case '<':
+        entity = "&lt;";
+        break;
+      case '>':
+        entity = "&gt;";
+        break;
+      case '"':
+        entity = "&quot;";
+        break;
+      default:
+        continue;
+    }
+    out->append(run, p - run);
+    *out += entity;
+    run = p + 1;
+  }
+  out->append(run, end - run);
+}
+
+void AppendEscaped(const std::string& text, std::string* out) {
+  AppendEscaped(text.data(), text.size(), out);
+}
+
+bool IsIdentifierChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '$';
+}
+
+const std::unordered_set<std::string>& Keywords() {
+  static const std::unordered_set<std::string> keywords = {
+      "abstract", "async",    "await",     "bool",     "break",   "case",
+      "catch",    "char",     "class",     "const",    "continue", "def",
+      "default",  "delete",   "do",        "double",   "elif",    "else",
+      "enum",     "export",   "extends",   "false",    "final",   "float",
+      "fn",       "for",      "from",      "func",     "function", "if",
+      "impl",     "import",   "in",        "int",      "interface", "is",
+      "late",     "let",      "long",      "match",    "mut",     "namespace",
+      "new",      "nil",      "None",      "null",     "private", "protected",
+      "pub",      "public",   "required",  "return",   "self",    "static",
+      "struct",   "super",    "switch",    "this",     "throw",   "true",
+      "True",     "False",    "try",       "type",     "typedef", "use",
+      "var",      "void",     "while",     "with",     "yield",   "package",
+      "unsigned", "auto",     "template",  "typename", "virtual", "override",
+      "lambda",   "pass",     "raise",     "except",   "finally", "not",
+      "and",      "or",       "until",     "echo",     "then",    "fi",
+      "done",     "esac",     "local",     "readonly", "undefined"};
+  return keywords;
+}
+
+void AppendSpan(const char* css_class, const char* text, size_t size,
+                std::string* out) {
+  *out += "<span class=\"";
+  *out += css_class;
+  *out += "\">";
+  AppendEscaped(text, size, out);
+  *out += "</span>";
+}
+
+// Lightweight lexer shared by all languages: strings, comments, numbers and
+// a union keyword set. Good enough for exported snapshots and cheap enough to
+// run over megabytes of tool output.
+void AppendHighlighted(const std::string& code, const std::string& language,
+                       std::string* out) {
+  const bool hash_comments = language == "python" || language == "py" ||
+                             language == "bash" || language == "sh" ||
+                             language == "shell" || language == "yaml" ||
+                             language == "yml" || language == "ruby" ||
+                             language == "toml";
+  const char* data = code.data();
+  const size_t size = code.size();
+  size_t i = 0;
+  size_t plain = 0;
+  auto flush_plain = [&](size_t end) {
+    AppendEscaped(data + plain, end - plain, out);
+  };
+  while (i < size) {
+    const char c = data[i];
+    size_t end = i;
+    const char* css_class = nullptr;
+    if ((c == '/' && i + 1 < size && data[i + 1] == '/') ||
+        (c == '#' && hash_comments)) {
+      end = code.find('\n', i);
+      end = end == std::string::npos ? size : end;
+      css_class = "c";
+    } else if (c == '/' && i + 1 < size && data[i + 1] == '*') {
+      end = code.find("*/", i + 2);
+      end = end == std::string::npos ? size : end + 2;
+      css_class = "c";
+    } else if (c == '"' || c == '\'' || c == '`') {
+      end = i + 1;
+      while (end < size && data[end] != c && data[end] != '\n') {
+        end += data[end] == '\\' ? 2 : 1;
+      }
+      end = std::min(end + 1, size);
+      css_class = "s";
+    } else if (c >= '0' && c <= '9' && (i == 0 || !IsIdentifierChar(data[i - 1]))) {
+      end = i;
+      while (end < size && (IsIdentifierChar(data[end]) || data[end] == '.')) {
+        ++end;
+      }
+      css_class = "n";
+    } else if (IsIdentifierChar(c) && (i == 0 || !IsIdentifierChar(data[i - 1]))) {
+      end = i;
+      while (end < size && IsIdentifierChar(data[end])) {
+        ++end;
+      }
+      if (Keywords().count(code.substr(i, end - i)) != 0) {
+        css_class = "k";
+      } else {
+        i = end;
+        continue;
+      }
+    } else {
+      ++i;
+      continue;
+    }
+    flush_plain(i);
+    AppendSpan(css_class, data + i, end - i, out);
+    i = end;
+    plain = end;
+  }
+  flush_plain(size);
+}
+
+void AppendCodeBlock(const std::string& code, const std::string& language,
+                     std::string* out) {
+  *out += "<pre><code";
+  if (!language.empty()) {
+    *out += " class=\"language-";
+    AppendEscaped(language, out);
+    *out += "\"";
+  }
+  *out += ">";
+  AppendHighlighted(code, language, out);
+  *out += "</code></pre>\n";
+}
+
+// Renders message text: fenced code blocks are highlighted, everything else
+// is escaped and keeps its line breaks.
+void AppendTextWithCode(const std::string& text, std::string* out) {
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t fence = text.find("```", pos);
+    while (fence != std::string::npos && fence != 0 && text[fence - 1] != '\n') {
+      fence = text.find("```", fence + 3);
+    }
+    const size_t prose_end = fence == std::string::npos ? text.size() : fence;
+    if (prose_end > pos) {
+      *out += "<div class=\"text\">";
+      AppendEscaped(text.data() + pos, prose_end - pos, out);
+      *out += "</div>\n";
+    }
+    if (fence == std::string::npos) {
+      break;
+    }
+    const size_t info_end = text.find('\n', fence);
+    if (info_end == std::string::npos) {
+      *out += "<div class=\"text\">";
+      AppendEscaped(text.data() + fence, text.size() - fence, out);
+      *out += "</div>\n";
+      break;
+    }
+    std::string language = text.substr(fence + 3, info_end - fence - 3);
+    language.erase(std::remove(language.begin(), language.end(), ' '),
+                   language.end());
+    size_t close = text.find("\n```", info_end);
+    const size_t code_end = close == std::string::npos ? text.size() : close + 1;
+    AppendCodeBlock(text.substr(info_end + 1, code_end - info_end - 1),
+                    language, out);
+    if (close == std::string::npos) {
+      break;
+    }
+    pos = text.find('\n', close + 4);
+    pos = pos == std::string::npos ? text.size() : pos + 1;
+  }
+}
+
+class HtmlRenderer : public SessionRenderer {
+ public:
+  void Begin(const std::string& title, std::string* out) override {
+    *out +=
+        "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\">\n<title>";
+    AppendEscaped(title.empty() ? std::string("Session") : title, out);
+    *out +=
+        "</title>\n<style>\n"
+        "body{font-family:system-ui,sans-serif;max-width:960px;margin:2em "
+        "auto;padding:0 1em;color:#1f2328}\n"
+        ".msg{border:1px solid #d0d7de;border-radius:8px;margin:1em "
+        "0;padding:.75em 1em}\n"
+        ".msg.user{background:#f6f8fa}.msg.tool{background:#fbfbfb}\n"
+        ".role{font-weight:600;margin-bottom:.5em}.ts{color:#656d76;font-"
+        "weight:400;margin-left:.5em}\n"
+        ".text{white-space:pre-wrap}.thinking{color:#656d76;font-style:"
+        "italic;white-space:pre-wrap}\n"
+        "pre{background:#f6f8fa;padding:.75em;border-radius:6px;overflow:"
+        "auto}\n"
+        ".tool-name{font-family:monospace;font-weight:600}.error{color:#"
+        "cf222e}\n"
+        ".k{color:#cf222e}.s{color:#0a3069}.c{color:#6e7781;font-style:"
+        "italic}.n{color:#0550ae}\n"
+        "</style></head><body>\n<h1>";
+    AppendEscaped(title.empty() ? std::string("Session") : title, out);
+    *out += "</h1>\n";
+  }
+
+  void Render(const ExportMessage& message, std::string* out) override {
+    *out += "<div class=\"msg " + message.role + "\"";
+    if (!message.id.empty()) {
+      *out += " id=\"";
+      AppendEscaped(message.id, out);
+      *out += "\"";
+    }
+    *out += "><div class=\"role\">";
+    *out += RoleLabel(message.role);
+    if (!message.timestamp.empty()) {
+      *out += "<span class=\"ts\">";
+      AppendEscaped(message.timestamp, out);
+      *out += "</span>";
+    }
+    *out += "</div>\n";
+    if (message.text != nullptr) {
+      AppendTextWithCode(message.text->AsString(), out);
+    }
+    for (const JsonValue* block : message.blocks) {
+      RenderBlock(*block, out);
+    }
+    *out += "</div>\n";
+  }
+
+  void End(std::string* out) override { *out += "</body></html>\n"; }
+
+ private:
+  void RenderBlock(const JsonValue& block, std::string* out) {
+    const std::string& type = block["type"].AsString();
+    if (type == "text") {
+      AppendTextWithCode(block["text"].AsString(), out);
+    } else if (type == "thinking") {
+      *out += "<div class=\"thinking\">";
+      AppendEscaped(block["thinking"].AsString(), out);
+      *out += "</div>\n";
+    } else if (type == "tool_use") {
+      *out += "<div class=\"tool-name\">";
+      AppendEscaped(block["name"].AsString(), out);
+      *out += "</div>\n";
+      AppendCodeBlock(block["input"].SerializePretty(), "json", out);
+    } else if (type == "tool_result") {
+      if (block["is_error"].AsBool()) {
+        *out += "<div class=\"error\">Tool error</div>\n";
+      }
+      AppendCodeBlock(ToolResultText(block), "", out);
+    } else if (type == "image") {
+      const JsonValue& source = block["source"];
+      if (source["type"].AsString() == "base64") {
+        *out += "<img alt=\"image\" style=\"max-width:100%\" src=\"data:";
+        AppendEscaped(source["media_type"].AsString(), out);
+        *out += ";base64,";
+        AppendEscaped(source["data"].AsString(), out);
+        *out += "\">\n";
+      }
+    }
+  }
+};
+
+// JSON --------------------------------------------------------------------
+
+class JsonRenderer : public SessionRenderer {
+ public:
+  void Begin(const std::string& title, std::string* out) override {
+    *out += "{\"title\":";
+    AppendJsonString(out, title);
+    *out += ",\"messages\":[\n";
+  }
+
+  void Render(const ExportMessage& message, std::string* out) override {
+    JsonValue normalized = JsonValue::Object();
+    normalized.Set("id", JsonValue::String(message.id));
+    normalized.Set("role", JsonValue::String(message.role));
+    normalized.Set("timestamp", JsonValue::String(message.timestamp));
+    JsonValue blocks = JsonValue::Array();
+    if (message.text != nullptr) {
+      blocks.Append(TextBlock("text", message.text->AsString()));
+    }
+    for (const JsonValue* block : message.blocks) {
+      blocks.Append(Normalize(*block));
+    }
+    normalized.Set("blocks", std::move(blocks));
+
+    if (!first_) {
+      *out += ",\n";
+    }
+    first_ = false;
+    normalized.SerializeTo(out);
+  }
+
+  void End(std::string* out) override { *out += "\n]}\n"; }
+
+ private:
+  static JsonValue TextBlock(const char* type, const std::string& text) {
+    JsonValue block = JsonValue::Object();
+    block.Set("type", JsonValue::String(type));
+    block.Set("text", JsonValue::String(text));
+    return block;
+  }
+
+  static JsonValue Normalize(const JsonValue& block) {
+    const std::string& type = block["type"].AsString();
+    if (type == "text") {
+      return TextBlock("text", block["text"].AsString());
+    }
+    if (type == "thinking") {
+      return TextBlock("thinking", block["thinking"].AsString());
+    }
+    if (type == "tool_result") {
+      JsonValue result = TextBlock("tool_result", ToolResultText(block));
+      result.Set("tool_use_id", JsonValue::String(block["tool_use_id"].AsString()));
+      result.Set("is_error", JsonValue::Bool(block["is_error"].AsBool()));
+      return result;
+    }
+    JsonValue result = JsonValue::Object();
+    result.Set("type", JsonValue::String(type));
+    if (type == "tool_use") {
+      result.Set("id", JsonValue::String(block["id"].AsString()));
+      result.Set("name", JsonValue::String(block["name"].AsString()));
+      result.Set("input", block["input"]);
+    } else {
+      const JsonValue& source = block["source"];
+      result.Set("media_type", JsonValue::String(source["media_type"].AsString()));
+      result.Set("data", JsonValue::String(source["data"].AsString()));
+    }
+    return result;
+  }
+
+  bool first_ = true;
+};
+
+std::unique_ptr<SessionRenderer> CreateRenderer(ExportFormat format) {
+  switch (format) {
+    case ExportFormat::kHtml:
+      return std::make_unique<HtmlRenderer>();
+    case ExportFormat::kJson:
+      return std::make_unique<JsonRenderer>();
+    case ExportFormat::kMarkdown:
+      break;
+  }
+  return std::make_unique<MarkdownRenderer>();
+}
+
+bool ParseFormat(const std::string& name, ExportFormat* format) {
+  if (name == "markdown" || name == "md") {
+    *format = ExportFormat::kMarkdown;
+  } else if (name == "html") {
+    *format = ExportFormat::kHtml;
+  } else if (name == "json") {
+    *format = ExportFormat::kJson;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+std::string ResolveClaudeSessionPath(const std::string& claude_dir,
+                                     const std::string& cwd,
+                                     const std::string& session_id) {
+  std::string root = claude_dir;
+  if (root.empty()) {
+    g_autofree gchar* home_claude =
+        g_build_filename(g_get_home_dir(), ".claude", nullptr);
+    root = home_claude;
+  }
+  std::string slug = cwd;
+  while (slug.size() > 1 && slug.back() == '/') {
+    slug.pop_back();
+  }
+  for (char& c : slug) {
+    if (!IsIdentifierChar(c) || c == '_' || c == '$') {
+      c = '-';
+    }
+  }
+  g_autofree gchar* path =
+      g_build_filename(root.c_str(), "projects", slug.c_str(),
+                       (session_id + ".jsonl").c_str(), nullptr);
+  return path;
+}
+
+ExportResult ExportSession(const ExportJob& job) {
+  ExportResult result;
+  std::ifstream input(job.source_path, std::ios::binary);
+  if (!input) {
+    result.error = "Cannot open " + job.source_path;
+    return result;
+  }
+  const std::string tmp_path = job.output_path + ".part";
+  std::ofstream output(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!output) {
+    result.error = "Cannot create " + job.output_path;
+    return result;
+  }
+
+  std::unique_ptr<SessionRenderer> renderer = CreateRenderer(job.format);
+  std::string buffer;
+  buffer.reserve(kFlushBytes * 2);
+  auto flush = [&]() {
+    output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    result.bytes_written += buffer.size();
+    buffer.clear();
+  };
+
+  renderer->Begin(job.title, &buffer);
+  std::string line;
+  JsonValue record;
+  ExportMessage message;
+  std::string parse_error;
+  while (std::getline(input, line)) {
+    if (line.empty() || line == "\r") {
+      continue;
+    }
+    result.records++;
+    if (!ParseJson(line, &record, &parse_error) ||
+        !ExtractMessage(record, &message)) {
+      continue;
+    }
+    result.messages++;
+    renderer->Render(message, &buffer);
+    if (buffer.size() >= kFlushBytes) {
+      flush();
+    }
+  }
+  renderer->End(&buffer);
+  flush();
+  output.close();
+
+  if (!output || input.bad()) {
+    remove(tmp_path.c_str());
+    result.error = "Write failed for " + job.output_path;
+    return result;
+  }
+  if (rename(tmp_path.c_str(), job.output_path.c_str()) != 0) {
+    remove(tmp_path.c_str());
+    result.error = "Cannot install " + job.output_path;
+    return result;
+  }
+  result.ok = true;
+  return result;
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_session_export_channel = nullptr;
+
+FlValue* ResultToValue(const ExportJob& job, const ExportResult& result) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "outputPath",
+                           fl_value_new_string(job.output_path.c_str()));
+  fl_value_set_string_take(value, "ok", fl_value_new_bool(result.ok));
+  fl_value_set_string_take(value, "records", fl_value_new_int(result.records));
+  fl_value_set_string_take(value, "messages",
+                           fl_value_new_int(result.messages));
+  fl_value_set_string_take(value, "bytesWritten",
+                           fl_value_new_int(result.bytes_written));
+  if (!result.ok) {
+    fl_value_set_string_take(value, "error",
+                             fl_value_new_string(result.error.c_str()));
+  }
+  return value;
+}
+
+bool JobFromArgs(FlValue* args, ExportJob* job, std::string* error) {
+  job->source_path = LookupStringArg(args, "sourcePath");
+  if (job->source_path.empty()) {
+    const std::string session_id = LookupStringArg(args, "sessionId");
+    const std::string cwd = LookupStringArg(args, "cwd");
+    if (session_id.empty() || cwd.empty()) {
+      *error = "sourcePath or sessionId and cwd are required";
+      return false;
+    }
+    job->source_path = ResolveClaudeSessionPath(
+        LookupStringArg(args, "claudeDir"), cwd, session_id);
+  }
+  job->output_path = LookupStringArg(args, "outputPath");
+  if (job->output_path.empty()) {
+    *error = "outputPath is required";
+    return false;
+  }
+  if (!ParseFormat(LookupStringArg(args, "format", "markdown"),
+                   &job->format)) {
+    *error = "Unknown export format";
+    return false;
+  }
+  job->title = LookupStringArg(args, "title");
+  return true;
+}
+
+// Collects the results of a batch; the last finishing job responds.
+struct BatchState {
+  BatchState(FlMethodCall* call, size_t size, bool single_job)
+      : method_call(call),
+        single(single_job),
+        jobs(size),
+        results(size),
+        remaining(size) {}
+
+  FlMethodCall* method_call;
+  bool single;  // exportSession responds with a map instead of a list.
+  std::vector<ExportJob> jobs;
+  std::vector<ExportResult> results;
+  std::atomic<size_t> remaining;
+};
+
+void RespondBatch(const std::shared_ptr<BatchState>& batch) {
+  RunOnMainThread([batch]() {
+    if (batch->single) {
+      RespondSuccess(batch->method_call,
+                     ResultToValue(batch->jobs[0], batch->results[0]));
+      g_object_unref(batch->method_call);
+      return;
+    }
+    FlValue* list = fl_value_new_list();
+    for (size_t i = 0; i < batch->jobs.size(); ++i) {
+      fl_value_append_take(list,
+                           ResultToValue(batch->jobs[i], batch->results[i]));
+    }
+    RespondSuccess(batch->method_call, list);
+    g_object_unref(batch->method_call);
+  });
+}
+
+void HandleSessionExportCall(FlMethodChannel* channel,
+                             FlMethodCall* method_call, gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  std::vector<FlValue*> job_args;
+  if (method == "exportSession") {
+    job_args.push_back(args);
+  } else if (method == "exportBatch") {
+    FlValue* jobs = args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+                        ? fl_value_lookup_string(args, "jobs")
+                        : nullptr;
+    if (jobs == nullptr || fl_value_get_type(jobs) != FL_VALUE_TYPE_LIST) {
+      RespondError(method_call, "INVALID_ARGUMENTS", "jobs list is required");
+      return;
+    }
+    for (size_t i = 0; i < fl_value_get_length(jobs); ++i) {
+      job_args.push_back(fl_value_get_list_value(jobs, i));
+    }
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+    return;
+  }
+
+  g_object_ref(method_call);
+  auto batch = std::make_shared<BatchState>(method_call, job_args.size(),
+                                            method == "exportSession");
+  std::vector<size_t> runnable;
+  for (size_t i = 0; i < job_args.size(); ++i) {
+    if (JobFromArgs(job_args[i], &batch->jobs[i], &batch->results[i].error)) {
+      runnable.push_back(i);
+    }
+  }
+  batch->remaining = runnable.size();
+  if (runnable.empty()) {
+    RespondBatch(batch);
+    return;
+  }
+  // Each session is an independent job, so a batch fans out across the pool.
+  for (size_t i : runnable) {
+    TaskPool::Get().PostBackground([batch, i]() {
+      batch->results[i] = ExportSession(batch->jobs[i]);
+      if (--batch->remaining == 0) {
+        RespondBatch(batch);
+      }
+    });
+  }
+}
+
+}  // namespace
+
+void RegisterSessionExportChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_session_export_channel = fl_method_channel_new(
+      messenger, kChannelName, FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_session_export_channel, HandleSessionExportCall, nullptr, nullptr);
+}
@@ -0,0 +1,42 @@
+#ifndef RUNNER_SESSION_EXPORT_H_
+#define RUNNER_SESSION_EXPORT_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+#include <string>
+
+enum class ExportFormat { kMarkdown, kHtml, kJson };
+
+struct ExportJob {
+  std::string source_path;  // Session JSONL transcript.
+  std::string output_path;
+  ExportFormat format = ExportFormat::kMarkdown;
+  std::string title;
+};
+
+struct ExportResult {
+  bool ok = false;
+  std::string error;
+  uint64_t records = 0;
+  uint64_t messages = 0;
+  uint64_t bytes_written = 0;
+};
+
+// Streams the transcript record by record through the renderer for
+// |job.format|. Only one record and one output buffer are held in memory at a
+// time, so the cost is bounded regardless of transcript size. Output goes to a
+// temporary file that replaces |job.output_path| once complete.
+ExportResult ExportSession(const ExportJob& job);
+
+// Returns the transcript path the backend uses for a Claude session:
+// <claude_dir>/projects/<slug of cwd>/<session_id>.jsonl. An empty
+// |claude_dir| means ~/.claude.
+std::string ResolveClaudeSessionPath(const std::string& claude_dir,
+                                     const std::string& cwd,
+                                     const std::string& session_id);
+
+// Registers the "com.codeagenthub/session_export" method channel.
+void RegisterSessionExportChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_SESSION_EXPORT_H_
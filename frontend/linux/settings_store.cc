@@ -0,0 +1,450 @@
+#include "settings_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "task_pool.h"
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'A', 'H', 'S', 'E', 'T', 'S', '\0'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 8 + 4 + 4 + 8 + 8;
+constexpr size_t kEntrySize = 4 * 4;
+
+uint64_t Fnv1a(const char* data, size_t size) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+template <typename T>
+void Put(std::string* out, T value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T ReadScalar(const char* data) {
+  T value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+bool WriteAll(int fd, const std::string& data) {
+  size_t done = 0;
+  while (done < data.size()) {
+    const ssize_t n = write(fd, data.data() + done, data.size() - done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Holds an exclusive flock() on a file until destroyed, so that processes
+// sharing the snapshot save one at a time.
+class FileLock {
+ public:
+  explicit FileLock(const std::string& path)
+      : fd_(open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600)) {
+    while (fd_ >= 0 && flock(fd_, LOCK_EX) != 0 && errno == EINTR) {
+    }
+  }
+  ~FileLock() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+
+ private:
+  const int fd_;
+};
+
+// Reads the whole file at |path|; on failure errno tells why.
+bool ReadFile(const std::string& path, std::string* data) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  char buffer[16384];
+  for (;;) {
+    const ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      const int saved_errno = errno;
+      close(fd);
+      errno = saved_errno;
+      return false;
+    }
+    if (n == 0) {
+      break;
+    }
+    data->append(buffer, static_cast<size_t>(n));
+  }
+  close(fd);
+  return true;
+}
+
+}  // namespace
+
+SettingsStore::SettingsStore(std::string path) : path_(std::move(path)) {}
+
+SettingsStore::~SettingsStore() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+}
+
+bool SettingsStore::Load(std::string* error) {
+  const int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      return true;
+    }
+    *error = "Cannot open " + path_ + ": " + strerror(errno);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return true;
+  }
+  void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                       MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    *error = "Cannot map " + path_ + ": " + strerror(errno);
+    return false;
+  }
+
+  std::map<std::string, View> views;
+  if (!Parse(static_cast<const char*>(mapping),
+             static_cast<size_t>(st.st_size), &views, error)) {
+    munmap(mapping, static_cast<size_t>(st.st_size));
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = mapping;
+  mapping_size_ = static_cast<size_t>(st.st_size);
+  entries_.clear();
+  for (const auto& view : views) {
+    entries_[view.first].view = view.second;
+  }
+  changed_.clear();
+  saved_generation_ = generation_;
+  return true;
+}
+
+int64_t SettingsStore::Read(const std::string& key, char* buffer,
+                            size_t capacity) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = entries_.find(key);
+  if (found == entries_.end()) {
+    return -1;
+  }
+  const View& view = found->second.view;
+  if (view.size > 0) {
+    memcpy(buffer, view.data, std::min(view.size, capacity));
+  }
+  return static_cast<int64_t>(view.size);
+}
+
+bool SettingsStore::Get(const std::string& key, std::string* value) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = entries_.find(key);
+  if (found == entries_.end()) {
+    return false;
+  }
+  value->assign(found->second.view.data, found->second.view.size);
+  return true;
+}
+
+void SettingsStore::Set(const std::string& key, std::string value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Value& entry = entries_[key];
+  entry.owned = std::move(value);
+  entry.view = {entry.owned.data(), entry.owned.size()};
+  changed_[key] = ++generation_;
+}
+
+void SettingsStore::Remove(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.erase(key) > 0) {
+    changed_[key] = ++generation_;
+  }
+}
+
+bool SettingsStore::dirty() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return generation_ != saved_generation_;
+}
+
+bool SettingsStore::Save(std::string* error) {
+  std::lock_guard<std::mutex> save_lock(save_mutex_);
+  std::map<std::string, std::string> local;
+  std::map<std::string, uint64_t> changed;
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation_ == saved_generation_) {
+      return true;
+    }
+    generation = generation_;
+    changed = changed_;
+    for (const auto& entry : entries_) {
+      local.emplace(entry.first, std::string(entry.second.view.data,
+                                             entry.second.view.size));
+    }
+  }
+
+  g_autofree gchar* dir = g_path_get_dirname(path_.c_str());
+  if (g_mkdir_with_parents(dir, 0700) != 0) {
+    *error = std::string("Cannot create ") + dir;
+    return false;
+  }
+  FileLock file_lock(path_ + ".lock");
+
+  // Start from the snapshot on disk and apply this store's changes. When it
+  // cannot be read, this store's full state replaces it.
+  std::map<std::string, std::string> entries;
+  std::string disk;
+  std::map<std::string, View> views;
+  std::string parse_error;
+  if (ReadFile(path_, &disk)) {
+    if (disk.empty() || Parse(disk.data(), disk.size(), &views, &parse_error)) {
+      for (const auto& view : views) {
+        entries.emplace(view.first,
+                        std::string(view.second.data, view.second.size));
+      }
+      for (const auto& key : changed) {
+        auto found = local.find(key.first);
+        if (found != local.end()) {
+          entries[key.first] = found->second;
+        } else {
+          entries.erase(key.first);
+        }
+      }
+    } else {
+      entries = local;
+    }
+  } else if (errno == ENOENT) {
+    entries = local;
+  } else {
+    *error = "Cannot read " + path_ + ": " + strerror(errno);
+    return false;
+  }
+
+  const std::string data = Serialize(entries);
+  const std::string tmp_path = path_ + ".tmp";
+  const int fd =
+      open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    *error = "Cannot create " + tmp_path + ": " + strerror(errno);
+    return false;
+  }
+  const bool written = WriteAll(fd, data) && fsync(fd) == 0;
+  close(fd);
+  if (!written || rename(tmp_path.c_str(), path_.c_str()) != 0) {
+    *error = "Cannot write " + path_ + ": " + strerror(errno);
+    unlink(tmp_path.c_str());
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Keys changed again while saving stay pending; the others now hold what
+  // was written, including values other processes saved.
+  for (auto it = changed_.begin(); it != changed_.end();) {
+    it = it->second <= generation ? changed_.erase(it) : std::next(it);
+  }
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (changed_.count(it->first) == 0 && entries.count(it->first) == 0) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto& entry : entries) {
+    if (changed_.count(entry.first) != 0) {
+      continue;
+    }
+    Value& value = entries_[entry.first];
+    if (entry.second.compare(0, std::string::npos, value.view.data,
+                             value.view.size) != 0) {
+      value.owned = std::move(entry.second);
+      value.view = {value.owned.data(), value.owned.size()};
+    }
+  }
+  saved_generation_ = generation;
+  return true;
+}
+
+std::string SettingsStore::Serialize(
+    const std::map<std::string, std::string>& entries) {
+  // Table offsets are relative to the payload start.
+  std::string table;
+  std::string bytes;
+  const size_t bytes_start = entries.size() * kEntrySize;
+  for (const auto& entry : entries) {
+    Put<uint32_t>(&table, static_cast<uint32_t>(bytes_start + bytes.size()));
+    Put<uint32_t>(&table, static_cast<uint32_t>(entry.first.size()));
+    bytes += entry.first;
+    Put<uint32_t>(&table, static_cast<uint32_t>(bytes_start + bytes.size()));
+    Put<uint32_t>(&table, static_cast<uint32_t>(entry.second.size()));
+    bytes += entry.second;
+  }
+  const std::string payload = table + bytes;
+
+  std::string out(kMagic, sizeof(kMagic));
+  Put<uint32_t>(&out, kVersion);
+  Put<uint32_t>(&out, static_cast<uint32_t>(entries.size()));
+  Put<uint64_t>(&out, payload.size());
+  Put<uint64_t>(&out, Fnv1a(payload.data(), payload.size()));
+  out += payload;
+  return out;
+}
+
+bool SettingsStore::Parse(const char* data, size_t size,
+                          std::map<std::string, View>* entries,
+                          std::string* error) {
+  if (size < kHeaderSize || memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    *error = "Not a settings snapshot";
+    return false;
+  }
+  const uint32_t version = ReadScalar<uint32_t>(data + 8);
+  const uint32_t count = ReadScalar<uint32_t>(data + 12);
+  const uint64_t payload_size = ReadScalar<uint64_t>(data + 16);
+  const uint64_t hash = ReadScalar<uint64_t>(data + 24);
+  if (version != kVersion) {
+    *error = "Unsupported settings snapshot version " + std::to_string(version);
+    return false;
+  }
+  const char* payload = data + kHeaderSize;
+  if (payload_size != size - kHeaderSize ||
+      static_cast<uint64_t>(count) * kEntrySize > payload_size ||
+      Fnv1a(payload, payload_size) != hash) {
+    *error = "Settings snapshot is truncated or corrupt";
+    return false;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    const char* entry = payload + i * kEntrySize;
+    const uint64_t key_offset = ReadScalar<uint32_t>(entry);
+    const uint64_t key_size = ReadScalar<uint32_t>(entry + 4);
+    const uint64_t value_offset = ReadScalar<uint32_t>(entry + 8);
+    const uint64_t value_size = ReadScalar<uint32_t>(entry + 12);
+    if (key_offset + key_size > payload_size ||
+        value_offset + value_size > payload_size) {
+      *error = "Settings snapshot entry out of range";
+      return false;
+    }
+    (*entries)[std::string(payload + key_offset, key_size)] = {
+        payload + value_offset, value_size};
+  }
+  return true;
+}
+
+// Process-wide store and the FFI entry points.
+
+namespace {
+
+SettingsStore* g_settings_store = nullptr;
+std::atomic<bool> g_save_scheduled{false};
+
+std::string SnapshotPath() {
+  g_autofree gchar* path = g_build_filename(
+      g_get_user_config_dir(), "codeagenthub", "settings.snapshot", nullptr);
+  return path;
+}
+
+SettingsStore* GetSettingsStore() {
+  // Normally loaded by LoadSettingsStore() before Dart runs.
+  static std::once_flag once;
+  std::call_once(once, []() {
+    if (g_settings_store == nullptr) {
+      g_settings_store = new SettingsStore(SnapshotPath());
+    }
+  });
+  return g_settings_store;
+}
+
+void SaveSettingsStore() {
+  std::string error;
+  if (!GetSettingsStore()->Save(&error)) {
+    g_warning("Failed to save settings: %s", error.c_str());
+  }
+}
+
+// Coalesces a burst of writes into one save.
+void ScheduleSave() {
+  if (g_save_scheduled.exchange(true)) {
+    return;
+  }
+  TaskPool::Get().PostBackground([]() {
+    g_save_scheduled.store(false);
+    SaveSettingsStore();
+  });
+}
+
+}  // namespace
+
+void LoadSettingsStore() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    std::string error;
+    if (!GetSettingsStore()->Load(&error)) {
+      g_warning("Ignoring settings snapshot: %s", error.c_str());
+    }
+  });
+}
+
+void FlushSettingsStore() {
+  if (GetSettingsStore()->dirty()) {
+    SaveSettingsStore();
+  }
+}
+
+int64_t codeagenthub_settings_read(const char* key, uint8_t* buffer,
+                                   int64_t capacity) {
+  return GetSettingsStore()->Read(key, reinterpret_cast<char*>(buffer),
+                                  capacity > 0 ? capacity : 0);
+}
+
+void codeagenthub_settings_write(const char* key, const uint8_t* data,
+                                 int64_t size) {
+  if (size < 0) {
+    GetSettingsStore()->Remove(key);
+  } else {
+    GetSettingsStore()->Set(
+        key, std::string(reinterpret_cast<const char*>(data),
+                         static_cast<size_t>(size)));
+  }
+  ScheduleSave();
+}
+
+void codeagenthub_settings_flush() { FlushSettingsStore(); }
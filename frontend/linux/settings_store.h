@@ -0,0 +1,104 @@
+#ifndef RUNNER_SETTINGS_STORE_H_
+#define RUNNER_SETTINGS_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// The app's local settings (config, interface settings, per-session agent
+// settings, last fetched user settings) as one versioned binary snapshot,
+// read by Dart synchronously through dart:ffi (see
+// lib/services/settings_snapshot.dart). Values are opaque bytes under string
+// keys; the Dart services store their JSON documents.
+//
+// File layout, in native byte order:
+//   magic "CAHSETS\0", u32 version, u32 entry count, u64 payload size,
+//   u64 FNV-1a hash of the payload
+//   payload: entry table (u32 key offset, key size, value offset, value size)
+//   sorted by key, followed by the key and value bytes
+//
+// Load() maps the file once; values are served from the mapping until they
+// are overwritten. Saves write a temporary file, fsync it and rename it over
+// the snapshot, so a crash leaves either the old or the new snapshot.
+// Another instance of the app may have saved in between: a save locks
+// "<path>.lock", re-reads the snapshot and replaces only the keys this store
+// changed, and takes the other keys' values from it. Thread-safe.
+class SettingsStore {
+ public:
+  explicit SettingsStore(std::string path);
+  ~SettingsStore();
+
+  SettingsStore(const SettingsStore&) = delete;
+  SettingsStore& operator=(const SettingsStore&) = delete;
+
+  // Maps the snapshot. A missing file is an empty store; an unreadable one is
+  // reported and treated as empty (the next save replaces it).
+  bool Load(std::string* error);
+
+  // Copies up to |capacity| bytes of the value into |buffer| and returns its
+  // full size, or -1 if |key| is not set.
+  int64_t Read(const std::string& key, char* buffer, size_t capacity) const;
+  bool Get(const std::string& key, std::string* value) const;
+
+  void Set(const std::string& key, std::string value);
+  void Remove(const std::string& key);
+
+  // Whether there are changes that Save() has not written yet.
+  bool dirty() const;
+
+  // Writes the keys changed since the last save into the snapshot on disk,
+  // then picks up the values other processes saved for the rest.
+  bool Save(std::string* error);
+
+  // The snapshot bytes for |entries|.
+  static std::string Serialize(
+      const std::map<std::string, std::string>& entries);
+  // Parses snapshot bytes; values point into |data|.
+  struct View {
+    const char* data;
+    size_t size;
+  };
+  static bool Parse(const char* data, size_t size,
+                    std::map<std::string, View>* entries, std::string* error);
+
+ private:
+  struct Value {
+    View view = {nullptr, 0};  // Into the mapping, or |owned|.
+    std::string owned;
+  };
+
+  const std::string path_;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Value> entries_;
+  // Keys set or removed since the last save, with the generation of their
+  // latest change.
+  std::map<std::string, uint64_t> changed_;
+  uint64_t generation_ = 0;
+  uint64_t saved_generation_ = 0;
+
+  std::mutex save_mutex_;  // One save at a time.
+};
+
+// Loads the process-wide store at startup, before the engine; later calls
+// do nothing.
+void LoadSettingsStore();
+
+// Writes pending changes now; used at shutdown.
+void FlushSettingsStore();
+
+// Synchronous entry points for Dart. Writes return at once and are persisted
+// on the task pool; a negative |size| removes the key.
+extern "C" __attribute__((visibility("default"))) int64_t
+codeagenthub_settings_read(const char* key, uint8_t* buffer, int64_t capacity);
+extern "C" __attribute__((visibility("default"))) void
+codeagenthub_settings_write(const char* key, const uint8_t* data,
+                            int64_t size);
+extern "C" __attribute__((visibility("default"))) void
+codeagenthub_settings_flush();
+
+#endif  // RUNNER_SETTINGS_STORE_H_
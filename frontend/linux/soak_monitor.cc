@@ -0,0 +1,488 @@
+#include "soak_monitor.h"
+
+#include <dirent.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <set>
+
+#include "json_value.h"
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/soak";
+const char kConfigEnv[] = "CODEAGENTHUB_SOAK";
+const char kConfigGroup[] = "soak";
+
+// Windows the post-warm-up samples are cut into.
+const size_t kTrendWindows = 5;
+
+struct MetricThreshold {
+  const char* metric;
+  double min_growth;
+  double min_delta;
+};
+
+// Process metrics worth flagging. Arena size is reported but not judged:
+// glibc rarely returns it, so it only shows the high-water mark.
+const MetricThreshold kProcessThresholds[] = {
+    {"rssBytes", 0.05, 8.0 * 1024 * 1024},
+    {"heapInUseBytes", 0.05, 4.0 * 1024 * 1024},
+    {"openFds", 0, 2},
+    {"threads", 0, 2},
+};
+
+// Dart gauges are judged by name: byte sizes need a few megabytes of growth,
+// counts of live objects any growth at all.
+const MetricThreshold kByteGaugeThreshold = {nullptr, 0.05,
+                                             4.0 * 1024 * 1024};
+const MetricThreshold kCountGaugeThreshold = {nullptr, 0.05, 1};
+
+uint64_t ReadRssBytes() {
+  FILE* file = fopen("/proc/self/statm", "re");
+  if (file == nullptr) {
+    return 0;
+  }
+  unsigned long long size = 0;
+  unsigned long long resident = 0;
+  const int fields = fscanf(file, "%llu %llu", &size, &resident);
+  fclose(file);
+  if (fields != 2) {
+    return 0;
+  }
+  return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+uint64_t CountOpenFds() {
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir == nullptr) {
+    return 0;
+  }
+  uint64_t count = 0;
+  while (dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      ++count;
+    }
+  }
+  closedir(dir);
+  // The directory stream holds one descriptor itself.
+  return count > 0 ? count - 1 : 0;
+}
+
+uint64_t CountThreads() {
+  FILE* file = fopen("/proc/self/status", "re");
+  if (file == nullptr) {
+    return 0;
+  }
+  char line[256];
+  uint64_t threads = 0;
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    unsigned long long value = 0;
+    if (sscanf(line, "Threads: %llu", &value) == 1) {
+      threads = value;
+      break;
+    }
+  }
+  fclose(file);
+  return threads;
+}
+
+double LeastSquaresSlope(const std::vector<double>& x,
+                         const std::vector<double>& y, size_t begin) {
+  const size_t n = x.size() - begin;
+  if (n < 2) {
+    return 0;
+  }
+  double mean_x = 0;
+  double mean_y = 0;
+  for (size_t i = begin; i < x.size(); ++i) {
+    mean_x += x[i];
+    mean_y += y[i];
+  }
+  mean_x /= n;
+  mean_y /= n;
+  double covariance = 0;
+  double variance = 0;
+  for (size_t i = begin; i < x.size(); ++i) {
+    covariance += (x[i] - mean_x) * (y[i] - mean_y);
+    variance += (x[i] - mean_x) * (x[i] - mean_x);
+  }
+  return variance > 0 ? covariance / variance : 0;
+}
+
+}  // namespace
+
+bool LoadSoakConfig(SoakConfig* config) {
+  const gchar* path = g_getenv(kConfigEnv);
+  if (path == nullptr || path[0] == '\0') {
+    return false;
+  }
+  g_autoptr(GKeyFile) key_file = g_key_file_new();
+  g_autoptr(GError) error = nullptr;
+  if (!g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, &error)) {
+    g_warning("Cannot read soak config %s: %s", path, error->message);
+    return false;
+  }
+
+  auto read_int = [&key_file](const char* key, int fallback) {
+    g_autoptr(GError) error = nullptr;
+    const gint value =
+        g_key_file_get_integer(key_file, kConfigGroup, key, &error);
+    return error == nullptr && value > 0 ? value : fallback;
+  };
+  g_autofree gchar* recording =
+      g_key_file_get_string(key_file, kConfigGroup, "recording", nullptr);
+  if (recording == nullptr || recording[0] == '\0') {
+    g_warning("Soak config %s has no recording", path);
+    return false;
+  }
+  config->recording = recording;
+  config->duration_minutes =
+      read_int("duration_minutes", config->duration_minutes);
+  config->tabs = read_int("tabs", config->tabs);
+  config->turns_per_session =
+      read_int("turns_per_session", config->turns_per_session);
+  config->sample_seconds = read_int("sample_seconds", config->sample_seconds);
+
+  g_autofree gchar* report =
+      g_key_file_get_string(key_file, kConfigGroup, "report", nullptr);
+  if (report != nullptr && report[0] != '\0') {
+    config->report = report;
+  } else {
+    const std::string name =
+        "soak-report-" + std::to_string(time(nullptr)) + ".json";
+    g_autofree gchar* default_report = g_build_filename(
+        g_get_user_cache_dir(), "codeagenthub", name.c_str(), nullptr);
+    config->report = default_report;
+  }
+
+  g_autoptr(GError) headless_error = nullptr;
+  const gboolean headless = g_key_file_get_boolean(key_file, kConfigGroup,
+                                                   "headless", &headless_error);
+  if (headless_error == nullptr) {
+    config->headless = headless;
+  }
+  return true;
+}
+
+void ReadProcessSample(SoakSample* sample) {
+  sample->rss_bytes = ReadRssBytes();
+  sample->open_fds = CountOpenFds();
+  sample->threads = CountThreads();
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  const struct mallinfo2 info = mallinfo2();
+#else
+  const struct mallinfo info = mallinfo();
+#endif
+  sample->heap_in_use_bytes =
+      static_cast<uint64_t>(info.uordblks) + static_cast<uint64_t>(info.hblkhd);
+  sample->heap_arena_bytes = static_cast<uint64_t>(info.arena);
+}
+
+SoakTrend AnalyzeSoakTrend(const std::string& metric,
+                           const std::vector<double>& seconds,
+                           const std::vector<double>& values,
+                           double min_growth, double min_delta) {
+  SoakTrend trend;
+  trend.metric = metric;
+  if (values.empty() || seconds.size() != values.size()) {
+    return trend;
+  }
+  const size_t warm_up = values.size() / 5;
+  const size_t measured = values.size() - warm_up;
+  trend.slope_per_hour = LeastSquaresSlope(seconds, values, warm_up) * 3600;
+  if (measured < kTrendWindows * 2) {
+    // Too short to tell a leak from noise.
+    trend.baseline = values[warm_up];
+    trend.latest = values.back();
+    return trend;
+  }
+
+  bool never_decreases = true;
+  double previous = 0;
+  for (size_t window = 0; window < kTrendWindows; ++window) {
+    const size_t begin = warm_up + measured * window / kTrendWindows;
+    const size_t end = warm_up + measured * (window + 1) / kTrendWindows;
+    const double minimum =
+        *std::min_element(values.begin() + begin, values.begin() + end);
+    if (window == 0) {
+      trend.baseline = minimum;
+    } else if (minimum < previous) {
+      never_decreases = false;
+    }
+    previous = minimum;
+  }
+  trend.latest = previous;
+
+  const double delta = trend.latest - trend.baseline;
+  trend.growing = never_decreases && delta > min_delta &&
+                  delta > trend.baseline * min_growth;
+  return trend;
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_soak_channel = nullptr;
+
+SoakConfig g_soak_config;
+bool g_soak_enabled = false;
+
+// Main thread only.
+std::vector<SoakSample> g_samples;
+std::map<std::string, double> g_dart_gauges;
+std::map<std::string, double> g_dart_counters;
+gint64 g_soak_started_at = 0;
+guint g_sample_source = 0;
+
+void TakeSample() {
+  SoakSample sample;
+  sample.elapsed_seconds =
+      (g_get_monotonic_time() - g_soak_started_at) / 1e6;
+  ReadProcessSample(&sample);
+  sample.gauges = g_dart_gauges;
+  sample.counters = g_dart_counters;
+  g_samples.push_back(std::move(sample));
+}
+
+gboolean OnSampleTimer(gpointer user_data) {
+  TakeSample();
+  return G_SOURCE_CONTINUE;
+}
+
+JsonValue NumberMap(const std::map<std::string, double>& values) {
+  JsonValue object = JsonValue::Object();
+  for (const auto& [name, value] : values) {
+    object.Set(name, JsonValue::Number(value));
+  }
+  return object;
+}
+
+JsonValue TrendToJson(const SoakTrend& trend) {
+  JsonValue object = JsonValue::Object();
+  object.Set("metric", JsonValue::String(trend.metric));
+  object.Set("baseline", JsonValue::Number(trend.baseline));
+  object.Set("latest", JsonValue::Number(trend.latest));
+  object.Set("slopePerHour", JsonValue::Number(trend.slope_per_hour));
+  object.Set("growing", JsonValue::Bool(trend.growing));
+  return object;
+}
+
+// Builds the report and returns the flagged metrics. Runs on the pool.
+JsonValue BuildReport(const SoakConfig& config,
+                      const std::vector<SoakSample>& samples,
+                      std::vector<std::string>* flagged) {
+  JsonValue report = JsonValue::Object();
+  JsonValue config_json = JsonValue::Object();
+  config_json.Set("recording", JsonValue::String(config.recording));
+  config_json.Set("durationMinutes",
+                  JsonValue::Integer(config.duration_minutes));
+  config_json.Set("tabs", JsonValue::Integer(config.tabs));
+  config_json.Set("turnsPerSession",
+                  JsonValue::Integer(config.turns_per_session));
+  config_json.Set("sampleSeconds", JsonValue::Integer(config.sample_seconds));
+  report.Set("config", std::move(config_json));
+  const double elapsed =
+      samples.empty() ? 0 : samples.back().elapsed_seconds;
+  report.Set("elapsedSeconds", JsonValue::Number(elapsed));
+
+  std::vector<double> seconds;
+  std::map<std::string, std::vector<double>> series;
+  std::set<std::string> gauge_names;
+  for (const SoakSample& sample : samples) {
+    for (const auto& [name, value] : sample.gauges) {
+      gauge_names.insert(name);
+    }
+  }
+  JsonValue samples_json = JsonValue::Array();
+  for (const SoakSample& sample : samples) {
+    seconds.push_back(sample.elapsed_seconds);
+    series["rssBytes"].push_back(sample.rss_bytes);
+    series["heapInUseBytes"].push_back(sample.heap_in_use_bytes);
+    series["openFds"].push_back(sample.open_fds);
+    series["threads"].push_back(sample.threads);
+    for (const std::string& name : gauge_names) {
+      // A gauge Dart has not reported yet counts as its first value.
+      auto it = sample.gauges.find(name);
+      auto& values = series[name];
+      values.push_back(it != sample.gauges.end()
+                           ? it->second
+                           : (values.empty() ? 0 : values.back()));
+    }
+
+    JsonValue sample_json = JsonValue::Object();
+    sample_json.Set("t", JsonValue::Number(sample.elapsed_seconds));
+    sample_json.Set("rssBytes", JsonValue::Integer(sample.rss_bytes));
+    sample_json.Set("heapInUseBytes",
+                    JsonValue::Integer(sample.heap_in_use_bytes));
+    sample_json.Set("heapArenaBytes",
+                    JsonValue::Integer(sample.heap_arena_bytes));
+    sample_json.Set("openFds", JsonValue::Integer(sample.open_fds));
+    sample_json.Set("threads", JsonValue::Integer(sample.threads));
+    sample_json.Set("dart", NumberMap(sample.gauges));
+    sample_json.Set("counters", NumberMap(sample.counters));
+    samples_json.Append(std::move(sample_json));
+  }
+
+  JsonValue trends_json = JsonValue::Array();
+  auto analyze = [&](const std::string& metric,
+                     const MetricThreshold& threshold) {
+    const SoakTrend trend =
+        AnalyzeSoakTrend(metric, seconds, series[metric],
+                         threshold.min_growth, threshold.min_delta);
+    if (trend.growing) {
+      flagged->push_back(metric);
+    }
+    trends_json.Append(TrendToJson(trend));
+  };
+  for (const MetricThreshold& threshold : kProcessThresholds) {
+    analyze(threshold.metric, threshold);
+  }
+  for (const std::string& name : gauge_names) {
+    const bool bytes = g_str_has_suffix(name.c_str(), "Bytes");
+    analyze(name, bytes ? kByteGaugeThreshold : kCountGaugeThreshold);
+  }
+  report.Set("trends", std::move(trends_json));
+
+  JsonValue flagged_json = JsonValue::Array();
+  for (const std::string& metric : *flagged) {
+    flagged_json.Append(JsonValue::String(metric));
+  }
+  report.Set("flagged", std::move(flagged_json));
+  report.Set("samples", std::move(samples_json));
+  return report;
+}
+
+FlValue* SoakConfigToFlValue(const SoakConfig& config) {
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "recording",
+                           fl_value_new_string(config.recording.c_str()));
+  fl_value_set_string_take(value, "durationMinutes",
+                           fl_value_new_int(config.duration_minutes));
+  fl_value_set_string_take(value, "tabs", fl_value_new_int(config.tabs));
+  fl_value_set_string_take(value, "turnsPerSession",
+                           fl_value_new_int(config.turns_per_session));
+  fl_value_set_string_take(value, "sampleSeconds",
+                           fl_value_new_int(config.sample_seconds));
+  fl_value_set_string_take(value, "report",
+                           fl_value_new_string(config.report.c_str()));
+  return value;
+}
+
+// Copies the numeric entries of a map argument into |out|.
+void LookupNumberMapArg(FlValue* args, const char* key,
+                        std::map<std::string, double>* out) {
+  FlValue* map = args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+                     ? fl_value_lookup_string(args, key)
+                     : nullptr;
+  if (map == nullptr || fl_value_get_type(map) != FL_VALUE_TYPE_MAP) {
+    return;
+  }
+  for (size_t i = 0; i < fl_value_get_length(map); ++i) {
+    FlValue* name = fl_value_get_map_key(map, i);
+    FlValue* number = fl_value_get_map_value(map, i);
+    if (fl_value_get_type(name) != FL_VALUE_TYPE_STRING) {
+      continue;
+    }
+    if (fl_value_get_type(number) == FL_VALUE_TYPE_INT) {
+      (*out)[fl_value_get_string(name)] =
+          static_cast<double>(fl_value_get_int(number));
+    } else if (fl_value_get_type(number) == FL_VALUE_TYPE_FLOAT) {
+      (*out)[fl_value_get_string(name)] = fl_value_get_float(number);
+    }
+  }
+}
+
+void HandleSoakCall(FlMethodChannel* channel, FlMethodCall* method_call,
+                    gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method == "getConfig") {
+    RespondSuccess(method_call, g_soak_enabled
+                                    ? SoakConfigToFlValue(g_soak_config)
+                                    : fl_value_new_null());
+  } else if (!g_soak_enabled) {
+    RespondError(method_call, "SOAK_ERROR", "Soak mode is off");
+  } else if (method == "report") {
+    LookupNumberMapArg(args, "gauges", &g_dart_gauges);
+    LookupNumberMapArg(args, "counters", &g_dart_counters);
+    RespondSuccess(method_call, nullptr);
+  } else if (method == "finish") {
+    if (g_sample_source != 0) {
+      g_source_remove(g_sample_source);
+      g_sample_source = 0;
+    }
+    TakeSample();
+    auto samples =
+        std::make_shared<std::vector<SoakSample>>(std::move(g_samples));
+    g_samples.clear();
+    const SoakConfig config = g_soak_config;
+    g_object_ref(method_call);
+    TaskPool::Get().PostBackground([method_call, samples, config]() {
+      auto flagged = std::make_shared<std::vector<std::string>>();
+      const std::string text =
+          BuildReport(config, *samples, flagged.get()).SerializePretty();
+      g_autofree gchar* dir = g_path_get_dirname(config.report.c_str());
+      g_mkdir_with_parents(dir, 0700);
+      g_autoptr(GError) error = nullptr;
+      const bool ok = g_file_set_contents(config.report.c_str(), text.data(),
+                                          text.size(), &error);
+      auto message = std::make_shared<std::string>(
+          ok ? std::string() : std::string(error->message));
+      const size_t sample_count = samples->size();
+      RunOnMainThread([method_call, config, flagged, message, ok,
+                       sample_count]() {
+        if (!ok) {
+          RespondError(method_call, "SOAK_ERROR",
+                       "Cannot write " + config.report + ": " + *message);
+        } else {
+          FlValue* result = fl_value_new_map();
+          fl_value_set_string_take(result, "report",
+                                   fl_value_new_string(config.report.c_str()));
+          fl_value_set_string_take(result, "samples",
+                                   fl_value_new_int(sample_count));
+          FlValue* names = fl_value_new_list();
+          for (const std::string& metric : *flagged) {
+            fl_value_append_take(names, fl_value_new_string(metric.c_str()));
+          }
+          fl_value_set_string_take(result, "flagged", names);
+          RespondSuccess(method_call, result);
+        }
+        g_object_unref(method_call);
+      });
+    });
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+}  // namespace
+
+void RegisterSoakChannel(FlBinaryMessenger* messenger,
+                         const SoakConfig* config) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_soak_channel = fl_method_channel_new(messenger, kChannelName,
+                                         FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(g_soak_channel, HandleSoakCall,
+                                            nullptr, nullptr);
+
+  if (config == nullptr) {
+    return;
+  }
+  g_soak_config = *config;
+  g_soak_enabled = true;
+  g_soak_started_at = g_get_monotonic_time();
+  TakeSample();
+  g_sample_source = g_timeout_add_seconds(g_soak_config.sample_seconds,
+                                          OnSampleTimer, nullptr);
+}
@@ -0,0 +1,80 @@
+#ifndef RUNNER_SOAK_MONITOR_H_
+#define RUNNER_SOAK_MONITOR_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Soak mode replays recorded agent turns for hours and watches the process
+// for leaks. It is enabled by pointing CODEAGENTHUB_SOAK at a key file:
+//
+//   [soak]
+//   recording=/path/to/turns.jsonl
+//   duration_minutes=240
+//   tabs=4
+//   turns_per_session=20
+//   sample_seconds=30
+//   report=/path/to/soak-report.json
+//   headless=true
+//
+// The runner samples the process itself; Dart drives the replay and adds its
+// own gauges (heap, retained messages) to each sample.
+struct SoakConfig {
+  std::string recording;
+  int duration_minutes = 60;
+  int tabs = 4;
+  int turns_per_session = 20;
+  int sample_seconds = 30;
+  std::string report;
+  // Keep the window unmapped; the view is only realized so the engine runs.
+  bool headless = true;
+};
+
+// Reads the soak configuration. Returns false when soak mode is off.
+bool LoadSoakConfig(SoakConfig* config);
+
+struct SoakSample {
+  double elapsed_seconds = 0;
+  uint64_t rss_bytes = 0;
+  // glibc malloc: bytes in use (including mmapped chunks) and arena size.
+  uint64_t heap_in_use_bytes = 0;
+  uint64_t heap_arena_bytes = 0;
+  uint64_t open_fds = 0;
+  uint64_t threads = 0;
+  // Latest values reported by Dart.
+  std::map<std::string, double> gauges;
+  std::map<std::string, double> counters;
+};
+
+// Fills the process fields of |sample| from /proc and the allocator.
+void ReadProcessSample(SoakSample* sample);
+
+struct SoakTrend {
+  std::string metric;
+  double baseline = 0;  // Minimum of the first window after warm-up.
+  double latest = 0;    // Minimum of the last window.
+  double slope_per_hour = 0;
+  bool growing = false;
+};
+
+// Looks for steady growth in |values| sampled at |seconds|. The first fifth
+// of the run is treated as warm-up; the rest is cut into windows and each
+// window is reduced to its minimum, so transient peaks inside a turn do not
+// count. A metric is flagged when the window minima never decrease and the
+// last one exceeds the first by more than |min_growth| (relative) and
+// |min_delta| (absolute).
+SoakTrend AnalyzeSoakTrend(const std::string& metric,
+                           const std::vector<double>& seconds,
+                           const std::vector<double>& values,
+                           double min_growth, double min_delta);
+
+// Registers the "com.codeagenthub/soak" method channel. |config| is the
+// loaded soak configuration, or nullptr outside soak mode; with a config,
+// sampling starts right away.
+void RegisterSoakChannel(FlBinaryMessenger* messenger,
+                         const SoakConfig* config);
+
+#endif  // RUNNER_SOAK_MONITOR_H_
@@ -0,0 +1,553 @@
+#include "stream_normalizer.h"
+
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "frame_pacing.h"
+#include "method_call_utils.h"
+#include "run_journal.h"
+#include "stream_quality.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/stream_normalizer";
+
+bool IsAsciiSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' ||
+         c == '\v';
+}
+
+bool StartsWith(const char* data, size_t size, const char* prefix) {
+  const size_t length = strlen(prefix);
+  return size >= length && memcmp(data, prefix, length) == 0;
+}
+
+JsonValue Delta(const char* type) {
+  JsonValue delta = JsonValue::Object();
+  delta.Set("t", JsonValue::String(type));
+  return delta;
+}
+
+JsonValue BlockDelta(const char* type, const std::string& message,
+                     int64_t index) {
+  JsonValue delta = Delta(type);
+  delta.Set("message", JsonValue::String(message));
+  delta.Set("index", JsonValue::Integer(index));
+  return delta;
+}
+
+JsonValue TextBlock(const std::string& text) {
+  JsonValue block = JsonValue::Object();
+  block.Set("type", JsonValue::String("text"));
+  block.Set("text", JsonValue::String(text));
+  return block;
+}
+
+}  // namespace
+
+StreamNormalizer::StreamNormalizer(StreamSchema schema, std::string message_id)
+    : schema_(schema), codex_message_id_(std::move(message_id)) {}
+
+void StreamNormalizer::Feed(const char* data, size_t size,
+                            std::vector<JsonValue>* deltas) {
+  // Only the new bytes are scanned for line breaks; a long data line that
+  // arrives in many chunks is still examined once.
+  size_t start = 0;
+  size_t scan = line_.size();
+  line_.append(data, size);
+  for (;;) {
+    const size_t newline = line_.find('\n', scan);
+    if (newline == std::string::npos) {
+      break;
+    }
+    HandleLine(line_.data() + start, newline - start, deltas);
+    start = newline + 1;
+    scan = start;
+  }
+  line_.erase(0, start);
+}
+
+void StreamNormalizer::Close(std::vector<JsonValue>* deltas) {
+  // An unterminated last line is dropped, as the Dart decoder does.
+  line_.clear();
+  if (schema_ == StreamSchema::kCodex) {
+    FlushCodexText(deltas);
+  }
+}
+
+void StreamNormalizer::HandleLine(const char* line, size_t size,
+                                  std::vector<JsonValue>* deltas) {
+  while (size > 0 && IsAsciiSpace(line[0])) {
+    ++line;
+    --size;
+  }
+  while (size > 0 && IsAsciiSpace(line[size - 1])) {
+    --size;
+  }
+  if (size == 0) {
+    event_type_.clear();  // A blank line ends the event.
+    return;
+  }
+  if (StartsWith(line, size, "event: ")) {
+    event_type_.assign(line + 7, size - 7);
+    return;
+  }
+  if (!StartsWith(line, size, "data: ") || event_type_.empty()) {
+    return;
+  }
+  JsonValue event;
+  std::string error;
+  if (!ParseJson(line + 6, size - 6, &event, &error) || !event.is_object()) {
+    return;  // Skip invalid JSON.
+  }
+  HandleEvent(event_type_, event, deltas);
+}
+
+void StreamNormalizer::HandleEvent(const std::string& type,
+                                   const JsonValue& event,
+                                   std::vector<JsonValue>* deltas) {
+  if (type == "run") {
+    const std::string& run_id = event["run_id"].AsString();
+    if (!run_id.empty()) {
+      JsonValue delta = Delta("run");
+      delta.Set("id", JsonValue::String(run_id));
+      deltas->push_back(std::move(delta));
+    }
+    return;
+  }
+
+  const std::string& session_id = event["session_id"].AsString();
+  if (!session_emitted_ && !session_id.empty()) {
+    JsonValue delta = Delta("session");
+    delta.Set("id", JsonValue::String(session_id));
+    deltas->push_back(std::move(delta));
+    session_emitted_ = true;
+  }
+
+  if (type == "token") {
+    const std::string& text = event["text"].AsString();
+    if (!text.empty()) {
+      HandleToken(text, deltas);
+    }
+  } else if (type == "message") {
+    HandlePayload(event["payload"], deltas);
+  } else if (type == "done") {
+    if (schema_ == StreamSchema::kCodex) {
+      FlushCodexText(deltas);
+    } else if (!current_.empty()) {
+      Message& message = messages_[current_];
+      if (!message.finalized && message.mode == Mode::kTokens) {
+        JsonValue delta = Delta("final");
+        delta.Set("message", JsonValue::String(current_));
+        deltas->push_back(std::move(delta));
+      }
+      message.finalized = true;
+      message.mode = Mode::kFinalized;
+    }
+    deltas->push_back(Delta("done"));
+  } else if (type == "error") {
+    const JsonValue& message = event["message"];
+    JsonValue delta = Delta("error");
+    delta.Set("message",
+              JsonValue::String(message.is_string() ? message.AsString()
+                                : message.is_null() ? "Unknown error"
+                                                    : message.Serialize()));
+    deltas->push_back(std::move(delta));
+  }
+}
+
+void StreamNormalizer::HandleToken(const std::string& text,
+                                   std::vector<JsonValue>* deltas) {
+  if (schema_ == StreamSchema::kCodex) {
+    codex_text_.append(text);
+    EmitText(codex_message_id_, 0, text, deltas);
+    return;
+  }
+
+  if (!current_.empty()) {
+    const Mode mode = messages_[current_].mode;
+    // Once stream events drive the message, tokens duplicate their text.
+    if (mode == Mode::kStreamEvents || mode == Mode::kFinalized) {
+      return;
+    }
+  } else {
+    current_ = NewId("temp");
+  }
+  Message& message = messages_[current_];
+  message.mode = Mode::kTokens;
+  message.blocks[0].type = "text";
+  EmitText(current_, 0, text, deltas);
+}
+
+void StreamNormalizer::HandlePayload(const JsonValue& payload,
+                                     std::vector<JsonValue>* deltas) {
+  const std::string& type = payload["type"].AsString();
+  if (type == "stream_event") {
+    HandleStreamEvent(payload["event"], deltas);
+  } else if (type == "result") {
+    JsonValue delta = Delta("stats");
+    delta.Set("payload", payload);
+    deltas->push_back(std::move(delta));
+  } else if (schema_ == StreamSchema::kCodex) {
+    if (type != "item.completed") {
+      return;
+    }
+    const JsonValue& item = payload["item"];
+    const std::string& text = item["text"].AsString();
+    if (item["type"].AsString() == "agent_message" && !text.empty() &&
+        !codex_final_emitted_) {
+      JsonValue blocks = JsonValue::Array();
+      blocks.Append(TextBlock(text));
+      EmitMessage(codex_message_id_, "assistant", std::move(blocks), deltas);
+      codex_final_emitted_ = true;
+    }
+  } else if (type == "user") {
+    // Usually tool results; they are shown on the assistant side.
+    const JsonValue& content = payload["message"]["content"];
+    if (!content.is_array() || content.items().empty()) {
+      return;
+    }
+    bool only_tool_results = true;
+    for (const JsonValue& block : content.items()) {
+      if (block["type"].AsString() != "tool_result") {
+        only_tool_results = false;
+      }
+    }
+    std::string id = payload["uuid"].AsString();
+    if (id.empty()) {
+      id = payload["id"].AsString();
+    }
+    if (id.empty()) {
+      id = NewId("user");
+    }
+    EmitMessage(id, only_tool_results ? "assistant" : "user", content, deltas);
+  } else if (type == "assistant") {
+    // A complete message duplicates one that stream events already built.
+    // Otherwise it was not streamed, or only its text arrived as tokens; then
+    // it replaces the token placeholder with the full blocks. The SDK nests
+    // the API message, with its id and content, under "message".
+    const JsonValue& api_message = payload["message"];
+    std::string id = api_message["id"].AsString();
+    if (!id.empty() && messages_.count(id) != 0) {
+      return;
+    }
+    const JsonValue& content = api_message["content"];
+    if (!content.is_array() || content.items().empty()) {
+      return;
+    }
+    if (!current_.empty() && messages_[current_].mode == Mode::kTokens) {
+      id = current_;
+      current_.clear();
+    } else if (id.empty()) {
+      id = NewId("assistant");
+    }
+    Message& message = messages_[id];
+    message.mode = Mode::kFinalized;
+    message.finalized = true;
+    EmitMessage(id, "assistant", content, deltas);
+  }
+}
+
+void StreamNormalizer::HandleStreamEvent(const JsonValue& event,
+                                         std::vector<JsonValue>* deltas) {
+  const std::string& type = event["type"].AsString();
+
+  if (type == "message_start") {
+    const std::string& id = event["message"]["id"].AsString();
+    if (id.empty()) {
+      return;
+    }
+    JsonValue delta = Delta("start");
+    delta.Set("message", JsonValue::String(id));
+    if (StartsWith(current_.data(), current_.size(), "temp_")) {
+      // Stream events rebuild the text the placeholder collected from tokens.
+      Message placeholder = std::move(messages_[current_]);
+      messages_.erase(current_);
+      if (placeholder.mode == Mode::kTokens) {
+        placeholder.blocks.clear();
+        delta.Set("replaces", JsonValue::String(current_));
+      }
+      messages_[id] = std::move(placeholder);
+    }
+    messages_[id].mode = Mode::kStreamEvents;
+    current_ = id;
+    deltas->push_back(std::move(delta));
+    return;
+  }
+
+  auto it = messages_.find(current_);
+  if (it == messages_.end()) {
+    return;
+  }
+  Message& message = it->second;
+
+  if (type == "content_block_start") {
+    const JsonValue& index_value = event["index"];
+    const JsonValue& content_block = event["content_block"];
+    if (!index_value.is_integer() || !content_block.is_object()) {
+      return;
+    }
+    const int64_t index = index_value.AsInt();
+    std::string block_type = content_block["type"].AsString();
+    if (block_type.empty()) {
+      block_type = "text";
+    }
+    Block& block = message.blocks[index];
+    block.type = block_type;
+    if (block_type == "text") {
+      const std::string& text = content_block["text"].AsString();
+      if (!text.empty()) {
+        EmitText(current_, index, text, deltas);
+      }
+    } else if (block_type == "tool_use") {
+      block.input = std::make_unique<PartialJsonParser>();
+      JsonValue delta = BlockDelta("tool", current_, index);
+      delta.Set("id", content_block["id"]);
+      delta.Set("name", content_block["name"]);
+      deltas->push_back(std::move(delta));
+    } else if (block_type == "tool_result" &&
+               schema_ == StreamSchema::kClaude) {
+      JsonValue blocks = JsonValue::Array();
+      blocks.Append(content_block);
+      EmitMessage(NewId("tool_result") + "_" + std::to_string(index),
+                  "assistant", std::move(blocks), deltas);
+    }
+  } else if (type == "content_block_delta") {
+    const int64_t index = event["index"].AsInt(0);
+    const JsonValue& delta = event["delta"];
+    const std::string& delta_type = delta["type"].AsString();
+    if (delta_type == "text_delta") {
+      Block& block = message.blocks[index];
+      if (block.type.empty()) {
+        block.type = "text";
+      }
+      EmitText(current_, index, delta["text"].AsString(), deltas);
+    } else if (delta_type == "input_json_delta") {
+      auto block = message.blocks.find(index);
+      if (block == message.blocks.end() || block->second.type != "tool_use") {
+        return;
+      }
+      const std::string& fragment = delta["partial_json"].AsString();
+      block->second.input_json.append(fragment);
+      PartialJsonParser* parser = block->second.input.get();
+      std::vector<PartialJsonUpdate> updates;
+      if (parser != nullptr && !parser->failed() &&
+          parser->Feed(fragment.data(), fragment.size(), &updates) &&
+          !updates.empty()) {
+        JsonValue input = BlockDelta("input", current_, index);
+        input.Set("updates", PartialJsonUpdatesToJson(updates));
+        deltas->push_back(std::move(input));
+      }
+    }
+  } else if (type == "content_block_stop") {
+    const JsonValue& index_value = event["index"];
+    if (!index_value.is_integer()) {
+      return;
+    }
+    const int64_t index = index_value.AsInt();
+    JsonValue delta = BlockDelta("stop", current_, index);
+    auto block = message.blocks.find(index);
+    if (block != message.blocks.end() && block->second.type == "tool_use") {
+      // The whole text is authoritative; the incremental tree was a preview.
+      JsonValue input;
+      std::string error;
+      if (!block->second.input_json.empty() &&
+          ParseJson(block->second.input_json, &input, &error) &&
+          input.is_object()) {
+        delta.Set("input", std::move(input));
+      }
+      block->second.input.reset();
+      block->second.input_json.clear();
+    }
+    deltas->push_back(std::move(delta));
+  } else if (type == "message_stop") {
+    if (!message.finalized) {
+      JsonValue delta = Delta("final");
+      delta.Set("message", JsonValue::String(current_));
+      deltas->push_back(std::move(delta));
+      message.finalized = true;
+      message.mode = Mode::kFinalized;
+    }
+  }
+}
+
+void StreamNormalizer::FlushCodexText(std::vector<JsonValue>* deltas) {
+  if (codex_text_.empty() || codex_final_emitted_) {
+    return;
+  }
+  JsonValue blocks = JsonValue::Array();
+  blocks.Append(TextBlock(codex_text_));
+  EmitMessage(codex_message_id_, "assistant", std::move(blocks), deltas);
+  codex_final_emitted_ = true;
+}
+
+void StreamNormalizer::EmitText(const std::string& message, int64_t index,
+                                const std::string& text,
+                                std::vector<JsonValue>* deltas) {
+  if (text.empty()) {
+    return;
+  }
+  if (!deltas->empty()) {
+    JsonValue& last = deltas->back();
+    if (last["t"].AsString() == "text" &&
+        last["message"].AsString() == message &&
+        last["index"].AsInt(-1) == index) {
+      last.Find("text")->mutable_string()->append(text);
+      return;
+    }
+  }
+  JsonValue delta = BlockDelta("text", message, index);
+  delta.Set("text", JsonValue::String(text));
+  deltas->push_back(std::move(delta));
+}
+
+void StreamNormalizer::EmitMessage(const std::string& message,
+                                   const char* role, JsonValue blocks,
+                                   std::vector<JsonValue>* deltas) {
+  JsonValue delta = Delta("message");
+  delta.Set("message", JsonValue::String(message));
+  delta.Set("role", JsonValue::String(role));
+  delta.Set("blocks", std::move(blocks));
+  deltas->push_back(std::move(delta));
+}
+
+std::string StreamNormalizer::NewId(const char* prefix) {
+  // The counter keeps ids made within the same millisecond apart.
+  return std::string(prefix) + "_" +
+         std::to_string(g_get_real_time() / 1000) + "_" +
+         std::to_string(next_id_++);
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_stream_normalizer_channel = nullptr;
+
+// Normalizers by stream id. The Dart side awaits each feed before sending
+// the next chunk, so a stream never has two feeds in flight and pool tasks
+// for it run in order.
+std::mutex g_normalizers_mutex;
+std::unordered_map<std::string, std::shared_ptr<StreamNormalizer>>
+    g_normalizers;
+
+std::shared_ptr<StreamNormalizer> FindNormalizer(const std::string& id) {
+  std::lock_guard<std::mutex> lock(g_normalizers_mutex);
+  auto it = g_normalizers.find(id);
+  return it != g_normalizers.end() ? it->second : nullptr;
+}
+
+FlValue* DeltasToFlValue(const std::vector<JsonValue>& deltas) {
+  FlValue* list = fl_value_new_list();
+  for (const JsonValue& delta : deltas) {
+    fl_value_append_take(list, JsonToFlValue(delta));
+  }
+  return list;
+}
+
+void HandleStreamNormalizerCall(FlMethodChannel* channel,
+                                FlMethodCall* method_call,
+                                gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+  const std::string stream_id = LookupStringArg(args, "streamId");
+  if (stream_id.empty()) {
+    RespondError(method_call, "INVALID_ARGUMENTS", "streamId is required");
+    return;
+  }
+
+  if (method == "open") {
+    const StreamSchema schema = LookupStringArg(args, "schema") == "codex"
+                                    ? StreamSchema::kCodex
+                                    : StreamSchema::kClaude;
+    auto normalizer = std::make_shared<StreamNormalizer>(
+        schema, LookupStringArg(args, "messageId"));
+    bool reopened;
+    {
+      std::lock_guard<std::mutex> lock(g_normalizers_mutex);
+      reopened = !g_normalizers.insert_or_assign(stream_id,
+                                                 std::move(normalizer))
+                      .second;
+    }
+    if (!reopened) {
+      FramePacingStreamOpened();
+    }
+    // The prompt arrives as JSON content blocks; an unparsable one is
+    // journaled as an empty message.
+    JsonValue prompt;
+    std::string error;
+    if (!ParseJson(LookupStringArg(args, "prompt", "[]"), &prompt, &error)) {
+      prompt = JsonValue::Array();
+    }
+    RunJournalStreamOpened(stream_id, LookupStringArg(args, "sessionId"),
+                           prompt);
+    RespondSuccess(method_call, nullptr);
+  } else if (method == "feed") {
+    auto normalizer = FindNormalizer(stream_id);
+    FlValue* data = args != nullptr ? fl_value_lookup_string(args, "data")
+                                    : nullptr;
+    if (normalizer == nullptr || data == nullptr ||
+        fl_value_get_type(data) != FL_VALUE_TYPE_UINT8_LIST) {
+      RespondError(method_call, "INVALID_ARGUMENTS",
+                   "open stream and data bytes are required");
+      return;
+    }
+    auto bytes = std::make_shared<std::string>(
+        reinterpret_cast<const char*>(fl_value_get_uint8_list(data)),
+        fl_value_get_length(data));
+    g_object_ref(method_call);
+    TaskPool::Get().Post([method_call, stream_id, normalizer, bytes]() {
+      auto deltas = std::make_shared<std::vector<JsonValue>>();
+      normalizer->Feed(bytes->data(), bytes->size(), deltas.get());
+      FramePacingStreamEvents(deltas->size());
+      RunJournalStreamDeltas(stream_id, *deltas);
+      if (!deltas->empty()) {
+        // Leads the batch so Dart sees it even when it stops at done.
+        JsonValue batch = Delta("batch");
+        batch.Set("seq", JsonValue::Integer(static_cast<int64_t>(
+                             StreamQualityBatchQueued(stream_id))));
+        deltas->insert(deltas->begin(), std::move(batch));
+      }
+      RunOnMainThread([method_call, deltas]() {
+        RespondSuccess(method_call, DeltasToFlValue(*deltas));
+        g_object_unref(method_call);
+      });
+    });
+  } else if (method == "close") {
+    std::shared_ptr<StreamNormalizer> normalizer;
+    {
+      std::lock_guard<std::mutex> lock(g_normalizers_mutex);
+      auto it = g_normalizers.find(stream_id);
+      if (it != g_normalizers.end()) {
+        normalizer = std::move(it->second);
+        g_normalizers.erase(it);
+      }
+    }
+    std::vector<JsonValue> deltas;
+    if (normalizer != nullptr) {
+      normalizer->Close(&deltas);
+      FramePacingStreamClosed();
+      RunJournalStreamDeltas(stream_id, deltas);
+      RunJournalStreamClosed(stream_id);
+    }
+    // Batches Dart fetched but never applied (the stream was stopped or its
+    // tab closed) are not UI backlog.
+    StreamQualityStreamClosed(stream_id);
+    RespondSuccess(method_call, DeltasToFlValue(deltas));
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+}  // namespace
+
+void RegisterStreamNormalizerChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_stream_normalizer_channel = fl_method_channel_new(
+      messenger, kChannelName, FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_stream_normalizer_channel, HandleStreamNormalizerCall, nullptr,
+      nullptr);
+}
@@ -0,0 +1,99 @@
+#ifndef RUNNER_STREAM_NORMALIZER_H_
+#define RUNNER_STREAM_NORMALIZER_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "json_value.h"
+#include "partial_json.h"
+
+enum class StreamSchema { kClaude, kCodex };
+
+// Turns the raw SSE body of /chat or /codex/chat into one compact stream of
+// message deltas. Each delta is a JSON object whose "t" member is one of:
+//
+//   session {id}                  The backend assigned a session id.
+//   run     {id}                  Run id for stopping a Claude task.
+//   start   {message, replaces?}  A streamed assistant message began; a
+//                                 token-mode placeholder may be replaced.
+//   text    {message, index, text}          Text appended to a block.
+//   tool    {message, index, id, name}      A tool_use block began.
+//   input   {message, index, updates}       Field updates to its input.
+//   stop    {message, index, input?}        A block is complete.
+//   final   {message}             A streamed message is complete.
+//   message {message, role, blocks}         A complete standalone message.
+//   stats   {payload}             The result payload with usage and cost.
+//   done, error {message}
+//   batch   {seq}                 Added by the channel ahead of each fed
+//                                 batch; Dart reports it applied (see
+//                                 stream_quality.h).
+//
+// Text deltas for the same block within one Feed() are merged, so the
+// consumer does work per network chunk instead of per backend event.
+class StreamNormalizer {
+ public:
+  // |message_id| names the single assistant message of a Codex turn.
+  StreamNormalizer(StreamSchema schema, std::string message_id);
+
+  void Feed(const char* data, size_t size, std::vector<JsonValue>* deltas);
+
+  // Signals the end of the body, whether or not a done event arrived.
+  void Close(std::vector<JsonValue>* deltas);
+
+ private:
+  enum class Mode { kIdle, kTokens, kStreamEvents, kFinalized };
+
+  struct Block {
+    std::string type;
+    std::string input_json;
+    std::unique_ptr<PartialJsonParser> input;
+  };
+
+  struct Message {
+    Mode mode = Mode::kIdle;
+    std::map<int64_t, Block> blocks;
+    bool finalized = false;
+  };
+
+  void HandleLine(const char* line, size_t size,
+                  std::vector<JsonValue>* deltas);
+  void HandleEvent(const std::string& type, const JsonValue& event,
+                   std::vector<JsonValue>* deltas);
+  void HandleToken(const std::string& text, std::vector<JsonValue>* deltas);
+  void HandlePayload(const JsonValue& payload,
+                     std::vector<JsonValue>* deltas);
+  void HandleStreamEvent(const JsonValue& event,
+                         std::vector<JsonValue>* deltas);
+  void FlushCodexText(std::vector<JsonValue>* deltas);
+
+  void EmitText(const std::string& message, int64_t index,
+                const std::string& text, std::vector<JsonValue>* deltas);
+  void EmitMessage(const std::string& message, const char* role,
+                   JsonValue blocks, std::vector<JsonValue>* deltas);
+  std::string NewId(const char* prefix);
+
+  const StreamSchema schema_;
+  const std::string codex_message_id_;
+
+  // SSE framing state.
+  std::string line_;
+  std::string event_type_;
+
+  bool session_emitted_ = false;
+  std::map<std::string, Message> messages_;
+  std::string current_;
+  uint64_t next_id_ = 0;
+
+  std::string codex_text_;
+  bool codex_final_emitted_ = false;
+};
+
+// Registers the "com.codeagenthub/stream_normalizer" method channel.
+void RegisterStreamNormalizerChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_STREAM_NORMALIZER_H_
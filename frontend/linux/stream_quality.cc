@@ -0,0 +1,359 @@
+#include "stream_quality.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+
+#include "method_call_utils.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/stream_quality";
+const char kEventChannelName[] = "com.codeagenthub/stream_quality_events";
+
+// How often pending batches are checked while streaming or degraded, so the
+// level can recover without painted frames.
+const guint kTickIntervalMs = 250;
+
+// At most this many latency samples are kept, however fast batches arrive.
+const size_t kMaxSamples = 1024;
+
+const char* StreamQualityLevelName(StreamQualityLevel level) {
+  switch (level) {
+    case StreamQualityLevel::kFull:
+      return "full";
+    case StreamQualityLevel::kReduced:
+      return "reduced";
+    case StreamQualityLevel::kMinimal:
+      return "minimal";
+  }
+  return "full";
+}
+
+}  // namespace
+
+StreamQuality ComputeStreamQuality(StreamQualityLevel level) {
+  StreamQuality quality;
+  quality.level = level;
+  switch (level) {
+    case StreamQualityLevel::kFull:
+      break;
+    case StreamQualityLevel::kReduced:
+      quality.stream_coalesce_ms = 100;
+      quality.defer_background_rendering = true;
+      break;
+    case StreamQualityLevel::kMinimal:
+      quality.stream_coalesce_ms = 250;
+      quality.defer_background_rendering = true;
+      quality.collapse_tool_result_chars = 4000;
+      break;
+  }
+  return quality;
+}
+
+uint64_t StreamQualityController::BatchQueued(const std::string& stream,
+                                              int64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint64_t batch = next_batch_++;
+  Pending& pending = pending_[batch];
+  pending.stream = stream;
+  pending.queued_us = now_us;
+  return batch;
+}
+
+void StreamQualityController::StreamClosed(const std::string& stream,
+                                           int64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& entry : pending_) {
+    if (entry.second.closed_us == 0 && entry.second.stream == stream) {
+      entry.second.closed_us = now_us;
+    }
+  }
+}
+
+void StreamQualityController::BatchesApplied(
+    const std::vector<uint64_t>& batches, int64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (uint64_t batch : batches) {
+    auto it = pending_.find(batch);
+    if (it == pending_.end()) {
+      continue;
+    }
+    applied_.push_back({it->second.queued_us, now_us});
+    pending_.erase(it);
+  }
+}
+
+void StreamQualityController::FramePresented(int64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const Applied& applied : applied_) {
+    AddSample(now_us, now_us - applied.queued_us);
+  }
+  applied_.clear();
+}
+
+void StreamQualityController::Expire(int64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto waiting = std::remove_if(
+      applied_.begin(), applied_.end(), [&](const Applied& applied) {
+        if (now_us - applied.applied_us < kPresentWaitUs) {
+          return false;
+        }
+        AddSample(now_us, applied.applied_us - applied.queued_us);
+        return true;
+      });
+  applied_.erase(waiting, applied_.end());
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    const Pending& pending = it->second;
+    const bool abandoned = now_us - pending.queued_us >= kAbandonUs ||
+                           (pending.closed_us != 0 &&
+                            now_us - pending.closed_us >= kClosedGraceUs);
+    it = abandoned ? pending_.erase(it) : std::next(it);
+  }
+}
+
+bool StreamQualityController::Evaluate(int64_t now_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (now_us - last_evaluated_us_ < kEvaluateIntervalUs) {
+    return false;
+  }
+  last_evaluated_us_ = now_us;
+  DropOldSamples(now_us);
+
+  const int64_t backlog = Backlog(now_us);
+  const int64_t latency = std::max(LatencyP90(), backlog);
+  if (latency > kBudgetUs) {
+    calm_since_us_ = 0;
+    if (++over_budget_ < kDegradeAfter ||
+        level_ == StreamQualityLevel::kMinimal) {
+      return false;
+    }
+    over_budget_ = 0;
+    level_ = static_cast<StreamQualityLevel>(static_cast<int>(level_) + 1);
+    // Judge the new level by its own frames.
+    samples_.clear();
+    return true;
+  }
+
+  over_budget_ = 0;
+  if (latency >= kBudgetUs / 2) {
+    calm_since_us_ = 0;
+    return false;
+  }
+  if (calm_since_us_ == 0) {
+    calm_since_us_ = now_us;
+  }
+  if (level_ == StreamQualityLevel::kFull ||
+      now_us - calm_since_us_ < kRestoreAfterUs) {
+    return false;
+  }
+  level_ = static_cast<StreamQualityLevel>(static_cast<int>(level_) - 1);
+  calm_since_us_ = now_us;
+  samples_.clear();
+  return true;
+}
+
+bool StreamQualityController::idle() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_.empty() && applied_.empty() &&
+         level_ == StreamQualityLevel::kFull;
+}
+
+StreamQuality StreamQualityController::Current(int64_t now_us) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StreamQuality quality = ComputeStreamQuality(level_);
+  quality.apply_latency_p90_us = LatencyP90();
+  quality.backlog_us = Backlog(now_us);
+  quality.pending_batches = std::count_if(
+      pending_.begin(), pending_.end(),
+      [](const auto& entry) { return entry.second.closed_us == 0; });
+  return quality;
+}
+
+void StreamQualityController::AddSample(int64_t now_us, int64_t latency_us) {
+  samples_.emplace_back(now_us, std::max<int64_t>(latency_us, 0));
+  if (samples_.size() > kMaxSamples) {
+    samples_.pop_front();
+  }
+}
+
+void StreamQualityController::DropOldSamples(int64_t now_us) {
+  while (!samples_.empty() && now_us - samples_.front().first > kWindowUs) {
+    samples_.pop_front();
+  }
+}
+
+int64_t StreamQualityController::LatencyP90() const {
+  if (samples_.empty()) {
+    return 0;
+  }
+  std::vector<int64_t> latencies;
+  latencies.reserve(samples_.size());
+  for (const auto& sample : samples_) {
+    latencies.push_back(sample.second);
+  }
+  const size_t rank = (latencies.size() * 9) / 10;
+  std::nth_element(latencies.begin(), latencies.begin() + rank,
+                   latencies.end());
+  return latencies[rank];
+}
+
+int64_t StreamQualityController::Backlog(int64_t now_us) const {
+  // Sequence numbers grow with queue time, so the first batch of an open
+  // stream is the oldest.
+  for (const auto& entry : pending_) {
+    if (entry.second.closed_us == 0) {
+      return std::max<int64_t>(now_us - entry.second.queued_us, 0);
+    }
+  }
+  return 0;
+}
+
+// Runner glue.
+
+namespace {
+
+StreamQualityController g_controller;
+std::atomic<bool> g_ticking{false};
+
+FlMethodChannel* g_stream_quality_channel = nullptr;
+FlEventChannel* g_quality_events_channel = nullptr;
+bool g_quality_events_listening = false;
+
+FlValue* StreamQualityToFlValue(const StreamQuality& quality) {
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(
+      result, "level",
+      fl_value_new_string(StreamQualityLevelName(quality.level)));
+  fl_value_set_string_take(result, "streamCoalesceMs",
+                           fl_value_new_int(quality.stream_coalesce_ms));
+  fl_value_set_string_take(
+      result, "deferBackgroundRendering",
+      fl_value_new_bool(quality.defer_background_rendering));
+  fl_value_set_string_take(
+      result, "collapseToolResultChars",
+      fl_value_new_int(static_cast<int64_t>(
+          quality.collapse_tool_result_chars)));
+  fl_value_set_string_take(result, "applyLatencyP90Us",
+                           fl_value_new_int(quality.apply_latency_p90_us));
+  fl_value_set_string_take(result, "backlogUs",
+                           fl_value_new_int(quality.backlog_us));
+  fl_value_set_string_take(
+      result, "pendingBatches",
+      fl_value_new_int(static_cast<int64_t>(quality.pending_batches)));
+  return result;
+}
+
+// Re-evaluates the level and tells Dart when it changed.
+void EvaluateQuality(int64_t now_us) {
+  if (!g_controller.Evaluate(now_us)) {
+    return;
+  }
+  const StreamQuality quality = g_controller.Current(now_us);
+  g_debug("Stream quality %s (apply p90 %lld us, backlog %lld us)",
+          StreamQualityLevelName(quality.level),
+          static_cast<long long>(quality.apply_latency_p90_us),
+          static_cast<long long>(quality.backlog_us));
+  if (g_quality_events_listening) {
+    g_autoptr(FlValue) event = StreamQualityToFlValue(quality);
+    g_autoptr(GError) error = nullptr;
+    if (!fl_event_channel_send(g_quality_events_channel, event, nullptr,
+                               &error)) {
+      g_warning("Failed to send stream quality: %s", error->message);
+    }
+  }
+}
+
+gboolean OnQualityTick(gpointer user_data) {
+  const int64_t now = g_get_monotonic_time();
+  g_controller.Expire(now);
+  EvaluateQuality(now);
+  if (g_controller.idle()) {
+    g_ticking = false;
+    // A batch queued since the check above must not be left without a tick.
+    if (g_controller.idle() || g_ticking.exchange(true)) {
+      return G_SOURCE_REMOVE;
+    }
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+void HandleStreamQualityCall(FlMethodChannel* channel,
+                             FlMethodCall* method_call, gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+  if (method == "applied") {
+    FlValue* batches =
+        args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+            ? fl_value_lookup_string(args, "batches")
+            : nullptr;
+    if (batches == nullptr ||
+        fl_value_get_type(batches) != FL_VALUE_TYPE_LIST) {
+      RespondError(method_call, "INVALID_ARGUMENTS", "batches is required");
+      return;
+    }
+    std::vector<uint64_t> applied;
+    for (size_t i = 0; i < fl_value_get_length(batches); ++i) {
+      FlValue* batch = fl_value_get_list_value(batches, i);
+      if (fl_value_get_type(batch) == FL_VALUE_TYPE_INT) {
+        applied.push_back(static_cast<uint64_t>(fl_value_get_int(batch)));
+      }
+    }
+    g_controller.BatchesApplied(applied, g_get_monotonic_time());
+    RespondSuccess(method_call, nullptr);
+  } else if (method == "getState") {
+    RespondSuccess(method_call, StreamQualityToFlValue(g_controller.Current(
+                                    g_get_monotonic_time())));
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+FlMethodErrorResponse* OnQualityEventsListen(FlEventChannel* channel,
+                                             FlValue* args,
+                                             gpointer user_data) {
+  g_quality_events_listening = true;
+  return nullptr;
+}
+
+FlMethodErrorResponse* OnQualityEventsCancel(FlEventChannel* channel,
+                                             FlValue* args,
+                                             gpointer user_data) {
+  g_quality_events_listening = false;
+  return nullptr;
+}
+
+}  // namespace
+
+uint64_t StreamQualityBatchQueued(const std::string& stream_id) {
+  const uint64_t batch =
+      g_controller.BatchQueued(stream_id, g_get_monotonic_time());
+  if (!g_ticking.exchange(true)) {
+    g_timeout_add(kTickIntervalMs, OnQualityTick, nullptr);
+  }
+  return batch;
+}
+
+void StreamQualityStreamClosed(const std::string& stream_id) {
+  g_controller.StreamClosed(stream_id, g_get_monotonic_time());
+}
+
+void StreamQualityFramePresented() {
+  const int64_t now = g_get_monotonic_time();
+  g_controller.FramePresented(now);
+  EvaluateQuality(now);
+}
+
+void RegisterStreamQualityChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_stream_quality_channel = fl_method_channel_new(messenger, kChannelName,
+                                                   FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_stream_quality_channel, HandleStreamQualityCall, nullptr, nullptr);
+
+  g_quality_events_channel = fl_event_channel_new(
+      messenger, kEventChannelName, FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(
+      g_quality_events_channel, OnQualityEventsListen, OnQualityEventsCancel,
+      nullptr, nullptr);
+}
@@ -0,0 +1,140 @@
+#ifndef RUNNER_STREAM_QUALITY_H_
+#define RUNNER_STREAM_QUALITY_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class StreamQualityLevel {
+  kFull,     // Every update rendered as it arrives.
+  kReduced,  // Coalesced updates; background tabs render plain text.
+  kMinimal,  // Heavier coalescing; large tool results are collapsed too.
+};
+
+// How much work Dart should spend per streamed update, given how far the UI
+// is behind. Dart combines the rates with the power policy's.
+struct StreamQuality {
+  StreamQualityLevel level = StreamQualityLevel::kFull;
+
+  // Minimum spacing of partial message updates while a reply streams.
+  int stream_coalesce_ms = 0;
+  // Tabs that are not visible skip markdown and highlighting until shown.
+  bool defer_background_rendering = false;
+  // Tool results longer than this start collapsed; 0 means never.
+  size_t collapse_tool_result_chars = 0;
+
+  // Diagnostics: apply latency over the recent window and the age of the
+  // oldest batch Dart has not applied yet.
+  int64_t apply_latency_p90_us = 0;
+  int64_t backlog_us = 0;
+  size_t pending_batches = 0;
+};
+
+StreamQuality ComputeStreamQuality(StreamQualityLevel level);
+
+// Measures how long streamed deltas take to reach the screen and picks a
+// quality level from it.
+//
+// Each batch of deltas handed to Dart carries a sequence number. Dart reports
+// the batches it applied once the frame that shows them has been built; the
+// next painted frame resolves them, and the latency from queueing the batch
+// to that frame is one sample. When the 90th percentile of the recent
+// samples, or the age of the oldest unapplied batch, stays above the budget
+// the level drops one step; it comes back one step at a time after the UI
+// has kept well within the budget for a while.
+//
+// Batches belong to a stream. Once the stream is closed, its unapplied
+// batches no longer count as backlog: a stopped stream or a closed tab never
+// applies the deltas it had already fetched. They can still be reported
+// for a short while, since Dart reports after the frame.
+//
+// BatchQueued() may be called from any thread; everything else runs on the
+// main thread.
+class StreamQualityController {
+ public:
+  static constexpr int64_t kBudgetUs = 100 * 1000;
+  static constexpr int64_t kWindowUs = 2 * 1000 * 1000;
+  static constexpr int64_t kEvaluateIntervalUs = 250 * 1000;
+  // Consecutive over-budget evaluations before degrading.
+  static constexpr int kDegradeAfter = 2;
+  // Time below half the budget before restoring a level.
+  static constexpr int64_t kRestoreAfterUs = 3 * 1000 * 1000;
+  // An applied batch with no frame painted after it within this time counts
+  // as presented when it was applied (the frame clock was idle).
+  static constexpr int64_t kPresentWaitUs = 50 * 1000;
+  // Batches Dart never reports are forgotten this long after they were
+  // queued, or after their stream was closed.
+  static constexpr int64_t kAbandonUs = 10 * 1000 * 1000;
+  static constexpr int64_t kClosedGraceUs = 1000 * 1000;
+
+  // Returns the sequence number of a new batch of |stream| queued at
+  // |now_us|.
+  uint64_t BatchQueued(const std::string& stream, int64_t now_us);
+  // |stream| was closed at |now_us|; its unapplied batches are abandoned.
+  void StreamClosed(const std::string& stream, int64_t now_us);
+  // Dart applied |batches| at |now_us|.
+  void BatchesApplied(const std::vector<uint64_t>& batches, int64_t now_us);
+  // A frame was painted at |now_us|.
+  void FramePresented(int64_t now_us);
+  // Resolves batches that no frame followed and drops abandoned ones.
+  void Expire(int64_t now_us);
+
+  // Updates the level; returns true when it changed.
+  bool Evaluate(int64_t now_us);
+
+  // Nothing is pending and the level is full, so nothing needs a timer.
+  bool idle() const;
+
+  StreamQuality Current(int64_t now_us) const;
+
+ private:
+  struct Pending {
+    std::string stream;
+    int64_t queued_us = 0;
+    int64_t closed_us = 0;  // 0 while the stream is open.
+  };
+
+  struct Applied {
+    int64_t queued_us;
+    int64_t applied_us;
+  };
+
+  void AddSample(int64_t now_us, int64_t latency_us);
+  void DropOldSamples(int64_t now_us);
+  int64_t LatencyP90() const;
+  int64_t Backlog(int64_t now_us) const;
+
+  mutable std::mutex mutex_;
+  uint64_t next_batch_ = 1;
+  std::map<uint64_t, Pending> pending_;
+  std::vector<Applied> applied_;  // Waiting for a painted frame.
+  std::deque<std::pair<int64_t, int64_t>> samples_;  // Time, latency.
+
+  StreamQualityLevel level_ = StreamQualityLevel::kFull;
+  int64_t last_evaluated_us_ = 0;
+  int over_budget_ = 0;
+  int64_t calm_since_us_ = 0;
+};
+
+// Records that a batch of deltas of |stream_id| is about to be sent to Dart
+// and returns the sequence number its "batch" delta carries. Thread-safe.
+uint64_t StreamQualityBatchQueued(const std::string& stream_id);
+
+// Stops counting the unapplied batches of |stream_id| as backlog.
+// Thread-safe.
+void StreamQualityStreamClosed(const std::string& stream_id);
+
+// Called by the frame clock after each painted frame; main thread only.
+void StreamQualityFramePresented();
+
+// Registers the "com.codeagenthub/stream_quality" method channel and the
+// "com.codeagenthub/stream_quality_events" event channel.
+void RegisterStreamQualityChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_STREAM_QUALITY_H_
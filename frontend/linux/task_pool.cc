@@ -0,0 +1,133 @@
+#include "task_pool.h"
+
+#include <glib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+
+namespace {
+
+gboolean RunMainThreadTask(gpointer user_data) {
+  auto* task = static_cast<std::function<void()>*>(user_data);
+  (*task)();
+  return G_SOURCE_REMOVE;
+}
+
+void DestroyMainThreadTask(gpointer user_data) {
+  delete static_cast<std::function<void()>*>(user_data);
+}
+
+}  // namespace
+
+TaskPool::TaskPool(size_t thread_count) {
+  thread_count = std::max<size_t>(thread_count, 1);
+  workers_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back(&TaskPool::WorkerLoop, this);
+  }
+}
+
+TaskPool::~TaskPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+TaskPool& TaskPool::Get() {
+  // Leave one core to the raster and platform threads.
+  static TaskPool pool(
+      std::max<unsigned>(std::thread::hardware_concurrency(), 2) - 1);
+  return pool;
+}
+
+void TaskPool::Post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void TaskPool::PostBackground(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    background_tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void TaskPool::SetBackgroundLimits(size_t max_active, bool batch) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_active_ = max_active;
+    batch_ = batch;
+  }
+  // A raised limit may release waiting workers.
+  cv_.notify_all();
+}
+
+bool TaskPool::BackgroundRunnable() const {
+  return !background_tasks_.empty() &&
+         (stopping_ || max_active_ == 0 || background_active_ < max_active_);
+}
+
+void TaskPool::WorkerLoop() {
+  bool batch = false;
+  for (;;) {
+    std::function<void()> task;
+    bool background;
+    bool want_batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] {
+        return stopping_ || !tasks_.empty() || BackgroundRunnable();
+      });
+      if (!tasks_.empty()) {
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+        background = false;
+      } else if (BackgroundRunnable()) {
+        task = std::move(background_tasks_.front());
+        background_tasks_.pop_front();
+        ++background_active_;
+        background = true;
+      } else {
+        return;
+      }
+      want_batch = background && batch_;
+    }
+    if (want_batch != batch) {
+      // Unprivileged threads may switch between SCHED_OTHER and SCHED_BATCH
+      // freely, since the nice value is left alone.
+      sched_param param = {};
+      if (pthread_setschedparam(pthread_self(),
+                                want_batch ? SCHED_BATCH : SCHED_OTHER,
+                                &param) == 0) {
+        batch = want_batch;
+      }
+    }
+    task();
+    if (background) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --background_active_;
+      }
+      // A worker may be waiting for the background limit.
+      cv_.notify_one();
+    }
+  }
+}
+
+void RunOnMainThread(std::function<void()> task) {
+  g_main_context_invoke_full(nullptr, G_PRIORITY_DEFAULT, RunMainThreadTask,
+                             new std::function<void()>(std::move(task)),
+                             DestroyMainThreadTask);
+}
@@ -0,0 +1,62 @@
+#ifndef RUNNER_TASK_POOL_H_
+#define RUNNER_TASK_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool shared by the runner's native services. Anything
+// that touches disk or burns CPU (compression, parsing, rendering) is posted
+// here so the GTK main loop that drives the Flutter engine never blocks.
+class TaskPool {
+ public:
+  explicit TaskPool(size_t thread_count);
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  // Returns the process-wide pool, sized to the hardware concurrency.
+  static TaskPool& Get();
+
+  // Queues |task| for execution on a worker thread. Use this for work a
+  // caller is waiting on (stream normalization, lookups, clipboard reads).
+  void Post(std::function<void()> task);
+
+  // Queues |task| behind everything posted with Post(). Use this for work
+  // nobody is waiting on (exports, cache and log writes, reports); it is the
+  // only work SetBackgroundLimits() throttles.
+  void PostBackground(std::function<void()> task);
+
+  size_t thread_count() const { return workers_.size(); }
+
+  // Throttles background tasks for battery use: at most |max_active| of them
+  // run at once (0 for no limit), and with |batch| they run as SCHED_BATCH
+  // so they yield to interactive threads. Tasks from Post() are not
+  // affected. Workers pick the change up before their next task.
+  void SetBackgroundLimits(size_t max_active, bool batch);
+
+ private:
+  void WorkerLoop();
+  bool BackgroundRunnable() const;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::deque<std::function<void()>> background_tasks_;
+  std::vector<std::thread> workers_;
+  bool stopping_ = false;
+  size_t background_active_ = 0;
+  size_t max_active_ = 0;
+  bool batch_ = false;
+};
+
+// Runs |task| on the GLib main context, i.e. the platform thread that owns
+// the Flutter engine. Safe to call from any thread.
+void RunOnMainThread(std::function<void()> task);
+
+#endif  // RUNNER_TASK_POOL_H_
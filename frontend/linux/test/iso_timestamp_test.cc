@@ -0,0 +1,129 @@
+#include "iso_timestamp.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+#include "test/test_util.h"
+
+namespace {
+
+constexpr int64_t kSecond = 1000000;
+// 2024-01-01T00:00:00Z.
+constexpr int64_t kNewYear = 1704067200 * kSecond;
+
+bool Parse(const std::string& text, int64_t* micros, bool* has_zone) {
+  return ParseIsoTimestamp(text.data(), text.size(), micros, has_zone);
+}
+
+void TestZones() {
+  int64_t micros = 0;
+  bool has_zone = false;
+  for (const char* text :
+       {"2024-01-01T00:00:00Z", "2024-01-01t00:00:00z",
+        "2024-01-01T05:30:00+05:30", "2024-01-01T05:30:00+0530",
+        "2023-12-31T19:00:00-05:00", "2023-12-31T23:00-01:00",
+        "2023-12-31 23:00:00-01", "2023-12-31T24:00:00Z"}) {
+    micros = 0;
+    has_zone = false;
+    EXPECT_TRUE(Parse(text, &micros, &has_zone));
+    EXPECT_EQ(kNewYear, micros);
+    EXPECT_TRUE(has_zone);
+  }
+}
+
+void TestFractionalSeconds() {
+  int64_t micros = 0;
+  bool has_zone = false;
+  EXPECT_TRUE(Parse("2024-01-01T00:00:00.5Z", &micros, &has_zone));
+  EXPECT_EQ(kNewYear + 500000, micros);
+  EXPECT_TRUE(Parse("2024-01-01T00:00:00,25Z", &micros, &has_zone));
+  EXPECT_EQ(kNewYear + 250000, micros);
+  EXPECT_TRUE(Parse("2024-01-01T00:00:00.123456Z", &micros, &has_zone));
+  EXPECT_EQ(kNewYear + 123456, micros);
+  // Digits past microseconds are dropped, not rounded.
+  EXPECT_TRUE(Parse("2024-01-01T00:00:00.1234569+00:00", &micros, &has_zone));
+  EXPECT_EQ(kNewYear + 123456, micros);
+  EXPECT_TRUE(Parse("2024-01-01T05:30:00.000001+05:30", &micros, &has_zone));
+  EXPECT_EQ(kNewYear + 1, micros);
+}
+
+void TestMalformed() {
+  for (const char* text :
+       {"", "2024", "2024-01", "2024-1-01", "2024-13-01T00:00:00Z",
+        "2024-01-32T00:00:00Z", "2024-01-01T25:00:00Z", "2024-01-01T00:60:00Z",
+        "2024-01-01T00:00:60Z", "2024-01-01T00:00:00.Z",
+        "2024-01-01T00:00:00+5", "2024-01-01T00:00:00+05:3",
+        "2024-01-01T00:00:00Zjunk", "2024-01-01T00:00:00 UTC",
+        "2024-01-01X00:00:00Z", "2024-01-01T00", "2024-01-01T00:00:0a",
+        "yesterday"}) {
+    int64_t micros = 0;
+    EXPECT_TRUE(!Parse(text, &micros, nullptr));
+  }
+
+  // The batch entry point marks them invalid, so Dart falls back to
+  // DateTime.parse for just those entries.
+  const std::string text =
+      "2024-01-01T00:00:00Znot a date2024-01-01T00:00:00.5Z";
+  const int64_t ends[] = {20, 30, static_cast<int64_t>(text.size())};
+  int64_t micros[3] = {};
+  uint8_t kinds[3] = {};
+  EXPECT_EQ(2, codeagenthub_parse_iso_timestamps(text.data(), ends, 3,
+                                                 micros, kinds));
+  EXPECT_EQ(kIsoTimestampZoned, kinds[0]);
+  EXPECT_EQ(kNewYear, micros[0]);
+  EXPECT_EQ(kIsoTimestampInvalid, kinds[1]);
+  EXPECT_EQ(0, micros[1]);
+  EXPECT_EQ(kIsoTimestampZoned, kinds[2]);
+  EXPECT_EQ(kNewYear + 500000, micros[2]);
+}
+
+// Runs with TZ set to US Eastern time, whose clocks went from 02:00 EST to
+// 03:00 EDT on 2024-03-10.
+void TestLocalTimeAcrossDst() {
+  int64_t micros = 0;
+  bool has_zone = true;
+  EXPECT_TRUE(Parse("2024-01-01T00:00:00", &micros, &has_zone));
+  EXPECT_EQ(1704085200 * kSecond, micros);
+  EXPECT_TRUE(!has_zone);
+  EXPECT_TRUE(Parse("2024-03-10", &micros, &has_zone));
+  EXPECT_EQ(1710046800 * kSecond, micros);
+
+  // Each hour is cached separately: the hours on either side of the change
+  // keep their own offsets.
+  EXPECT_TRUE(Parse("2024-03-10T01:30:00", &micros, &has_zone));
+  EXPECT_EQ(1710052200 * kSecond, micros);
+  EXPECT_TRUE(Parse("2024-03-10T03:30:00.25", &micros, &has_zone));
+  EXPECT_EQ(1710055800 * kSecond + 250000, micros);
+  EXPECT_TRUE(Parse("2024-03-10T01:59:59", &micros, &has_zone));
+  EXPECT_EQ(1710052200 * kSecond + 1799 * kSecond, micros);
+
+  // 09:30 shares a cache slot with 01:30; each evicts the other rather than
+  // reusing its offset.
+  EXPECT_TRUE(Parse("2024-03-10T09:30:00", &micros, &has_zone));
+  EXPECT_EQ(1710077400 * kSecond, micros);
+  EXPECT_TRUE(Parse("2024-03-10T01:30:00", &micros, &has_zone));
+  EXPECT_EQ(1710052200 * kSecond, micros);
+
+  // An explicit zone ignores the local offset.
+  EXPECT_TRUE(Parse("2024-03-10T01:30:00Z", &micros, &has_zone));
+  EXPECT_EQ(1710052200 * kSecond - 5 * 3600 * kSecond, micros);
+  EXPECT_TRUE(has_zone);
+}
+
+}  // namespace
+
+int main() {
+  setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+  tzset();
+
+  TestZones();
+  TestFractionalSeconds();
+  TestMalformed();
+  TestLocalTimeAcrossDst();
+  if (test_failures != 0) {
+    fprintf(stderr, "%d check(s) failed\n", test_failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,164 @@
+#include "partial_json.h"
+
+#include <glib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "test/test_util.h"
+
+namespace {
+
+// Feeds |document| in fragments of |step| bytes and collects every update.
+bool FeedInSteps(PartialJsonParser* parser, const std::string& document,
+                 size_t step, std::vector<PartialJsonUpdate>* updates) {
+  bool ok = true;
+  for (size_t offset = 0; offset < document.size(); offset += step) {
+    const size_t size = std::min(step, document.size() - offset);
+    ok = parser->Feed(document.data() + offset, size, updates) && ok;
+  }
+  return ok;
+}
+
+// The text appended to the string at member |key| of the root object.
+std::string AppendedText(const std::vector<PartialJsonUpdate>& updates,
+                         const std::string& key) {
+  std::string text;
+  for (const PartialJsonUpdate& update : updates) {
+    if (update.op == PartialJsonUpdate::Op::kAppend &&
+        update.path.size() == 1 && update.path[0].key == key) {
+      text += update.text;
+    }
+  }
+  return text;
+}
+
+bool HasUpdate(const std::vector<PartialJsonUpdate>& updates,
+               PartialJsonUpdate::Op op, const std::string& path) {
+  for (const PartialJsonUpdate& update : updates) {
+    std::string joined;
+    for (const JsonPathSegment& segment : update.path) {
+      joined += "/" + (segment.is_index ? std::to_string(segment.index)
+                                        : segment.key);
+    }
+    if (update.op == op && joined == path) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TestSplitUtf8() {
+  // Two-, three- and four-byte characters, fed one byte at a time so every
+  // multi-byte sequence is split between fragments.
+  const std::string text =
+      "h\xc3\xa9llo \xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80";
+  const std::string document = "{\"text\":\"" + text + "\"}";
+  for (size_t step = 1; step <= 3; ++step) {
+    PartialJsonParser parser;
+    std::vector<PartialJsonUpdate> updates;
+    EXPECT_TRUE(FeedInSteps(&parser, document, step, &updates));
+    EXPECT_TRUE(parser.complete());
+    EXPECT_EQ(text, parser.value()["text"].AsString());
+    EXPECT_EQ(text, AppendedText(updates, "text"));
+    // Each append is sent to Dart as a string on its own.
+    for (const PartialJsonUpdate& update : updates) {
+      if (update.op == PartialJsonUpdate::Op::kAppend) {
+        EXPECT_TRUE(g_utf8_validate(update.text.data(),
+                                    static_cast<gssize>(update.text.size()),
+                                    nullptr));
+      }
+    }
+  }
+}
+
+void TestEscapesAcrossChunks() {
+  const std::string document =
+      "{\"s\":\"a\\\"b\\\\c\\nd\\/\\u00e9\\ud83d\\ude00\\t\"}";
+  const std::string expected = "a\"b\\c\nd/\xc3\xa9\xf0\x9f\x98\x80\t";
+  for (size_t step = 1; step <= 4; ++step) {
+    PartialJsonParser parser;
+    std::vector<PartialJsonUpdate> updates;
+    EXPECT_TRUE(FeedInSteps(&parser, document, step, &updates));
+    EXPECT_TRUE(parser.complete());
+    EXPECT_EQ(expected, parser.value()["s"].AsString());
+    EXPECT_EQ(expected, AppendedText(updates, "s"));
+  }
+
+  // A high surrogate without its low half becomes U+FFFD.
+  PartialJsonParser parser;
+  std::vector<PartialJsonUpdate> updates;
+  const std::string lone = "{\"s\":\"\\ud83dx\"}";
+  EXPECT_TRUE(FeedInSteps(&parser, lone, 1, &updates));
+  EXPECT_EQ(std::string("\xef\xbf\xbdx"), parser.value()["s"].AsString());
+}
+
+void TestNesting() {
+  const std::string document =
+      "{\"a\": [1, {\"b\": true, \"c\": null}], \"d\": {\"e\": \"x\"}, "
+      "\"f\": [], \"g\": -2.5e1}";
+  JsonValue expected;
+  std::string error;
+  EXPECT_TRUE(ParseJson(document, &expected, &error));
+
+  for (size_t step : {1, 3, 7, 1000}) {
+    PartialJsonParser parser;
+    std::vector<PartialJsonUpdate> updates;
+    EXPECT_TRUE(FeedInSteps(&parser, document, step, &updates));
+    EXPECT_TRUE(parser.complete());
+    EXPECT_EQ(expected.Serialize(), parser.value().Serialize());
+    EXPECT_TRUE(HasUpdate(updates, PartialJsonUpdate::Op::kSet, "/a/0"));
+    EXPECT_TRUE(HasUpdate(updates, PartialJsonUpdate::Op::kSet, "/a/1/b"));
+    EXPECT_TRUE(HasUpdate(updates, PartialJsonUpdate::Op::kComplete, "/a/1"));
+    EXPECT_TRUE(HasUpdate(updates, PartialJsonUpdate::Op::kComplete, "/d/e"));
+    EXPECT_TRUE(HasUpdate(updates, PartialJsonUpdate::Op::kComplete, "/f"));
+    EXPECT_TRUE(HasUpdate(updates, PartialJsonUpdate::Op::kSet, "/g"));
+    EXPECT_TRUE(HasUpdate(updates, PartialJsonUpdate::Op::kComplete, ""));
+  }
+}
+
+void TestTruncatedInput() {
+  // The received prefix is visible while the document is incomplete.
+  PartialJsonParser parser;
+  std::vector<PartialJsonUpdate> updates;
+  const std::string prefix = "{\"path\":\"src/ma";
+  EXPECT_TRUE(parser.Feed(prefix.data(), prefix.size(), &updates));
+  EXPECT_TRUE(!parser.complete());
+  EXPECT_EQ(std::string("src/ma"), parser.value()["path"].AsString());
+  EXPECT_TRUE(!parser.Finish(&updates));
+  EXPECT_TRUE(!parser.failed());
+
+  // A root number is only closed by Finish().
+  PartialJsonParser number;
+  updates.clear();
+  EXPECT_TRUE(number.Feed("12", 2, &updates));
+  EXPECT_TRUE(!number.complete());
+  EXPECT_TRUE(number.Finish(&updates));
+  EXPECT_EQ(12, number.value().AsInt());
+
+  // Malformed input fails and later fragments are ignored.
+  for (const char* bad : {"{\"a\" 1}", "[1,,2]", "{\"a\":tru}", "[\"\\x\"]",
+                          "{} {}"}) {
+    PartialJsonParser broken;
+    updates.clear();
+    EXPECT_TRUE(!FeedInSteps(&broken, bad, 1, &updates));
+    EXPECT_TRUE(broken.failed());
+    EXPECT_TRUE(!broken.error().empty());
+    EXPECT_TRUE(!broken.Feed("]", 1, &updates));
+  }
+}
+
+}  // namespace
+
+int main() {
+  TestSplitUtf8();
+  TestEscapesAcrossChunks();
+  TestNesting();
+  TestTruncatedInput();
+  if (test_failures != 0) {
+    fprintf(stderr, "%d check(s) failed\n", test_failures);
+    return 1;
+  }
+  return 0;
+}
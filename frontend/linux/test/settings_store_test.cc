@@ -0,0 +1,163 @@
+#include "settings_store.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+#include "test/test_util.h"
+
+namespace {
+
+void WriteFile(const std::string& path, const std::string& data) {
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  EXPECT_TRUE(fd >= 0);
+  if (fd >= 0) {
+    EXPECT_EQ(static_cast<ssize_t>(data.size()),
+              write(fd, data.data(), data.size()));
+    close(fd);
+  }
+}
+
+std::string Value(const SettingsStore& store, const std::string& key) {
+  std::string value;
+  return store.Get(key, &value) ? value : "<unset>";
+}
+
+void TestLoadAndSave(const std::string& dir) {
+  const std::string path = dir + "/config/settings.snapshot";
+  std::string error;
+  {
+    // A missing file is an empty store.
+    SettingsStore store(path);
+    EXPECT_TRUE(store.Load(&error));
+    EXPECT_EQ(std::string("<unset>"), Value(store, "app_settings"));
+    EXPECT_TRUE(!store.dirty());
+
+    store.Set("app_settings", "{\"darkMode\":true}");
+    store.Set("empty", "");
+    store.Set("gone", "x");
+    store.Remove("gone");
+    store.Remove("never_set");
+    EXPECT_TRUE(store.dirty());
+    EXPECT_TRUE(store.Save(&error));
+    EXPECT_TRUE(!store.dirty());
+    // Nothing changed, so nothing is written.
+    EXPECT_TRUE(store.Save(&error));
+  }
+
+  SettingsStore store(path);
+  EXPECT_TRUE(store.Load(&error));
+  EXPECT_EQ(std::string("{\"darkMode\":true}"), Value(store, "app_settings"));
+  EXPECT_EQ(std::string(""), Value(store, "empty"));
+  EXPECT_EQ(std::string("<unset>"), Value(store, "gone"));
+
+  // Read() reports the full size and copies what fits.
+  char buffer[4] = {};
+  EXPECT_EQ(17, store.Read("app_settings", buffer, sizeof(buffer)));
+  EXPECT_EQ(std::string("{\"da"), std::string(buffer, sizeof(buffer)));
+  EXPECT_EQ(0, store.Read("empty", buffer, sizeof(buffer)));
+  EXPECT_EQ(-1, store.Read("gone", buffer, sizeof(buffer)));
+}
+
+void TestUnreadableSnapshotIsReplaced(const std::string& dir) {
+  const std::string path = dir + "/settings.snapshot";
+  std::map<std::string, std::string> entries = {{"key", "value"}};
+  std::string snapshot = SettingsStore::Serialize(entries);
+
+  // A snapshot from a newer version, a truncated one and garbage are all
+  // reported and treated as empty; the next save replaces them.
+  std::string newer = snapshot;
+  newer[8] = 2;
+  std::string truncated = snapshot.substr(0, snapshot.size() - 1);
+  for (const std::string& data : {newer, truncated, std::string("garbage")}) {
+    WriteFile(path, data);
+    SettingsStore store(path);
+    std::string error;
+    EXPECT_TRUE(!store.Load(&error));
+    EXPECT_TRUE(!error.empty());
+    EXPECT_EQ(std::string("<unset>"), Value(store, "key"));
+
+    store.Set("other", "1");
+    error.clear();
+    EXPECT_TRUE(store.Save(&error));
+    SettingsStore reloaded(path);
+    EXPECT_TRUE(reloaded.Load(&error));
+    EXPECT_EQ(std::string("1"), Value(reloaded, "other"));
+    EXPECT_EQ(std::string("<unset>"), Value(reloaded, "key"));
+  }
+}
+
+void TestInstancesMergeByKey(const std::string& dir) {
+  const std::string path = dir + "/settings.snapshot";
+  std::string error;
+  {
+    SettingsStore seed(path);
+    seed.Set("shared", "0");
+    seed.Set("doomed", "0");
+    EXPECT_TRUE(seed.Save(&error));
+  }
+
+  // Two app instances load the same snapshot and each change their own keys.
+  SettingsStore first(path);
+  SettingsStore second(path);
+  EXPECT_TRUE(first.Load(&error));
+  EXPECT_TRUE(second.Load(&error));
+
+  first.Set("app_settings", "first");
+  first.Remove("doomed");
+  EXPECT_TRUE(first.Save(&error));
+
+  second.Set("session_settings", "second");
+  EXPECT_TRUE(second.Save(&error));
+
+  // The second save kept the first instance's changes and picked them up.
+  EXPECT_EQ(std::string("first"), Value(second, "app_settings"));
+  EXPECT_EQ(std::string("<unset>"), Value(second, "doomed"));
+  EXPECT_EQ(std::string("0"), Value(second, "shared"));
+
+  // A key both changed keeps the later save.
+  first.Set("shared", "1");
+  second.Set("shared", "2");
+  EXPECT_TRUE(first.Save(&error));
+  EXPECT_TRUE(second.Save(&error));
+  EXPECT_EQ(std::string("2"), Value(second, "shared"));
+
+  // Reloading replaces the mapped values with the latest snapshot.
+  EXPECT_EQ(std::string("1"), Value(first, "shared"));
+  EXPECT_TRUE(first.Load(&error));
+  EXPECT_TRUE(!first.dirty());
+  EXPECT_EQ(std::string("2"), Value(first, "shared"));
+  EXPECT_EQ(std::string("second"), Value(first, "session_settings"));
+  EXPECT_EQ(std::string("first"), Value(first, "app_settings"));
+
+  SettingsStore fresh(path);
+  EXPECT_TRUE(fresh.Load(&error));
+  EXPECT_EQ(std::string("first"), Value(fresh, "app_settings"));
+  EXPECT_EQ(std::string("second"), Value(fresh, "session_settings"));
+  EXPECT_EQ(std::string("2"), Value(fresh, "shared"));
+  EXPECT_EQ(std::string("<unset>"), Value(fresh, "doomed"));
+}
+
+}  // namespace
+
+int main() {
+  {
+    ScopedTempDir dir;
+    TestLoadAndSave(dir.path());
+  }
+  {
+    ScopedTempDir dir;
+    TestUnreadableSnapshotIsReplaced(dir.path());
+  }
+  {
+    ScopedTempDir dir;
+    TestInstancesMergeByKey(dir.path());
+  }
+  if (test_failures != 0) {
+    fprintf(stderr, "%d check(s) failed\n", test_failures);
+    return 1;
+  }
+  return 0;
+}
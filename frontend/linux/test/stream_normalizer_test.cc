@@ -0,0 +1,182 @@
+#include "stream_normalizer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "test/test_util.h"
+
+namespace {
+
+// An SSE frame as the backend writes it (see formatSse in streaming.ts).
+std::string Frame(const std::string& event, const std::string& data) {
+  return "event: " + event + "\ndata: " + data + "\n\n";
+}
+
+std::string Token(const std::string& text) {
+  return Frame("token",
+               "{\"session_id\":\"s-1\",\"text\":\"" + text + "\"}");
+}
+
+std::string SdkMessage(const std::string& payload) {
+  return Frame("message",
+               "{\"session_id\":\"s-1\",\"payload\":" + payload + "}");
+}
+
+// Feeds |body| in fragments of |step| bytes, then closes the stream.
+std::vector<JsonValue> Normalize(const std::string& body, size_t step) {
+  StreamNormalizer normalizer(StreamSchema::kClaude, "");
+  std::vector<JsonValue> deltas;
+  for (size_t offset = 0; offset < body.size(); offset += step) {
+    normalizer.Feed(body.data() + offset,
+                    std::min(step, body.size() - offset), &deltas);
+  }
+  normalizer.Close(&deltas);
+  return deltas;
+}
+
+std::vector<const JsonValue*> OfType(const std::vector<JsonValue>& deltas,
+                                     const std::string& type) {
+  std::vector<const JsonValue*> matches;
+  for (const JsonValue& delta : deltas) {
+    if (delta["t"].AsString() == type) {
+      matches.push_back(&delta);
+    }
+  }
+  return matches;
+}
+
+// A /chat body for a turn that calls a tool and then answers. The backend
+// replays the text of each complete assistant message as word tokens ahead
+// of the message itself; the tool call has no text and so no tokens.
+std::string ToolTurnBody() {
+  return Frame("run", "{\"run_id\":\"run-1\"}") +
+         Frame("session",
+               "{\"session_id\":\"s-1\",\"cwd\":\"/tmp\",\"is_new\":false}") +
+         SdkMessage(
+             "{\"type\":\"system\",\"subtype\":\"init\",\"session_id\":"
+             "\"s-1\"}") +
+         SdkMessage(
+             "{\"type\":\"assistant\",\"uuid\":\"u-1\",\"session_id\":"
+             "\"s-1\",\"message\":{\"id\":\"msg_01\",\"role\":\"assistant\","
+             "\"content\":[{\"type\":\"tool_use\",\"id\":\"toolu_1\","
+             "\"name\":\"Read\",\"input\":{\"file_path\":\"/tmp/a.txt\"}}]}}") +
+         SdkMessage(
+             "{\"type\":\"user\",\"uuid\":\"u-2\",\"session_id\":\"s-1\","
+             "\"message\":{\"role\":\"user\",\"content\":[{\"type\":"
+             "\"tool_result\",\"tool_use_id\":\"toolu_1\",\"content\":"
+             "\"hello\"}]}}") +
+         Token("The") + Token(" ") + Token("file") + Token(" ") +
+         Token("says") + Token(" ") + Token("hello.") +
+         SdkMessage(
+             "{\"type\":\"assistant\",\"uuid\":\"u-3\",\"session_id\":"
+             "\"s-1\",\"message\":{\"id\":\"msg_02\",\"role\":\"assistant\","
+             "\"content\":[{\"type\":\"text\",\"text\":\"The file says "
+             "hello.\"}]}}") +
+         SdkMessage(
+             "{\"type\":\"result\",\"subtype\":\"success\",\"session_id\":"
+             "\"s-1\",\"total_cost_usd\":0.01,\"usage\":{\"input_tokens\":"
+             "12,\"output_tokens\":8}}") +
+         Frame("done",
+               "{\"run_id\":\"run-1\",\"session_id\":\"s-1\",\"cwd\":"
+               "\"/tmp\",\"length\":20}");
+}
+
+void TestCompleteAssistantMessages() {
+  for (size_t step : {1, 5, 64, 1 << 20}) {
+    const std::vector<JsonValue> deltas = Normalize(ToolTurnBody(), step);
+
+    const auto sessions = OfType(deltas, "session");
+    EXPECT_EQ(1u, sessions.size());
+    EXPECT_EQ(1u, OfType(deltas, "run").size());
+
+    // The unstreamed tool call, the tool result and the answer, in order.
+    const auto messages = OfType(deltas, "message");
+    EXPECT_EQ(3u, messages.size());
+    if (messages.size() != 3) {
+      continue;
+    }
+    const JsonValue& tool_call = *messages[0];
+    EXPECT_EQ(std::string("msg_01"), tool_call["message"].AsString());
+    EXPECT_EQ(std::string("assistant"), tool_call["role"].AsString());
+    EXPECT_EQ(1u, tool_call["blocks"].items().size());
+    EXPECT_EQ(std::string("Read"), tool_call["blocks"].items()[0]["name"]
+                                       .AsString());
+
+    EXPECT_EQ(std::string("u-2"), (*messages[1])["message"].AsString());
+    EXPECT_EQ(std::string("assistant"), (*messages[1])["role"].AsString());
+
+    // The answer's tokens built a placeholder, which the complete message
+    // replaces under the same id.
+    const auto texts = OfType(deltas, "text");
+    std::string streamed;
+    for (const JsonValue* text : texts) {
+      EXPECT_EQ((*texts[0])["message"].AsString(),
+                (*text)["message"].AsString());
+      streamed += (*text)["text"].AsString();
+    }
+    EXPECT_EQ(std::string("The file says hello."), streamed);
+    const JsonValue& answer = *messages[2];
+    EXPECT_TRUE(!texts.empty() && (*texts[0])["message"].AsString() ==
+                                      answer["message"].AsString());
+    EXPECT_EQ(std::string("The file says hello."),
+              answer["blocks"].items()[0]["text"].AsString());
+
+    // The placeholder was finalized by its message, not by done.
+    EXPECT_TRUE(OfType(deltas, "final").empty());
+    EXPECT_EQ(1u, OfType(deltas, "stats").size());
+    EXPECT_EQ(1u, OfType(deltas, "done").size());
+    EXPECT_EQ(std::string("done"), deltas.back()["t"].AsString());
+  }
+}
+
+void TestStreamedMessageIsNotRepeated() {
+  const std::string body =
+      Token("Hi") +
+      SdkMessage(
+          "{\"type\":\"stream_event\",\"event\":{\"type\":\"message_start\","
+          "\"message\":{\"id\":\"msg_03\"}}}") +
+      SdkMessage(
+          "{\"type\":\"stream_event\",\"event\":{\"type\":"
+          "\"content_block_start\",\"index\":0,\"content_block\":{\"type\":"
+          "\"text\",\"text\":\"\"}}}") +
+      SdkMessage(
+          "{\"type\":\"stream_event\",\"event\":{\"type\":"
+          "\"content_block_delta\",\"index\":0,\"delta\":{\"type\":"
+          "\"text_delta\",\"text\":\"Hi there\"}}}") +
+      Token(" there") +
+      SdkMessage(
+          "{\"type\":\"stream_event\",\"event\":{\"type\":"
+          "\"content_block_stop\",\"index\":0}}") +
+      SdkMessage(
+          "{\"type\":\"stream_event\",\"event\":{\"type\":\"message_stop\"}}") +
+      SdkMessage(
+          "{\"type\":\"assistant\",\"message\":{\"id\":\"msg_03\","
+          "\"content\":[{\"type\":\"text\",\"text\":\"Hi there\"}]}}") +
+      Frame("done", "{\"session_id\":\"s-1\"}");
+
+  const std::vector<JsonValue> deltas = Normalize(body, 7);
+  const auto starts = OfType(deltas, "start");
+  EXPECT_EQ(1u, starts.size());
+  if (starts.size() == 1) {
+    EXPECT_EQ(std::string("msg_03"), (*starts[0])["message"].AsString());
+    // The token placeholder is replaced by the streamed message.
+    EXPECT_TRUE((*starts[0])["replaces"].is_string());
+  }
+  const auto finals = OfType(deltas, "final");
+  EXPECT_EQ(1u, finals.size());
+  // The complete copy of the streamed message adds nothing.
+  EXPECT_TRUE(OfType(deltas, "message").empty());
+}
+
+}  // namespace
+
+int main() {
+  TestCompleteAssistantMessages();
+  TestStreamedMessageIsNotRepeated();
+  if (test_failures != 0) {
+    fprintf(stderr, "%d check(s) failed\n", test_failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef RUNNER_TEST_TEST_UTIL_H_
+#define RUNNER_TEST_TEST_UTIL_H_
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// Minimal checks for the runner's native unit tests, which are plain
+// executables run by CTest (see RUNNER_BUILD_TESTS in CMakeLists.txt).
+
+#define EXPECT_TRUE(condition)                                         \
+  do {                                                                 \
+    if (!(condition)) {                                                \
+      fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,      \
+              #condition);                                             \
+      ++test_failures;                                                 \
+    }                                                                  \
+  } while (0)
+
+#define EXPECT_EQ(expected, actual)                                    \
+  do {                                                                 \
+    if (!((expected) == (actual))) {                                   \
+      fprintf(stderr, "%s:%d: expected %s == %s\n", __FILE__, __LINE__, \
+              #expected, #actual);                                     \
+      ++test_failures;                                                 \
+    }                                                                  \
+  } while (0)
+
+inline int test_failures = 0;
+
+// A fresh directory under $TMPDIR, removed with its contents by the
+// destructor.
+class ScopedTempDir {
+ public:
+  ScopedTempDir() {
+    const char* tmp = getenv("TMPDIR");
+    std::string pattern = std::string(tmp != nullptr ? tmp : "/tmp") +
+                          "/runner_test_XXXXXX";
+    if (mkdtemp(&pattern[0]) != nullptr) {
+      path_ = pattern;
+    }
+  }
+  ~ScopedTempDir() {
+    if (!path_.empty()) {
+      RemoveTree(path_);
+    }
+  }
+
+  ScopedTempDir(const ScopedTempDir&) = delete;
+  ScopedTempDir& operator=(const ScopedTempDir&) = delete;
+
+  const std::string& path() const { return path_; }
+
+ private:
+  static void RemoveTree(const std::string& path) {
+    DIR* dir = opendir(path.c_str());
+    if (dir != nullptr) {
+      while (struct dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+          continue;
+        }
+        const std::string child = path + "/" + name;
+        struct stat st;
+        if (lstat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+          RemoveTree(child);
+        } else {
+          unlink(child.c_str());
+        }
+      }
+      closedir(dir);
+    }
+    rmdir(path.c_str());
+  }
+
+  std::string path_;
+};
+
+#endif  // RUNNER_TEST_TEST_UTIL_H_
@@ -0,0 +1,152 @@
+#include "transcript_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "test/test_util.h"
+
+namespace {
+
+std::string Record(int turn, const std::string& text) {
+  return "{\"type\":\"assistant\",\"turn\":" + std::to_string(turn) +
+         ",\"text\":\"" + text + "\"}";
+}
+
+// Large enough to be cut into shared chunks.
+std::string LargeRecord(int turn) {
+  std::string text;
+  for (int line = 0; text.size() < 64 * 1024; ++line) {
+    text += "  src/module_" + std::to_string(line % 97) +
+            ".cc: const int value_" + std::to_string(line) + " = " +
+            std::to_string(line * 7919 % 10007) + ";\\n";
+  }
+  return Record(turn, text);
+}
+
+std::vector<std::string> ReadAll(TranscriptCache* cache,
+                                 const std::string& session) {
+  std::vector<std::string> records;
+  std::string error;
+  EXPECT_TRUE(cache->ReadRange(session, 0, UINT64_MAX, &records, &error));
+  return records;
+}
+
+void TestWriteAppendAndReadRange(const std::string& root) {
+  TranscriptCache cache(root);
+  std::string error;
+  EXPECT_TRUE(cache.Open(&error));
+
+  std::vector<std::string> records = {Record(0, "hello"), Record(1, "world"),
+                                      Record(2, "")};
+  EXPECT_TRUE(cache.Write("session-a", records, false, &error));
+  EXPECT_EQ(3u, cache.RecordCount("session-a"));
+  EXPECT_TRUE(ReadAll(&cache, "session-a") == records);
+
+  const std::vector<std::string> more = {Record(3, "again"), LargeRecord(4)};
+  EXPECT_TRUE(cache.Write("session-a", more, true, &error));
+  records.insert(records.end(), more.begin(), more.end());
+  EXPECT_EQ(5u, cache.RecordCount("session-a"));
+  EXPECT_TRUE(ReadAll(&cache, "session-a") == records);
+
+  // Ranges are clamped to the records that exist.
+  std::vector<std::string> range;
+  EXPECT_TRUE(cache.ReadRange("session-a", 3, 10, &range, &error));
+  EXPECT_TRUE(range == more);
+  range.clear();
+  EXPECT_TRUE(cache.ReadRange("session-a", 1, 1, &range, &error));
+  EXPECT_TRUE(range == std::vector<std::string>{records[1]});
+  range.clear();
+  EXPECT_TRUE(cache.ReadRange("session-a", 9, 1, &range, &error));
+  EXPECT_TRUE(range.empty());
+
+  // Rewriting without append replaces the session.
+  EXPECT_TRUE(cache.Write("session-a", {Record(9, "only")}, false, &error));
+  EXPECT_EQ(1u, cache.RecordCount("session-a"));
+  EXPECT_TRUE(ReadAll(&cache, "session-a") ==
+              std::vector<std::string>{Record(9, "only")});
+}
+
+void TestLargeRecordsAreDeduplicated(const std::string& root) {
+  TranscriptCache cache(root);
+  std::string error;
+  EXPECT_TRUE(cache.Open(&error));
+
+  const std::string large = LargeRecord(1);
+  EXPECT_TRUE(cache.Write("session-b", {large}, false, &error));
+  const TranscriptCache::Stats first = cache.GetStats();
+  EXPECT_TRUE(first.chunks > 0);
+
+  EXPECT_TRUE(cache.Write("session-c", {Record(0, "x"), large}, false, &error));
+  const TranscriptCache::Stats second = cache.GetStats();
+  EXPECT_EQ(first.chunks, second.chunks);
+  EXPECT_EQ(first.chunk_bytes, second.chunk_bytes);
+
+  EXPECT_TRUE(ReadAll(&cache, "session-b") == std::vector<std::string>{large});
+  EXPECT_TRUE(ReadAll(&cache, "session-c") ==
+              (std::vector<std::string>{Record(0, "x"), large}));
+}
+
+void TestReopenAndDictionary(const std::string& root) {
+  std::vector<std::string> before;
+  {
+    TranscriptCache cache(root);
+    std::string error;
+    EXPECT_TRUE(cache.Open(&error));
+    for (int turn = 0; turn < 200; ++turn) {
+      before.push_back(Record(turn, "tool output line " +
+                                        std::to_string(turn % 13)));
+    }
+    EXPECT_TRUE(cache.Write("session-d", before, false, &error));
+    EXPECT_TRUE(cache.TrainDictionary(&error));
+    EXPECT_TRUE(cache.Write("session-e", before, false, &error));
+  }
+
+  // A second instance reads what the first wrote, with and without the
+  // dictionary.
+  TranscriptCache cache(root);
+  std::string error;
+  EXPECT_TRUE(cache.Open(&error));
+  EXPECT_EQ(200u, cache.RecordCount("session-d"));
+  EXPECT_TRUE(ReadAll(&cache, "session-d") == before);
+  EXPECT_TRUE(ReadAll(&cache, "session-e") == before);
+  EXPECT_TRUE(cache.GetStats().dictionary_id != 0);
+
+  EXPECT_TRUE(cache.Remove("session-d"));
+  EXPECT_EQ(0u, cache.RecordCount("session-d"));
+  std::vector<std::string> records;
+  EXPECT_TRUE(!cache.ReadRange("session-d", 0, 1, &records, &error));
+}
+
+void TestInvalidSessionIds(const std::string& root) {
+  TranscriptCache cache(root);
+  std::string error;
+  EXPECT_TRUE(cache.Open(&error));
+  EXPECT_TRUE(!cache.Write("../escape", {Record(0, "x")}, false, &error));
+  EXPECT_EQ(0u, cache.RecordCount("../escape"));
+}
+
+}  // namespace
+
+int main() {
+  {
+    ScopedTempDir dir;
+    TestWriteAppendAndReadRange(dir.path());
+  }
+  {
+    ScopedTempDir dir;
+    TestLargeRecordsAreDeduplicated(dir.path());
+  }
+  {
+    ScopedTempDir dir;
+    TestReopenAndDictionary(dir.path());
+  }
+  {
+    ScopedTempDir dir;
+    TestInvalidSessionIds(dir.path());
+  }
+  if (test_failures != 0) {
+    fprintf(stderr, "%d check(s) failed\n", test_failures);
+    return 1;
+  }
+  return 0;
+}
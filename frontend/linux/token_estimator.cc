@@ -0,0 +1,363 @@
+#include "token_estimator.h"
+
+#include <gtk/gtk.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/token_estimator";
+
+constexpr size_t kCacheCapacity = 8192;
+
+// Segments end at the first line break after kMinSegment bytes. Lines longer
+// than kMaxSegment are cut at the next space so a single huge pasted line does
+// not defeat the cache.
+constexpr size_t kMinSegment = 512;
+constexpr size_t kMaxSegment = 8 * 1024;
+
+// API-side image limits used by EstimateImageTokens.
+constexpr double kImageMaxEdge = 1568;
+constexpr double kImageMaxPixels = 1150000;
+constexpr double kPixelsPerToken = 750;
+
+enum class CharClass {
+  kSpace,
+  kNewline,
+  kLetter,       // ASCII letters.
+  kOtherLetter,  // Latin extended, Greek, Cyrillic, Hebrew, Arabic, ...
+  kCjk,          // Han, kana, Hangul and full-width forms.
+  kDigit,
+  kPunct,   // ASCII punctuation.
+  kSymbol,  // Everything else: emoji, box drawing, math, ...
+};
+
+// Decodes one code point; invalid sequences consume a single byte.
+size_t DecodeUtf8(const unsigned char* p, size_t remaining, uint32_t* cp) {
+  const unsigned char c = p[0];
+  size_t length;
+  if (c < 0x80) {
+    *cp = c;
+    return 1;
+  } else if ((c & 0xE0) == 0xC0) {
+    length = 2;
+    *cp = c & 0x1F;
+  } else if ((c & 0xF0) == 0xE0) {
+    length = 3;
+    *cp = c & 0x0F;
+  } else if ((c & 0xF8) == 0xF0) {
+    length = 4;
+    *cp = c & 0x07;
+  } else {
+    *cp = 0xFFFD;
+    return 1;
+  }
+  if (length > remaining) {
+    *cp = 0xFFFD;
+    return 1;
+  }
+  for (size_t i = 1; i < length; ++i) {
+    if ((p[i] & 0xC0) != 0x80) {
+      *cp = 0xFFFD;
+      return 1;
+    }
+    *cp = (*cp << 6) | (p[i] & 0x3F);
+  }
+  return length;
+}
+
+CharClass Classify(uint32_t cp) {
+  if (cp < 0x80) {
+    if (cp == '\n' || cp == '\r') return CharClass::kNewline;
+    if (cp == ' ' || cp == '\t') return CharClass::kSpace;
+    if ((cp | 0x20) >= 'a' && (cp | 0x20) <= 'z') return CharClass::kLetter;
+    if (cp >= '0' && cp <= '9') return CharClass::kDigit;
+    return CharClass::kPunct;
+  }
+  if ((cp >= 0x3000 && cp <= 0x30FF) || (cp >= 0x3400 && cp <= 0x4DBF) ||
+      (cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0xAC00 && cp <= 0xD7AF) ||
+      (cp >= 0xF900 && cp <= 0xFAFF) || (cp >= 0xFF00 && cp <= 0xFFEF) ||
+      (cp >= 0x20000 && cp <= 0x2FFFF)) {
+    return CharClass::kCjk;
+  }
+  if ((cp >= 0x00C0 && cp <= 0x024F) || (cp >= 0x0370 && cp <= 0x052F) ||
+      (cp >= 0x0590 && cp <= 0x06FF) || (cp >= 0x1E00 && cp <= 0x1FFF)) {
+    return CharClass::kOtherLetter;
+  }
+  if (cp == 0x00A0) return CharClass::kSpace;
+  return CharClass::kSymbol;
+}
+
+bool IsUpper(unsigned char c) { return c >= 'A' && c <= 'Z'; }
+
+// Charges an ASCII word. Identifiers are split where BPE vocabularies usually
+// split them: at lower-to-upper case changes and before the last capital of
+// an acronym ("HTTPServer" -> "HTTP" "Server"). Common words up to eight
+// letters are single tokens; longer pieces split roughly every six letters.
+size_t CountAsciiWord(const char* word, size_t size) {
+  size_t tokens = 0;
+  size_t start = 0;
+  auto charge = [&tokens](size_t length) {
+    tokens += length <= 8 ? 1 : 1 + (length - 3) / 6;
+  };
+  for (size_t i = 1; i < size; ++i) {
+    const unsigned char previous = word[i - 1];
+    const unsigned char current = word[i];
+    const bool camel_break = !IsUpper(previous) && IsUpper(current);
+    const bool acronym_break = IsUpper(previous) && IsUpper(current) &&
+                               i + 1 < size && !IsUpper(word[i + 1]);
+    if (camel_break || acronym_break) {
+      charge(i - start);
+      start = i;
+    }
+  }
+  charge(size - start);
+  return tokens;
+}
+
+uint64_t HashSegment(const char* data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 0x100000001b3ull;
+  }
+  return hash ^ (static_cast<uint64_t>(size) * 0x9e3779b97f4a7c15ull);
+}
+
+}  // namespace
+
+size_t EstimateTextTokens(const char* data, size_t size) {
+  const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+  size_t tokens = 0;
+  size_t i = 0;
+  while (i < size) {
+    uint32_t cp;
+    const size_t first_length = DecodeUtf8(bytes + i, size - i, &cp);
+    const CharClass cls = Classify(cp);
+
+    // Extent of the run of |cls| starting at i, in bytes and code points.
+    size_t end = i + first_length;
+    size_t count = 1;
+    while (end < size) {
+      uint32_t next;
+      const size_t length = DecodeUtf8(bytes + end, size - end, &next);
+      if (Classify(next) != cls) {
+        break;
+      }
+      end += length;
+      ++count;
+    }
+
+    switch (cls) {
+      case CharClass::kSpace: {
+        // A single space before a word is merged into the word's token.
+        const bool before_word =
+            end < size && bytes[end] != '\n' && bytes[end] != '\r';
+        const size_t loose = before_word ? count - 1 : count;
+        if (loose > 0) {
+          tokens += 1 + (loose - 1) / 8;
+        }
+        break;
+      }
+      case CharClass::kNewline:
+        tokens += 1 + count / 4;
+        break;
+      case CharClass::kLetter:
+        tokens += CountAsciiWord(data + i, end - i);
+        break;
+      case CharClass::kOtherLetter:
+        tokens += (count + 1) / 2;
+        break;
+      case CharClass::kCjk:
+        tokens += count;
+        break;
+      case CharClass::kDigit:
+        tokens += (count + 2) / 3;
+        break;
+      case CharClass::kPunct:
+        tokens += (count + 1) / 2;
+        break;
+      case CharClass::kSymbol:
+        // Byte-level fallback: roughly one token per two UTF-8 bytes.
+        tokens += (end - i + 1) / 2;
+        break;
+    }
+    i = end;
+  }
+  return tokens;
+}
+
+size_t EstimateImageTokens(int width, int height) {
+  if (width <= 0 || height <= 0) {
+    return 0;
+  }
+  double w = width;
+  double h = height;
+  const double edge_scale = kImageMaxEdge / std::max(w, h);
+  const double pixel_scale = std::sqrt(kImageMaxPixels / (w * h));
+  const double scale = std::min({1.0, edge_scale, pixel_scale});
+  w = std::floor(w * scale);
+  h = std::floor(h * scale);
+  return static_cast<size_t>(std::ceil(w * h / kPixelsPerToken));
+}
+
+TokenEstimator::TokenEstimator(size_t capacity) : capacity_(capacity) {}
+
+TokenEstimator& TokenEstimator::Get() {
+  static TokenEstimator* estimator = new TokenEstimator(kCacheCapacity);
+  return *estimator;
+}
+
+size_t TokenEstimator::CountText(const std::string& text) {
+  const char* data = text.data();
+  const size_t size = text.size();
+  size_t tokens = 0;
+  size_t start = 0;
+  while (start < size) {
+    size_t end = start;
+    while (end < size) {
+      const char c = data[end++];
+      const size_t length = end - start;
+      if (c == '\n' && length >= kMinSegment) {
+        break;
+      }
+      // Only cut overlong lines at a space, which is never inside a UTF-8
+      // sequence and rarely inside a BPE token.
+      if (c == ' ' && length >= kMaxSegment) {
+        break;
+      }
+    }
+    tokens += CountSegment(data + start, end - start);
+    start = end;
+  }
+  return tokens;
+}
+
+size_t TokenEstimator::cached_segments() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t TokenEstimator::CountSegment(const char* data, size_t size) {
+  const uint64_t key = HashSegment(data, size);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second.position);
+      return it->second.tokens;
+    }
+  }
+
+  // Counted outside the lock so concurrent estimates do not serialize.
+  const size_t tokens = EstimateTextTokens(data, size);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.find(key) == entries_.end()) {
+    lru_.push_front(key);
+    entries_[key] = Entry{tokens, lru_.begin()};
+    while (entries_.size() > capacity_) {
+      entries_.erase(lru_.back());
+      lru_.pop_back();
+    }
+  }
+  return tokens;
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_token_estimator_channel = nullptr;
+
+struct DraftBlock {
+  bool image = false;
+  std::string text;
+  int width = 0;
+  int height = 0;
+  std::string path;  // Image file whose header supplies the size.
+};
+
+size_t CountBlock(const DraftBlock& block) {
+  if (!block.image) {
+    return TokenEstimator::Get().CountText(block.text);
+  }
+  int width = block.width;
+  int height = block.height;
+  if ((width <= 0 || height <= 0) && !block.path.empty()) {
+    // Reads only the image header.
+    if (gdk_pixbuf_get_file_info(block.path.c_str(), &width, &height) ==
+        nullptr) {
+      return 0;
+    }
+  }
+  return EstimateImageTokens(width, height);
+}
+
+void HandleTokenEstimatorCall(FlMethodChannel* channel,
+                              FlMethodCall* method_call, gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method != "estimate") {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+    return;
+  }
+
+  FlValue* list = args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_MAP
+                      ? fl_value_lookup_string(args, "blocks")
+                      : nullptr;
+  if (list == nullptr || fl_value_get_type(list) != FL_VALUE_TYPE_LIST) {
+    RespondError(method_call, "INVALID_ARGUMENTS", "blocks list is required");
+    return;
+  }
+  auto blocks = std::make_shared<std::vector<DraftBlock>>();
+  for (size_t i = 0; i < fl_value_get_length(list); ++i) {
+    FlValue* item = fl_value_get_list_value(list, i);
+    DraftBlock block;
+    block.image = LookupStringArg(item, "type", "text") == "image";
+    if (block.image) {
+      block.width = static_cast<int>(LookupIntArg(item, "width", 0));
+      block.height = static_cast<int>(LookupIntArg(item, "height", 0));
+      block.path = LookupStringArg(item, "path");
+    } else {
+      block.text = LookupStringArg(item, "text");
+    }
+    blocks->push_back(std::move(block));
+  }
+
+  g_object_ref(method_call);
+  TaskPool::Get().Post([method_call, blocks]() {
+    auto counts = std::make_shared<std::vector<int64_t>>();
+    int64_t total = 0;
+    for (const DraftBlock& block : *blocks) {
+      counts->push_back(static_cast<int64_t>(CountBlock(block)));
+      total += counts->back();
+    }
+    RunOnMainThread([method_call, counts, total]() {
+      FlValue* result = fl_value_new_map();
+      fl_value_set_string_take(result, "total", fl_value_new_int(total));
+      fl_value_set_string_take(
+          result, "blocks",
+          fl_value_new_int64_list(counts->data(), counts->size()));
+      RespondSuccess(method_call, result);
+      g_object_unref(method_call);
+    });
+  });
+}
+
+}  // namespace
+
+void RegisterTokenEstimatorChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_token_estimator_channel = fl_method_channel_new(
+      messenger, kChannelName, FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_token_estimator_channel, HandleTokenEstimatorCall, nullptr, nullptr);
+}
@@ -0,0 +1,57 @@
+#ifndef RUNNER_TOKEN_ESTIMATOR_H_
+#define RUNNER_TOKEN_ESTIMATOR_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// Approximate token count of UTF-8 |data|. The text is split with the same
+// pre-tokenization rules byte-level BPE tokenizers apply (words with their
+// leading space, digit groups, punctuation runs, whitespace runs) and each
+// piece is charged by its script and length. Without the vocabulary this is
+// an estimate, typically within 15% for prose and code, and errs high for
+// CJK text.
+size_t EstimateTextTokens(const char* data, size_t size);
+
+// Tokens charged for an image of |width| x |height| pixels after the API's
+// own downscaling (longest edge 1568px, about 1.15 megapixels).
+size_t EstimateImageTokens(int width, int height);
+
+// Counts draft text incrementally. Text is cut into segments at line breaks,
+// and segment counts are cached by content, so an edit only re-counts the
+// segment it touches. Thread-safe; meant to be called from the task pool.
+class TokenEstimator {
+ public:
+  explicit TokenEstimator(size_t capacity);
+
+  static TokenEstimator& Get();
+
+  size_t CountText(const std::string& text);
+
+  size_t cached_segments() const;
+
+ private:
+  size_t CountSegment(const char* data, size_t size);
+
+  using LruList = std::list<uint64_t>;
+  struct Entry {
+    size_t tokens;
+    LruList::iterator position;
+  };
+
+  const size_t capacity_;
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, Entry> entries_;
+  LruList lru_;
+};
+
+// Registers the "com.codeagenthub/token_estimator" method channel.
+void RegisterTokenEstimatorChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_TOKEN_ESTIMATOR_H_
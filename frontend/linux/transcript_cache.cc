@@ -0,0 +1,1075 @@
+#include "transcript_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zdict.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+
+#include "isolate_bridge.h"
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+constexpr char kFileMagic[8] = {'C', 'A', 'H', 'T', 'C', 'V', '0', '1'};
+constexpr char kIndexMagic[8] = {'C', 'A', 'H', 'T', 'C', 'I', 'D', 'X'};
+constexpr uint32_t kFileVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kBlockInfoSize = 28;
+constexpr size_t kTrailerSize = 32;
+
+constexpr uint32_t kChunkMagic = 0x4B4E4843;  // "CHNK"
+constexpr size_t kChunkHeaderSize = 24;
+
+// A block is closed after this many records or raw bytes, whichever first.
+constexpr uint32_t kBlockRecords = 64;
+constexpr size_t kBlockBytes = 128 * 1024;
+
+// Records above this size are content-defined chunked. The gear mask gives
+// an average chunk of ~8 KiB between the min and max bounds.
+constexpr size_t kChunkThreshold = 16 * 1024;
+constexpr size_t kMinChunkSize = 2 * 1024;
+constexpr size_t kMaxChunkSize = 64 * 1024;
+constexpr uint64_t kChunkMask = (1u << 13) - 1;
+
+constexpr uint8_t kInlineRecord = 0;
+constexpr uint8_t kChunkedRecord = 1;
+
+constexpr int kCompressionLevel = 7;
+constexpr size_t kBlockCacheCapacity = 16;
+
+// Dictionary training input: bounded reservoir of record prefixes.
+constexpr size_t kSamplePrefixBytes = 16 * 1024;
+constexpr size_t kMaxSampleBytes = 4 * 1024 * 1024;
+constexpr size_t kAutoTrainBytes = 512 * 1024;
+constexpr size_t kDictionaryCapacity = 64 * 1024;
+
+const char kChannelName[] = "com.codeagenthub/transcript_cache";
+
+struct GearTable {
+  uint64_t values[256];
+
+  GearTable() {
+    // Fixed seed: chunk boundaries must be stable across runs, otherwise
+    // deduplication against chunks.pack stops working after a restart.
+    uint64_t state = 0x43414854524e5343ull;
+    for (auto& value : values) {
+      state += 0x9e3779b97f4a7c15ull;
+      uint64_t z = state;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      value = z ^ (z >> 31);
+    }
+  }
+};
+
+const GearTable& Gear() {
+  static const GearTable table;
+  return table;
+}
+
+// Returns the length of the next chunk of |data|.
+size_t NextChunkLength(const char* data, size_t size) {
+  if (size <= kMinChunkSize) {
+    return size;
+  }
+  const size_t limit = std::min(size, kMaxChunkSize);
+  const uint64_t* gear = Gear().values;
+  uint64_t hash = 0;
+  for (size_t i = kMinChunkSize; i < limit; ++i) {
+    hash = (hash << 1) + gear[static_cast<uint8_t>(data[i])];
+    if ((hash & kChunkMask) == 0) {
+      return i + 1;
+    }
+  }
+  return limit;
+}
+
+uint64_t HashChunk(const char* data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 0x100000001b3ull;
+  }
+  return hash ^ (static_cast<uint64_t>(size) << 40);
+}
+
+void PutU32(std::string* out, uint32_t value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void PutU64(std::string* out, uint64_t value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+uint32_t GetU32(const char* data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint64_t GetU64(const char* data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+void PutVarint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+bool GetVarint(const std::string& in, size_t* pos, uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && *pos < in.size(); shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(in[(*pos)++]);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IsValidSessionId(const std::string& session_id) {
+  if (session_id.empty() || session_id.size() > 128) {
+    return false;
+  }
+  return std::all_of(session_id.begin(), session_id.end(), [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '-' || c == '_';
+  });
+}
+
+bool ReadExact(int fd, uint64_t offset, size_t size, std::string* out) {
+  out->resize(size);
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t n = pread(fd, &(*out)[done], size - done, offset + done);
+    if (n <= 0) {
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool WriteExact(int fd, uint64_t offset, const std::string& data) {
+  size_t done = 0;
+  while (done < data.size()) {
+    const ssize_t n =
+        pwrite(fd, data.data() + done, data.size() - done, offset + done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool ReadWholeFile(const std::string& path, std::string* out) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  const bool ok = fstat(fd, &st) == 0 &&
+                  ReadExact(fd, 0, static_cast<size_t>(st.st_size), out);
+  close(fd);
+  return ok;
+}
+
+bool WriteWholeFile(const std::string& path, const std::string& data) {
+  const std::string tmp_path = path + ".tmp";
+  const int fd =
+      open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  const bool ok = WriteExact(fd, 0, data);
+  close(fd);
+  return ok && rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+}  // namespace
+
+TranscriptCache::TranscriptCache(std::string root_dir)
+    : root_dir_(std::move(root_dir)) {}
+
+TranscriptCache::~TranscriptCache() {
+  if (chunk_fd_ >= 0) {
+    close(chunk_fd_);
+  }
+  for (auto& entry : dictionaries_) {
+    ZSTD_freeCDict(entry.second.cdict);
+    ZSTD_freeDDict(entry.second.ddict);
+  }
+  ZSTD_freeCCtx(cctx_);
+  ZSTD_freeDCtx(dctx_);
+}
+
+bool TranscriptCache::Open(std::string* error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (opened_) {
+    return true;
+  }
+  if (g_mkdir_with_parents(root_dir_.c_str(), 0700) != 0) {
+    *error = "Cannot create cache directory " + root_dir_;
+    return false;
+  }
+
+  cctx_ = ZSTD_createCCtx();
+  dctx_ = ZSTD_createDCtx();
+  if (cctx_ == nullptr || dctx_ == nullptr) {
+    *error = "Cannot allocate zstd contexts";
+    return false;
+  }
+
+  std::string current;
+  if (ReadWholeFile(root_dir_ + "/dict.current", &current)) {
+    current_dictionary_id_ =
+        static_cast<uint32_t>(strtoul(current.c_str(), nullptr, 10));
+    if (current_dictionary_id_ != 0 &&
+        GetDictionary(current_dictionary_id_) == nullptr) {
+      g_warning("Transcript cache dictionary %u is missing",
+                current_dictionary_id_);
+      current_dictionary_id_ = 0;
+    }
+  }
+
+  const std::string chunk_path = root_dir_ + "/chunks.pack";
+  chunk_fd_ = open(chunk_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (chunk_fd_ < 0) {
+    *error = "Cannot open " + chunk_path;
+    return false;
+  }
+
+  // Rebuild the chunk index from the entry headers. A torn tail from an
+  // interrupted write is cut off so new chunks append after the last good
+  // entry.
+  struct stat st;
+  if (fstat(chunk_fd_, &st) != 0) {
+    *error = "Cannot stat " + chunk_path;
+    return false;
+  }
+  const uint64_t file_size = static_cast<uint64_t>(st.st_size);
+  uint64_t offset = 0;
+  std::string header;
+  while (offset + kChunkHeaderSize <= file_size &&
+         ReadExact(chunk_fd_, offset, kChunkHeaderSize, &header) &&
+         GetU32(header.data()) == kChunkMagic) {
+    ChunkInfo info;
+    const uint64_t hash = GetU64(header.data() + 4);
+    info.raw_size = GetU32(header.data() + 12);
+    info.compressed_size = GetU32(header.data() + 16);
+    info.dictionary_id = GetU32(header.data() + 20);
+    info.offset = offset + kChunkHeaderSize;
+    if (info.offset + info.compressed_size > file_size) {
+      break;
+    }
+    chunks_[hash] = info;
+    offset = info.offset + info.compressed_size;
+  }
+  if (offset != file_size && ftruncate(chunk_fd_, offset) != 0) {
+    *error = "Cannot repair " + chunk_path;
+    return false;
+  }
+  chunk_file_size_ = offset;
+
+  opened_ = true;
+  return true;
+}
+
+std::string TranscriptCache::SessionPath(const std::string& session_id) const {
+  return root_dir_ + "/" + session_id + ".tcache";
+}
+
+const TranscriptCache::Dictionary* TranscriptCache::GetDictionary(
+    uint32_t dictionary_id) {
+  auto it = dictionaries_.find(dictionary_id);
+  if (it != dictionaries_.end()) {
+    return &it->second;
+  }
+  std::string content;
+  const std::string path =
+      root_dir_ + "/dict-" + std::to_string(dictionary_id) + ".zdict";
+  if (!ReadWholeFile(path, &content)) {
+    return nullptr;
+  }
+  Dictionary dictionary;
+  dictionary.cdict =
+      ZSTD_createCDict(content.data(), content.size(), kCompressionLevel);
+  dictionary.ddict = ZSTD_createDDict(content.data(), content.size());
+  if (dictionary.cdict == nullptr || dictionary.ddict == nullptr) {
+    ZSTD_freeCDict(dictionary.cdict);
+    ZSTD_freeDDict(dictionary.ddict);
+    return nullptr;
+  }
+  return &dictionaries_.emplace(dictionary_id, dictionary).first->second;
+}
+
+bool TranscriptCache::Compress(const char* data, size_t size,
+                               uint32_t dictionary_id, std::string* compressed,
+                               std::string* error) {
+  compressed->resize(ZSTD_compressBound(size));
+  size_t result;
+  const Dictionary* dictionary =
+      dictionary_id != 0 ? GetDictionary(dictionary_id) : nullptr;
+  if (dictionary != nullptr) {
+    result = ZSTD_compress_usingCDict(cctx_, &(*compressed)[0],
+                                      compressed->size(), data, size,
+                                      dictionary->cdict);
+  } else {
+    result = ZSTD_compressCCtx(cctx_, &(*compressed)[0], compressed->size(),
+                               data, size, kCompressionLevel);
+  }
+  if (ZSTD_isError(result)) {
+    *error = std::string("zstd compression failed: ") +
+             ZSTD_getErrorName(result);
+    return false;
+  }
+  compressed->resize(result);
+  return true;
+}
+
+bool TranscriptCache::Decompress(const char* data, size_t size,
+                                 size_t raw_size, uint32_t dictionary_id,
+                                 std::string* raw, std::string* error) {
+  raw->resize(raw_size);
+  size_t result;
+  if (dictionary_id != 0) {
+    const Dictionary* dictionary = GetDictionary(dictionary_id);
+    if (dictionary == nullptr) {
+      *error = "Missing dictionary " + std::to_string(dictionary_id);
+      return false;
+    }
+    result = ZSTD_decompress_usingDDict(dctx_, &(*raw)[0], raw_size, data,
+                                        size, dictionary->ddict);
+  } else {
+    result = ZSTD_decompressDCtx(dctx_, &(*raw)[0], raw_size, data, size);
+  }
+  if (ZSTD_isError(result) || result != raw_size) {
+    *error = "Corrupt transcript cache data";
+    return false;
+  }
+  return true;
+}
+
+bool TranscriptCache::StoreChunk(const char* data, size_t size,
+                                 uint64_t* hash, std::string* error) {
+  // The hash only picks the chunk id: an existing chunk is reused when its
+  // bytes match, and a different chunk with the same hash takes the next
+  // free id.
+  std::string stored;
+  std::string load_error;
+  for (*hash = HashChunk(data, size);; ++*hash) {
+    auto it = chunks_.find(*hash);
+    if (it == chunks_.end()) {
+      break;
+    }
+    if (it->second.raw_size == size && LoadChunk(*hash, &stored, &load_error) &&
+        stored.compare(0, std::string::npos, data, size) == 0) {
+      return true;
+    }
+  }
+
+  std::string compressed;
+  if (!Compress(data, size, current_dictionary_id_, &compressed, error)) {
+    return false;
+  }
+  std::string entry;
+  entry.reserve(kChunkHeaderSize + compressed.size());
+  PutU32(&entry, kChunkMagic);
+  PutU64(&entry, *hash);
+  PutU32(&entry, static_cast<uint32_t>(size));
+  PutU32(&entry, static_cast<uint32_t>(compressed.size()));
+  PutU32(&entry, current_dictionary_id_);
+  entry += compressed;
+  if (!WriteExact(chunk_fd_, chunk_file_size_, entry)) {
+    *error = "Cannot append to chunks.pack";
+    return false;
+  }
+
+  ChunkInfo info;
+  info.offset = chunk_file_size_ + kChunkHeaderSize;
+  info.compressed_size = static_cast<uint32_t>(compressed.size());
+  info.raw_size = static_cast<uint32_t>(size);
+  info.dictionary_id = current_dictionary_id_;
+  chunks_[*hash] = info;
+  chunk_file_size_ += entry.size();
+  return true;
+}
+
+bool TranscriptCache::LoadChunk(uint64_t hash, std::string* data,
+                                std::string* error) {
+  auto it = chunks_.find(hash);
+  if (it == chunks_.end()) {
+    *error = "Missing transcript chunk";
+    return false;
+  }
+  const ChunkInfo& info = it->second;
+  std::string compressed;
+  if (!ReadExact(chunk_fd_, info.offset, info.compressed_size, &compressed)) {
+    *error = "Cannot read chunks.pack";
+    return false;
+  }
+  return Decompress(compressed.data(), compressed.size(), info.raw_size,
+                    info.dictionary_id, data, error);
+}
+
+bool TranscriptCache::EncodeRecord(const std::string& record,
+                                   std::string* encoded, std::string* error) {
+  if (record.size() < kChunkThreshold) {
+    encoded->push_back(static_cast<char>(kInlineRecord));
+    PutVarint(encoded, record.size());
+    encoded->append(record);
+    return true;
+  }
+
+  std::vector<uint64_t> hashes;
+  size_t offset = 0;
+  while (offset < record.size()) {
+    const size_t length =
+        NextChunkLength(record.data() + offset, record.size() - offset);
+    uint64_t hash;
+    if (!StoreChunk(record.data() + offset, length, &hash, error)) {
+      return false;
+    }
+    hashes.push_back(hash);
+    offset += length;
+  }
+  encoded->push_back(static_cast<char>(kChunkedRecord));
+  PutVarint(encoded, hashes.size());
+  for (uint64_t hash : hashes) {
+    PutU64(encoded, hash);
+  }
+  return true;
+}
+
+bool TranscriptCache::DecodeRecords(const std::string& block, size_t skip,
+                                    size_t count,
+                                    std::vector<std::string>* records,
+                                    std::string* error) {
+  size_t pos = 0;
+  for (size_t i = 0; i < skip + count; ++i) {
+    if (pos >= block.size()) {
+      *error = "Truncated transcript block";
+      return false;
+    }
+    const uint8_t kind = static_cast<uint8_t>(block[pos++]);
+    uint64_t length;
+    if (!GetVarint(block, &pos, &length)) {
+      *error = "Corrupt transcript block";
+      return false;
+    }
+    const uint64_t payload_size =
+        kind == kChunkedRecord ? length * sizeof(uint64_t) : length;
+    if (payload_size > block.size() - pos) {
+      *error = "Corrupt transcript block";
+      return false;
+    }
+    if (i >= skip) {
+      if (kind == kInlineRecord) {
+        records->emplace_back(block, pos, length);
+      } else {
+        std::string record;
+        std::string chunk;
+        for (uint64_t c = 0; c < length; ++c) {
+          if (!LoadChunk(GetU64(block.data() + pos + c * sizeof(uint64_t)),
+                         &chunk, error)) {
+            return false;
+          }
+          record += chunk;
+        }
+        records->push_back(std::move(record));
+      }
+    }
+    pos += payload_size;
+  }
+  return true;
+}
+
+TranscriptCache::SessionIndex* TranscriptCache::LoadIndex(
+    const std::string& session_id) {
+  auto it = indexes_.find(session_id);
+  if (it != indexes_.end()) {
+    return it->second.get();
+  }
+
+  const int fd = open(SessionPath(session_id).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  auto index = std::make_unique<SessionIndex>();
+  struct stat st;
+  std::string header;
+  std::string trailer;
+  std::string entries;
+  bool ok = fstat(fd, &st) == 0 &&
+            static_cast<uint64_t>(st.st_size) >= kHeaderSize + kTrailerSize &&
+            ReadExact(fd, 0, kHeaderSize, &header) &&
+            memcmp(header.data(), kFileMagic, sizeof(kFileMagic)) == 0 &&
+            GetU32(header.data() + 8) == kFileVersion &&
+            ReadExact(fd, st.st_size - kTrailerSize, kTrailerSize, &trailer) &&
+            memcmp(trailer.data() + 24, kIndexMagic, sizeof(kIndexMagic)) == 0;
+  if (ok) {
+    index->file_size = static_cast<uint64_t>(st.st_size);
+    const uint64_t index_offset = GetU64(trailer.data());
+    index->record_count = GetU64(trailer.data() + 8);
+    index->raw_bytes = GetU64(trailer.data() + 16);
+    const uint64_t index_size = index->file_size - kTrailerSize - index_offset;
+    ok = index_offset >= kHeaderSize &&
+         index_offset <= index->file_size - kTrailerSize &&
+         index_size % kBlockInfoSize == 0 &&
+         ReadExact(fd, index_offset, index_size, &entries);
+  }
+  close(fd);
+  if (!ok) {
+    g_warning("Dropping unreadable transcript cache for %s",
+              session_id.c_str());
+    unlink(SessionPath(session_id).c_str());
+    return nullptr;
+  }
+
+  for (size_t pos = 0; pos < entries.size(); pos += kBlockInfoSize) {
+    const char* entry = entries.data() + pos;
+    BlockInfo block;
+    block.offset = GetU64(entry);
+    block.compressed_size = GetU32(entry + 8);
+    block.raw_size = GetU32(entry + 12);
+    block.first_record = GetU32(entry + 16);
+    block.record_count = GetU32(entry + 20);
+    block.dictionary_id = GetU32(entry + 24);
+    index->blocks.push_back(block);
+  }
+  return (indexes_[session_id] = std::move(index)).get();
+}
+
+bool TranscriptCache::LoadBlock(const std::string& session_id,
+                                const SessionIndex& index, size_t block,
+                                std::shared_ptr<const std::string>* raw,
+                                std::string* error) {
+  const BlockKey key(session_id, block);
+  for (auto it = block_cache_.begin(); it != block_cache_.end(); ++it) {
+    if (it->first == key) {
+      block_cache_.splice(block_cache_.begin(), block_cache_, it);
+      *raw = it->second;
+      return true;
+    }
+  }
+
+  const BlockInfo& info = index.blocks[block];
+  const int fd = open(SessionPath(session_id).c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    *error = "Transcript cache file disappeared";
+    return false;
+  }
+  std::string compressed;
+  const bool read_ok =
+      ReadExact(fd, info.offset, info.compressed_size, &compressed);
+  close(fd);
+  auto decompressed = std::make_shared<std::string>();
+  if (!read_ok) {
+    *error = "Cannot read transcript block";
+    return false;
+  }
+  if (!Decompress(compressed.data(), compressed.size(), info.raw_size,
+                  info.dictionary_id, decompressed.get(), error)) {
+    return false;
+  }
+
+  block_cache_.emplace_front(key, decompressed);
+  if (block_cache_.size() > kBlockCacheCapacity) {
+    block_cache_.pop_back();
+  }
+  *raw = std::move(decompressed);
+  return true;
+}
+
+bool TranscriptCache::WriteBlocks(
+    const std::string& session_id, SessionIndex* index,
+    const std::vector<std::string>& encoded_records, std::string* error) {
+  const std::string path = SessionPath(session_id);
+  const bool in_place = index->file_size != 0;
+  const std::string write_path = in_place ? path : path + ".tmp";
+  const int fd = open(write_path.c_str(),
+                      O_RDWR | O_CREAT | O_CLOEXEC | (in_place ? 0 : O_TRUNC),
+                      0600);
+  if (fd < 0) {
+    *error = "Cannot open " + write_path;
+    return false;
+  }
+
+  // Appends reopen a partially filled last block so frequent small appends
+  // do not leave a trail of tiny, poorly compressed blocks behind.
+  std::string current;
+  uint32_t current_count = 0;
+  uint64_t offset = kHeaderSize;
+  bool ok = true;
+  if (!in_place) {
+    std::string header(kFileMagic, sizeof(kFileMagic));
+    PutU32(&header, kFileVersion);
+    PutU32(&header, 0);
+    ok = WriteExact(fd, 0, header);
+  } else if (!index->blocks.empty()) {
+    const BlockInfo& last = index->blocks.back();
+    offset = last.offset + last.compressed_size;
+    if (last.record_count < kBlockRecords && last.raw_size < kBlockBytes) {
+      std::shared_ptr<const std::string> raw;
+      ok = LoadBlock(session_id, *index, index->blocks.size() - 1, &raw,
+                     error);
+      if (ok) {
+        current = *raw;
+        current_count = last.record_count;
+        offset = last.offset;
+        index->blocks.pop_back();
+      }
+    }
+  }
+  block_cache_.remove_if([&session_id](const decltype(block_cache_)::value_type&
+                                           entry) {
+    return entry.first.first == session_id;
+  });
+
+  auto flush_block = [&]() {
+    std::string compressed;
+    if (!Compress(current.data(), current.size(), current_dictionary_id_,
+                  &compressed, error)) {
+      return false;
+    }
+    if (!WriteExact(fd, offset, compressed)) {
+      *error = "Cannot write transcript block";
+      return false;
+    }
+    BlockInfo info;
+    info.offset = offset;
+    info.compressed_size = static_cast<uint32_t>(compressed.size());
+    info.raw_size = static_cast<uint32_t>(current.size());
+    info.record_count = current_count;
+    info.first_record = index->blocks.empty()
+                            ? 0
+                            : index->blocks.back().first_record +
+                                  index->blocks.back().record_count;
+    info.dictionary_id = current_dictionary_id_;
+    index->blocks.push_back(info);
+    offset += compressed.size();
+    current.clear();
+    current_count = 0;
+    return true;
+  };
+
+  for (const auto& encoded : encoded_records) {
+    if (!ok) {
+      break;
+    }
+    current += encoded;
+    ++current_count;
+    if (current_count >= kBlockRecords || current.size() >= kBlockBytes) {
+      ok = flush_block();
+    }
+  }
+  if (ok && current_count > 0) {
+    ok = flush_block();
+  }
+
+  if (ok) {
+    std::string tail;
+    for (const auto& block : index->blocks) {
+      PutU64(&tail, block.offset);
+      PutU32(&tail, block.compressed_size);
+      PutU32(&tail, block.raw_size);
+      PutU32(&tail, block.first_record);
+      PutU32(&tail, block.record_count);
+      PutU32(&tail, block.dictionary_id);
+    }
+    PutU64(&tail, offset);
+    PutU64(&tail, index->record_count);
+    PutU64(&tail, index->raw_bytes);
+    tail.append(kIndexMagic, sizeof(kIndexMagic));
+    ok = WriteExact(fd, offset, tail) && ftruncate(fd, offset + tail.size()) == 0;
+    if (ok) {
+      index->file_size = offset + tail.size();
+    } else {
+      *error = "Cannot write transcript index";
+    }
+  }
+  close(fd);
+
+  if (ok && !in_place && rename(write_path.c_str(), path.c_str()) != 0) {
+    *error = "Cannot install " + path;
+    ok = false;
+  }
+  if (!ok) {
+    indexes_.erase(session_id);
+    unlink(write_path.c_str());
+  }
+  return ok;
+}
+
+bool TranscriptCache::Write(const std::string& session_id,
+                            const std::vector<std::string>& records,
+                            bool append, std::string* error) {
+  if (!IsValidSessionId(session_id)) {
+    *error = "Invalid session id";
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!opened_) {
+    *error = "Transcript cache is not open";
+    return false;
+  }
+
+  SessionIndex* index = append ? LoadIndex(session_id) : nullptr;
+  if (index == nullptr) {
+    auto fresh = std::make_unique<SessionIndex>();
+    index = fresh.get();
+    indexes_[session_id] = std::move(fresh);
+  }
+
+  std::vector<std::string> encoded_records;
+  encoded_records.reserve(records.size());
+  for (const auto& record : records) {
+    std::string encoded;
+    if (!EncodeRecord(record, &encoded, error)) {
+      indexes_.erase(session_id);
+      return false;
+    }
+    encoded_records.push_back(std::move(encoded));
+    index->record_count++;
+    index->raw_bytes += record.size();
+    AddSample(record);
+  }
+
+  if (!WriteBlocks(session_id, index, encoded_records, error)) {
+    return false;
+  }
+
+  if (current_dictionary_id_ == 0 && sample_bytes_ >= kAutoTrainBytes) {
+    std::string train_error;
+    if (!TrainDictionaryLocked(&train_error)) {
+      g_warning("Transcript cache dictionary training failed: %s",
+                train_error.c_str());
+    }
+  }
+  return true;
+}
+
+bool TranscriptCache::ReadRange(const std::string& session_id, uint64_t start,
+                                uint64_t count,
+                                std::vector<std::string>* records,
+                                std::string* error) {
+  if (!IsValidSessionId(session_id)) {
+    *error = "Invalid session id";
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  SessionIndex* index = opened_ ? LoadIndex(session_id) : nullptr;
+  if (index == nullptr) {
+    *error = "Session is not cached";
+    return false;
+  }
+  if (start >= index->record_count) {
+    return true;
+  }
+  const uint64_t end = std::min(index->record_count, start + count);
+
+  // Blocks are ordered by first_record; find the one holding |start|.
+  auto it = std::upper_bound(
+      index->blocks.begin(), index->blocks.end(), start,
+      [](uint64_t record, const BlockInfo& block) {
+        return record < block.first_record;
+      });
+  size_t block = static_cast<size_t>(it - index->blocks.begin()) - 1;
+  uint64_t next = start;
+  for (; next < end && block < index->blocks.size(); ++block) {
+    const BlockInfo& info = index->blocks[block];
+    std::shared_ptr<const std::string> raw;
+    if (!LoadBlock(session_id, *index, block, &raw, error)) {
+      return false;
+    }
+    const uint64_t skip = next - info.first_record;
+    const uint64_t take =
+        std::min<uint64_t>(end - next, info.record_count - skip);
+    if (!DecodeRecords(*raw, skip, take, records, error)) {
+      return false;
+    }
+    next += take;
+  }
+  return true;
+}
+
+uint64_t TranscriptCache::RecordCount(const std::string& session_id) {
+  if (!IsValidSessionId(session_id)) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  SessionIndex* index = opened_ ? LoadIndex(session_id) : nullptr;
+  return index != nullptr ? index->record_count : 0;
+}
+
+bool TranscriptCache::Remove(const std::string& session_id) {
+  if (!IsValidSessionId(session_id)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  indexes_.erase(session_id);
+  block_cache_.remove_if([&session_id](const decltype(block_cache_)::value_type&
+                                           entry) {
+    return entry.first.first == session_id;
+  });
+  return unlink(SessionPath(session_id).c_str()) == 0;
+}
+
+void TranscriptCache::AddSample(const std::string& record) {
+  if (sample_bytes_ >= kMaxSampleBytes || record.empty()) {
+    return;
+  }
+  samples_.emplace_back(record, 0, std::min(record.size(), kSamplePrefixBytes));
+  sample_bytes_ += samples_.back().size();
+}
+
+bool TranscriptCache::TrainDictionary(std::string* error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!opened_) {
+    *error = "Transcript cache is not open";
+    return false;
+  }
+  return TrainDictionaryLocked(error);
+}
+
+bool TranscriptCache::TrainDictionaryLocked(std::string* error) {
+  if (samples_.size() < 16) {
+    *error = "Not enough cached records to train a dictionary";
+    return false;
+  }
+
+  std::string joined;
+  joined.reserve(sample_bytes_);
+  std::vector<size_t> sizes;
+  sizes.reserve(samples_.size());
+  for (const auto& sample : samples_) {
+    joined += sample;
+    sizes.push_back(sample.size());
+  }
+  std::string dictionary(kDictionaryCapacity, '\0');
+  const size_t size =
+      ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(), joined.data(),
+                            sizes.data(), static_cast<unsigned>(sizes.size()));
+  if (ZDICT_isError(size)) {
+    *error = std::string("Dictionary training failed: ") +
+             ZDICT_getErrorName(size);
+    return false;
+  }
+  dictionary.resize(size);
+
+  const uint32_t dictionary_id = ZDICT_getDictID(dictionary.data(), size);
+  const std::string path =
+      root_dir_ + "/dict-" + std::to_string(dictionary_id) + ".zdict";
+  if (!WriteWholeFile(path, dictionary) ||
+      !WriteWholeFile(root_dir_ + "/dict.current",
+                      std::to_string(dictionary_id))) {
+    *error = "Cannot store dictionary";
+    return false;
+  }
+  if (GetDictionary(dictionary_id) == nullptr) {
+    *error = "Trained dictionary is unusable";
+    return false;
+  }
+  current_dictionary_id_ = dictionary_id;
+  samples_.clear();
+  sample_bytes_ = 0;
+  return true;
+}
+
+TranscriptCache::Stats TranscriptCache::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  stats.dictionary_id = current_dictionary_id_;
+  stats.chunks = chunks_.size();
+  stats.chunk_bytes = chunk_file_size_;
+  stats.stored_bytes = chunk_file_size_;
+
+  DIR* dir = opendir(root_dir_.c_str());
+  if (dir == nullptr) {
+    return stats;
+  }
+  static const std::string kSuffix = ".tcache";
+  while (struct dirent* entry = readdir(dir)) {
+    const std::string name = entry->d_name;
+    if (name.size() <= kSuffix.size() ||
+        name.compare(name.size() - kSuffix.size(), kSuffix.size(), kSuffix) !=
+            0) {
+      continue;
+    }
+    SessionIndex* index = LoadIndex(name.substr(0, name.size() - kSuffix.size()));
+    if (index == nullptr) {
+      continue;
+    }
+    stats.sessions++;
+    stats.records += index->record_count;
+    stats.raw_bytes += index->raw_bytes;
+    stats.stored_bytes += index->file_size;
+  }
+  closedir(dir);
+  return stats;
+}
+
+// Method channel glue. All cache work runs on the task pool; responses are
+// delivered back on the platform thread.
+
+namespace {
+
+// Pool threads race to the first call; only one of them may create the cache,
+// since two instances would both append to chunks.pack.
+std::mutex g_transcript_cache_mutex;
+TranscriptCache* g_transcript_cache = nullptr;
+FlMethodChannel* g_transcript_cache_channel = nullptr;
+
+TranscriptCache* GetTranscriptCache(std::string* error) {
+  std::lock_guard<std::mutex> lock(g_transcript_cache_mutex);
+  if (g_transcript_cache == nullptr) {
+    g_autofree gchar* root = g_build_filename(
+        g_get_user_cache_dir(), "codeagenthub", "transcripts", nullptr);
+    auto* cache = new TranscriptCache(root);
+    if (!cache->Open(error)) {
+      delete cache;
+      return nullptr;
+    }
+    g_transcript_cache = cache;
+  }
+  return g_transcript_cache;
+}
+
+FlValue* StatsToValue(const TranscriptCache::Stats& stats) {
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "sessions", fl_value_new_int(stats.sessions));
+  fl_value_set_string_take(result, "records", fl_value_new_int(stats.records));
+  fl_value_set_string_take(result, "rawBytes",
+                           fl_value_new_int(stats.raw_bytes));
+  fl_value_set_string_take(result, "storedBytes",
+                           fl_value_new_int(stats.stored_bytes));
+  fl_value_set_string_take(result, "chunks", fl_value_new_int(stats.chunks));
+  fl_value_set_string_take(result, "chunkBytes",
+                           fl_value_new_int(stats.chunk_bytes));
+  fl_value_set_string_take(result, "dictionaryId",
+                           fl_value_new_int(stats.dictionary_id));
+  return result;
+}
+
+void HandleTranscriptCacheCall(FlMethodChannel* channel,
+                               FlMethodCall* method_call,
+                               gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method != "write" && method != "readRange" && method != "count" &&
+      method != "remove" && method != "trainDictionary" && method != "stats") {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+    return;
+  }
+
+  const std::string session_id = LookupStringArg(args, "sessionId");
+  const int64_t start = LookupIntArg(args, "start", 0);
+  const int64_t count = LookupIntArg(args, "count", INT64_MAX);
+  const bool append = LookupBoolArg(args, "append", false);
+  // readRange only: deliver the records to this isolate port instead of the
+  // reply, which then carries just the record count.
+  const int64_t reply_port = LookupIntArg(args, "replyPort", 0);
+  const int64_t job = LookupIntArg(args, "job", 0);
+  std::vector<std::string> records = LookupStringListArg(args, "records");
+
+  g_object_ref(method_call);
+  std::function<void()> task = [method, session_id, start, count, append,
+                                reply_port, job, records = std::move(records),
+                                method_call]() {
+    std::string error;
+    FlValue* result = nullptr;
+    TranscriptCache* cache = GetTranscriptCache(&error);
+    if (cache != nullptr) {
+      if (method == "write") {
+        if (cache->Write(session_id, records, append, &error)) {
+          result = fl_value_new_int(cache->RecordCount(session_id));
+        }
+      } else if (method == "readRange") {
+        std::vector<std::string> out;
+        if (cache->ReadRange(session_id, std::max<int64_t>(start, 0),
+                             std::max<int64_t>(count, 0), &out, &error)) {
+          if (reply_port != 0) {
+            // One JSONL buffer, posted without a copy.
+            size_t size = 0;
+            for (const auto& record : out) {
+              size += record.size() + 1;
+            }
+            std::string lines;
+            lines.reserve(size);
+            for (const auto& record : out) {
+              lines += record;
+              lines += '\n';
+            }
+            if (PostBytesToIsolate(reply_port, job, std::move(lines))) {
+              result = fl_value_new_int(static_cast<int64_t>(out.size()));
+            } else {
+              error = "Isolate port is closed";
+            }
+          } else {
+            result = fl_value_new_list();
+            for (const auto& record : out) {
+              fl_value_append_take(result, fl_value_new_string(record.c_str()));
+            }
+          }
+        }
+      } else if (method == "count") {
+        result = fl_value_new_int(cache->RecordCount(session_id));
+      } else if (method == "remove") {
+        result = fl_value_new_bool(cache->Remove(session_id));
+      } else if (method == "trainDictionary") {
+        if (cache->TrainDictionary(&error)) {
+          result = fl_value_new_bool(true);
+        }
+      } else {
+        result = StatsToValue(cache->GetStats());
+      }
+    }
+
+    RunOnMainThread([method_call, result, error]() {
+      if (result != nullptr) {
+        RespondSuccess(method_call, result);
+      } else {
+        RespondError(method_call, "TRANSCRIPT_CACHE_ERROR", error);
+      }
+      g_object_unref(method_call);
+    });
+  };
+  // Reads feed a session being opened; writes and training can wait.
+  if (method == "write" || method == "trainDictionary") {
+    TaskPool::Get().PostBackground(std::move(task));
+  } else {
+    TaskPool::Get().Post(std::move(task));
+  }
+}
+
+}  // namespace
+
+void RegisterTranscriptCacheChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_transcript_cache_channel = fl_method_channel_new(
+      messenger, kChannelName, FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_transcript_cache_channel, HandleTranscriptCacheCall, nullptr, nullptr);
+}
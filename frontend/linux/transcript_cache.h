@@ -0,0 +1,157 @@
+#ifndef RUNNER_TRANSCRIPT_CACHE_H_
+#define RUNNER_TRANSCRIPT_CACHE_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <zstd.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Local, compressed copy of session transcripts (one JSONL record per entry).
+//
+// Layout under the cache root:
+//   dict-<id>.zdict   zstd dictionaries trained from cached records
+//   chunks.pack       content-defined chunks shared by every session
+//   <session>.tcache  header, zstd blocks of encoded records, block index
+//
+// Records larger than kChunkThreshold are cut with a gear rolling hash and
+// stored once in chunks.pack, so the same file contents or tool output
+// repeated across turns and sessions costs a few hash references. The block
+// index at the tail of each session file allows reading any record by
+// decompressing a single block.
+class TranscriptCache {
+ public:
+  struct Stats {
+    uint64_t sessions = 0;
+    uint64_t records = 0;
+    uint64_t raw_bytes = 0;
+    uint64_t stored_bytes = 0;
+    uint64_t chunks = 0;
+    uint64_t chunk_bytes = 0;
+    uint32_t dictionary_id = 0;
+  };
+
+  explicit TranscriptCache(std::string root_dir);
+  ~TranscriptCache();
+
+  TranscriptCache(const TranscriptCache&) = delete;
+  TranscriptCache& operator=(const TranscriptCache&) = delete;
+
+  // Creates the cache root and loads the chunk index and latest dictionary.
+  bool Open(std::string* error);
+
+  // Replaces (or, with |append|, extends) the cached records of a session.
+  bool Write(const std::string& session_id,
+             const std::vector<std::string>& records, bool append,
+             std::string* error);
+
+  // Reads |count| records starting at |start|; the range is clamped to the
+  // records that exist.
+  bool ReadRange(const std::string& session_id, uint64_t start,
+                 uint64_t count, std::vector<std::string>* records,
+                 std::string* error);
+
+  // Returns the number of cached records, or 0 if the session is not cached.
+  uint64_t RecordCount(const std::string& session_id);
+
+  bool Remove(const std::string& session_id);
+
+  // Trains a new dictionary from the sampled records. Later blocks and
+  // chunks use it; existing data keeps referencing the dictionary it was
+  // written with.
+  bool TrainDictionary(std::string* error);
+
+  Stats GetStats();
+
+ private:
+  struct BlockInfo {
+    uint64_t offset = 0;
+    uint32_t compressed_size = 0;
+    uint32_t raw_size = 0;
+    uint32_t first_record = 0;
+    uint32_t record_count = 0;
+    uint32_t dictionary_id = 0;
+  };
+
+  struct SessionIndex {
+    std::vector<BlockInfo> blocks;
+    uint64_t record_count = 0;
+    uint64_t raw_bytes = 0;
+    uint64_t file_size = 0;
+  };
+
+  struct ChunkInfo {
+    uint64_t offset = 0;
+    uint32_t compressed_size = 0;
+    uint32_t raw_size = 0;
+    uint32_t dictionary_id = 0;
+  };
+
+  struct Dictionary {
+    ZSTD_CDict* cdict = nullptr;
+    ZSTD_DDict* ddict = nullptr;
+  };
+
+  std::string SessionPath(const std::string& session_id) const;
+  SessionIndex* LoadIndex(const std::string& session_id);
+  bool WriteBlocks(const std::string& session_id, SessionIndex* index,
+                   const std::vector<std::string>& encoded_records,
+                   std::string* error);
+
+  // Encodes a record as an inline payload or a list of chunk references.
+  bool EncodeRecord(const std::string& record, std::string* encoded,
+                    std::string* error);
+  bool DecodeRecords(const std::string& block, size_t skip, size_t count,
+                     std::vector<std::string>* records, std::string* error);
+  bool StoreChunk(const char* data, size_t size, uint64_t* hash,
+                  std::string* error);
+  bool LoadChunk(uint64_t hash, std::string* data, std::string* error);
+
+  bool Compress(const char* data, size_t size, uint32_t dictionary_id,
+                std::string* compressed, std::string* error);
+  bool Decompress(const char* data, size_t size, size_t raw_size,
+                  uint32_t dictionary_id, std::string* raw,
+                  std::string* error);
+  const Dictionary* GetDictionary(uint32_t dictionary_id);
+  bool LoadBlock(const std::string& session_id, const SessionIndex& index,
+                 size_t block, std::shared_ptr<const std::string>* raw,
+                 std::string* error);
+
+  void AddSample(const std::string& record);
+  bool TrainDictionaryLocked(std::string* error);
+
+  std::string root_dir_;
+  std::mutex mutex_;
+  bool opened_ = false;
+
+  ZSTD_CCtx* cctx_ = nullptr;
+  ZSTD_DCtx* dctx_ = nullptr;
+  uint32_t current_dictionary_id_ = 0;
+  std::map<uint32_t, Dictionary> dictionaries_;
+
+  int chunk_fd_ = -1;
+  uint64_t chunk_file_size_ = 0;
+  std::unordered_map<uint64_t, ChunkInfo> chunks_;
+
+  std::unordered_map<std::string, std::unique_ptr<SessionIndex>> indexes_;
+
+  // Decompressed blocks, most recently used first.
+  using BlockKey = std::pair<std::string, size_t>;
+  std::list<std::pair<BlockKey, std::shared_ptr<const std::string>>>
+      block_cache_;
+
+  std::vector<std::string> samples_;
+  size_t sample_bytes_ = 0;
+};
+
+// Registers the "com.codeagenthub/transcript_cache" method channel.
+void RegisterTranscriptCacheChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_TRANSCRIPT_CACHE_H_
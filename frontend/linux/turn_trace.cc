@@ -0,0 +1,207 @@
+#include "turn_trace.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "method_call_utils.h"
+#include "task_pool.h"
+
+namespace {
+
+const char kChannelName[] = "com.codeagenthub/turn_trace";
+const char kDirectoryEnv[] = "CODEAGENTHUB_TRACE_TURNS";
+
+const int kClientPid = 1;
+const int kBackendPid = 2;
+
+JsonValue MetadataEvent(const char* name, int pid, int tid,
+                        const std::string& value) {
+  JsonValue event = JsonValue::Object();
+  event.Set("name", JsonValue::String(name));
+  event.Set("ph", JsonValue::String("M"));
+  event.Set("pid", JsonValue::Integer(pid));
+  event.Set("tid", JsonValue::Integer(tid));
+  JsonValue args = JsonValue::Object();
+  args.Set("name", JsonValue::String(value));
+  event.Set("args", std::move(args));
+  return event;
+}
+
+// Converts one reported span; |shift_us| moves it onto the trace timeline.
+JsonValue SpanEvent(const JsonValue& span, const char* category, int pid,
+                    int tid, int64_t shift_us) {
+  JsonValue event = JsonValue::Object();
+  event.Set("name", JsonValue::String(span["name"].AsString()));
+  event.Set("cat", JsonValue::String(category));
+  const JsonValue* dur = span.Find("dur");
+  if (dur != nullptr && dur->is_number()) {
+    event.Set("ph", JsonValue::String("X"));
+    event.Set("dur", JsonValue::Integer(std::max<int64_t>(dur->AsInt(), 0)));
+  } else {
+    event.Set("ph", JsonValue::String("i"));
+    event.Set("s", JsonValue::String("t"));
+  }
+  event.Set("pid", JsonValue::Integer(pid));
+  event.Set("tid", JsonValue::Integer(tid));
+  event.Set("ts", JsonValue::Integer(span["ts"].AsInt() - shift_us));
+  const JsonValue* args = span.Find("args");
+  if (args != nullptr && args->is_object()) {
+    event.Set("args", *args);
+  }
+  return event;
+}
+
+}  // namespace
+
+TraceClockOffset EstimateTraceClockOffset(int64_t client_sent_us,
+                                          int64_t backend_received_us,
+                                          int64_t backend_headers_us,
+                                          int64_t client_headers_us) {
+  TraceClockOffset result;
+  if (backend_headers_us <= 0 || client_headers_us <= 0) {
+    result.offset_us = backend_received_us - client_sent_us;
+    return result;
+  }
+  result.offset_us = ((backend_received_us - client_sent_us) +
+                      (backend_headers_us - client_headers_us)) /
+                     2;
+  result.round_trip_us =
+      std::max<int64_t>((client_headers_us - client_sent_us) -
+                            (backend_headers_us - backend_received_us),
+                        0);
+  return result;
+}
+
+JsonValue MergeTurnTrace(const JsonValue& turn) {
+  const int64_t sent_us = turn["sentUs"].AsInt();
+  JsonValue events = JsonValue::Array();
+  events.Append(MetadataEvent("process_name", kClientPid, 0, "client"));
+
+  // One thread per client track, in order of first appearance.
+  std::map<std::string, int> tracks;
+  int64_t dropped = turn["dropped"].AsInt();
+  for (const JsonValue& span : turn["spans"].items()) {
+    const std::string& track = span["track"].AsString();
+    auto it = tracks.find(track);
+    if (it == tracks.end()) {
+      const int tid = static_cast<int>(tracks.size()) + 1;
+      it = tracks.emplace(track, tid).first;
+      events.Append(MetadataEvent("thread_name", kClientPid, tid,
+                                  track.empty() ? "client" : track));
+    }
+    events.Append(SpanEvent(span, "client", kClientPid, it->second, sent_us));
+  }
+
+  TraceClockOffset clock;
+  const JsonValue& backend = turn["backend"];
+  if (backend.is_object()) {
+    clock = EstimateTraceClockOffset(
+        sent_us, backend["received_us"].AsInt(),
+        backend["headers_us"].AsInt(), turn["headersUs"].AsInt());
+    dropped += backend["dropped"].AsInt();
+    events.Append(MetadataEvent("process_name", kBackendPid, 0, "backend"));
+    events.Append(MetadataEvent("thread_name", kBackendPid, 1, "chat"));
+    for (const JsonValue& span : backend["spans"].items()) {
+      events.Append(SpanEvent(span, "backend", kBackendPid, 1,
+                              sent_us + clock.offset_us));
+    }
+  }
+
+  JsonValue other = JsonValue::Object();
+  other.Set("traceId", JsonValue::String(turn["id"].AsString()));
+  other.Set("schema", JsonValue::String(turn["schema"].AsString()));
+  other.Set("hasBackend", JsonValue::Bool(backend.is_object()));
+  other.Set("clockOffsetUs", JsonValue::Integer(clock.offset_us));
+  other.Set("roundTripUs", JsonValue::Integer(clock.round_trip_us));
+  other.Set("droppedSpans", JsonValue::Integer(dropped));
+
+  JsonValue trace = JsonValue::Object();
+  trace.Set("traceEvents", std::move(events));
+  trace.Set("displayTimeUnit", JsonValue::String("ms"));
+  trace.Set("otherData", std::move(other));
+  return trace;
+}
+
+// Method channel glue.
+
+namespace {
+
+FlMethodChannel* g_turn_trace_channel = nullptr;
+std::string g_trace_directory;
+
+// Keeps trace IDs from escaping the directory.
+std::string SanitizeTraceId(const std::string& id) {
+  std::string result;
+  for (char c : id.substr(0, 64)) {
+    result.push_back(g_ascii_isalnum(c) || c == '-' ? c : '_');
+  }
+  return result.empty() ? "turn" : result;
+}
+
+void HandleTurnTraceCall(FlMethodChannel* channel, FlMethodCall* method_call,
+                         gpointer user_data) {
+  const std::string method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (method == "isEnabled") {
+    RespondSuccess(method_call, fl_value_new_bool(!g_trace_directory.empty()));
+  } else if (method == "write") {
+    if (g_trace_directory.empty()) {
+      RespondError(method_call, "TURN_TRACE_ERROR", "Turn tracing is off");
+      return;
+    }
+    auto text = std::make_shared<std::string>(LookupStringArg(args, "turn"));
+    const std::string directory = g_trace_directory;
+    g_object_ref(method_call);
+    TaskPool::Get().PostBackground([method_call, text, directory]() {
+      JsonValue turn;
+      auto message = std::make_shared<std::string>();
+      auto path = std::make_shared<std::string>();
+      if (!ParseJson(*text, &turn, message.get()) || !turn.is_object()) {
+        *message = "Invalid turn: " + *message;
+      } else {
+        const std::string trace = MergeTurnTrace(turn).Serialize();
+        g_autoptr(GDateTime) now = g_date_time_new_now_local();
+        g_autofree gchar* stamp = g_date_time_format(now, "%Y%m%d-%H%M%S");
+        const std::string name = std::string("turn-") + stamp + "-" +
+                                 SanitizeTraceId(turn["id"].AsString()) +
+                                 ".json";
+        g_autofree gchar* file =
+            g_build_filename(directory.c_str(), name.c_str(), nullptr);
+        g_mkdir_with_parents(directory.c_str(), 0700);
+        g_autoptr(GError) error = nullptr;
+        if (g_file_set_contents(file, trace.data(), trace.size(), &error)) {
+          *path = file;
+        } else {
+          *message = std::string("Cannot write ") + file + ": " +
+                     error->message;
+        }
+      }
+      RunOnMainThread([method_call, path, message]() {
+        if (path->empty()) {
+          RespondError(method_call, "TURN_TRACE_ERROR", *message);
+        } else {
+          RespondSuccess(method_call, fl_value_new_string(path->c_str()));
+        }
+        g_object_unref(method_call);
+      });
+    });
+  } else {
+    fl_method_call_respond_not_implemented(method_call, nullptr);
+  }
+}
+
+}  // namespace
+
+void RegisterTurnTraceChannel(FlBinaryMessenger* messenger) {
+  const gchar* directory = g_getenv(kDirectoryEnv);
+  g_trace_directory = directory != nullptr ? directory : "";
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_turn_trace_channel = fl_method_channel_new(messenger, kChannelName,
+                                               FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(
+      g_turn_trace_channel, HandleTurnTraceCall, nullptr, nullptr);
+}
@@ -0,0 +1,50 @@
+#ifndef RUNNER_TURN_TRACE_H_
+#define RUNNER_TURN_TRACE_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <cstdint>
+
+#include "json_value.h"
+
+// Turn traces put the backend's and the client's view of one chat turn on a
+// single timeline. They are enabled by pointing CODEAGENTHUB_TRACE_TURNS at a
+// directory; each finished turn is written there as a Chrome trace
+// (chrome://tracing, Perfetto).
+//
+// The client stamps the request with its monotonic clock, the backend replies
+// with its spans on its own clock (see backend/ts_backend/src/tracing.ts), and
+// the runner merges both. Dart's Timeline clock is the runner's monotonic
+// clock, so only the backend needs shifting.
+
+struct TraceClockOffset {
+  int64_t offset_us = 0;       // Backend clock minus client clock.
+  int64_t round_trip_us = -1;  // Network round trip, or -1 when unknown.
+};
+
+// Estimates the offset between the two clocks from the request send and
+// receipt and the response header send and receipt, assuming the network
+// delay is the same both ways (as NTP does). Without the header times the
+// request delay is taken as zero.
+TraceClockOffset EstimateTraceClockOffset(int64_t client_sent_us,
+                                          int64_t backend_received_us,
+                                          int64_t backend_headers_us,
+                                          int64_t client_headers_us);
+
+// Builds a Chrome trace from a turn reported by Dart:
+//
+//   {"id": "...", "schema": "claude", "sentUs": 0, "headersUs": 0,
+//    "spans": [{"track": "network", "name": "...", "ts": 0, "dur": 0,
+//               "args": {...}}, ...],
+//    "dropped": 0,
+//    "backend": {"received_us": 0, "headers_us": 0, "spans": [...],
+//                "dropped": 0} | null}
+//
+// Spans without "dur" are instants. Timestamps in the result are relative to
+// the request send time.
+JsonValue MergeTurnTrace(const JsonValue& turn);
+
+// Registers the "com.codeagenthub/turn_trace" method channel.
+void RegisterTurnTraceChannel(FlBinaryMessenger* messenger);
+
+#endif  // RUNNER_TURN_TRACE_H_
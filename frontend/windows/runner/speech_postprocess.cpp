@@ -0,0 +1,613 @@
+#include "speech_postprocess.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// 扫描项目目录时的上限
+constexpr size_t kMaxFiles = 5000;
+constexpr uintmax_t kMaxFileBytes = 1 << 20;
+constexpr uintmax_t kMaxTotalBytes = 32 << 20;
+constexpr size_t kMaxIdentifierLength = 64;
+
+bool IsAsciiLower(char c) { return c >= 'a' && c <= 'z'; }
+bool IsAsciiUpper(char c) { return c >= 'A' && c <= 'Z'; }
+bool IsAsciiDigit(char c) { return c >= '0' && c <= '9'; }
+bool IsAsciiAlpha(char c) { return IsAsciiLower(c) || IsAsciiUpper(c); }
+bool IsAsciiAlnum(char c) { return IsAsciiAlpha(c) || IsAsciiDigit(c); }
+bool IsIdentifierChar(char c) { return IsAsciiAlnum(c) || c == '_'; }
+
+char ToLower(char c) { return IsAsciiUpper(c) ? static_cast<char>(c - 'A' + 'a') : c; }
+char ToUpper(char c) { return IsAsciiLower(c) ? static_cast<char>(c - 'a' + 'A') : c; }
+
+std::string Lower(const std::string& text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(), ToLower);
+    return result;
+}
+
+// 解码 text[*pos] 开始的一个 UTF-8 字符，非法字节按单字节处理
+char32_t DecodeUtf8(const std::string& text, size_t* pos) {
+    const unsigned char lead = static_cast<unsigned char>(text[*pos]);
+    size_t length = 1;
+    char32_t cp = lead;
+    if (lead >= 0xF0) {
+        length = 4;
+        cp = lead & 0x07;
+    } else if (lead >= 0xE0) {
+        length = 3;
+        cp = lead & 0x0F;
+    } else if (lead >= 0xC0) {
+        length = 2;
+        cp = lead & 0x1F;
+    }
+    if (length == 1 || *pos + length > text.size()) {
+        *pos += 1;
+        return lead;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        cp = (cp << 6) | (static_cast<unsigned char>(text[*pos + i]) & 0x3F);
+    }
+    *pos += length;
+    return cp;
+}
+
+char32_t FirstCodepoint(const std::string& text) {
+    size_t pos = 0;
+    return text.empty() ? 0 : DecodeUtf8(text, &pos);
+}
+
+char32_t LastCodepoint(const std::string& text) {
+    if (text.empty()) {
+        return 0;
+    }
+    size_t start = text.size() - 1;
+    while (start > 0 && (static_cast<unsigned char>(text[start]) & 0xC0) == 0x80) {
+        --start;
+    }
+    return DecodeUtf8(text, &start);
+}
+
+bool IsCjk(char32_t c) {
+    return (c >= 0x3040 && c <= 0x30FF) ||   // 假名
+           (c >= 0x3400 && c <= 0x4DBF) ||   // 扩展 A
+           (c >= 0x4E00 && c <= 0x9FFF) ||   // 基本汉字
+           (c >= 0xAC00 && c <= 0xD7AF) ||   // 谚文
+           (c >= 0xF900 && c <= 0xFAFF) ||   // 兼容汉字
+           (c >= 0x20000 && c <= 0x2FFFF);
+}
+
+// 全角标点（CJK 符号和全角形式）
+bool IsCjkPunct(char32_t c) {
+    return (c >= 0x3000 && c <= 0x303F) || (c >= 0xFF00 && c <= 0xFFEF);
+}
+
+bool IsPunct(char32_t c) {
+    if (c < 0x80) {
+        return c > 0x20 && !IsAsciiAlnum(static_cast<char>(c));
+    }
+    return IsCjkPunct(c);
+}
+
+bool IsAlnumCodepoint(char32_t c) {
+    return c < 0x80 && IsAsciiAlnum(static_cast<char>(c));
+}
+
+// 两段文本相接处是否需要空格（a 为前一段的最后一个字符）
+bool NeedsSpace(char32_t a, char32_t b) {
+    if (a == ' ' || IsCjkPunct(a) || IsPunct(b)) {
+        return false;
+    }
+    return !(IsCjk(a) && IsCjk(b));
+}
+
+// 一个词内部中文与英文、数字之间加空格："用React写" -> "用 React 写"
+std::string SpaceCjkLatin(const std::string& text) {
+    if (std::all_of(text.begin(), text.end(),
+                    [](char c) { return static_cast<unsigned char>(c) < 0x80; })) {
+        return text;
+    }
+    std::string result;
+    result.reserve(text.size() + 8);
+    char32_t previous = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const size_t start = pos;
+        const char32_t c = DecodeUtf8(text, &pos);
+        if ((IsCjk(previous) && IsAlnumCodepoint(c)) ||
+            (IsAlnumCodepoint(previous) && IsCjk(c))) {
+            result += ' ';
+        }
+        result.append(text, start, pos - start);
+        previous = c;
+    }
+    return result;
+}
+
+bool IsLatinWord(const std::string& text) {
+    return !text.empty() && std::all_of(text.begin(), text.end(), IsAsciiAlnum);
+}
+
+// 口述标识符在这些词前结束："camel case foo bar and ..." -> fooBar and ...
+bool IsConjunction(const std::string& word) {
+    const std::string lower = Lower(word);
+    return lower == "and" || lower == "or" || lower == "then" || lower == "but";
+}
+
+// 常见英文单词。全由这些词组成的标识符（isEmpty、toString、getUserName）
+// 读出来和普通英文没有区别，不能仅凭标识符表替换
+bool IsCommonWord(const std::string& word) {
+    static const char* const kCommonWords[] = {
+        "a", "about", "add", "after", "all", "an", "and", "any", "are", "as",
+        "at", "back", "be", "before", "by", "call", "can", "change", "check",
+        "clear", "close", "count", "create", "current", "data", "default",
+        "delete", "do", "done", "each", "else", "empty", "end", "error",
+        "file", "find", "first", "for", "from", "get", "go", "has", "have",
+        "if", "in", "index", "into", "is", "it", "item", "key", "last", "left",
+        "length", "line", "list", "load", "make", "map", "max", "message",
+        "min", "mode", "more", "move", "name", "need", "new", "next", "no",
+        "not", "now", "number", "of", "off", "old", "on", "one", "only",
+        "open", "or", "out", "over", "page", "path", "put", "read", "remove",
+        "reset", "result", "right", "run", "save", "send", "set", "should",
+        "show", "size", "start", "state", "stop", "string", "take", "test",
+        "text", "that", "the", "then", "this", "time", "to", "true", "type",
+        "up", "update", "use", "user", "value", "view", "was", "when", "will",
+        "with", "word", "write",
+    };
+    return std::any_of(std::begin(kCommonWords), std::end(kCommonWords),
+                       [&](const char* common) { return word == common; });
+}
+
+bool EndsWithQuestionParticle(const std::string& text) {
+    const char32_t last = LastCodepoint(text);
+    return last == 0x5417 || last == 0x5462;  // 吗 呢
+}
+
+// 句末标点，跟随前文的文字
+const char* SentenceMark(const std::string& text) {
+    if (!IsCjk(LastCodepoint(text))) {
+        return ".";
+    }
+    return EndsWithQuestionParticle(text) ? "\xEF\xBC\x9F" : "\xE3\x80\x82";  // ？ 。
+}
+
+const char* CommaMark(const std::string& text) {
+    return IsCjk(LastCodepoint(text)) ? "\xEF\xBC\x8C" : ",";  // ，
+}
+
+bool IsSkippedDirectory(const std::string& name) {
+    static const char* const kSkipped[] = {
+        "node_modules", "build", "dist", "out", "target", "vendor",
+        "__pycache__", "Pods", "venv",
+    };
+    if (name.empty() || name[0] == '.') {
+        return true;
+    }
+    return std::any_of(std::begin(kSkipped), std::end(kSkipped),
+                       [&](const char* skipped) { return name == skipped; });
+}
+
+bool HasSourceExtension(const std::filesystem::path& path) {
+    static const char* const kExtensions[] = {
+        ".dart", ".ts", ".tsx", ".js", ".jsx", ".py", ".go", ".rs", ".java",
+        ".kt", ".swift", ".c", ".cc", ".cpp", ".h", ".hpp", ".cs", ".rb",
+        ".php", ".m", ".mm",
+    };
+    const std::string extension = Lower(path.extension().string());
+    return std::any_of(std::begin(kExtensions), std::end(kExtensions),
+                       [&](const char* known) { return extension == known; });
+}
+
+// 口述的命名方式："camel case" 后面的单词按对应方式拼成一个标识符
+enum CaseStyle { kCamel, kPascal, kSnake, kKebab, kConstant };
+
+struct CaseCommand {
+    const char* words[3];
+    size_t count;
+    CaseStyle style;
+};
+
+// 较长的命令在前；中文命令以 UTF-8 转义书写，不依赖源文件编码
+const CaseCommand kCaseCommands[] = {
+    {{"upper", "snake", "case"}, 3, kConstant},
+    {{"camel", "case"}, 2, kCamel},
+    {{"pascal", "case"}, 2, kPascal},
+    {{"snake", "case"}, 2, kSnake},
+    {{"kebab", "case"}, 2, kKebab},
+    {{"dash", "case"}, 2, kKebab},
+    {{"constant", "case"}, 2, kConstant},
+    {{"camelcase"}, 1, kCamel},
+    {{"pascalcase"}, 1, kPascal},
+    {{"snakecase"}, 1, kSnake},
+    {{"\xE5\xA4\xA7\xE9\xA9\xBC\xE5\xB3\xB0"}, 1, kPascal},  // 大驼峰
+    {{"\xE9\xA9\xBC\xE5\xB3\xB0"}, 1, kCamel},                  // 驼峰
+    {{"\xE8\x9B\x87\xE5\xBD\xA2"}, 1, kSnake},                  // 蛇形
+};
+
+std::string Capitalize(const std::string& word) {
+    std::string result(word);
+    if (!result.empty()) {
+        result[0] = ToUpper(result[0]);
+    }
+    return result;
+}
+
+std::string FormatIdentifier(const std::vector<std::string>& words, CaseStyle style) {
+    std::string result;
+    for (size_t i = 0; i < words.size(); ++i) {
+        const std::string& word = words[i];
+        switch (style) {
+            case kCamel:
+                result += i == 0 ? word : Capitalize(word);
+                break;
+            case kPascal:
+                result += Capitalize(word);
+                break;
+            case kSnake:
+                result += (i == 0 ? "" : "_") + word;
+                break;
+            case kKebab:
+                result += (i == 0 ? "" : "-") + word;
+                break;
+            default: {
+                std::string upper(word);
+                std::transform(upper.begin(), upper.end(), upper.begin(), ToUpper);
+                result += (i == 0 ? "" : "_") + upper;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+void SpeechPostProcessor::SetVocabulary(const std::vector<std::string>& identifiers,
+                                        uint64_t request) {
+    std::unordered_map<std::string, Identifier> vocabulary;
+    vocabulary.reserve(identifiers.size());
+    for (const auto& identifier : identifiers) {
+        const auto parts = SplitIdentifier(identifier);
+        // 单个单词不替换，避免改动普通文字
+        if (parts.size() < 2 || parts.size() > kMaxPhraseWords) {
+            continue;
+        }
+        std::string key = parts[0];
+        for (size_t i = 1; i < parts.size(); ++i) {
+            key += ' ';
+            key += parts[i];
+        }
+        Identifier entry;
+        entry.text = identifier;
+        // 至少三个单词且含有不常见的单词，才不会和普通文字混淆
+        entry.distinctive = parts.size() >= 3 &&
+                            !std::all_of(parts.begin(), parts.end(), IsCommonWord);
+        vocabulary.emplace(std::move(key), std::move(entry));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (request != vocabulary_request_.load() || request < vocabulary_applied_) {
+        return;
+    }
+    vocabulary_applied_ = request;
+    vocabulary_.swap(vocabulary);
+}
+
+size_t SpeechPostProcessor::VocabularySize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return vocabulary_.size();
+}
+
+void SpeechPostProcessor::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tokens_.clear();
+    pauses_.clear();
+    units_.clear();
+    output_.clear();
+}
+
+std::string SpeechPostProcessor::Process(const std::vector<SpeechToken>& tokens, bool is_final) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 与上一个假设相同的前缀（文字和停顿都不变）
+    std::vector<uint8_t> pauses(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        pauses[i] = PauseBefore(tokens, i);
+    }
+    size_t common = 0;
+    while (common < tokens.size() && common < tokens_.size() &&
+           tokens[common].text == tokens_[common].text && pauses[common] == pauses_[common]) {
+        ++common;
+    }
+
+    // 保留只依赖这段前缀的输出
+    size_t keep = 0;
+    while (keep < units_.size() && !units_[keep].open && units_[keep].horizon <= common) {
+        ++keep;
+    }
+    units_.resize(keep);
+    output_.resize(keep > 0 ? units_.back().output_end : 0);
+
+    tokens_.resize(common);
+    tokens_.insert(tokens_.end(), tokens.begin() + common, tokens.end());
+    pauses_.swap(pauses);
+
+    size_t next = keep > 0 ? units_.back().end : 0;
+    while (next < tokens_.size()) {
+        Unit unit;
+        std::string text;
+        BuildUnit(next, &unit, &text);
+        AppendUnit(unit, text);
+        next = unit.end;
+    }
+
+    std::string result = output_;
+    if (is_final) {
+        // 整句结束补句号；只说了一个标识符或一个词时不补
+        if (units_.size() >= 2 && !units_.back().code && !IsPunct(LastCodepoint(result))) {
+            result += SentenceMark(result);
+        }
+        tokens_.clear();
+        pauses_.clear();
+        units_.clear();
+        output_.clear();
+    }
+    return result;
+}
+
+void SpeechPostProcessor::BuildUnit(size_t begin, Unit* unit, std::string* text) const {
+    unit->begin = begin;
+    unit->end = begin + 1;
+    unit->horizon = begin + 1;
+
+    int style = 0;
+    bool open = false;
+    const size_t command = MatchCommand(begin, &style, &open);
+    if (command > 0) {
+        const size_t words_begin = begin + command;
+        bool run_open = false;
+        const size_t run = LatinRun(words_begin, kMaxPhraseWords, &run_open);
+        if (run > 0) {
+            // 优先取项目中存在的标识符长度，否则到停顿或连词为止
+            size_t length = 0;
+            for (size_t k = run; k >= 2 && length == 0; --k) {
+                if (vocabulary_.count(PhraseKey(words_begin, words_begin + k)) > 0) {
+                    length = k;
+                }
+            }
+            if (length == 0) {
+                length = 1;
+                while (length < run && !IsConjunction(tokens_[words_begin + length].text)) {
+                    ++length;
+                }
+            }
+            std::vector<std::string> words;
+            for (size_t i = words_begin; i < words_begin + length; ++i) {
+                words.push_back(Lower(tokens_[i].text));
+            }
+            *text = FormatIdentifier(words, static_cast<CaseStyle>(style));
+            unit->end = words_begin + length;
+            unit->horizon = std::min(tokens_.size(), words_begin + run + 1);
+            unit->open = run_open;
+            unit->code = true;
+            return;
+        }
+        // 命令后面还没有单词
+        open = run_open;
+    }
+
+    const std::string& token = tokens_[begin].text;
+    if (command == 0 && IsLatinWord(token) && !vocabulary_.empty()) {
+        bool run_open = false;
+        const size_t run = LatinRun(begin, kMaxPhraseWords, &run_open);
+        for (size_t k = run; k >= 2; --k) {
+            auto found = vocabulary_.find(PhraseKey(begin, begin + k));
+            if (found != vocabulary_.end() && found->second.distinctive) {
+                *text = found->second.text;
+                unit->end = begin + k;
+                unit->code = true;
+                break;
+            }
+        }
+        unit->horizon = std::min(tokens_.size(), begin + run + 1);
+        unit->open = run_open;
+        if (unit->code) {
+            return;
+        }
+    } else {
+        unit->open = open;
+    }
+    *text = SpaceCjkLatin(token);
+}
+
+size_t SpeechPostProcessor::MatchCommand(size_t begin, int* style, bool* open) const {
+    for (const auto& command : kCaseCommands) {
+        size_t matched = 0;
+        // 命令内部不能有停顿
+        while (matched < command.count && begin + matched < tokens_.size() &&
+               Lower(tokens_[begin + matched].text) == command.words[matched] &&
+               (matched == 0 || pauses_[begin + matched] == 0)) {
+            ++matched;
+        }
+        if (matched == command.count) {
+            *style = command.style;
+            return command.count;
+        }
+        if (matched > 0 && begin + matched == tokens_.size()) {
+            // 说到一半的命令，等后面的词
+            *open = true;
+        }
+    }
+    return 0;
+}
+
+size_t SpeechPostProcessor::LatinRun(size_t begin, size_t limit, bool* open) const {
+    size_t count = 0;
+    while (count < limit) {
+        const size_t index = begin + count;
+        if (index >= tokens_.size()) {
+            // 后面的词还没识别出来
+            *open = true;
+            break;
+        }
+        if (!IsLatinWord(tokens_[index].text) || (count > 0 && pauses_[index] != 0)) {
+            break;
+        }
+        ++count;
+    }
+    return count;
+}
+
+std::string SpeechPostProcessor::PhraseKey(size_t begin, size_t end) const {
+    std::string key;
+    for (size_t i = begin; i < end; ++i) {
+        if (i > begin) {
+            key += ' ';
+        }
+        key += Lower(tokens_[i].text);
+    }
+    return key;
+}
+
+uint8_t SpeechPostProcessor::PauseBefore(const std::vector<SpeechToken>& tokens,
+                                         size_t index) const {
+    // 没有时间信息（start_ms 为 0）时不按停顿加标点
+    if (index == 0 || tokens[index].start_ms == 0 ||
+        tokens[index].start_ms <= tokens[index - 1].end_ms) {
+        return 0;
+    }
+    const uint32_t gap = tokens[index].start_ms - tokens[index - 1].end_ms;
+    if (gap >= kSentencePauseMs) {
+        return 2;
+    }
+    return gap >= kCommaPauseMs ? 1 : 0;
+}
+
+void SpeechPostProcessor::AppendUnit(const Unit& unit, const std::string& text) {
+    if (!text.empty() && !output_.empty()) {
+        const char32_t first = FirstCodepoint(text);
+        const uint8_t pause = pauses_[unit.begin];
+        if (pause > 0 && !IsPunct(LastCodepoint(output_)) && !IsPunct(first)) {
+            output_ += pause == 2 ? SentenceMark(output_) : CommaMark(output_);
+        }
+        if (NeedsSpace(LastCodepoint(output_), first)) {
+            output_ += ' ';
+        }
+    }
+    output_ += text;
+
+    Unit stored = unit;
+    stored.output_end = output_.size();
+    units_.push_back(stored);
+}
+
+std::vector<std::string> SpeechPostProcessor::SplitIdentifier(const std::string& identifier) {
+    std::vector<std::string> parts;
+    std::string current;
+    for (size_t i = 0; i < identifier.size(); ++i) {
+        const char c = identifier[i];
+        if (!IsAsciiAlnum(c)) {
+            if (!current.empty()) {
+                parts.push_back(std::move(current));
+                current.clear();
+            }
+            continue;
+        }
+        if (!current.empty()) {
+            const char previous = identifier[i - 1];
+            // fooBar、HTTPResponse、utf8 的分界
+            const bool boundary =
+                (IsAsciiLower(previous) && IsAsciiUpper(c)) ||
+                (IsAsciiDigit(previous) != IsAsciiDigit(c)) ||
+                (IsAsciiUpper(previous) && IsAsciiUpper(c) && i + 1 < identifier.size() &&
+                 IsAsciiLower(identifier[i + 1]));
+            if (boundary) {
+                parts.push_back(std::move(current));
+                current.clear();
+            }
+        }
+        current += ToLower(c);
+    }
+    if (!current.empty()) {
+        parts.push_back(std::move(current));
+    }
+    return parts;
+}
+
+std::vector<std::string> SpeechPostProcessor::CollectIdentifiers(const std::string& root,
+                                                                 size_t limit) {
+    namespace fs = std::filesystem;
+
+    std::unordered_map<std::string, uint32_t> counts;
+    std::error_code error;
+    fs::recursive_directory_iterator it(fs::u8path(root),
+                                        fs::directory_options::skip_permission_denied, error);
+    size_t files = 0;
+    uintmax_t total_bytes = 0;
+    for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+        const fs::directory_entry& entry = *it;
+        std::error_code entry_error;
+        if (entry.is_directory(entry_error)) {
+            if (IsSkippedDirectory(entry.path().filename().u8string())) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!entry.is_regular_file(entry_error) || !HasSourceExtension(entry.path())) {
+            continue;
+        }
+        const uintmax_t size = entry.file_size(entry_error);
+        if (entry_error || size > kMaxFileBytes) {
+            continue;
+        }
+        if (++files > kMaxFiles || total_bytes + size > kMaxTotalBytes) {
+            break;
+        }
+        total_bytes += size;
+
+        std::ifstream in(entry.path(), std::ios::binary);
+        const std::string content((std::istreambuf_iterator<char>(in)),
+                                  std::istreambuf_iterator<char>());
+        size_t i = 0;
+        while (i < content.size()) {
+            if (!IsIdentifierChar(content[i])) {
+                ++i;
+                continue;
+            }
+            size_t j = i + 1;
+            while (j < content.size() && IsIdentifierChar(content[j])) {
+                ++j;
+            }
+            // 数字开头的是字面量
+            if (!IsAsciiDigit(content[i]) && j - i >= 3 && j - i <= kMaxIdentifierLength) {
+                ++counts[content.substr(i, j - i)];
+            }
+            i = j;
+        }
+    }
+
+    std::vector<std::pair<uint32_t, std::string>> ranked;
+    for (auto& entry : counts) {
+        const size_t parts = SplitIdentifier(entry.first).size();
+        if (parts >= 2 && parts <= kMaxPhraseWords) {
+            ranked.emplace_back(entry.second, entry.first);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    if (ranked.size() > limit) {
+        ranked.resize(limit);
+    }
+
+    std::vector<std::string> identifiers;
+    identifiers.reserve(ranked.size());
+    for (auto& entry : ranked) {
+        identifiers.push_back(std::move(entry.second));
+    }
+    return identifiers;
+}
@@ -0,0 +1,96 @@
+#ifndef RUNNER_SPEECH_POSTPROCESS_H_
+#define RUNNER_SPEECH_POSTPROCESS_H_
+
+// 听写结果后处理，只依赖标准库，不含平台相关代码
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 识别出的一个词（SAPI 中的 phrase element）
+struct SpeechToken {
+    std::string text;       // UTF-8 显示文本
+    uint32_t start_ms = 0;  // 相对于本句开始；没有时间信息时为 0
+    uint32_t end_ms = 0;
+};
+
+// 把一句听写结果整理成可以直接发送的提示词：
+//   - 中文与英文、数字之间加空格
+//   - 按词间停顿补逗号、句号（中文用全角标点）
+//   - 口述的代码标识符："camel case user name" -> userName，
+//     以及与项目标识符表匹配的连续单词："parse markdown blocks" -> parseMarkdownBlocks。
+//     isEmpty、forEach 这类全由常见英文单词组成或只有两个单词的标识符在普通
+//     文字中也会出现，只在命名命令后面替换："camel case is empty" -> isEmpty
+//
+// 识别过程中会不断收到同一句的假设。与上一个假设相同的前缀直接复用已经
+// 格式化的结果，只重新处理变化的部分；每个词最多向后看 kMaxPhraseWords
+// 个词，因此每个新词的处理开销有上限，与句子长度和标识符表大小无关。
+// 线程安全。
+class SpeechPostProcessor {
+public:
+    // 标识符最多由几个单词组成，也是向后看的窗口大小
+    static constexpr size_t kMaxPhraseWords = 6;
+    // 停顿超过这些时长时补逗号 / 句号
+    static constexpr uint32_t kCommaPauseMs = 400;
+    static constexpr uint32_t kSentencePauseMs = 900;
+
+    SpeechPostProcessor() = default;
+    SpeechPostProcessor(const SpeechPostProcessor&) = delete;
+    SpeechPostProcessor& operator=(const SpeechPostProcessor&) = delete;
+
+    // 标识符表在后台线程中加载；只接受最近一次请求的结果
+    uint64_t BeginVocabularyLoad() { return ++vocabulary_request_; }
+    // identifiers 按优先级排列，同样读法的标识符保留靠前的一个
+    void SetVocabulary(const std::vector<std::string>& identifiers, uint64_t request);
+    size_t VocabularySize() const;
+
+    // 处理当前句子的一个假设，返回整句格式化后的文本
+    std::string Process(const std::vector<SpeechToken>& tokens, bool is_final);
+
+    // 开始新的一句
+    void Reset();
+
+    // 从代码目录提取标识符，按出现次数排序，最多 limit 个
+    static std::vector<std::string> CollectIdentifiers(const std::string& root, size_t limit);
+    // 把标识符拆成小写单词："getHTTPResponse2" -> get http response 2
+    static std::vector<std::string> SplitIdentifier(const std::string& identifier);
+
+private:
+    // 输出中的一段，对应 tokens_[begin, end)
+    struct Unit {
+        size_t begin = 0;
+        size_t end = 0;
+        size_t horizon = 0;      // 决定这一段时看过的词的末尾
+        bool open = false;       // 决定时词已用完，后续的词可能改变结果
+        bool code = false;       // 标识符
+        size_t output_end = 0;   // 这一段（含前面的分隔）在 output_ 中的结束位置
+    };
+
+    void BuildUnit(size_t begin, Unit* unit, std::string* text) const;
+    size_t MatchCommand(size_t begin, int* style, bool* open) const;
+    size_t LatinRun(size_t begin, size_t limit, bool* open) const;
+    std::string PhraseKey(size_t begin, size_t end) const;
+    uint8_t PauseBefore(const std::vector<SpeechToken>& tokens, size_t index) const;
+    void AppendUnit(const Unit& unit, const std::string& text);
+
+    mutable std::mutex mutex_;
+    std::atomic<uint64_t> vocabulary_request_{0};
+    uint64_t vocabulary_applied_ = 0;
+    struct Identifier {
+        std::string text;
+        bool distinctive = false;  // 没有命名命令时也替换
+    };
+    // 读法（小写单词以空格连接）-> 标识符
+    std::unordered_map<std::string, Identifier> vocabulary_;
+
+    // 上一个假设及其格式化结果
+    std::vector<SpeechToken> tokens_;
+    std::vector<uint8_t> pauses_;  // 每个词前的停顿：0 无，1 逗号，2 句号
+    std::vector<Unit> units_;
+    std::string output_;
+};
+
+#endif  // RUNNER_SPEECH_POSTPROCESS_H_
@@ -4,6 +4,9 @@
 #include <locale>
 #include <cstring>
 
+// 项目标识符表的上限
+static constexpr size_t kMaxVocabularySize = 20000;
+
 SpeechRecognition::SpeechRecognition() {}
 
 SpeechRecognition::~SpeechRecognition() {
@@ -65,9 +68,10 @@ bool SpeechRecognition::Initialize() {
         return false;
     }
 
-    // 设置感兴趣的事件
-    hr = context_->SetInterest(SPFEI(SPEI_RECOGNITION) | SPFEI(SPEI_FALSE_RECOGNITION),
-                                SPFEI(SPEI_RECOGNITION) | SPFEI(SPEI_FALSE_RECOGNITION));
+    // 设置感兴趣的事件（假设用于边说边显示）
+    const ULONGLONG interest =
+        SPFEI(SPEI_RECOGNITION) | SPFEI(SPEI_FALSE_RECOGNITION) | SPFEI(SPEI_HYPOTHESIS);
+    hr = context_->SetInterest(interest, interest);
     if (FAILED(hr)) {
         if (error_callback_) {
             error_callback_("设置事件失败");
@@ -149,6 +153,9 @@ bool SpeechRecognition::StartListening() {
 
     is_listening_ = true;
     should_stop_ = false;
+    // 上次停止时未说完的一句不再继续
+    post_processor_->Reset();
+    hypothesis_sent_ = false;
 
     // 启动识别线程
     recognition_thread_ = std::thread(&SpeechRecognition::RecognitionThread, this);
@@ -194,30 +201,38 @@ void SpeechRecognition::RecognitionThread() {
 
             while (context_->GetEvents(1, &event, &fetched) == S_OK && fetched > 0) {
                 // Process recognition events
-                if (event.eEventId == SPEI_RECOGNITION || event.eEventId == SPEI_FALSE_RECOGNITION) {
+                if (event.eEventId == SPEI_RECOGNITION || event.eEventId == SPEI_FALSE_RECOGNITION ||
+                    event.eEventId == SPEI_HYPOTHESIS) {
                     // For recognition events, lParam contains ISpRecoResult*
                     if (event.elParamType == SPET_LPARAM_IS_OBJECT && event.lParam) {
                         ISpRecoResult* reco_result = reinterpret_cast<ISpRecoResult*>(event.lParam);
 
-                        if (event.eEventId == SPEI_RECOGNITION) {
-                            // 获取识别的文本
-                            LPWSTR text = nullptr;
-                            // Cast SP_GETWHOLEPHRASE (-1) to ULONG to avoid signed/unsigned warning
-                            HRESULT hr = reco_result->GetText(static_cast<ULONG>(SP_GETWHOLEPHRASE), static_cast<ULONG>(SP_GETWHOLEPHRASE), TRUE, &text, nullptr);
-                            if (SUCCEEDED(hr) && text) {
-                                std::wstring wtext(text);
-                                std::string utf8_text = WideToUtf8(wtext);
+                        if (event.eEventId == SPEI_FALSE_RECOGNITION) {
+                            // 误识别：撤回已经显示的假设
+                            post_processor_->Reset();
+                            if (hypothesis_sent_) {
+                                hypothesis_sent_ = false;
+                                std::lock_guard<std::mutex> lock(callback_mutex_);
+                                if (result_callback_) {
+                                    result_callback_("", true);
+                                }
+                            }
+                        } else {
+                            const bool is_final = event.eEventId == SPEI_RECOGNITION;
+                            std::vector<SpeechToken> tokens;
+                            if (ReadTokens(reco_result, &tokens)) {
+                                // 整理空格、标点和口述的标识符
+                                const std::string utf8_text = post_processor_->Process(tokens, is_final);
+                                hypothesis_sent_ = !is_final;
 
                                 // Thread-safe callback invocation
                                 std::lock_guard<std::mutex> lock(callback_mutex_);
-                                if (result_callback_ && !utf8_text.empty()) {
-                                    result_callback_(utf8_text, true);
+                                if (result_callback_ && (is_final || !utf8_text.empty())) {
+                                    result_callback_(utf8_text, is_final);
                                 }
-
-                                CoTaskMemFree(text);
                             }
                         }
-                        // Release the result object for both RECOGNITION and FALSE_RECOGNITION
+                        // Release the result object for all recognition events
                         reco_result->Release();
                     }
                 } else {
@@ -245,6 +260,56 @@ std::string SpeechRecognition::WideToUtf8(const std::wstring& wstr) {
     return result;
 }
 
+bool SpeechRecognition::ReadTokens(ISpRecoResult* result, std::vector<SpeechToken>* tokens) {
+    SPPHRASE* phrase = nullptr;
+    if (SUCCEEDED(result->GetPhrase(&phrase)) && phrase) {
+        for (ULONG i = 0; i < phrase->Rule.ulCountOfElements; ++i) {
+            const SPPHRASEELEMENT& element = phrase->pElements[i];
+            const WCHAR* text = element.pszDisplayText ? element.pszDisplayText : element.pszLexicalForm;
+            if (!text || !*text) {
+                continue;
+            }
+            SpeechToken token;
+            token.text = WideToUtf8(text);
+            // 时间以 100 纳秒为单位，相对于本句开始
+            token.start_ms = element.ulAudioTimeOffset / 10000;
+            token.end_ms = (element.ulAudioTimeOffset + element.ulAudioSizeTime) / 10000;
+            tokens->push_back(std::move(token));
+        }
+        CoTaskMemFree(phrase);
+    }
+    if (!tokens->empty()) {
+        return true;
+    }
+
+    // 没有分词信息时整句作为一个词
+    LPWSTR text = nullptr;
+    HRESULT hr = result->GetText(static_cast<ULONG>(SP_GETWHOLEPHRASE), static_cast<ULONG>(SP_GETWHOLEPHRASE), TRUE, &text, nullptr);
+    if (SUCCEEDED(hr) && text) {
+        SpeechToken token;
+        token.text = WideToUtf8(text);
+        if (!token.text.empty()) {
+            tokens->push_back(std::move(token));
+        }
+        CoTaskMemFree(text);
+    }
+    return !tokens->empty();
+}
+
+void SpeechRecognition::LoadVocabulary(const std::string& root) {
+    // 同一个项目只扫描一次
+    if (root.empty() || root == vocabulary_root_) {
+        return;
+    }
+    vocabulary_root_ = root;
+
+    auto processor = post_processor_;
+    const uint64_t request = processor->BeginVocabularyLoad();
+    std::thread([processor, root, request]() {
+        processor->SetVocabulary(SpeechPostProcessor::CollectIdentifiers(root, kMaxVocabularySize), request);
+    }).detach();
+}
+
 void SpeechRecognition::SetResultCallback(std::function<void(const std::string&, bool)> callback) {
     std::lock_guard<std::mutex> lock(callback_mutex_);
     result_callback_ = callback;
@@ -301,6 +366,25 @@ void RegisterSpeechRecognitionChannel(flutter::FlutterEngine* engine) {
                 bool listening = g_speech_recognition ? g_speech_recognition->IsListening() : false;
                 result->Success(flutter::EncodableValue(listening));
 
+            } else if (call.method_name() == "setVocabularyRoot") {
+                // 当前项目目录，用于识别口述的标识符
+                const auto* arguments = std::get_if<flutter::EncodableMap>(call.arguments());
+                if (!arguments) {
+                    result->Error("INVALID_ARGUMENTS", "缺少参数");
+                    return;
+                }
+                auto root = arguments->find(flutter::EncodableValue("root"));
+                const std::string* path = root != arguments->end() ? std::get_if<std::string>(&root->second) : nullptr;
+                if (!path) {
+                    result->Error("INVALID_ARGUMENTS", "缺少 root");
+                    return;
+                }
+                if (!g_speech_recognition) {
+                    g_speech_recognition = std::make_unique<SpeechRecognition>();
+                }
+                g_speech_recognition->LoadVocabulary(*path);
+                result->Success(flutter::EncodableValue(true));
+
             } else if (call.method_name() == "isInitialized") {
                 bool initialized = g_speech_recognition ? g_speech_recognition->IsInitialized() : false;
                 result->Success(flutter::EncodableValue(initialized));
@@ -17,6 +17,9 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <vector>
+
+#include "speech_postprocess.h"
 
 #pragma comment(lib, "sapi.lib")
 
@@ -49,10 +52,15 @@ public:
     // 设置状态回调 (thread-safe)
     void SetStatusCallback(std::function<void(const std::string&)> callback);
 
+    // 在后台扫描项目目录，用其中的标识符识别口述的代码
+    void LoadVocabulary(const std::string& root);
+
 private:
     void RecognitionThread();
     void Cleanup();
     std::string WideToUtf8(const std::wstring& wstr);
+    // 读取识别结果中的词及其时间
+    bool ReadTokens(ISpRecoResult* result, std::vector<SpeechToken>* tokens);
 
     ISpRecognizer* recognizer_ = nullptr;
     ISpRecoContext* context_ = nullptr;
@@ -65,6 +73,11 @@ private:
     bool com_initialized_ = false;
     std::thread recognition_thread_;
 
+    // 结果后处理；扫描线程持有一份引用，不依赖本对象的生命周期
+    std::shared_ptr<SpeechPostProcessor> post_processor_ = std::make_shared<SpeechPostProcessor>();
+    std::string vocabulary_root_;
+    bool hypothesis_sent_ = false;  // 仅在识别线程中访问
+
     // Mutex for thread-safe callback access
     mutable std::mutex callback_mutex_;
     std::function<void(const std::string&, bool)> result_callback_;
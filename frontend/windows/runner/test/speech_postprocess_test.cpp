@@ -0,0 +1,176 @@
+#include "speech_postprocess.h"
+
+#include <string>
+#include <vector>
+
+#include "test/test_util.h"
+
+namespace {
+
+// 中文以 UTF-8 转义书写，不依赖源文件编码
+const char kUse[] = "\xE7\x94\xA8";                    // 用
+const char kWrite[] = "\xE5\x86\x99";                  // 写
+const char kComponent[] = "\xE7\xBB\x84\xE4\xBB\xB6";  // 组件
+const char kHello[] = "\xE4\xBD\xA0\xE5\xA5\xBD";      // 你好
+const char kWorld[] = "\xE4\xB8\x96\xE7\x95\x8C";      // 世界
+const char kOkQuestion[] = "\xE5\xA5\xBD\xE5\x90\x97";  // 好吗
+const char kYes[] = "\xE6\x98\xAF\xE7\x9A\x84";        // 是的
+const char kCamel[] = "\xE9\xA9\xBC\xE5\xB3\xB0";      // 驼峰
+const char kComma[] = "\xEF\xBC\x8C";                  // ，
+const char kPeriod[] = "\xE3\x80\x82";                 // 。
+const char kQuestion[] = "\xEF\xBC\x9F";               // ？
+
+// 没有时间信息的词
+std::vector<SpeechToken> Words(const std::vector<std::string>& words) {
+    std::vector<SpeechToken> tokens;
+    for (const auto& word : words) {
+        SpeechToken token;
+        token.text = word;
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+SpeechToken Timed(const std::string& text, uint32_t start_ms, uint32_t end_ms) {
+    SpeechToken token;
+    token.text = text;
+    token.start_ms = start_ms;
+    token.end_ms = end_ms;
+    return token;
+}
+
+std::string Final(const std::vector<SpeechToken>& tokens) {
+    SpeechPostProcessor processor;
+    return processor.Process(tokens, true);
+}
+
+void TestCjkSpacing() {
+    EXPECT_EQ(std::string(kUse) + " React " + kWrite + kComponent + kPeriod,
+              Final(Words({kUse, "React", kWrite, kComponent})));
+    // 一个词内部的中英文之间
+    EXPECT_EQ(std::string(kUse) + " React " + kWrite,
+              Final(Words({std::string(kUse) + "React" + kWrite})));
+    EXPECT_EQ(std::string(kUse) + " 2 " + kComponent + kPeriod,
+              Final(Words({kUse, "2", kComponent})));
+    EXPECT_EQ(std::string("hello world."), Final(Words({"hello", "world"})));
+}
+
+void TestPausePunctuation() {
+    EXPECT_EQ(std::string("hello, world. again."),
+              Final({Timed("hello", 100, 300), Timed("world", 800, 1000),
+                     Timed("again", 2000, 2200)}));
+    // 停顿不够长时不加标点
+    EXPECT_EQ(std::string("hello world."),
+              Final({Timed("hello", 100, 300), Timed("world", 500, 700)}));
+    EXPECT_EQ(std::string(kHello) + kComma + kWorld + kPeriod,
+              Final({Timed(kHello, 100, 300), Timed(kWorld, 800, 1000)}));
+    // 中文疑问语气词后用问号
+    EXPECT_EQ(std::string(kHello) + kOkQuestion + kQuestion + kYes + kPeriod,
+              Final({Timed(kHello, 100, 300), Timed(kOkQuestion, 300, 500),
+                     Timed(kYes, 1500, 1700)}));
+}
+
+void TestCaseCommands() {
+    EXPECT_EQ(std::string("userName"), Final(Words({"camel", "case", "user", "name"})));
+    EXPECT_EQ(std::string("UserName"), Final(Words({"Pascal", "case", "user", "name"})));
+    EXPECT_EQ(std::string("MAX_SIZE"), Final(Words({"upper", "snake", "case", "max", "size"})));
+    EXPECT_EQ(std::string("user-name"), Final(Words({"kebab", "case", "user", "name"})));
+    EXPECT_EQ(std::string("userName"), Final(Words({kCamel, "user", "name"})));
+    // 连词和停顿结束标识符
+    EXPECT_EQ(std::string("rename user_name and more."),
+              Final(Words({"rename", "snake", "case", "user", "name", "and", "more"})));
+    EXPECT_EQ(std::string("userName, next."),
+              Final({Timed("camel", 100, 200), Timed("case", 200, 300),
+                     Timed("user", 300, 400), Timed("name", 400, 500),
+                     Timed("next", 1000, 1200)}));
+    // 命令内部有停顿时不是命令
+    EXPECT_EQ(std::string("camel, case user."),
+              Final({Timed("camel", 100, 200), Timed("case", 700, 800),
+                     Timed("user", 800, 900)}));
+}
+
+void TestVocabulary() {
+    SpeechPostProcessor processor;
+    const uint64_t stale = processor.BeginVocabularyLoad();
+    processor.SetVocabulary({"isEmpty", "forEach", "getUserName", "parseMarkdownBlocks"},
+                            processor.BeginVocabularyLoad());
+    // 已被更新的请求取代的结果不生效
+    processor.SetVocabulary({"staleIdentifierName"}, stale);
+    EXPECT_EQ(4u, processor.VocabularySize());
+
+    // 只由常见单词组成或只有两个单词的标识符不在普通文字中替换
+    EXPECT_EQ(std::string("the list is empty."),
+              processor.Process(Words({"the", "list", "is", "empty"}), true));
+    EXPECT_EQ(std::string("for each user."),
+              processor.Process(Words({"for", "each", "user"}), true));
+    EXPECT_EQ(std::string("get user name."),
+              processor.Process(Words({"get", "user", "name"}), true));
+    EXPECT_EQ(std::string("call parseMarkdownBlocks now."),
+              processor.Process(Words({"call", "parse", "markdown", "blocks", "now"}), true));
+    // 命名命令后按标识符表决定长度
+    EXPECT_EQ(std::string("isEmpty and more."),
+              processor.Process(Words({"camel", "case", "is", "empty", "and", "more"}), true));
+    EXPECT_EQ(std::string("isEmpty next."),
+              processor.Process(Words({"camel", "case", "is", "empty", "next"}), true));
+}
+
+void TestIncrementalHypotheses() {
+    const std::vector<SpeechToken> sentence = {
+        Timed("please", 100, 300),  Timed("rename", 300, 500), Timed("camel", 500, 600),
+        Timed("case", 600, 700),    Timed("user", 700, 800),   Timed("name", 800, 900),
+        Timed(kUse, 1500, 1600),    Timed("React", 1600, 1800), Timed(kWrite, 1800, 1900),
+    };
+    const std::string expected = Final(sentence);
+
+    // 逐词增长的假设，每一步的结果都与从头处理相同
+    SpeechPostProcessor processor;
+    for (size_t count = 1; count < sentence.size(); ++count) {
+        const std::vector<SpeechToken> prefix(sentence.begin(), sentence.begin() + count);
+        SpeechPostProcessor fresh;
+        EXPECT_EQ(fresh.Process(prefix, false), processor.Process(prefix, false));
+    }
+    EXPECT_EQ(expected, processor.Process(sentence, true));
+
+    // 说到一半的命令等后面的词
+    SpeechPostProcessor partial;
+    EXPECT_EQ(std::string("camel"), partial.Process(Words({"camel"}), false));
+    EXPECT_EQ(std::string("fooBar"),
+              partial.Process(Words({"camel", "case", "foo", "bar"}), false));
+
+    // 识别器改写了前面的词：变化之后的部分重新处理
+    SpeechPostProcessor revised;
+    EXPECT_EQ(std::string("foo_bar and done"),
+              revised.Process(Words({"snake", "case", "foo", "bar", "and", "done"}), false));
+    EXPECT_EQ(std::string("fooBar and done"),
+              revised.Process(Words({"camel", "case", "foo", "bar", "and", "done"}), false));
+    EXPECT_EQ(std::string("fooBar and done."),
+              revised.Process(Words({"camel", "case", "foo", "bar", "and", "done"}), true));
+
+    // 整句结束后开始新的一句
+    EXPECT_EQ(std::string("hello"), revised.Process(Words({"hello"}), false));
+    revised.Reset();
+    EXPECT_EQ(std::string("world"), revised.Process(Words({"world"}), false));
+}
+
+void TestSplitIdentifier() {
+    EXPECT_TRUE(SpeechPostProcessor::SplitIdentifier("getHTTPResponse2") ==
+                (std::vector<std::string>{"get", "http", "response", "2"}));
+    EXPECT_TRUE(SpeechPostProcessor::SplitIdentifier("MAX_SIZE") ==
+                (std::vector<std::string>{"max", "size"}));
+}
+
+}  // namespace
+
+int main() {
+    TestCjkSpacing();
+    TestPausePunctuation();
+    TestCaseCommands();
+    TestVocabulary();
+    TestIncrementalHypotheses();
+    TestSplitIdentifier();
+    if (test_failures != 0) {
+        fprintf(stderr, "%d check(s) failed\n", test_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef RUNNER_TEST_TEST_UTIL_H_
+#define RUNNER_TEST_TEST_UTIL_H_
+
+#include <cstdio>
+
+// runner 原生单元测试用的最小断言，测试是由 CTest 运行的普通可执行文件
+// （见 CMakeLists.txt 中的 RUNNER_BUILD_TESTS）
+
+#define EXPECT_TRUE(condition)                                                   \
+    do {                                                                         \
+        if (!(condition)) {                                                      \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__,          \
+                    #condition);                                                 \
+            ++test_failures;                                                     \
+        }                                                                        \
+    } while (0)
+
+#define EXPECT_EQ(expected, actual)                                              \
+    do {                                                                         \
+        if (!((expected) == (actual))) {                                         \
+            fprintf(stderr, "%s:%d: expected %s == %s\n", __FILE__, __LINE__,    \
+                    #expected, #actual);                                         \
+            ++test_failures;                                                     \
+        }                                                                        \
+    } while (0)
+
+inline int test_failures = 0;
+
+#endif  // RUNNER_TEST_TEST_UTIL_H_